@@ -0,0 +1,860 @@
+//****************************************************************************
+// FILE:    AudioInterleave.h
+//
+// DESC:    Bulk conversion of audio sample data between the interleaved
+//          (frame after frame) and non-interleaved (channel after channel)
+//          layouts.
+//
+//          16 bit and 32 bit (int32 / float) samples with 2, 4, 6 or 8
+//          channels use SSE2 / AVX2 kernels, selected at run-time.
+//          Everything else (and any left over frames) use scalar loops.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _AUDIO_INTERLEAVE_H_
+#define _AUDIO_INTERLEAVE_H_
+
+
+#include "SimdUtils.h"
+
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Scalar de-interleave, for a fixed number of channels
+// (so the inner loop is fully unrolled).
+template <typename T, unsigned int NUM_CHLS> inline void deinterleaveFrames
+    (
+        T *pTarget,
+        const size_t chlStride,
+        const T *pSource,
+        const size_t startFrame,
+        const size_t numFrames
+    )
+{
+    for (size_t frame = startFrame; frame < numFrames; frame++)
+    {
+        const T *pFrame = (pSource + (frame * NUM_CHLS));
+
+        for (unsigned int chl = 0; chl < NUM_CHLS; chl++)
+            *(pTarget + (chl * chlStride) + frame) = pFrame[chl];
+    }
+}
+
+// Scalar interleave, for a fixed number of channels
+template <typename T, unsigned int NUM_CHLS> inline void interleaveFrames
+    (
+        T *pTarget,
+        const T *pSource,
+        const size_t chlStride,
+        const size_t startFrame,
+        const size_t numFrames
+    )
+{
+    for (size_t frame = startFrame; frame < numFrames; frame++)
+    {
+        T *pFrame = (pTarget + (frame * NUM_CHLS));
+
+        for (unsigned int chl = 0; chl < NUM_CHLS; chl++)
+            pFrame[chl] = *(pSource + (chl * chlStride) + frame);
+    }
+}
+
+// Scalar de-interleave, for any number of channels
+template <typename T> inline void deinterleaveFrames
+    (
+        T *pTarget,
+        const size_t chlStride,
+        const T *pSource,
+        const unsigned int numChls,
+        const size_t startFrame,
+        const size_t numFrames
+    )
+{
+    switch (numChls)
+    {
+        case 1: deinterleaveFrames<T, 1>(pTarget, chlStride, pSource, startFrame, numFrames); return;
+        case 2: deinterleaveFrames<T, 2>(pTarget, chlStride, pSource, startFrame, numFrames); return;
+        case 4: deinterleaveFrames<T, 4>(pTarget, chlStride, pSource, startFrame, numFrames); return;
+        case 6: deinterleaveFrames<T, 6>(pTarget, chlStride, pSource, startFrame, numFrames); return;
+        case 8: deinterleaveFrames<T, 8>(pTarget, chlStride, pSource, startFrame, numFrames); return;
+        default: break;
+    }
+
+    for (size_t frame = startFrame; frame < numFrames; frame++)
+    {
+        const T *pFrame = (pSource + (frame * numChls));
+
+        for (unsigned int chl = 0; chl < numChls; chl++)
+            *(pTarget + (chl * chlStride) + frame) = pFrame[chl];
+    }
+}
+
+// Scalar interleave, for any number of channels
+template <typename T> inline void interleaveFrames
+    (
+        T *pTarget,
+        const T *pSource,
+        const size_t chlStride,
+        const unsigned int numChls,
+        const size_t startFrame,
+        const size_t numFrames
+    )
+{
+    switch (numChls)
+    {
+        case 1: interleaveFrames<T, 1>(pTarget, pSource, chlStride, startFrame, numFrames); return;
+        case 2: interleaveFrames<T, 2>(pTarget, pSource, chlStride, startFrame, numFrames); return;
+        case 4: interleaveFrames<T, 4>(pTarget, pSource, chlStride, startFrame, numFrames); return;
+        case 6: interleaveFrames<T, 6>(pTarget, pSource, chlStride, startFrame, numFrames); return;
+        case 8: interleaveFrames<T, 8>(pTarget, pSource, chlStride, startFrame, numFrames); return;
+        default: break;
+    }
+
+    for (size_t frame = startFrame; frame < numFrames; frame++)
+    {
+        T *pFrame = (pTarget + (frame * numChls));
+
+        for (unsigned int chl = 0; chl < numChls; chl++)
+            pFrame[chl] = *(pSource + (chl * chlStride) + frame);
+    }
+}
+
+
+#ifdef SIMD_X86
+
+// The SIMD kernels below only move bits around, so 32 bit samples of
+// any type are handled as float, and 16 bit samples as int16.
+// Each kernel returns the number of frames it converted (a multiple of
+// its vector width) - the caller converts the rest with a scalar loop.
+
+//
+// 32 bit samples - SSE2
+//
+
+SIMD_TARGET_SSE2 inline size_t deinterleave2Sse2(float *pTarget, const size_t chlStride, const float *pSource, const size_t numFrames)
+{
+    float *pChl0 = pTarget;
+    float *pChl1 = (pTarget + chlStride);
+
+    size_t frame = 0;
+
+    for (; (frame + 4) <= numFrames; frame += 4)
+    {
+        __m128 a = _mm_loadu_ps(pSource + (frame * 2));
+        __m128 b = _mm_loadu_ps(pSource + (frame * 2) + 4);
+
+        _mm_storeu_ps((pChl0 + frame), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps((pChl1 + frame), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_SSE2 inline size_t interleave2Sse2(float *pTarget, const float *pSource, const size_t chlStride, const size_t numFrames)
+{
+    const float *pChl0 = pSource;
+    const float *pChl1 = (pSource + chlStride);
+
+    size_t frame = 0;
+
+    for (; (frame + 4) <= numFrames; frame += 4)
+    {
+        __m128 l = _mm_loadu_ps(pChl0 + frame);
+        __m128 r = _mm_loadu_ps(pChl1 + frame);
+
+        _mm_storeu_ps((pTarget + (frame * 2)), _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps((pTarget + (frame * 2) + 4), _mm_unpackhi_ps(l, r));
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_SSE2 inline size_t deinterleave4Sse2(float *pTarget, const size_t chlStride, const float *pSource, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 4) <= numFrames; frame += 4)
+    {
+        const float *pFrames = (pSource + (frame * 4));
+
+        __m128 r0 = _mm_loadu_ps(pFrames);
+        __m128 r1 = _mm_loadu_ps(pFrames + 4);
+        __m128 r2 = _mm_loadu_ps(pFrames + 8);
+        __m128 r3 = _mm_loadu_ps(pFrames + 12);
+
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        _mm_storeu_ps((pTarget + frame), r0);
+        _mm_storeu_ps((pTarget + chlStride + frame), r1);
+        _mm_storeu_ps((pTarget + (chlStride * 2) + frame), r2);
+        _mm_storeu_ps((pTarget + (chlStride * 3) + frame), r3);
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_SSE2 inline size_t interleave4Sse2(float *pTarget, const float *pSource, const size_t chlStride, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 4) <= numFrames; frame += 4)
+    {
+        __m128 r0 = _mm_loadu_ps(pSource + frame);
+        __m128 r1 = _mm_loadu_ps(pSource + chlStride + frame);
+        __m128 r2 = _mm_loadu_ps(pSource + (chlStride * 2) + frame);
+        __m128 r3 = _mm_loadu_ps(pSource + (chlStride * 3) + frame);
+
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        float *pFrames = (pTarget + (frame * 4));
+
+        _mm_storeu_ps(pFrames, r0);
+        _mm_storeu_ps((pFrames + 4), r1);
+        _mm_storeu_ps((pFrames + 8), r2);
+        _mm_storeu_ps((pFrames + 12), r3);
+    }
+
+    return frame;
+}
+
+// 6 channels = a 4x4 transpose of channels 0-3, plus
+// a 2 channel de-interleave of channels 4 & 5.
+SIMD_TARGET_SSE2 inline size_t deinterleave6Sse2(float *pTarget, const size_t chlStride, const float *pSource, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 4) <= numFrames; frame += 4)
+    {
+        const float *pFrames = (pSource + (frame * 6));
+
+        __m128 r0 = _mm_loadu_ps(pFrames);
+        __m128 r1 = _mm_loadu_ps(pFrames + 6);
+        __m128 r2 = _mm_loadu_ps(pFrames + 12);
+        __m128 r3 = _mm_loadu_ps(pFrames + 18);
+
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        // channels 4 & 5 of frames 0/1 and 2/3
+        __m128 a = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (pFrames + 4)), (const __m64 *) (pFrames + 10));
+        __m128 b = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (pFrames + 16)), (const __m64 *) (pFrames + 22));
+
+        _mm_storeu_ps((pTarget + frame), r0);
+        _mm_storeu_ps((pTarget + chlStride + frame), r1);
+        _mm_storeu_ps((pTarget + (chlStride * 2) + frame), r2);
+        _mm_storeu_ps((pTarget + (chlStride * 3) + frame), r3);
+        _mm_storeu_ps((pTarget + (chlStride * 4) + frame), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps((pTarget + (chlStride * 5) + frame), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_SSE2 inline size_t interleave6Sse2(float *pTarget, const float *pSource, const size_t chlStride, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 4) <= numFrames; frame += 4)
+    {
+        __m128 r0 = _mm_loadu_ps(pSource + frame);
+        __m128 r1 = _mm_loadu_ps(pSource + chlStride + frame);
+        __m128 r2 = _mm_loadu_ps(pSource + (chlStride * 2) + frame);
+        __m128 r3 = _mm_loadu_ps(pSource + (chlStride * 3) + frame);
+        __m128 c4 = _mm_loadu_ps(pSource + (chlStride * 4) + frame);
+        __m128 c5 = _mm_loadu_ps(pSource + (chlStride * 5) + frame);
+
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        __m128 a = _mm_unpacklo_ps(c4, c5);
+        __m128 b = _mm_unpackhi_ps(c4, c5);
+
+        float *pFrames = (pTarget + (frame * 6));
+
+        _mm_storeu_ps(pFrames, r0);
+        _mm_storel_pi((__m64 *) (pFrames + 4), a);
+        _mm_storeu_ps((pFrames + 6), r1);
+        _mm_storeh_pi((__m64 *) (pFrames + 10), a);
+        _mm_storeu_ps((pFrames + 12), r2);
+        _mm_storel_pi((__m64 *) (pFrames + 16), b);
+        _mm_storeu_ps((pFrames + 18), r3);
+        _mm_storeh_pi((__m64 *) (pFrames + 22), b);
+    }
+
+    return frame;
+}
+
+// 8 channels = two 4x4 transposes (channels 0-3 & 4-7)
+SIMD_TARGET_SSE2 inline size_t deinterleave8Sse2(float *pTarget, const size_t chlStride, const float *pSource, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 4) <= numFrames; frame += 4)
+    {
+        const float *pFrames = (pSource + (frame * 8));
+
+        for (unsigned int half = 0; half < 2; half++)
+        {
+            __m128 r0 = _mm_loadu_ps(pFrames + (half * 4));
+            __m128 r1 = _mm_loadu_ps(pFrames + (half * 4) + 8);
+            __m128 r2 = _mm_loadu_ps(pFrames + (half * 4) + 16);
+            __m128 r3 = _mm_loadu_ps(pFrames + (half * 4) + 24);
+
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            float *pChls = (pTarget + (chlStride * half * 4) + frame);
+
+            _mm_storeu_ps(pChls, r0);
+            _mm_storeu_ps((pChls + chlStride), r1);
+            _mm_storeu_ps((pChls + (chlStride * 2)), r2);
+            _mm_storeu_ps((pChls + (chlStride * 3)), r3);
+        }
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_SSE2 inline size_t interleave8Sse2(float *pTarget, const float *pSource, const size_t chlStride, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 4) <= numFrames; frame += 4)
+    {
+        float *pFrames = (pTarget + (frame * 8));
+
+        for (unsigned int half = 0; half < 2; half++)
+        {
+            const float *pChls = (pSource + (chlStride * half * 4) + frame);
+
+            __m128 r0 = _mm_loadu_ps(pChls);
+            __m128 r1 = _mm_loadu_ps(pChls + chlStride);
+            __m128 r2 = _mm_loadu_ps(pChls + (chlStride * 2));
+            __m128 r3 = _mm_loadu_ps(pChls + (chlStride * 3));
+
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            _mm_storeu_ps((pFrames + (half * 4)), r0);
+            _mm_storeu_ps((pFrames + (half * 4) + 8), r1);
+            _mm_storeu_ps((pFrames + (half * 4) + 16), r2);
+            _mm_storeu_ps((pFrames + (half * 4) + 24), r3);
+        }
+    }
+
+    return frame;
+}
+
+//
+// 32 bit samples - AVX2
+//
+
+SIMD_TARGET_AVX2 inline size_t deinterleave2Avx2(float *pTarget, const size_t chlStride, const float *pSource, const size_t numFrames)
+{
+    float *pChl0 = pTarget;
+    float *pChl1 = (pTarget + chlStride);
+
+    size_t frame = 0;
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        __m256 a = _mm256_loadu_ps(pSource + (frame * 2));
+        __m256 b = _mm256_loadu_ps(pSource + (frame * 2) + 8);
+
+        // in-lane shuffles leave the 64 bit pairs in (0, 2, 1, 3) order
+        __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+        l = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0)));
+        r = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0)));
+
+        _mm256_storeu_ps((pChl0 + frame), l);
+        _mm256_storeu_ps((pChl1 + frame), r);
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_AVX2 inline size_t interleave2Avx2(float *pTarget, const float *pSource, const size_t chlStride, const size_t numFrames)
+{
+    const float *pChl0 = pSource;
+    const float *pChl1 = (pSource + chlStride);
+
+    size_t frame = 0;
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        __m256 l = _mm256_loadu_ps(pChl0 + frame);
+        __m256 r = _mm256_loadu_ps(pChl1 + frame);
+
+        __m256 lo = _mm256_unpacklo_ps(l, r);       // frames 0, 1, 4, 5
+        __m256 hi = _mm256_unpackhi_ps(l, r);       // frames 2, 3, 6, 7
+
+        _mm256_storeu_ps((pTarget + (frame * 2)), _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps((pTarget + (frame * 2) + 8), _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+
+    return frame;
+}
+
+// Transpose an 8x8 block of 32 bit values (in place)
+SIMD_TARGET_AVX2 inline void transpose8x8Avx2(__m256 &r0, __m256 &r1, __m256 &r2, __m256 &r3, __m256 &r4, __m256 &r5, __m256 &r6, __m256 &r7)
+{
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+    __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+    __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+    __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+
+    __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+    r0 = _mm256_permute2f128_ps(u0, u4, 0x20);
+    r1 = _mm256_permute2f128_ps(u1, u5, 0x20);
+    r2 = _mm256_permute2f128_ps(u2, u6, 0x20);
+    r3 = _mm256_permute2f128_ps(u3, u7, 0x20);
+    r4 = _mm256_permute2f128_ps(u0, u4, 0x31);
+    r5 = _mm256_permute2f128_ps(u1, u5, 0x31);
+    r6 = _mm256_permute2f128_ps(u2, u6, 0x31);
+    r7 = _mm256_permute2f128_ps(u3, u7, 0x31);
+}
+
+SIMD_TARGET_AVX2 inline size_t deinterleave8Avx2(float *pTarget, const size_t chlStride, const float *pSource, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        const float *pFrames = (pSource + (frame * 8));
+
+        __m256 r0 = _mm256_loadu_ps(pFrames);
+        __m256 r1 = _mm256_loadu_ps(pFrames + 8);
+        __m256 r2 = _mm256_loadu_ps(pFrames + 16);
+        __m256 r3 = _mm256_loadu_ps(pFrames + 24);
+        __m256 r4 = _mm256_loadu_ps(pFrames + 32);
+        __m256 r5 = _mm256_loadu_ps(pFrames + 40);
+        __m256 r6 = _mm256_loadu_ps(pFrames + 48);
+        __m256 r7 = _mm256_loadu_ps(pFrames + 56);
+
+        transpose8x8Avx2(r0, r1, r2, r3, r4, r5, r6, r7);
+
+        _mm256_storeu_ps((pTarget + frame), r0);
+        _mm256_storeu_ps((pTarget + chlStride + frame), r1);
+        _mm256_storeu_ps((pTarget + (chlStride * 2) + frame), r2);
+        _mm256_storeu_ps((pTarget + (chlStride * 3) + frame), r3);
+        _mm256_storeu_ps((pTarget + (chlStride * 4) + frame), r4);
+        _mm256_storeu_ps((pTarget + (chlStride * 5) + frame), r5);
+        _mm256_storeu_ps((pTarget + (chlStride * 6) + frame), r6);
+        _mm256_storeu_ps((pTarget + (chlStride * 7) + frame), r7);
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_AVX2 inline size_t interleave8Avx2(float *pTarget, const float *pSource, const size_t chlStride, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        __m256 r0 = _mm256_loadu_ps(pSource + frame);
+        __m256 r1 = _mm256_loadu_ps(pSource + chlStride + frame);
+        __m256 r2 = _mm256_loadu_ps(pSource + (chlStride * 2) + frame);
+        __m256 r3 = _mm256_loadu_ps(pSource + (chlStride * 3) + frame);
+        __m256 r4 = _mm256_loadu_ps(pSource + (chlStride * 4) + frame);
+        __m256 r5 = _mm256_loadu_ps(pSource + (chlStride * 5) + frame);
+        __m256 r6 = _mm256_loadu_ps(pSource + (chlStride * 6) + frame);
+        __m256 r7 = _mm256_loadu_ps(pSource + (chlStride * 7) + frame);
+
+        transpose8x8Avx2(r0, r1, r2, r3, r4, r5, r6, r7);
+
+        float *pFrames = (pTarget + (frame * 8));
+
+        _mm256_storeu_ps(pFrames, r0);
+        _mm256_storeu_ps((pFrames + 8), r1);
+        _mm256_storeu_ps((pFrames + 16), r2);
+        _mm256_storeu_ps((pFrames + 24), r3);
+        _mm256_storeu_ps((pFrames + 32), r4);
+        _mm256_storeu_ps((pFrames + 40), r5);
+        _mm256_storeu_ps((pFrames + 48), r6);
+        _mm256_storeu_ps((pFrames + 56), r7);
+    }
+
+    return frame;
+}
+
+//
+// 16 bit samples - SSE2
+//
+
+SIMD_TARGET_SSE2 inline size_t deinterleave2Sse2(int16_t *pTarget, const size_t chlStride, const int16_t *pSource, const size_t numFrames)
+{
+    int16_t *pChl0 = pTarget;
+    int16_t *pChl1 = (pTarget + chlStride);
+
+    size_t frame = 0;
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *) (pSource + (frame * 2)));
+        __m128i b = _mm_loadu_si128((const __m128i *) (pSource + (frame * 2) + 8));
+
+        // sign extend each 16 bit half to 32 bits, then pack
+        // (the values always fit, so the saturation is a no-op)
+        __m128i l = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+        __m128i r = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+
+        _mm_storeu_si128((__m128i *) (pChl0 + frame), l);
+        _mm_storeu_si128((__m128i *) (pChl1 + frame), r);
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_SSE2 inline size_t interleave2Sse2(int16_t *pTarget, const int16_t *pSource, const size_t chlStride, const size_t numFrames)
+{
+    const int16_t *pChl0 = pSource;
+    const int16_t *pChl1 = (pSource + chlStride);
+
+    size_t frame = 0;
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        __m128i l = _mm_loadu_si128((const __m128i *) (pChl0 + frame));
+        __m128i r = _mm_loadu_si128((const __m128i *) (pChl1 + frame));
+
+        _mm_storeu_si128((__m128i *) (pTarget + (frame * 2)), _mm_unpacklo_epi16(l, r));
+        _mm_storeu_si128((__m128i *) (pTarget + (frame * 2) + 8), _mm_unpackhi_epi16(l, r));
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_SSE2 inline size_t deinterleave4Sse2(int16_t *pTarget, const size_t chlStride, const int16_t *pSource, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        const int16_t *pFrames = (pSource + (frame * 4));
+
+        __m128i a = _mm_loadu_si128((const __m128i *) pFrames);           // frames 0, 1
+        __m128i b = _mm_loadu_si128((const __m128i *) (pFrames + 8));     // frames 2, 3
+        __m128i c = _mm_loadu_si128((const __m128i *) (pFrames + 16));    // frames 4, 5
+        __m128i d = _mm_loadu_si128((const __m128i *) (pFrames + 24));    // frames 6, 7
+
+        __m128i t0 = _mm_unpacklo_epi16(a, b);
+        __m128i t1 = _mm_unpackhi_epi16(a, b);
+        __m128i t2 = _mm_unpacklo_epi16(c, d);
+        __m128i t3 = _mm_unpackhi_epi16(c, d);
+
+        __m128i u0 = _mm_unpacklo_epi16(t0, t1);      // chl 0 & 1, frames 0-3
+        __m128i u1 = _mm_unpackhi_epi16(t0, t1);      // chl 2 & 3, frames 0-3
+        __m128i u2 = _mm_unpacklo_epi16(t2, t3);      // chl 0 & 1, frames 4-7
+        __m128i u3 = _mm_unpackhi_epi16(t2, t3);      // chl 2 & 3, frames 4-7
+
+        _mm_storeu_si128((__m128i *) (pTarget + frame), _mm_unpacklo_epi64(u0, u2));
+        _mm_storeu_si128((__m128i *) (pTarget + chlStride + frame), _mm_unpackhi_epi64(u0, u2));
+        _mm_storeu_si128((__m128i *) (pTarget + (chlStride * 2) + frame), _mm_unpacklo_epi64(u1, u3));
+        _mm_storeu_si128((__m128i *) (pTarget + (chlStride * 3) + frame), _mm_unpackhi_epi64(u1, u3));
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_SSE2 inline size_t interleave4Sse2(int16_t *pTarget, const int16_t *pSource, const size_t chlStride, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        __m128i c0 = _mm_loadu_si128((const __m128i *) (pSource + frame));
+        __m128i c1 = _mm_loadu_si128((const __m128i *) (pSource + chlStride + frame));
+        __m128i c2 = _mm_loadu_si128((const __m128i *) (pSource + (chlStride * 2) + frame));
+        __m128i c3 = _mm_loadu_si128((const __m128i *) (pSource + (chlStride * 3) + frame));
+
+        __m128i t0 = _mm_unpacklo_epi16(c0, c1);      // chl 0 & 1, frames 0-3
+        __m128i t1 = _mm_unpacklo_epi16(c2, c3);      // chl 2 & 3, frames 0-3
+        __m128i t2 = _mm_unpackhi_epi16(c0, c1);      // chl 0 & 1, frames 4-7
+        __m128i t3 = _mm_unpackhi_epi16(c2, c3);      // chl 2 & 3, frames 4-7
+
+        int16_t *pFrames = (pTarget + (frame * 4));
+
+        _mm_storeu_si128((__m128i *) pFrames, _mm_unpacklo_epi32(t0, t1));
+        _mm_storeu_si128((__m128i *) (pFrames + 8), _mm_unpackhi_epi32(t0, t1));
+        _mm_storeu_si128((__m128i *) (pFrames + 16), _mm_unpacklo_epi32(t2, t3));
+        _mm_storeu_si128((__m128i *) (pFrames + 24), _mm_unpackhi_epi32(t2, t3));
+    }
+
+    return frame;
+}
+
+// Transpose an 8x8 block of 16 bit values (in place)
+SIMD_TARGET_SSE2 inline void transpose8x8Sse2(__m128i *pRows)
+{
+    __m128i b0 = _mm_unpacklo_epi16(pRows[0], pRows[1]);
+    __m128i b1 = _mm_unpackhi_epi16(pRows[0], pRows[1]);
+    __m128i b2 = _mm_unpacklo_epi16(pRows[2], pRows[3]);
+    __m128i b3 = _mm_unpackhi_epi16(pRows[2], pRows[3]);
+    __m128i b4 = _mm_unpacklo_epi16(pRows[4], pRows[5]);
+    __m128i b5 = _mm_unpackhi_epi16(pRows[4], pRows[5]);
+    __m128i b6 = _mm_unpacklo_epi16(pRows[6], pRows[7]);
+    __m128i b7 = _mm_unpackhi_epi16(pRows[6], pRows[7]);
+
+    __m128i c0 = _mm_unpacklo_epi32(b0, b2);
+    __m128i c1 = _mm_unpackhi_epi32(b0, b2);
+    __m128i c2 = _mm_unpacklo_epi32(b1, b3);
+    __m128i c3 = _mm_unpackhi_epi32(b1, b3);
+    __m128i c4 = _mm_unpacklo_epi32(b4, b6);
+    __m128i c5 = _mm_unpackhi_epi32(b4, b6);
+    __m128i c6 = _mm_unpacklo_epi32(b5, b7);
+    __m128i c7 = _mm_unpackhi_epi32(b5, b7);
+
+    pRows[0] = _mm_unpacklo_epi64(c0, c4);
+    pRows[1] = _mm_unpackhi_epi64(c0, c4);
+    pRows[2] = _mm_unpacklo_epi64(c1, c5);
+    pRows[3] = _mm_unpackhi_epi64(c1, c5);
+    pRows[4] = _mm_unpacklo_epi64(c2, c6);
+    pRows[5] = _mm_unpackhi_epi64(c2, c6);
+    pRows[6] = _mm_unpacklo_epi64(c3, c7);
+    pRows[7] = _mm_unpackhi_epi64(c3, c7);
+}
+
+SIMD_TARGET_SSE2 inline size_t deinterleave8Sse2(int16_t *pTarget, const size_t chlStride, const int16_t *pSource, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    __m128i rows[8];
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        const int16_t *pFrames = (pSource + (frame * 8));
+
+        for (unsigned int x = 0; x < 8; x++)
+            rows[x] = _mm_loadu_si128((const __m128i *) (pFrames + (x * 8)));
+
+        transpose8x8Sse2(rows);
+
+        for (unsigned int chl = 0; chl < 8; chl++)
+            _mm_storeu_si128((__m128i *) (pTarget + (chl * chlStride) + frame), rows[chl]);
+    }
+
+    return frame;
+}
+
+SIMD_TARGET_SSE2 inline size_t interleave8Sse2(int16_t *pTarget, const int16_t *pSource, const size_t chlStride, const size_t numFrames)
+{
+    size_t frame = 0;
+
+    __m128i rows[8];
+
+    for (; (frame + 8) <= numFrames; frame += 8)
+    {
+        for (unsigned int chl = 0; chl < 8; chl++)
+            rows[chl] = _mm_loadu_si128((const __m128i *) (pSource + (chl * chlStride) + frame));
+
+        transpose8x8Sse2(rows);
+
+        int16_t *pFrames = (pTarget + (frame * 8));
+
+        for (unsigned int x = 0; x < 8; x++)
+            _mm_storeu_si128((__m128i *) (pFrames + (x * 8)), rows[x]);
+    }
+
+    return frame;
+}
+
+#endif // SIMD_X86
+
+
+// Run the best SIMD de-interleave kernel for this CPU (if there is one).
+// Returns the number of frames converted.
+inline size_t deinterleaveSimd(float *pTarget, const size_t chlStride, const float *pSource, const unsigned int numChls, const size_t numFrames)
+{
+#ifdef SIMD_X86
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+    switch (numChls)
+    {
+        case 2:
+            if (cpu.bAvx2)
+                return deinterleave2Avx2(pTarget, chlStride, pSource, numFrames);
+            if (cpu.bSse2)
+                return deinterleave2Sse2(pTarget, chlStride, pSource, numFrames);
+            break;
+
+        case 4:
+            if (cpu.bSse2)
+                return deinterleave4Sse2(pTarget, chlStride, pSource, numFrames);
+            break;
+
+        case 6:
+            if (cpu.bSse2)
+                return deinterleave6Sse2(pTarget, chlStride, pSource, numFrames);
+            break;
+
+        case 8:
+            if (cpu.bAvx2)
+                return deinterleave8Avx2(pTarget, chlStride, pSource, numFrames);
+            if (cpu.bSse2)
+                return deinterleave8Sse2(pTarget, chlStride, pSource, numFrames);
+            break;
+
+        default:
+            break;
+    }
+#endif
+
+    return 0;
+}
+
+inline size_t deinterleaveSimd(int16_t *pTarget, const size_t chlStride, const int16_t *pSource, const unsigned int numChls, const size_t numFrames)
+{
+#ifdef SIMD_X86
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+    if (cpu.bSse2)
+    {
+        switch (numChls)
+        {
+            case 2: return deinterleave2Sse2(pTarget, chlStride, pSource, numFrames);
+            case 4: return deinterleave4Sse2(pTarget, chlStride, pSource, numFrames);
+            case 8: return deinterleave8Sse2(pTarget, chlStride, pSource, numFrames);
+            default: break;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+// Run the best SIMD interleave kernel for this CPU (if there is one).
+// Returns the number of frames converted.
+inline size_t interleaveSimd(float *pTarget, const float *pSource, const size_t chlStride, const unsigned int numChls, const size_t numFrames)
+{
+#ifdef SIMD_X86
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+    switch (numChls)
+    {
+        case 2:
+            if (cpu.bAvx2)
+                return interleave2Avx2(pTarget, pSource, chlStride, numFrames);
+            if (cpu.bSse2)
+                return interleave2Sse2(pTarget, pSource, chlStride, numFrames);
+            break;
+
+        case 4:
+            if (cpu.bSse2)
+                return interleave4Sse2(pTarget, pSource, chlStride, numFrames);
+            break;
+
+        case 6:
+            if (cpu.bSse2)
+                return interleave6Sse2(pTarget, pSource, chlStride, numFrames);
+            break;
+
+        case 8:
+            if (cpu.bAvx2)
+                return interleave8Avx2(pTarget, pSource, chlStride, numFrames);
+            if (cpu.bSse2)
+                return interleave8Sse2(pTarget, pSource, chlStride, numFrames);
+            break;
+
+        default:
+            break;
+    }
+#endif
+
+    return 0;
+}
+
+inline size_t interleaveSimd(int16_t *pTarget, const int16_t *pSource, const size_t chlStride, const unsigned int numChls, const size_t numFrames)
+{
+#ifdef SIMD_X86
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+    if (cpu.bSse2)
+    {
+        switch (numChls)
+        {
+            case 2: return interleave2Sse2(pTarget, pSource, chlStride, numFrames);
+            case 4: return interleave4Sse2(pTarget, pSource, chlStride, numFrames);
+            case 8: return interleave8Sse2(pTarget, pSource, chlStride, numFrames);
+            default: break;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+
+// De-interleave numFrames frames of numChls channels.
+// Channel "n" is written to (pTarget + (n * chlStride)).
+template <typename T> inline void deinterleaveSamples
+    (
+        T *pTarget,
+        const size_t chlStride,
+        const T *pSource,
+        const unsigned int numChls,
+        const size_t numFrames
+    )
+{
+    if (pTarget == nullptr || pSource == nullptr || numChls < 1)
+        return;
+
+    size_t frame = 0;
+
+    if constexpr (std::is_trivially_copyable<T>::value && sizeof(T) == sizeof(float))
+    {
+        frame = deinterleaveSimd((float *) pTarget, chlStride, (const float *) pSource, numChls, numFrames);
+    }
+    else if constexpr (std::is_trivially_copyable<T>::value && sizeof(T) == sizeof(int16_t))
+    {
+        frame = deinterleaveSimd((int16_t *) pTarget, chlStride, (const int16_t *) pSource, numChls, numFrames);
+    }
+
+    deinterleaveFrames(pTarget, chlStride, pSource, numChls, frame, numFrames);
+}
+
+// Interleave numFrames frames of numChls channels.
+// Channel "n" is read from (pSource + (n * chlStride)).
+template <typename T> inline void interleaveSamples
+    (
+        T *pTarget,
+        const T *pSource,
+        const size_t chlStride,
+        const unsigned int numChls,
+        const size_t numFrames
+    )
+{
+    if (pTarget == nullptr || pSource == nullptr || numChls < 1)
+        return;
+
+    size_t frame = 0;
+
+    if constexpr (std::is_trivially_copyable<T>::value && sizeof(T) == sizeof(float))
+    {
+        frame = interleaveSimd((float *) pTarget, (const float *) pSource, chlStride, numChls, numFrames);
+    }
+    else if constexpr (std::is_trivially_copyable<T>::value && sizeof(T) == sizeof(int16_t))
+    {
+        frame = interleaveSimd((int16_t *) pTarget, (const int16_t *) pSource, chlStride, numChls, numFrames);
+    }
+
+    interleaveFrames(pTarget, pSource, chlStride, numChls, frame, numFrames);
+}
+
+
+#endif // _AUDIO_INTERLEAVE_H_
@@ -0,0 +1,259 @@
+//****************************************************************************
+// FILE:    BufferSpan.h
+//
+// DESC:    Light weight (non owning) views of the elements of a buffer.
+//
+//          CBufferSpan         - count contiguous elements, ie: a channel
+//                                of a non-interleaved audio buffer.
+//          CStridedBufferSpan  - count elements, "stride" elements apart,
+//                                ie: a channel of an interleaved buffer.
+//
+//          Both can be used with range-for and the std algorithms, ie:
+//
+//              for (auto &sample : buffer.getChannelSpan(chan))
+//                  sample *= gain;
+//
+//              std::fill(span.begin(), span.end(), 0);
+//
+//          Element indexes are only checked in debug builds (assert).
+//          A span is only valid while the buffer it views is allocated.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _BUFFER_SPAN_H_
+#define _BUFFER_SPAN_H_
+
+
+#include <algorithm>
+#include <iterator>
+
+#include <cassert>
+#include <cstddef>
+
+
+// A view of "count" contiguous elements
+template <class T> class CBufferSpan
+{
+    T           *m_pData;
+    size_t      m_count;
+
+  public:
+
+    typedef T           value_type;
+    typedef T           *iterator;
+    typedef const T     *const_iterator;
+
+    CBufferSpan() :
+        m_pData(nullptr),
+        m_count(0)
+    {
+    }
+
+    CBufferSpan(T *pData, const size_t count) :
+        m_pData(pData),
+        m_count((pData != nullptr) ? count : 0)
+    {
+    }
+
+    T *data() const
+    {
+        return m_pData;
+    }
+
+    size_t size() const
+    {
+        return m_count;
+    }
+
+    bool empty() const
+    {
+        return (m_count == 0);
+    }
+
+    T &operator[](const size_t idx) const
+    {
+        assert(idx < m_count);
+
+        return m_pData[idx];
+    }
+
+    iterator begin() const
+    {
+        return m_pData;
+    }
+
+    iterator end() const
+    {
+        return (m_pData + m_count);
+    }
+
+    // Get a view of "count" elements, starting at "offset"
+    // (clipped to the end of this span)
+    CBufferSpan<T> subspan(const size_t offset, const size_t count) const
+    {
+        if (offset >= m_count)
+            return CBufferSpan<T>();
+
+        return CBufferSpan<T>((m_pData + offset), std::min(count, (m_count - offset)));
+    }
+};
+
+
+// A view of "count" elements, "stride" elements apart
+template <class T> class CStridedBufferSpan
+{
+    T           *m_pData;
+    size_t      m_count;
+    size_t      m_stride;
+
+  public:
+
+    // Random access iterator (element index based, so an
+    // end() iterator never points past the end of the buffer)
+    class iterator
+    {
+        T           *m_pData;
+        ptrdiff_t   m_idx;
+        ptrdiff_t   m_stride;
+
+      public:
+
+        typedef std::random_access_iterator_tag     iterator_category;
+        typedef T                                   value_type;
+        typedef ptrdiff_t                           difference_type;
+        typedef T                                   *pointer;
+        typedef T                                   &reference;
+
+        iterator() :
+            m_pData(nullptr),
+            m_idx(0),
+            m_stride(1)
+        {
+        }
+
+        iterator(T *pData, const ptrdiff_t idx, const ptrdiff_t stride) :
+            m_pData(pData),
+            m_idx(idx),
+            m_stride(stride)
+        {
+        }
+
+        reference operator*() const                 { return m_pData[m_idx * m_stride]; }
+        pointer operator->() const                  { return &m_pData[m_idx * m_stride]; }
+        reference operator[](const ptrdiff_t n) const { return m_pData[(m_idx + n) * m_stride]; }
+
+        iterator &operator++()                      { m_idx++; return *this; }
+        iterator operator++(int)                    { iterator tmp = *this; m_idx++; return tmp; }
+        iterator &operator--()                      { m_idx--; return *this; }
+        iterator operator--(int)                    { iterator tmp = *this; m_idx--; return tmp; }
+
+        iterator &operator+=(const ptrdiff_t n)     { m_idx += n; return *this; }
+        iterator &operator-=(const ptrdiff_t n)     { m_idx -= n; return *this; }
+
+        iterator operator+(const ptrdiff_t n) const { return iterator(m_pData, (m_idx + n), m_stride); }
+        iterator operator-(const ptrdiff_t n) const { return iterator(m_pData, (m_idx - n), m_stride); }
+
+        friend iterator operator+(const ptrdiff_t n, const iterator &it) { return (it + n); }
+
+        ptrdiff_t operator-(const iterator &other) const { return (m_idx - other.m_idx); }
+
+        bool operator==(const iterator &other) const { return (m_idx == other.m_idx); }
+        bool operator!=(const iterator &other) const { return (m_idx != other.m_idx); }
+        bool operator<(const iterator &other) const  { return (m_idx < other.m_idx); }
+        bool operator>(const iterator &other) const  { return (m_idx > other.m_idx); }
+        bool operator<=(const iterator &other) const { return (m_idx <= other.m_idx); }
+        bool operator>=(const iterator &other) const { return (m_idx >= other.m_idx); }
+    };
+
+    typedef T           value_type;
+
+    CStridedBufferSpan() :
+        m_pData(nullptr),
+        m_count(0),
+        m_stride(1)
+    {
+    }
+
+    CStridedBufferSpan(T *pData, const size_t count, const size_t stride) :
+        m_pData(pData),
+        m_count((pData != nullptr) ? count : 0),
+        m_stride((stride > 0) ? stride : 1)
+    {
+    }
+
+    // A contiguous span is a strided span with a stride of 1
+    CStridedBufferSpan(const CBufferSpan<T> &span) :
+        m_pData(span.data()),
+        m_count(span.size()),
+        m_stride(1)
+    {
+    }
+
+    // Get the 1st element
+    T *data() const
+    {
+        return m_pData;
+    }
+
+    size_t size() const
+    {
+        return m_count;
+    }
+
+    size_t stride() const
+    {
+        return m_stride;
+    }
+
+    bool empty() const
+    {
+        return (m_count == 0);
+    }
+
+    bool isContiguous() const
+    {
+        return (m_stride == 1);
+    }
+
+    // Get the span as a contiguous span (empty if it is not contiguous),
+    // so a loop can be written for the (faster) contiguous case.
+    CBufferSpan<T> getContiguous() const
+    {
+        if (m_stride != 1)
+            return CBufferSpan<T>();
+
+        return CBufferSpan<T>(m_pData, m_count);
+    }
+
+    T &operator[](const size_t idx) const
+    {
+        assert(idx < m_count);
+
+        return m_pData[idx * m_stride];
+    }
+
+    iterator begin() const
+    {
+        return iterator(m_pData, 0, (ptrdiff_t) m_stride);
+    }
+
+    iterator end() const
+    {
+        return iterator(m_pData, (ptrdiff_t) m_count, (ptrdiff_t) m_stride);
+    }
+
+    // Get a view of "count" elements, starting at element
+    // "offset" (clipped to the end of this span)
+    CStridedBufferSpan<T> subspan(const size_t offset, const size_t count) const
+    {
+        if (offset >= m_count)
+            return CStridedBufferSpan<T>();
+
+        return CStridedBufferSpan<T>((m_pData + (offset * m_stride)), std::min(count, (m_count - offset)), m_stride);
+    }
+};
+
+
+#endif // _BUFFER_SPAN_H_
@@ -15,8 +15,16 @@
 #include <string>
 #include <vector>
 
+#include <cassert>
+#include <cstring>
+
 #include "../Error/CError.h"
 
+#include "AudioInterleave.h"
+#include "BufferSpan.h"
+#include "CBufferPool.h"
+#include "SampleConvert.h"
+
 
 #define interleavedAudioBufferOffset(ptr, chl, frm, nc)      *(ptr + (frm * nc) + chl)
 
@@ -38,10 +46,176 @@ class CSimpleAudioBuffer : public CErrorHandler
 
     T*            m_pBuffer;
 
+    CBufferAllocator *m_pAllocator;   // where m_pBuffer comes from
+    size_t        m_allocSize;    // size (in bytes) of the m_pBuffer allocation
+
     std::mutex    m_ioLock;
 
+    // Get the offset of a sample in m_pBuffer (no checks)
+    size_t getSampleOffset(const unsigned int chan, const unsigned int frame)
+    {
+        if (m_bInterleaved)
+            return ((size_t) frame * m_numChls) + chan;     // (frame_number * size_of_a_frame) + channel_number
+        else
+            return ((size_t) chan * m_blockSize) + frame;   // (channel_number * size_of_channel_block) + frame_number
+    }
+
   public:
 
+    // Scoped direct access to the sample data.  The buffer is locked
+    // (lockBuffer()) once, for the life of the CBlockAccess, so its
+    // accessors do no locking of their own.  Channel / frame numbers
+    // are only checked in debug builds (assert).
+    // NOTE: Don't call the (locking) buffer functions, ie: getSample(),
+    // free(), from the same thread while holding a CBlockAccess.
+    class CBlockAccess
+    {
+        CSimpleAudioBuffer<T>   *m_pOwner;
+
+        T               *m_pData;
+        unsigned int    m_numChls;
+        unsigned int    m_numFrames;
+        size_t          m_sampleStride;     // distance between 2 samples of a channel
+        size_t          m_channelStride;    // distance between 2 channels of a frame
+
+      public:
+
+        explicit CBlockAccess(CSimpleAudioBuffer<T> &buffer) :
+            m_pOwner(&buffer)
+        {
+            buffer.lockBuffer();
+
+            m_pData         = buffer.m_bAllocated ? buffer.m_pBuffer : nullptr;
+            m_numChls       = (m_pData != nullptr) ? buffer.m_numChls : 0;
+            m_numFrames     = (m_pData != nullptr) ? buffer.m_blockSize : 0;
+            m_sampleStride  = buffer.m_bInterleaved ? buffer.m_numChls : 1;
+            m_channelStride = buffer.m_bInterleaved ? 1 : buffer.m_blockSize;
+        }
+
+        CBlockAccess(CBlockAccess &&other) noexcept :
+            m_pOwner(other.m_pOwner),
+            m_pData(other.m_pData),
+            m_numChls(other.m_numChls),
+            m_numFrames(other.m_numFrames),
+            m_sampleStride(other.m_sampleStride),
+            m_channelStride(other.m_channelStride)
+        {
+            other.m_pOwner = nullptr;
+            other.m_pData = nullptr;
+            other.m_numChls = 0;
+            other.m_numFrames = 0;
+        }
+
+        ~CBlockAccess()
+        {
+            release();
+        }
+
+        CBlockAccess(const CBlockAccess &) = delete;
+        CBlockAccess &operator=(const CBlockAccess &) = delete;
+        CBlockAccess &operator=(CBlockAccess &&) = delete;
+
+        // Unlock the buffer (before the end of the scope)
+        void release()
+        {
+            if (m_pOwner == nullptr)
+                return;
+
+            m_pOwner->unlockBuffer();
+
+            m_pOwner = nullptr;
+            m_pData = nullptr;
+            m_numChls = 0;
+            m_numFrames = 0;
+        }
+
+        // false = released, or the buffer is not allocated
+        bool isValid()
+        {
+            return (m_pData != nullptr);
+        }
+
+        unsigned int getNumChannels()
+        {
+            return m_numChls;
+        }
+
+        unsigned int getNumFrames()
+        {
+            return m_numFrames;
+        }
+
+        size_t getSampleStride()
+        {
+            return m_sampleStride;
+        }
+
+        size_t getChannelStride()
+        {
+            return m_channelStride;
+        }
+
+        T &at(const unsigned int chan, const unsigned int frame)
+        {
+            assert(chan < m_numChls && frame < m_numFrames);
+
+            return m_pData[(chan * m_channelStride) + (frame * m_sampleStride)];
+        }
+
+        T &operator()(const unsigned int chan, const unsigned int frame)
+        {
+            return at(chan, frame);
+        }
+
+        // Get the 1st sample of a channel (the next
+        // sample is getSampleStride() samples on).
+        T *getChannelPtr(const unsigned int chan)
+        {
+            assert(chan < m_numChls);
+
+            return (m_pData + (chan * m_channelStride));
+        }
+
+        // Get the 1st sample of a frame (the next
+        // channel is getChannelStride() samples on).
+        T *getFramePtr(const unsigned int frame)
+        {
+            assert(frame < m_numFrames);
+
+            return (m_pData + (frame * m_sampleStride));
+        }
+
+        // Get a view of the samples of a channel
+        CStridedBufferSpan<T> getChannelSpan(const unsigned int chan)
+        {
+            if (chan >= m_numChls)
+                return CStridedBufferSpan<T>();
+
+            return CStridedBufferSpan<T>((m_pData + (chan * m_channelStride)), m_numFrames, m_sampleStride);
+        }
+
+        // Get a view of the channels of a frame
+        CStridedBufferSpan<T> getFrameSpan(const unsigned int frame)
+        {
+            if (frame >= m_numFrames)
+                return CStridedBufferSpan<T>();
+
+            return CStridedBufferSpan<T>((m_pData + (frame * m_sampleStride)), m_numChls, m_channelStride);
+        }
+
+        template <class Fn> void forEachChannel(Fn &&fn)
+        {
+            if (m_pOwner != nullptr)
+                m_pOwner->forEachChannel(fn);
+        }
+
+        template <class Fn> void forEachFrame(Fn &&fn)
+        {
+            if (m_pOwner != nullptr)
+                m_pOwner->forEachFrame(fn);
+        }
+    };
+
     CSimpleAudioBuffer(bool bInterleaved = false) :
         m_numChls(1),
         m_bAllocated(false)
@@ -54,6 +228,9 @@ class CSimpleAudioBuffer : public CErrorHandler
         m_writeIdx      = 0;
 
         m_pBuffer       = nullptr;
+
+        m_pAllocator    = getDefaultBufferAllocator();
+        m_allocSize     = 0;
     }
 
     ~CSimpleAudioBuffer()
@@ -83,6 +260,11 @@ class CSimpleAudioBuffer : public CErrorHandler
         return m_numChls;
     }
 
+    bool isInterleaved()
+    {
+        return m_bInterleaved;
+    }
+
     void setSamplesPerBlock(unsigned int blockSize)
     {
         if (m_bAllocated)
@@ -121,6 +303,20 @@ class CSimpleAudioBuffer : public CErrorHandler
         return true;
     }
 
+    // Set the allocator the sample data buffer comes from
+    // (default = the shared 64 byte aligned buffer pool).
+    bool setAllocator(CBufferAllocator *pAllocator)
+    {
+        if (m_bAllocated || pAllocator == nullptr)
+        {
+            return false;
+        }
+
+        m_pAllocator = pAllocator;
+
+        return true;
+    }
+
     bool alloc(unsigned int blockSize = 0)
     {
         if (blockSize > 0)
@@ -136,9 +332,16 @@ class CSimpleAudioBuffer : public CErrorHandler
             return false;
         }
 
+        if (m_bAllocated)
+        {
+            free();
+        }
+
         m_arraySize = (m_blockSize * m_numChls); // arraySize = total numner of samples in the buffer
 
-        m_pBuffer = (T*) calloc(m_arraySize, sizeof(T));
+        size_t numBytes = (m_arraySize * sizeof(T));
+
+        m_pBuffer = (T*) m_pAllocator->allocate(numBytes);
 
         if (m_pBuffer == nullptr)
         {
@@ -147,6 +350,9 @@ class CSimpleAudioBuffer : public CErrorHandler
             return false;
         }
 
+        memset(m_pBuffer, 0, numBytes);
+
+        m_allocSize  = numBytes;
         m_bAllocated = true;
 
         return true;
@@ -175,7 +381,7 @@ class CSimpleAudioBuffer : public CErrorHandler
         {
             try
             {
-                ::free(m_pBuffer);
+                m_pAllocator->deallocate(m_pBuffer, m_allocSize);
             }
             catch (...)
             {
@@ -183,6 +389,7 @@ class CSimpleAudioBuffer : public CErrorHandler
         }
 
         m_pBuffer = nullptr;
+        m_allocSize = 0;
 
         m_bAllocated = false;
     }
@@ -308,51 +515,105 @@ class CSimpleAudioBuffer : public CErrorHandler
         m_ioLock.unlock();
     }
 
-    T getSample(unsigned int chan, unsigned int frame)
+    // Lock the buffer, for direct (unlocked) sample access, until
+    // the returned CBlockAccess goes out of scope.  Use this (rather
+    // than getSample() / setSample()) for per-sample loops.
+    CBlockAccess getBlockAccess()
     {
-        std::lock_guard<std::mutex> lock(m_ioLock);
+        return CBlockAccess(*this);
+    }
 
-        if (m_numChls < 1 || chan > m_numChls || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated)
-        {            
-            return 0;
+    // Get a view of all the samples of the buffer (in buffer order)
+    CBufferSpan<T> getSampleSpan()
+    {
+        if (!m_bAllocated)
+        {
+            return CBufferSpan<T>();
         }
 
-        unsigned int offset;
+        return CBufferSpan<T>(m_pBuffer, m_arraySize);
+    }
 
-        if (m_bInterleaved)
-            offset = (frame * m_numChls) + chan; // interleaved offset = (frame_number * size_of_a_frame) + channel_number
-        else
-            offset = (chan * m_blockSize) + frame;   // non-interleaved offset = (channel_number * size_of_channel_block) + frame_number
+    // Get a view of the samples of a channel (contiguous if
+    // the buffer is not interleaved, strided if it is).
+    // NOTE: The buffer is NOT locked (see getBlockAccess()).
+    CStridedBufferSpan<T> getChannelSpan(const unsigned int chan)
+    {
+        if (!m_bAllocated || chan >= m_numChls)
+        {
+            return CStridedBufferSpan<T>();
+        }
 
-        if (offset >= m_arraySize)
+        return CStridedBufferSpan<T>((m_pBuffer + getSampleOffset(chan, 0)), m_blockSize, (m_bInterleaved ? m_numChls : 1));
+    }
+
+    // Get a view of the channels of a frame (contiguous if
+    // the buffer is interleaved, strided if it is not).
+    // NOTE: The buffer is NOT locked (see getBlockAccess()).
+    CStridedBufferSpan<T> getFrameSpan(const unsigned int frame)
+    {
+        if (!m_bAllocated || frame >= m_blockSize)
         {
-            return 0;
+            return CStridedBufferSpan<T>();
         }
 
-        return *(m_pBuffer + offset);
+        return CStridedBufferSpan<T>((m_pBuffer + getSampleOffset(0, frame)), m_numChls, (m_bInterleaved ? 1 : m_blockSize));
     }
 
-    void setSample(unsigned int chan, unsigned int frame, T value)
+    // Call fn(chan, pSamples, stride) for every channel, where
+    // pSamples[n * stride] is sample (frame) n of the channel.
+    // NOTE: The buffer is NOT locked (see getBlockAccess()).
+    template <class Fn> void forEachChannel(Fn &&fn)
     {
-        std::lock_guard<std::mutex> lock(m_ioLock);
+        if (!m_bAllocated)
+        {
+            return;
+        }
+
+        size_t stride = m_bInterleaved ? m_numChls : 1;
 
-        if (m_numChls < 1 || chan > m_numChls || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated)
+        for (unsigned int chan = 0; chan < m_numChls; chan++)
+            fn(chan, (m_pBuffer + getSampleOffset(chan, 0)), stride);
+    }
+
+    // Call fn(frame, pSamples, stride) for every frame, where
+    // pSamples[n * stride] is channel n of the frame.
+    // NOTE: The buffer is NOT locked (see getBlockAccess()).
+    template <class Fn> void forEachFrame(Fn &&fn)
+    {
+        if (!m_bAllocated)
         {
             return;
         }
 
-        unsigned int offset;
-        if (m_bInterleaved)
-            offset = (frame * m_numChls) + chan; // interleaved offset = (frame_number * size_of_a_frame) + channel_number
-        else
-            offset = (chan * m_blockSize) + frame;   // non-interleaved offset = (channel_number * size_of_channel_block) + frame_number
+        size_t stride = m_bInterleaved ? 1 : m_blockSize;
 
-        if (offset >= m_arraySize)
+        for (unsigned int frame = 0; frame < m_blockSize; frame++)
+            fn(frame, (m_pBuffer + getSampleOffset(0, frame)), stride);
+    }
+
+    T getSample(unsigned int chan, unsigned int frame)
+    {
+        std::lock_guard<std::mutex> lock(m_ioLock);
+
+        if (m_numChls < 1 || chan >= m_numChls || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated)
+        {            
+            return 0;
+        }
+
+        return *(m_pBuffer + getSampleOffset(chan, frame));
+    }
+
+    void setSample(unsigned int chan, unsigned int frame, T value)
+    {
+        std::lock_guard<std::mutex> lock(m_ioLock);
+
+        if (m_numChls < 1 || chan >= m_numChls || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated)
         {
             return;
         }
 
-        *(m_pBuffer + offset) = value;
+        *(m_pBuffer + getSampleOffset(chan, frame)) = value;
     }
 
     void resetReadIndex()
@@ -626,6 +887,9 @@ template <class T> class CAudioBufferBase
 
     T           *m_pBuff;
 
+    CBufferAllocator *m_pAllocator;     // where m_pBuff comes from
+    size_t       m_allocSize;           // size (in bytes) of the m_pBuff allocation
+
     unsigned int m_numChls;
     unsigned int m_samplesPerBlock;
     unsigned int m_totalNumSamples;
@@ -655,18 +919,30 @@ template <class T> class CAudioBufferBase
 
         m_totalNumSamples = (m_numChls * m_samplesPerBlock);
 
-        if (m_pBuff != nullptr)
-            free(m_pBuff);
-
-        m_pBuff = (T *) calloc(m_totalNumSamples, sizeof(T));
+        size_t numBytes = (m_totalNumSamples * sizeof(T));
 
-        if (m_pBuff == nullptr)
+        // Re-use the current buffer if it is big enough
+        if (m_pBuff == nullptr || numBytes > m_allocSize)
         {
-            m_totalNumSamples = 0;
+            if (m_pBuff != nullptr)
+                m_pAllocator->deallocate(m_pBuff, m_allocSize);
 
-            return;
+            m_pBuff = (T *) m_pAllocator->allocate(numBytes);
+
+            if (m_pBuff == nullptr)
+            {
+                m_totalNumSamples = 0;
+                m_allocSize       = 0;
+                m_bAllocated      = false;
+
+                return;
+            }
+
+            m_allocSize = m_pAllocator->getAllocSize(numBytes);
         }
 
+        memset(m_pBuff, 0, numBytes);
+
         m_bAllocated = true;
     }
 
@@ -683,10 +959,11 @@ template <class T> class CAudioBufferBase
 
     void freeBuffer()
     {
-        if (m_pBuff == nullptr)
-            ::free(m_pBuff);
+        if (m_pBuff != nullptr)
+            m_pAllocator->deallocate(m_pBuff, m_allocSize);
 
         m_pBuff           = nullptr;
+        m_allocSize       = 0;
         m_bAllocated      = false;
         m_totalNumSamples = 0;
     }
@@ -695,6 +972,8 @@ template <class T> class CAudioBufferBase
     CAudioBufferBase()
     {
         m_pBuff           = nullptr;
+        m_pAllocator      = getDefaultBufferAllocator();
+        m_allocSize       = 0;
         m_numChls         = 0;
         m_samplesPerBlock = 0;
         m_totalNumSamples = 0;
@@ -719,6 +998,8 @@ template <class T> class CAudioBufferBase
         m_numChls(numChls)
     {
         m_pBuff           = nullptr;
+        m_pAllocator      = getDefaultBufferAllocator();
+        m_allocSize       = 0;
         m_samplesPerBlock = 0;
         m_totalNumSamples = 0;
         m_bAllocated      = false;
@@ -743,7 +1024,10 @@ template <class T> class CAudioBufferBase
         m_samplesPerBlock(samplesPerBlk)
     {
         m_pBuff           = nullptr;
+        m_pAllocator      = getDefaultBufferAllocator();
+        m_allocSize       = 0;
         m_totalNumSamples = 0;
+        m_bAllocated      = false;
 
 #ifdef SUPPORT_FILE_IO
         m_sInputFile  = "";
@@ -772,11 +1056,23 @@ template <class T> class CAudioBufferBase
 #endif
 
         if (m_pBuff != nullptr)
-            free(m_pBuff);
+            m_pAllocator->deallocate(m_pBuff, m_allocSize);
 
         m_pBuff = nullptr;
     }
 
+    // Set the allocator the sample buffer comes from
+    // (default = the shared 64 byte aligned buffer pool).
+    bool setAllocator(CBufferAllocator *pAllocator)
+    {
+        if (m_pBuff != nullptr || pAllocator == nullptr)
+            return false;
+
+        m_pAllocator = pAllocator;
+
+        return true;
+    }
+
     // Set number of channels
     void setNumChannels(const unsigned int numChls)
     {
@@ -827,6 +1123,15 @@ template <class T> class CAudioBufferBase
         return m_pBuff;
     }
 
+    // Get a view of all the samples of the buffer (in buffer order)
+    CBufferSpan<T> getSampleSpan()
+    {
+        if (!initialized())
+            return CBufferSpan<T>();
+
+        return CBufferSpan<T>(m_pBuff, m_totalNumSamples);
+    }
+
     // Clear the sample buffer (set it to zeros)
     void clear()
     {
@@ -984,6 +1289,24 @@ template <class T> class CInterleavedBuffer : public CAudioBufferBase<T>
     {
     }
 
+    // Get a view of the samples of a channel
+    CStridedBufferSpan<T> getChannelSpan(const unsigned int chan)
+    {
+        if (!CAudioBufferBase<T>::initialized() || chan >= CAudioBufferBase<T>::m_numChls)
+            return CStridedBufferSpan<T>();
+
+        return CStridedBufferSpan<T>((CAudioBufferBase<T>::m_pBuff + chan), CAudioBufferBase<T>::m_samplesPerBlock, CAudioBufferBase<T>::m_numChls);
+    }
+
+    // Get a view of the (contiguous) channels of a frame
+    CBufferSpan<T> getFrameSpan(const unsigned int frame)
+    {
+        if (!CAudioBufferBase<T>::initialized() || frame >= CAudioBufferBase<T>::m_samplesPerBlock)
+            return CBufferSpan<T>();
+
+        return CBufferSpan<T>((CAudioBufferBase<T>::m_pBuff + ((size_t) frame * CAudioBufferBase<T>::m_numChls)), CAudioBufferBase<T>::m_numChls);
+    }
+
     // Set the value of a sample within the buffer
     void setSample(const size_t chan, const size_t frame, const T value)
     {
@@ -1038,6 +1361,24 @@ template <class T> class CNonInterleavedBuffer : public CAudioBufferBase<T>
     {
     }
 
+    // Get a view of the (contiguous) samples of a channel
+    CBufferSpan<T> getChannelSpan(const unsigned int chan)
+    {
+        if (!CAudioBufferBase<T>::initialized() || chan >= CAudioBufferBase<T>::m_numChls)
+            return CBufferSpan<T>();
+
+        return CBufferSpan<T>((CAudioBufferBase<T>::m_pBuff + ((size_t) chan * CAudioBufferBase<T>::m_samplesPerBlock)), CAudioBufferBase<T>::m_samplesPerBlock);
+    }
+
+    // Get a view of the channels of a frame
+    CStridedBufferSpan<T> getFrameSpan(const unsigned int frame)
+    {
+        if (!CAudioBufferBase<T>::initialized() || frame >= CAudioBufferBase<T>::m_samplesPerBlock)
+            return CStridedBufferSpan<T>();
+
+        return CStridedBufferSpan<T>((CAudioBufferBase<T>::m_pBuff + frame), CAudioBufferBase<T>::m_numChls, CAudioBufferBase<T>::m_samplesPerBlock);
+    }
+
     // Set the value of a sample within the buffer
     void setSample(const size_t chan, const size_t index, const T value)
     {
@@ -1085,4 +1426,85 @@ template <class T> class CNonInterleavedBuffer : public CAudioBufferBase<T>
     }
 };
 
+// Copy (de-interleave) all the frames of an interleaved buffer
+// into a non-interleaved buffer, in bulk.
+// Returns the number of frames copied (0 = buffers not compatible).
+template <class T> unsigned int deinterleaveBuffer(CNonInterleavedBuffer<T> &target, CInterleavedBuffer<T> &source)
+{
+    if (!source.initialized() || !target.initialized())
+    {
+        return 0;
+    }
+
+    if (source.getNumChannels() != target.getNumChannels())
+    {
+        return 0;
+    }
+
+    unsigned int numFrames = source.getSamplesPerBock();
+
+    if (numFrames > target.getSamplesPerBock())
+        numFrames = target.getSamplesPerBock();
+
+    deinterleaveSamples(target.getBuffPtr(), target.getSamplesPerBock(), source.getBuffPtr(), source.getNumChannels(), numFrames);
+
+    return numFrames;
+}
+
+// Copy (interleave) all the frames of a non-interleaved buffer
+// into an interleaved buffer, in bulk.
+// Returns the number of frames copied (0 = buffers not compatible).
+template <class T> unsigned int interleaveBuffer(CInterleavedBuffer<T> &target, CNonInterleavedBuffer<T> &source)
+{
+    if (!source.initialized() || !target.initialized())
+    {
+        return 0;
+    }
+
+    if (source.getNumChannels() != target.getNumChannels())
+    {
+        return 0;
+    }
+
+    unsigned int numFrames = source.getSamplesPerBock();
+
+    if (numFrames > target.getSamplesPerBock())
+        numFrames = target.getSamplesPerBock();
+
+    interleaveSamples(target.getBuffPtr(), source.getBuffPtr(), source.getSamplesPerBock(), source.getNumChannels(), numFrames);
+
+    return numFrames;
+}
+
+// Convert the samples of one buffer to the sample type of another
+// (ie: int16 -> float), in bulk.  Both buffers must be the same
+// size (and should use the same layout).
+template <class TTarget, class TSource> bool convertBuffer
+    (
+        CAudioBufferBase<TTarget> &target, 
+        CAudioBufferBase<TSource> &source, 
+        const int flags = SAMPLE_CONVERT_CLIP
+    )
+{
+    if (!source.initialized() || !target.initialized())
+    {
+        return false;
+    }
+
+    if (target.getSize() != source.getSize())
+    {
+        return false;
+    }
+
+    return convertSamples
+        (
+            target.getBuffPtr(), 
+            getSampleFormat<TTarget>(), 
+            source.getBuffPtr(), 
+            getSampleFormat<TSource>(), 
+            source.getSize(), 
+            flags
+        );
+}
+
 #endif // _AUDIO_BUFFER_CLASS_H
@@ -11,8 +11,11 @@
 #ifndef _CBuffer_H_
 #define _CBuffer_H_
 
+#include <string>
 #include <vector>
 
+#include <cstring>
+
 
 class CBuffer : 
 	public std::vector<unsigned char>
@@ -29,18 +32,19 @@ public:
 
 	}
 
+	//* (the destructor above would otherwise disable the moves)
+
+	CBuffer(const CBuffer &) = default;
+	CBuffer(CBuffer &&) noexcept = default;
+
+	CBuffer &operator=(const CBuffer &) = default;
+	CBuffer &operator=(CBuffer &&) noexcept = default;
+
+	//* empty the buffer (keeps the capacity, for the next message)
+
 	void clear()
 	{
-		try
-		{
-			if (size() > 0)
-			{
-				resize(0);
-			}
-		}
-		catch (...)
-		{
-		}
+		vector::clear();
 	}
 
 	void assign(const CBuffer &rVal)
@@ -62,7 +66,7 @@ public:
 		}
 	}
 
-	void assign(const std::string sVal)
+	void assign(const std::string &sVal)
 	{
 		try
 		{
@@ -75,12 +79,9 @@ public:
 
 			if (nLen > 0)
 			{
-				//vector::assign(sVal.begin(), sVal.end());
-
-				//this->resize(nLen + 1);
-				this->resize(nLen);
+				//* copy straight in (no zero fill, re-uses the capacity)
 
-				memcpy((this->data()), (sVal.data()), nLen);
+				vector::assign((const unsigned char *) sVal.data(), ((const unsigned char *) sVal.data() + nLen));
 			}
 			//else
 			//{
@@ -109,10 +110,7 @@ public:
 				return;
 			}
 
-			//this->resize(nLen + 1);
-			this->resize(nLen);
-
-			memcpy((this->data()), pVal, nLen);
+			vector::assign((const unsigned char *) pVal, ((const unsigned char *) pVal + nLen));
 		}
 		catch (...)
 		{
@@ -242,14 +240,18 @@ public:
 			{
 				//* copy the new buffer data to the end of the current buffer data
 
-				//unsigned long nNewSize = (nCurBufSize + nCopySize + 1);
-				unsigned long nNewSize = (nCurBufSize + nCopySize);
+				//* (grows geometrically, so repeated appends are amortised O(1))
 
-				this->resize(nNewSize);
+				if (&rVal == this)
+				{
+					this->resize(nCurBufSize + nCopySize);
 
-				unsigned char *pData = (this->data() + nCurBufSize);
-
-				memcpy(pData, (rVal.data()), nCopySize);
+					memcpy((this->data() + nCurBufSize), this->data(), nCopySize);
+				}
+				else
+				{
+					vector::insert(end(), rVal.data(), (rVal.data() + nCopySize));
+				}
 
 				//* add a NULL char to the end of the buffer;
 
@@ -261,25 +263,16 @@ public:
 		}
 	}
 
-	void append(std::string sVal)
+	void append(const std::string &sVal)
 	{
 		try
 		{
-			unsigned long nCurBufSize = (unsigned long) this->size();
-
 			unsigned long nCopySize = (unsigned long) sVal.size();
 			if (nCopySize > 0)
 			{
 				//* copy the new buffer data to the end of the current buffer data
 
-				//unsigned long nNewSize = (nCurBufSize + nCopySize + 1);
-				unsigned long nNewSize = (nCurBufSize + nCopySize);
-
-				this->resize(nNewSize);
-
-				unsigned char *pData = (this->data() + nCurBufSize);
-
-				memcpy(pData, (sVal.data()), nCopySize);
+				vector::insert(end(), (const unsigned char *) sVal.data(), ((const unsigned char *) sVal.data() + nCopySize));
 
 				//* add a NULL char to the end of the buffer;
 
@@ -300,20 +293,11 @@ public:
 
 		try
 		{
-			unsigned long nCurBufSize = (unsigned long) this->size();
-
 			if (nLen > 0)
 			{
 				//* copy the new buffer data to the end of the current buffer data
 
-				//unsigned long nNewSize = (nCurBufSize + nLen + 1);
-				unsigned long nNewSize = (nCurBufSize + nLen);
-
-				this->resize(nNewSize);
-
-				unsigned char *pData = (this->data() + nCurBufSize);
-
-				memcpy(pData, pVal, nLen);
+				vector::insert(end(), (const unsigned char *) pVal, ((const unsigned char *) pVal + nLen));
 
 				//* add a NULL char to the end of the buffer;
 
@@ -336,17 +320,14 @@ public:
 		{
 			//* if the buffer is currently too small... pad it with NULL bytes
 			
-			for (int x = (int)size(); x < (int) nPos; x++)
+			if (size() < nPos)
 			{
-				push_back((unsigned char) 0);
+				resize(nPos, (unsigned char) 0);
 			}
 
-			//* insert bytes into buffer
+			//* insert bytes into buffer (the tail is moved once)
 
-			for (int b = 0; b < nLen; b++)
-			{
-				vector::insert((begin() + (nPos + b)), cVal);
-			}
+			vector::insert((begin() + nPos), (size_t) nLen, cVal);
 		}
 		catch (...)
 		{
@@ -364,17 +345,14 @@ public:
 		{
 			//* if the buffer is currently too small... pad it with NULL bytes
 
-			for (int x = (int) size(); x < (int) nPos; x++)
+			if (size() < nPos)
 			{
-				this->push_back((unsigned char) 0);
+				this->resize(nPos, (unsigned char) 0);
 			}
 
-			//* insert bytes into buffer
+			//* insert bytes into buffer (the tail is moved once)
 
-			for (int b = 0; b < nLen; b++)
-			{
-				vector::insert((begin() + (nPos + b)), ((unsigned char) *(pVal + b)));
-			}
+			vector::insert((begin() + nPos), (const unsigned char *) pVal, ((const unsigned char *) pVal + nLen));
 		}
 		catch (...)
 		{
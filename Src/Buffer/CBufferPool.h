@@ -0,0 +1,362 @@
+//****************************************************************************
+// FILE:    CBufferPool.h
+//
+// DESC:    Pluggable (aligned) memory allocators for the buffer classes.
+//
+//          CAlignedAllocator allocates directly from the heap, with a
+//          given alignment (default 64 bytes, so SIMD loads of any
+//          width can be aligned).
+//
+//          CBufferPool rounds requests up to a power of 2 size class,
+//          and keeps released buffers on a per class free list, so
+//          buffers of common (block) sizes are recycled instead of
+//          going back to the heap.  The free lists hold at most
+//          BUFFER_POOL_MAX_FREE_PER_CLASS buffers per class, and
+//          BUFFER_POOL_MAX_FREE_BYTES in total (so a burst of large
+//          buffers doesn't stay pinned), and trim() releases them.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _BUFFER_POOL_H_
+#define _BUFFER_POOL_H_
+
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <cstddef>
+#include <cstdlib>
+
+#ifdef WINDOWS
+#include <malloc.h>
+#endif
+
+
+#define DEFAULT_BUFFER_ALIGNMENT        64
+
+#define BUFFER_POOL_MIN_CLASS_SIZE      256                 // bytes
+#define BUFFER_POOL_NUM_SIZE_CLASSES    17                  // 256 bytes to 16 MB
+#define BUFFER_POOL_MAX_FREE_PER_CLASS  64
+#define BUFFER_POOL_MAX_FREE_BYTES      (64 * 1024 * 1024)  // total cached in the free lists
+
+
+// Allocate "numBytes" of memory aligned to "alignment"
+// (a power of 2), or nullptr on failure.
+inline void *alignedAlloc(const size_t numBytes, const size_t alignment = DEFAULT_BUFFER_ALIGNMENT)
+{
+    if (numBytes < 1)
+        return nullptr;
+
+#ifdef WINDOWS
+    return _aligned_malloc(numBytes, alignment);
+#else
+    void *pMem = nullptr;
+
+    if (posix_memalign(&pMem, std::max(alignment, sizeof(void *)), numBytes) != 0)
+        return nullptr;
+
+    return pMem;
+#endif
+}
+
+// Free memory allocated by alignedAlloc()
+inline void alignedFree(void *pMem)
+{
+    if (pMem == nullptr)
+        return;
+
+#ifdef WINDOWS
+    _aligned_free(pMem);
+#else
+    ::free(pMem);
+#endif
+}
+
+
+// Allocator interface used by the buffer classes
+class CBufferAllocator
+{
+  public:
+
+    virtual ~CBufferAllocator()
+    {
+    }
+
+    // Allocate (at least) numBytes, or return nullptr.
+    // NOTE: The memory is NOT zeroed.
+    virtual void *allocate(const size_t numBytes) = 0;
+
+    // Release memory returned by allocate().  "numBytes" must be
+    // the size that was asked for (or the getAllocSize() of it).
+    virtual void deallocate(void *pMem, const size_t numBytes) = 0;
+
+    // Get the number of bytes that allocate(numBytes) really
+    // provides (so a buffer can be re-used for a smaller size).
+    virtual size_t getAllocSize(const size_t numBytes)
+    {
+        return numBytes;
+    }
+
+    // Release cached (free) memory, until no more than maxFreeBytes
+    // is kept (for allocators that cache).
+    virtual void trim(const size_t maxFreeBytes = 0)
+    {
+        (void) maxFreeBytes;
+    }
+};
+
+
+// Allocates directly from the heap, with a fixed alignment
+class CAlignedAllocator : public CBufferAllocator
+{
+    size_t      m_alignment;
+
+  public:
+
+    CAlignedAllocator(const size_t alignment = DEFAULT_BUFFER_ALIGNMENT)
+    {
+        m_alignment = alignment;
+    }
+
+    void *allocate(const size_t numBytes) override
+    {
+        return alignedAlloc(numBytes, m_alignment);
+    }
+
+    void deallocate(void *pMem, const size_t numBytes) override
+    {
+        (void) numBytes;
+
+        alignedFree(pMem);
+    }
+
+    size_t getAlignment()
+    {
+        return m_alignment;
+    }
+};
+
+
+// Recycles (aligned) buffers by power of 2 size class.
+// Requests larger than the biggest size class go straight to the heap.
+class CBufferPool : public CBufferAllocator
+{
+    struct SSizeClass
+    {
+        std::mutex              lock;
+        std::vector<void *>     freeList;
+    };
+
+    size_t                  m_alignment;
+    size_t                  m_maxFreePerClass;
+    size_t                  m_maxFreeBytes;
+
+    SSizeClass              m_sizeClasses[BUFFER_POOL_NUM_SIZE_CLASSES];
+
+    std::atomic<size_t>     m_nAllocs;          // total allocate() calls
+    std::atomic<size_t>     m_nReused;          // ... that were served from a free list
+    std::atomic<size_t>     m_nFreeBytes;       // bytes cached in the free lists
+
+  protected:
+
+    // Get the size class for numBytes (-1 = too big to pool)
+    int getSizeClass(const size_t numBytes)
+    {
+        size_t classSize = BUFFER_POOL_MIN_CLASS_SIZE;
+
+        for (int idx = 0; idx < BUFFER_POOL_NUM_SIZE_CLASSES; idx++)
+        {
+            if (numBytes <= classSize)
+                return idx;
+
+            classSize <<= 1;
+        }
+
+        return -1;
+    }
+
+    size_t getClassSize(const int idx)
+    {
+        return ((size_t) BUFFER_POOL_MIN_CLASS_SIZE << idx);
+    }
+
+  public:
+
+    CBufferPool
+        (
+            const size_t alignment = DEFAULT_BUFFER_ALIGNMENT,
+            const size_t maxFreePerClass = BUFFER_POOL_MAX_FREE_PER_CLASS,
+            const size_t maxFreeBytes = BUFFER_POOL_MAX_FREE_BYTES
+        ) :
+        m_nAllocs(0),
+        m_nReused(0),
+        m_nFreeBytes(0)
+    {
+        m_alignment = alignment;
+        m_maxFreePerClass = maxFreePerClass;
+        m_maxFreeBytes = maxFreeBytes;
+    }
+
+    ~CBufferPool() override
+    {
+        trim();
+    }
+
+    CBufferPool(const CBufferPool &) = delete;
+    CBufferPool &operator=(const CBufferPool &) = delete;
+
+    void *allocate(const size_t numBytes) override
+    {
+        if (numBytes < 1)
+            return nullptr;
+
+        m_nAllocs++;
+
+        int idx = getSizeClass(numBytes);
+
+        if (idx < 0)
+            return alignedAlloc(numBytes, m_alignment);
+
+        {
+            std::lock_guard<std::mutex> lock{m_sizeClasses[idx].lock};
+
+            auto &freeList = m_sizeClasses[idx].freeList;
+
+            if (freeList.empty() == false)
+            {
+                void *pMem = freeList.back();
+                freeList.pop_back();
+
+                m_nFreeBytes -= getClassSize(idx);
+                m_nReused++;
+
+                return pMem;
+            }
+        }
+
+        return alignedAlloc(getClassSize(idx), m_alignment);
+    }
+
+    void deallocate(void *pMem, const size_t numBytes) override
+    {
+        if (pMem == nullptr)
+            return;
+
+        int idx = getSizeClass(numBytes);
+
+        if (idx >= 0)
+        {
+            std::lock_guard<std::mutex> lock{m_sizeClasses[idx].lock};
+
+            auto &freeList = m_sizeClasses[idx].freeList;
+
+            if (freeList.size() < m_maxFreePerClass)
+            {
+                size_t classSize = getClassSize(idx);
+
+                // (reserve the bytes first, so 2 classes can't both go over the cap)
+                if ((m_nFreeBytes.fetch_add(classSize) + classSize) <= m_maxFreeBytes)
+                {
+                    freeList.push_back(pMem);
+                    return;
+                }
+
+                m_nFreeBytes -= classSize;
+            }
+        }
+
+        alignedFree(pMem);
+    }
+
+    size_t getAllocSize(const size_t numBytes) override
+    {
+        int idx = getSizeClass(numBytes);
+
+        if (idx < 0)
+            return numBytes;
+
+        return getClassSize(idx);
+    }
+
+    // Free the (cached) buffers on the free lists, largest size class
+    // first, until no more than maxFreeBytes are cached (0 = free them all)
+    void trim(const size_t maxFreeBytes = 0) override
+    {
+        for (int idx = (BUFFER_POOL_NUM_SIZE_CLASSES - 1); idx >= 0; idx--)
+        {
+            std::lock_guard<std::mutex> lock{m_sizeClasses[idx].lock};
+
+            auto &freeList = m_sizeClasses[idx].freeList;
+
+            while (freeList.empty() == false && m_nFreeBytes.load() > maxFreeBytes)
+            {
+                alignedFree(freeList.back());
+                freeList.pop_back();
+
+                m_nFreeBytes -= getClassSize(idx);
+            }
+        }
+    }
+
+    // Get the number of bytes cached in the free lists
+    size_t getFreeBytes()
+    {
+        return m_nFreeBytes.load();
+    }
+
+    size_t getNumAllocs()
+    {
+        return m_nAllocs.load();
+    }
+
+    size_t getNumReused()
+    {
+        return m_nReused.load();
+    }
+
+    size_t getAlignment()
+    {
+        return m_alignment;
+    }
+};
+
+
+// The allocator used by new buffers (unless they are given one).
+// The default is a (process wide) 64 byte aligned CBufferPool.
+inline std::atomic<CBufferAllocator *> &defaultBufferAllocator()
+{
+    // never deleted, so buffers released during static
+    // destruction still have a valid pool
+    static std::atomic<CBufferAllocator *> pAllocator{new CBufferPool()};
+
+    return pAllocator;
+}
+
+inline CBufferAllocator *getDefaultBufferAllocator()
+{
+    return defaultBufferAllocator().load();
+}
+
+// Replace the default allocator (safe while other threads allocate).
+// Buffers already allocated keep (and release their memory to) the
+// allocator they were created with, so the old allocator must not be
+// deleted while they exist.
+inline void setDefaultBufferAllocator(CBufferAllocator *pAllocator)
+{
+    if (pAllocator != nullptr)
+        defaultBufferAllocator().store(pAllocator);
+}
+
+// Release the memory cached by the default allocator, down to
+// maxFreeBytes (ie: after a burst of large buffers)
+inline void trimDefaultBufferAllocator(const size_t maxFreeBytes = 0)
+{
+    getDefaultBufferAllocator()->trim(maxFreeBytes);
+}
+
+
+#endif // _BUFFER_POOL_H_
@@ -0,0 +1,479 @@
+//****************************************************************************
+// FILE:    CByteBuffer.h
+//
+// DESC:    A (move only) byte buffer with inline small buffer storage,
+//          for building protocol frames / network messages.
+//
+//          Up to "InlineSize" bytes are held inside the object, so short
+//          messages need no heap allocation at all.  Larger buffers grow
+//          geometrically (amortised O(1) append), clear() and assign()
+//          keep the capacity, and insert() moves the tail once (O(n)).
+//
+//          It has the assign() / append() / insert() / getStr() interface
+//          of CBuffer, plus the common std::vector style functions
+//          (size(), data(), begin(), resize(), reserve(), push_back() ...).
+//
+//          Copying is explicit (assign()), moving transfers the heap
+//          block (or copies the inline bytes), so a filled buffer can be
+//          handed on to a message / send queue without a copy.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _BYTE_BUFFER_H_
+#define _BYTE_BUFFER_H_
+
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+
+#define BYTE_BUFFER_DEFAULT_INLINE_SIZE     256
+
+
+template <size_t InlineSize = BYTE_BUFFER_DEFAULT_INLINE_SIZE> class CByteBuffer
+{
+    unsigned char   *m_pData;           // m_inline, or a heap block
+    size_t          m_size;
+    size_t          m_capacity;
+
+    unsigned char   m_inline[(InlineSize > 0) ? InlineSize : 1];
+
+  protected:
+
+    bool isHeap() const
+    {
+        return (m_pData != m_inline);
+    }
+
+    void freeHeap()
+    {
+        if (isHeap())
+            ::free(m_pData);
+
+        m_pData = m_inline;
+        m_capacity = sizeof(m_inline);
+    }
+
+    // Make room for (at least) "numBytes", growing geometrically
+    // (or to exactly numBytes, if bExact)
+    bool grow(const size_t numBytes, const bool bExact = false)
+    {
+        if (numBytes <= m_capacity)
+            return true;
+
+        size_t newCapacity = (bExact ? numBytes : (m_capacity * 2));
+
+        if (newCapacity < numBytes)
+            newCapacity = numBytes;
+
+        unsigned char *pNew;
+
+        if (isHeap())
+        {
+            pNew = (unsigned char *) ::realloc(m_pData, newCapacity);
+        }
+        else
+        {
+            pNew = (unsigned char *) ::malloc(newCapacity);
+
+            if (pNew != nullptr && m_size > 0)
+                memcpy(pNew, m_pData, m_size);
+        }
+
+        if (pNew == nullptr)
+            return false;
+
+        m_pData = pNew;
+        m_capacity = newCapacity;
+
+        return true;
+    }
+
+    // Take the contents of another buffer (which is left empty)
+    void moveFrom(CByteBuffer &other)
+    {
+        if (other.isHeap())
+        {
+            m_pData = other.m_pData;
+            m_size = other.m_size;
+            m_capacity = other.m_capacity;
+
+            other.m_pData = other.m_inline;
+            other.m_capacity = sizeof(other.m_inline);
+        }
+        else
+        {
+            m_pData = m_inline;
+            m_capacity = sizeof(m_inline);
+            m_size = other.m_size;
+
+            if (m_size > 0)
+                memcpy(m_inline, other.m_inline, m_size);
+        }
+
+        other.m_size = 0;
+    }
+
+    // Open a gap of numBytes at nPos (moving the tail once),
+    // and return a pointer to it (nullptr = out of memory)
+    unsigned char *makeGap(const size_t nPos, const size_t numBytes)
+    {
+        size_t curSize = m_size;
+        size_t padSize = ((nPos > curSize) ? (nPos - curSize) : 0);
+
+        if (grow(curSize + padSize + numBytes) == false)
+            return nullptr;
+
+        if (padSize > 0)
+        {
+            memset((m_pData + curSize), 0, padSize);
+            curSize += padSize;
+        }
+        else if (nPos < curSize)
+        {
+            memmove((m_pData + nPos + numBytes), (m_pData + nPos), (curSize - nPos));
+        }
+
+        m_size = (curSize + numBytes);
+
+        return (m_pData + nPos);
+    }
+
+  public:
+
+    typedef unsigned char           value_type;
+    typedef unsigned char           *iterator;
+    typedef const unsigned char     *const_iterator;
+
+    CByteBuffer() :
+        m_pData(m_inline),
+        m_size(0),
+        m_capacity(sizeof(m_inline))
+    {
+    }
+
+    CByteBuffer(const void *pSource, const size_t numBytes) :
+        CByteBuffer()
+    {
+        appendBytes(pSource, numBytes);
+    }
+
+    explicit CByteBuffer(const std::string &sVal) :
+        CByteBuffer()
+    {
+        appendBytes(sVal.data(), sVal.size());
+    }
+
+    CByteBuffer(CByteBuffer &&other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    CByteBuffer &operator=(CByteBuffer &&other) noexcept
+    {
+        if (this != &other)
+        {
+            freeHeap();
+            moveFrom(other);
+        }
+
+        return *this;
+    }
+
+    // Copies must be made explicitly, with assign()
+    CByteBuffer(const CByteBuffer &) = delete;
+    CByteBuffer &operator=(const CByteBuffer &) = delete;
+
+    ~CByteBuffer()
+    {
+        freeHeap();
+    }
+
+    unsigned char *data()
+    {
+        return m_pData;
+    }
+
+    const unsigned char *data() const
+    {
+        return m_pData;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    size_t length() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return (m_size == 0);
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    // true = the data is held in the inline storage
+    bool isInline() const
+    {
+        return (isHeap() == false);
+    }
+
+    iterator begin()                { return m_pData; }
+    iterator end()                  { return (m_pData + m_size); }
+    const_iterator begin() const    { return m_pData; }
+    const_iterator end() const      { return (m_pData + m_size); }
+
+    unsigned char &operator[](const size_t idx)
+    {
+        return m_pData[idx];
+    }
+
+    const unsigned char &operator[](const size_t idx) const
+    {
+        return m_pData[idx];
+    }
+
+    bool reserve(const size_t numBytes)
+    {
+        return grow(numBytes, true);
+    }
+
+    // Set the size, new bytes are set to 0
+    bool resize(const size_t numBytes)
+    {
+        if (grow(numBytes) == false)
+            return false;
+
+        if (numBytes > m_size)
+            memset((m_pData + m_size), 0, (numBytes - m_size));
+
+        m_size = numBytes;
+
+        return true;
+    }
+
+    // Empty the buffer (keeps the capacity)
+    void clear()
+    {
+        m_size = 0;
+    }
+
+    // Release the heap block, if the data fits in the inline storage
+    void shrink_to_fit()
+    {
+        if (isHeap() == false || m_size > sizeof(m_inline))
+            return;
+
+        unsigned char *pHeap = m_pData;
+
+        if (m_size > 0)
+            memcpy(m_inline, pHeap, m_size);
+
+        ::free(pHeap);
+
+        m_pData = m_inline;
+        m_capacity = sizeof(m_inline);
+    }
+
+    bool push_back(const unsigned char cVal)
+    {
+        if (m_size >= m_capacity && grow(m_size + 1) == false)
+            return false;
+
+        m_pData[m_size++] = cVal;
+
+        return true;
+    }
+
+    bool appendBytes(const void *pSource, const size_t numBytes)
+    {
+        if (numBytes < 1)
+            return true;
+
+        if (pSource == nullptr)
+            return false;
+
+        auto pSrc = (const unsigned char *) pSource;
+
+        // the source may be inside this buffer (and move when it grows)
+        if (pSrc >= m_pData && pSrc < (m_pData + m_capacity))
+        {
+            size_t offset = (size_t) (pSrc - m_pData);
+
+            if (grow(m_size + numBytes) == false)
+                return false;
+
+            memmove((m_pData + m_size), (m_pData + offset), numBytes);
+        }
+        else
+        {
+            if (grow(m_size + numBytes) == false)
+                return false;
+
+            memcpy((m_pData + m_size), pSrc, numBytes);
+        }
+
+        m_size += numBytes;
+
+        return true;
+    }
+
+    bool assignBytes(const void *pSource, const size_t numBytes)
+    {
+        m_size = 0;
+
+        return appendBytes(pSource, numBytes);
+    }
+
+    bool assign(const CByteBuffer &rVal)
+    {
+        if (this == &rVal)
+            return true;
+
+        return assignBytes(rVal.data(), rVal.size());
+    }
+
+    bool assign(const std::vector<unsigned char> &rVal)
+    {
+        return assignBytes(rVal.data(), rVal.size());
+    }
+
+    bool assign(const std::string &sVal)
+    {
+        return assignBytes(sVal.data(), sVal.size());
+    }
+
+    bool assign(const char *pVal, int nLen)
+    {
+        if (nLen < 1)
+        {
+            m_size = 0;
+            return true;
+        }
+
+        return assignBytes(pVal, (size_t) nLen);
+    }
+
+    CByteBuffer &operator=(const std::string &sVal)
+    {
+        assign(sVal);
+
+        return *this;
+    }
+
+    bool append(const CByteBuffer &rVal)
+    {
+        return appendBytes(rVal.data(), rVal.size());
+    }
+
+    bool append(const std::vector<unsigned char> &rVal)
+    {
+        return appendBytes(rVal.data(), rVal.size());
+    }
+
+    bool append(const std::string &sVal)
+    {
+        return appendBytes(sVal.data(), sVal.size());
+    }
+
+    bool append(const char *pVal, int nLen)
+    {
+        if (nLen < 1)
+            return true;
+
+        return appendBytes(pVal, (size_t) nLen);
+    }
+
+    // Insert nLen copies of cVal at nPos (if the buffer is
+    // shorter than nPos, it is padded with NULL bytes first)
+    bool insert(unsigned long nPos, const unsigned char cVal, int nLen)
+    {
+        if (nLen < 1)
+            return true;
+
+        unsigned char *pGap = makeGap(nPos, (size_t) nLen);
+
+        if (pGap == nullptr)
+            return false;
+
+        memset(pGap, cVal, (size_t) nLen);
+
+        return true;
+    }
+
+    // Insert nLen bytes at nPos (if the buffer is shorter
+    // than nPos, it is padded with NULL bytes first)
+    bool insert(unsigned long nPos, const char *pVal, int nLen)
+    {
+        if (nLen < 1)
+            return true;
+
+        if (pVal == nullptr)
+            return false;
+
+        // the source may be inside this buffer (and move when it grows)
+        if ((const unsigned char *) pVal >= m_pData && (const unsigned char *) pVal < (m_pData + m_capacity))
+        {
+            CByteBuffer tmp(pVal, (size_t) nLen);
+
+            return insert(nPos, (const char *) tmp.data(), nLen);
+        }
+
+        unsigned char *pGap = makeGap(nPos, (size_t) nLen);
+
+        if (pGap == nullptr)
+            return false;
+
+        memcpy(pGap, pVal, (size_t) nLen);
+
+        return true;
+    }
+
+    // Remove "numBytes" bytes, starting at "pos"
+    void erase(const size_t pos, const size_t numBytes)
+    {
+        if (pos >= m_size || numBytes < 1)
+            return;
+
+        size_t count = ((numBytes < (m_size - pos)) ? numBytes : (m_size - pos));
+
+        memmove((m_pData + pos), (m_pData + pos + count), (m_size - (pos + count)));
+
+        m_size -= count;
+    }
+
+    // Get the buffer as a string (NULL terminated, as CBuffer::getStr())
+    std::string getStr() const
+    {
+        std::string sOut = "";
+
+        if (m_size > 0)
+        {
+            sOut.assign((const char *) m_pData, m_size);
+
+            if (sOut[(m_size - 1)] != 0)
+            {
+                sOut.append(1, 0);
+            }
+        }
+
+        return sOut;
+    }
+
+};
+
+
+#endif // _BYTE_BUFFER_H_
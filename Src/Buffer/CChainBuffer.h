@@ -0,0 +1,391 @@
+//****************************************************************************
+// FILE:    CChainBuffer.h
+//
+// DESC:    A chained (rope) buffer, for assembling messages from pieces
+//          without copying them into one contiguous buffer.
+//
+//          The buffer is a list of segments, each one a (pointer, length)
+//          view of some memory, and (optionally) a reference counted
+//          owner that keeps the memory alive:
+//
+//              appendCopy() / prependCopy()    - copied into a block owned
+//                                                by the chain (small pieces
+//                                                are packed into 1 block)
+//              appendOwned() / prependOwned()  - a container (std::vector,
+//                                                std::string, CBuffer,
+//                                                CByteBuffer ...) moved into
+//                                                the chain, no copy
+//              appendShared() / prependShared()- memory owned by a
+//                                                std::shared_ptr, no copy
+//              appendRef() / prependRef()      - memory owned by the caller
+//                                                (must outlive the chain)
+//
+//          Segments can be shared by several chains (appendChain()), ie:
+//          1 payload sent with different headers.  getIoVecs() exports
+//          the segments for writev() / sendmsg(), and NetIO/NetBufferSeq.h
+//          adapts a chain to an asio buffer sequence.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _CHAIN_BUFFER_H_
+#define _CHAIN_BUFFER_H_
+
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifndef WINDOWS
+#include <sys/uio.h>
+#endif
+
+
+#define CHAIN_BUFFER_BLOCK_SIZE     512     // min. size of a block for copied data
+
+
+// One piece of a chain buffer
+struct SChainSegment
+{
+    std::shared_ptr<const void>     pOwner;         // keeps pData alive (nullptr = caller owned)
+    const uint8_t                   *pData  = nullptr;
+    size_t                          len     = 0;
+    size_t                          room    = 0;    // free bytes after the data (chain owned blocks only)
+};
+
+
+class CChainBuffer
+{
+    std::deque<SChainSegment>   m_segments;
+    size_t                      m_size;             // total bytes in all the segments
+
+  protected:
+
+    // Allocate a chain owned block, with room for "numBytes"
+    SChainSegment newBlock(const size_t numBytes, const size_t blockSize)
+    {
+        SChainSegment seg;
+
+        std::shared_ptr<uint8_t> pBlock(new uint8_t[blockSize], std::default_delete<uint8_t[]>());
+
+        seg.pData = pBlock.get();
+        seg.len = numBytes;
+        seg.room = (blockSize - numBytes);
+        seg.pOwner = std::move(pBlock);
+
+        return seg;
+    }
+
+    void addSegment(SChainSegment &&seg, const bool bFront)
+    {
+        if (seg.len < 1)
+            return;
+
+        m_size += seg.len;
+
+        if (bFront)
+            m_segments.push_front(std::move(seg));
+        else
+            m_segments.push_back(std::move(seg));
+    }
+
+  public:
+
+    typedef std::deque<SChainSegment>::const_iterator   const_iterator;
+
+    CChainBuffer() :
+        m_size(0)
+    {
+    }
+
+    // Moves leave the other chain empty
+    CChainBuffer(CChainBuffer &&other) :
+        m_segments(std::move(other.m_segments)),
+        m_size(other.m_size)
+    {
+        other.m_segments.clear();
+        other.m_size = 0;
+    }
+
+    CChainBuffer &operator=(CChainBuffer &&other)
+    {
+        if (this != &other)
+        {
+            m_segments = std::move(other.m_segments);
+            m_size = other.m_size;
+
+            other.m_segments.clear();
+            other.m_size = 0;
+        }
+
+        return *this;
+    }
+
+    // Copies share the segments (see appendChain())
+    CChainBuffer(const CChainBuffer &other) :
+        m_size(0)
+    {
+        appendChain(other);
+    }
+
+    CChainBuffer &operator=(const CChainBuffer &other)
+    {
+        if (this != &other)
+        {
+            clear();
+            appendChain(other);
+        }
+
+        return *this;
+    }
+
+    // Get the total number of bytes
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return (m_size == 0);
+    }
+
+    size_t getNumSegments() const
+    {
+        return m_segments.size();
+    }
+
+    const SChainSegment &getSegment(const size_t idx) const
+    {
+        return m_segments[idx];
+    }
+
+    const_iterator begin() const
+    {
+        return m_segments.begin();
+    }
+
+    const_iterator end() const
+    {
+        return m_segments.end();
+    }
+
+    void clear()
+    {
+        m_segments.clear();
+        m_size = 0;
+    }
+
+    // Copy data onto the end of the chain (packed into the
+    // last block, if it was created by appendCopy() and has room)
+    void appendCopy(const void *pSource, const size_t numBytes)
+    {
+        if (pSource == nullptr || numBytes < 1)
+            return;
+
+        if (m_segments.empty() == false && m_segments.back().room >= numBytes)
+        {
+            SChainSegment &last = m_segments.back();
+
+            memcpy((uint8_t *) (last.pData + last.len), pSource, numBytes);
+
+            last.len += numBytes;
+            last.room -= numBytes;
+            m_size += numBytes;
+
+            return;
+        }
+
+        SChainSegment seg = newBlock(numBytes, std::max(numBytes, (size_t) CHAIN_BUFFER_BLOCK_SIZE));
+
+        memcpy((uint8_t *) seg.pData, pSource, numBytes);
+
+        addSegment(std::move(seg), false);
+    }
+
+    // Copy data onto the front of the chain (ie: a header)
+    void prependCopy(const void *pSource, const size_t numBytes)
+    {
+        if (pSource == nullptr || numBytes < 1)
+            return;
+
+        SChainSegment seg = newBlock(numBytes, numBytes);
+
+        memcpy((uint8_t *) seg.pData, pSource, numBytes);
+
+        addSegment(std::move(seg), true);
+    }
+
+    // Add memory kept alive by a shared pointer (no copy)
+    void appendShared(std::shared_ptr<const void> pOwner, const void *pData, const size_t numBytes)
+    {
+        SChainSegment seg;
+
+        seg.pOwner = std::move(pOwner);
+        seg.pData = (const uint8_t *) pData;
+        seg.len = (pData != nullptr) ? numBytes : 0;
+
+        addSegment(std::move(seg), false);
+    }
+
+    void prependShared(std::shared_ptr<const void> pOwner, const void *pData, const size_t numBytes)
+    {
+        SChainSegment seg;
+
+        seg.pOwner = std::move(pOwner);
+        seg.pData = (const uint8_t *) pData;
+        seg.len = (pData != nullptr) ? numBytes : 0;
+
+        addSegment(std::move(seg), true);
+    }
+
+    // Add memory owned by the caller (no copy).
+    // NOTE: It must not change / be freed while the chain uses it.
+    void appendRef(const void *pData, const size_t numBytes)
+    {
+        appendShared(nullptr, pData, numBytes);
+    }
+
+    void prependRef(const void *pData, const size_t numBytes)
+    {
+        prependShared(nullptr, pData, numBytes);
+    }
+
+    // Move a byte container (anything with data() and size(), ie:
+    // std::vector<uint8_t>, std::string, CBuffer, CByteBuffer) into
+    // the chain, without copying its data.
+    template <class TContainer> void appendOwned(TContainer &&container)
+    {
+        static_assert(std::is_rvalue_reference<TContainer &&>::value, "appendOwned() takes the container by std::move()");
+
+        auto pOwner = std::make_shared<typename std::decay<TContainer>::type>(std::move(container));
+
+        appendShared(pOwner, pOwner->data(), (pOwner->size() * sizeof(*pOwner->data())));
+    }
+
+    template <class TContainer> void prependOwned(TContainer &&container)
+    {
+        static_assert(std::is_rvalue_reference<TContainer &&>::value, "prependOwned() takes the container by std::move()");
+
+        auto pOwner = std::make_shared<typename std::decay<TContainer>::type>(std::move(container));
+
+        prependShared(pOwner, pOwner->data(), (pOwner->size() * sizeof(*pOwner->data())));
+    }
+
+    // Add the segments of another chain (shared, the data is not copied)
+    void appendChain(const CChainBuffer &other)
+    {
+        if (&other == this)
+        {
+            CChainBuffer tmp(other);
+
+            appendChain(tmp);
+            return;
+        }
+
+        for (auto &seg : other.m_segments)
+        {
+            SChainSegment copy = seg;
+
+            // only the chain that created a block may fill it
+            copy.room = 0;
+
+            addSegment(std::move(copy), false);
+        }
+    }
+
+    // Remove numBytes from the front (ie: after a partial send).
+    // Returns the number of bytes removed.
+    size_t consume(size_t numBytes)
+    {
+        size_t removed = 0;
+
+        while (numBytes > 0 && m_segments.empty() == false)
+        {
+            SChainSegment &first = m_segments.front();
+
+            if (numBytes < first.len)
+            {
+                first.pData += numBytes;
+                first.len -= numBytes;
+
+                removed += numBytes;
+                break;
+            }
+
+            numBytes -= first.len;
+            removed += first.len;
+
+            m_segments.pop_front();
+        }
+
+        m_size -= removed;
+
+        return removed;
+    }
+
+    // Copy (up to) maxLen bytes, starting "offset" bytes
+    // into the chain.  Returns the number of bytes copied.
+    size_t copyTo(void *pTarget, const size_t maxLen, size_t offset = 0) const
+    {
+        if (pTarget == nullptr)
+            return 0;
+
+        auto pTrgt = (uint8_t *) pTarget;
+
+        size_t copied = 0;
+
+        for (auto &seg : m_segments)
+        {
+            if (copied >= maxLen)
+                break;
+
+            if (offset >= seg.len)
+            {
+                offset -= seg.len;
+                continue;
+            }
+
+            size_t count = std::min((seg.len - offset), (maxLen - copied));
+
+            memcpy((pTrgt + copied), (seg.pData + offset), count);
+
+            copied += count;
+            offset = 0;
+        }
+
+        return copied;
+    }
+
+#ifndef WINDOWS
+    // Fill an iovec array (for writev() / sendmsg()) with the segments,
+    // starting at segment "firstSeg".  Returns the number of entries used.
+    size_t getIoVecs(struct iovec *pVecs, const size_t maxVecs, const size_t firstSeg = 0) const
+    {
+        if (pVecs == nullptr)
+            return 0;
+
+        size_t count = 0;
+
+        for (size_t idx = firstSeg; idx < m_segments.size() && count < maxVecs; idx++)
+        {
+            pVecs[count].iov_base = (void *) m_segments[idx].pData;
+            pVecs[count].iov_len = m_segments[idx].len;
+
+            count++;
+        }
+
+        return count;
+    }
+#endif
+};
+
+
+#endif // _CHAIN_BUFFER_H_
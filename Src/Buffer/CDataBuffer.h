@@ -17,6 +17,8 @@
 
 #include "../Error/CError.h"
 
+#include "BufferSpan.h"
+
 
 template <class T> class CSimpleDataBuffer : 
     public CErrorHandler
@@ -230,6 +232,40 @@ template <class T> class CSimpleDataBuffer :
         return (m_pBuffer + offset);
     }
 
+    // Get a view of all the data items of the buffer
+    CBufferSpan<T> getDataSpan()
+    {
+        if (!m_bAllocated)
+        {
+            return CBufferSpan<T>();
+        }
+
+        return CBufferSpan<T>(m_pBuffer, m_arraySize);
+    }
+
+    // Get a view of the (contiguous) data items of a frame
+    CBufferSpan<T> getFrameSpan(const unsigned int frame)
+    {
+        if (!m_bAllocated || frame >= m_blockSize)
+        {
+            return CBufferSpan<T>();
+        }
+
+        return CBufferSpan<T>((m_pBuffer + ((size_t) frame * m_frameSize)), m_frameSize);
+    }
+
+    // Get a view of data item "index" of every frame
+    // (strided, ie: 1 field of a frame of fields)
+    CStridedBufferSpan<T> getElementSpan(const unsigned int index)
+    {
+        if (!m_bAllocated || index >= m_frameSize)
+        {
+            return CStridedBufferSpan<T>();
+        }
+
+        return CStridedBufferSpan<T>((m_pBuffer + index), m_blockSize, m_frameSize);
+    }
+
     void lockBuffer()
     {
         m_ioLock.lock();
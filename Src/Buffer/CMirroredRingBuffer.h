@@ -0,0 +1,748 @@
+//****************************************************************************
+// FILE:    CMirroredRingBuffer.h
+//
+// DESC:    Ring buffer class with configurable data type, whose storage
+//          pages are mapped twice (back to back) in virtual memory.
+//          Any read or write of up to "max buffer size" entries is
+//          then one contiguous block, with no wrap-around handling.
+//
+//          NOTE: The data type must be trivially copyable, and the
+//          buffer size is rounded up to a whole number of pages.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _MIRRORED_RING_BUFFER_H_
+#define _MIRRORED_RING_BUFFER_H_
+
+
+#include "../Logging/Logging.h"
+
+#include "RingBufferUtils.h"
+
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(WINDOWS)
+#ifndef NOMINMAX
+#define NOMINMAX                // (keep std::min / std::max usable)
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// Maps one block of (shared) memory at two adjacent virtual addresses
+
+class CMirroredMemory
+{
+    void                    *m_pBase;
+
+    size_t                  m_nSize;
+
+#if defined(WINDOWS)
+    HANDLE                  m_hMapping;
+#endif
+
+    static size_t gcd(size_t a, size_t b)
+    {
+        while (b != 0)
+        {
+            size_t t = (a % b);
+            a = b;
+            b = t;
+        }
+
+        return a;
+    }
+
+  public:
+
+    CMirroredMemory()
+    {
+        m_pBase = nullptr;
+        m_nSize = 0;
+
+#if defined(WINDOWS)
+        m_hMapping = nullptr;
+#endif
+    }
+
+    ~CMirroredMemory()
+    {
+        free();
+    }
+
+    CMirroredMemory(const CMirroredMemory &) = delete;
+    CMirroredMemory &operator=(const CMirroredMemory &) = delete;
+
+    // Get the mapping granularity (page size) of the OS
+    static size_t getPageSize()
+    {
+#if defined(WINDOWS)
+        SYSTEM_INFO sysInfo;
+
+        GetSystemInfo(&sysInfo);
+
+        return (size_t) sysInfo.dwAllocationGranularity;
+#else
+        long pageSize = sysconf(_SC_PAGESIZE);
+
+        return (pageSize > 0) ? (size_t) pageSize : 4096;
+#endif
+    }
+
+    // Round "numBytes" up to a size that is a multiple of both
+    // the page size and the entry size.
+    static size_t getMappingSize(const size_t numBytes, const size_t entrySize)
+    {
+        size_t pageSize = getPageSize();
+
+        size_t unit = ((pageSize / gcd(pageSize, entrySize)) * entrySize);
+
+        return (((numBytes + unit) - 1) / unit) * unit;
+    }
+
+    // Allocate (at least) "numBytes" of memory (a multiple of the page size),
+    // mapped at [base, base + size) and again at [base + size, base + (2 * size)).
+    bool allocate(const size_t numBytes)
+    {
+        free();
+
+        if (numBytes < 1)
+            return false;
+
+#if defined(WINDOWS)
+        m_hMapping = CreateFileMappingA
+            (
+                INVALID_HANDLE_VALUE,
+                nullptr,
+                PAGE_READWRITE,
+                (DWORD) (((unsigned long long) numBytes) >> 32),
+                (DWORD) (numBytes & 0xFFFFFFFF),
+                nullptr
+            );
+
+        if (m_hMapping == nullptr)
+        {
+            LogDebug("[CMirroredMemory:{}] CreateFileMapping failed ", __func__);
+            return false;
+        }
+
+        // Find a free address range (2 * size), release it,
+        // then map both views there.  Another thread may grab
+        // the range in between, so retry a few times.
+        for (int attempt = 0; attempt < 16; attempt++)
+        {
+            void *pRange = VirtualAlloc(nullptr, (numBytes * 2), MEM_RESERVE, PAGE_NOACCESS);
+
+            if (pRange == nullptr)
+                break;
+
+            VirtualFree(pRange, 0, MEM_RELEASE);
+
+            void *pView1 = MapViewOfFileEx(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, numBytes, pRange);
+
+            if (pView1 == nullptr)
+                continue;
+
+            void *pView2 = MapViewOfFileEx(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, numBytes, (((uint8_t *) pRange) + numBytes));
+
+            if (pView2 == nullptr)
+            {
+                UnmapViewOfFile(pView1);
+                continue;
+            }
+
+            m_pBase = pView1;
+            m_nSize = numBytes;
+
+            return true;
+        }
+
+        CloseHandle(m_hMapping);
+
+        m_hMapping = nullptr;
+
+        LogDebug("[CMirroredMemory:{}] MapViewOfFileEx failed ", __func__);
+
+        return false;
+#else
+        int fd = -1;
+
+#if defined(__linux__)
+        fd = memfd_create("CMirroredMemory", 0);
+#else
+        // No memfd - use an (immediately unlinked) POSIX shared memory object
+        std::string sName = "/CMirroredMemory_" + std::to_string((long) getpid()) + "_" + std::to_string((unsigned long long) (size_t) this);
+
+        fd = shm_open(sName.c_str(), (O_RDWR | O_CREAT | O_EXCL), 0600);
+
+        if (fd >= 0)
+        {
+            shm_unlink(sName.c_str());
+        }
+#endif
+
+        if (fd < 0)
+        {
+            LogDebug("[CMirroredMemory:{}] unable to create shared memory object ", __func__);
+            return false;
+        }
+
+        if (ftruncate(fd, (off_t) numBytes) != 0)
+        {
+            LogDebug("[CMirroredMemory:{}] ftruncate failed ", __func__);
+            close(fd);
+            return false;
+        }
+
+        // Reserve (2 * size) of address space, then map the
+        // memory object over both halves of it.
+        void *pRange = mmap(nullptr, (numBytes * 2), PROT_NONE, (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+
+        if (pRange == MAP_FAILED)
+        {
+            LogDebug("[CMirroredMemory:{}] address range reservation failed ", __func__);
+            close(fd);
+            return false;
+        }
+
+        void *pView1 = mmap(pRange, numBytes, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_FIXED), fd, 0);
+
+        void *pView2 = mmap((((uint8_t *) pRange) + numBytes), numBytes, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_FIXED), fd, 0);
+
+        close(fd);
+
+        if (pView1 == MAP_FAILED || pView2 == MAP_FAILED)
+        {
+            LogDebug("[CMirroredMemory:{}] mirrored mapping failed ", __func__);
+            munmap(pRange, (numBytes * 2));
+            return false;
+        }
+
+        m_pBase = pRange;
+        m_nSize = numBytes;
+
+        return true;
+#endif
+    }
+
+    void free()
+    {
+        if (m_pBase == nullptr)
+            return;
+
+#if defined(WINDOWS)
+        UnmapViewOfFile(((uint8_t *) m_pBase) + m_nSize);
+        UnmapViewOfFile(m_pBase);
+
+        if (m_hMapping != nullptr)
+        {
+            CloseHandle(m_hMapping);
+            m_hMapping = nullptr;
+        }
+#else
+        munmap(m_pBase, (m_nSize * 2));
+#endif
+
+        m_pBase = nullptr;
+        m_nSize = 0;
+    }
+
+    // Get a pointer to the start of the (first) mapping
+    void *getPtr()
+    {
+        return m_pBase;
+    }
+
+    // Get the size (in bytes) of one mapping
+    size_t getSize()
+    {
+        return m_nSize;
+    }
+};
+
+
+template <typename T> class CMirroredRingBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "CMirroredRingBuffer requires a trivially copyable type");
+
+    CMirroredMemory         m_memory;
+
+    T                       *m_pDataBuffer;
+
+    size_t                  m_bufferSize;
+
+    size_t                  m_entriesPerBlock;
+
+    size_t                  m_currentDataSize;
+
+    size_t                  m_writeIdx;
+    size_t                  m_readIdx;
+
+    std::mutex              m_ioMutex;
+
+  protected:
+
+    bool allocateBuffer(const size_t numEntries)
+    {
+        m_memory.free();
+
+        m_pDataBuffer = nullptr;
+        m_bufferSize = 0;
+
+        m_currentDataSize = 0;
+        m_writeIdx = 0;
+        m_readIdx = 0;
+
+        if (numEntries < 1)
+            return false;
+
+        auto numBytes = CMirroredMemory::getMappingSize((numEntries * sizeof(T)), sizeof(T));
+
+        if (m_memory.allocate(numBytes) == false)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid data buffer pointer ", __func__);
+            return false;
+        }
+
+        m_pDataBuffer = (T *) m_memory.getPtr();
+
+        m_bufferSize = (m_memory.getSize() / sizeof(T));
+
+        return true;
+    }
+
+    // Delete (remove) numEntries starting at current pos.
+    // NOTE: m_ioMutex must be held by the caller.
+    bool erase(const size_t numEntries = 1)
+    {
+        if (m_pDataBuffer == nullptr || m_bufferSize < 1 || m_currentDataSize < 1)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid param ", __func__);
+            return false;
+        }
+
+        if (numEntries > m_currentDataSize)
+        {
+            LogDebug
+            (
+                "[CMirroredRingBuffer:{}] numEnties ({}) > currDataSiZe ({}) ",
+                __func__,
+                numEntries,
+                m_currentDataSize
+            );
+            m_readIdx = 0;
+            m_writeIdx = 0;
+            m_currentDataSize = 0;
+            return true;
+        }
+
+        m_readIdx = ((m_readIdx + numEntries) % m_bufferSize);
+
+        m_currentDataSize -= numEntries;
+
+        return true;
+    }
+
+    // NOTE: m_ioMutex must be held by the caller.
+    int read(T *pTargetBuff, const size_t numEntries, const bool deleteEntries)
+    {
+        size_t numEntriesToRead = std::min(numEntries, m_currentDataSize);
+
+        if (numEntriesToRead < 1)
+            return 0;
+
+        copyBufferEntries(pTargetBuff, (m_pDataBuffer + m_readIdx), numEntriesToRead);
+
+        if (deleteEntries == true)
+        {
+            erase(numEntriesToRead);
+        }
+
+        return (int) numEntriesToRead;
+    }
+
+    // NOTE: m_ioMutex must be held by the caller.
+    int write(const T *pSourceBuff, const size_t numEntries, const bool bOverwrite)
+    {
+        size_t numEntriesFree = (m_bufferSize - m_currentDataSize);
+
+        if (numEntries > numEntriesFree)
+        {
+            if (bOverwrite == false)
+            {
+                LogDebug("[CMirroredRingBuffer:{}] Buffer over-flow ", __func__);
+                return -5;
+            }
+
+            // overwrite flag = true, so drop the oldest entries
+            erase(numEntries - numEntriesFree);
+        }
+
+        copyBufferEntries((m_pDataBuffer + m_writeIdx), pSourceBuff, numEntries);
+
+        m_writeIdx = ((m_writeIdx + numEntries) % m_bufferSize);
+
+        m_currentDataSize += numEntries;
+
+        return (int) numEntries;
+    }
+
+  public:
+
+    CMirroredRingBuffer(const size_t numEntries = 0)
+    {
+        m_pDataBuffer = nullptr;
+
+        m_entriesPerBlock = 1;
+        m_bufferSize = 0;
+
+        m_currentDataSize = 0;
+        m_writeIdx = 0;
+        m_readIdx = 0;
+
+        if (numEntries > 0)
+        {
+            allocateBuffer(numEntries);
+        }
+    }
+
+    CMirroredRingBuffer(const size_t entriesPerBlock, const size_t numBlocks)
+    {
+        m_pDataBuffer = nullptr;
+
+        m_entriesPerBlock = entriesPerBlock;
+        m_bufferSize = 0;
+
+        m_currentDataSize = 0;
+        m_writeIdx = 0;
+        m_readIdx = 0;
+
+        if (entriesPerBlock > 0 && numBlocks > 0)
+        {
+            allocateBuffer(entriesPerBlock * numBlocks);
+        }
+    }
+
+    ~CMirroredRingBuffer()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        m_memory.free();
+
+        m_pDataBuffer = nullptr;
+        m_bufferSize = 0;
+    }
+
+    // Set the minimum number of entries that can be stored in the entry array
+    // (the actual size is rounded up to a whole number of pages).
+    // NOTE: Doing this will flush the data buffer.
+    bool setMaxBufferSize(const size_t numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        return allocateBuffer(numEntries);
+    }
+
+    // Set the minimum number of entries that can be stored in the entry array
+    // (the actual size is rounded up to a whole number of pages).
+    // NOTE: Doing this will flush the data buffer.
+    bool setMaxBufferSize(const size_t entriesPerBlock, const size_t numBlocks)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (entriesPerBlock > 0 && numBlocks > 0)
+        {
+            auto status = allocateBuffer(entriesPerBlock * numBlocks);
+
+            if (status == true)
+            {
+                m_entriesPerBlock = entriesPerBlock;
+            }
+
+            return status;
+        }
+
+        LogDebug("[CMirroredRingBuffer:{}] Invalid param ", __func__);
+
+        return false;
+    }
+
+    // Get the maximum number of entries that can be
+    // stored in the buffer (storage array).
+    int getMaxBufferSize()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        return (int) m_bufferSize;
+    }
+
+    // Get the current (active) number of entries in
+    // the buffer (storage array).
+    unsigned int getCurrentDataSize()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        return (unsigned int) m_currentDataSize;
+    }
+
+    // Flush (zero out) the data buffer.
+    bool flush(const bool bZeroOutBuffer = false)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        m_currentDataSize = 0;
+        m_writeIdx = 0;
+        m_readIdx = 0;
+
+        if (bZeroOutBuffer == false)
+        {
+            return true;
+        }
+
+        if (m_bufferSize > 0)
+        {
+            memset((void *) m_pDataBuffer, 0, (m_bufferSize * sizeof(T)));
+
+            return true;
+        }
+
+        LogDebug("[CMirroredRingBuffer:{}] Invalid buffer size ", __func__);
+
+        return false;
+    }
+
+    // Read "blockSize" entries from the data block (entry array).
+    int readBlock
+        (
+            T *pTargetBuff,
+            const size_t blockSize,
+            const bool deleteEntries = false
+        )
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_pDataBuffer == nullptr || pTargetBuff == nullptr)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (m_bufferSize < 1 || blockSize > m_bufferSize)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid buffer size ", __func__);
+            return -1;
+        }
+
+        return read(pTargetBuff, blockSize, deleteEntries);
+    }
+
+    // Read (entriesPerBlock * blockSize) entries from the data block (entry array).
+    int readBlock
+        (
+            T *pTargetBuff,
+            const size_t entriesPerBlock,       // this is (more or less) numChannels
+            const size_t blockSize,             // this is (more or less) numFrames
+            const bool deleteEntries = false
+        )
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_pDataBuffer == nullptr || pTargetBuff == nullptr)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        size_t numEntriesToRead = (entriesPerBlock * blockSize);
+
+        if (m_bufferSize < 1 || numEntriesToRead > m_bufferSize)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid buffer size ", __func__);
+            return -1;
+        }
+
+        return read(pTargetBuff, numEntriesToRead, deleteEntries);
+    }
+
+    // Write "blockSize" entries to the data block (entry array).
+    int writeBlock
+        (
+            const T *pSourceBuff,
+            const size_t blockSize,
+            bool bOverwrite = false
+        )
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_pDataBuffer == nullptr || pSourceBuff == nullptr)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (m_bufferSize < 1 || blockSize > m_bufferSize)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid buffer size ", __func__);
+            return -2;
+        }
+
+        return write(pSourceBuff, blockSize, bOverwrite);
+    }
+
+    // Write (entriesPerBlock * blockSize) entries to the data block (entry array).
+    int writeBlock
+        (
+            const T *pSourceBuff,
+            const size_t entriesPerBlock,           // this is (more or less) numChannels
+            const size_t blockSize,                 // this is (more or less) numFrames
+            bool bOverwrite = false
+        )
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_pDataBuffer == nullptr || pSourceBuff == nullptr)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        size_t writeSize = (entriesPerBlock * blockSize);
+
+        if (writeSize < 1 || writeSize > m_bufferSize)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid write size ", __func__);
+            return -3;
+        }
+
+        return write(pSourceBuff, writeSize, bOverwrite);
+    }
+
+    // Get a pointer to the entry "offset" entries past the current
+    // read index.  Because the storage is mirrored, the next
+    // (getCurrentDataSize() - offset) entries are contiguous, so any
+    // window of the buffered stream can be used in place (ie: by a
+    // SIMD mixer or a GStreamer buffer fill).
+    // The pointer is only valid until the entries are deleted.
+    const T *getReadPtr(const size_t offset = 0)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_pDataBuffer == nullptr || offset >= m_currentDataSize)
+        {
+            return nullptr;
+        }
+
+        return (m_pDataBuffer + m_readIdx + offset);
+    }
+
+    // Get (up to) "numEntries" free entries of the data buffer, to be
+    // filled in place.  The region is always one contiguous block (size2 = 0).
+    SRingBufferRegion<T> reserveWrite(const size_t numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        SRingBufferRegion<T> region;
+
+        if (m_pDataBuffer == nullptr || m_bufferSize < 1)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid buffer size ", __func__);
+            return region;
+        }
+
+        region.pData1 = (m_pDataBuffer + m_writeIdx);
+        region.size1  = std::min(numEntries, (m_bufferSize - m_currentDataSize));
+
+        return region;
+    }
+
+    // Publish "numEntries" entries written into the
+    // region returned by the last reserveWrite() call.
+    int commitWrite(const size_t numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_bufferSize < 1 || numEntries > (m_bufferSize - m_currentDataSize))
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Buffer over-flow ", __func__);
+            return -5;
+        }
+
+        m_writeIdx = ((m_writeIdx + numEntries) % m_bufferSize);
+
+        m_currentDataSize += numEntries;
+
+        return (int) numEntries;
+    }
+
+    // Get (up to) "numEntries" entries, starting at the current read
+    // index, to be used in place.  The region is always one contiguous block.
+    SRingBufferRegion<T> peekRead(const size_t numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        SRingBufferRegion<T> region;
+
+        if (m_pDataBuffer == nullptr || m_bufferSize < 1)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid buffer size ", __func__);
+            return region;
+        }
+
+        region.pData1 = (m_pDataBuffer + m_readIdx);
+        region.size1  = std::min(numEntries, m_currentDataSize);
+
+        return region;
+    }
+
+    // Release "numEntries" entries (returned by the last peekRead() call).
+    int consumeRead(const size_t numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (numEntries > m_currentDataSize)
+        {
+            LogDebug("[CMirroredRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (numEntries > 0)
+        {
+            erase(numEntries);
+        }
+
+        return (int) numEntries;
+    }
+
+    // Delete (remove) 1 entry.
+    bool deleteEntry()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        return erase(1);
+    }
+
+    // Delete (remove) numEntries entries from the front of the buffer.
+    bool deleteBlock(unsigned int numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        return erase(numEntries);
+    }
+};
+
+#endif // _MIRRORED_RING_BUFFER_H_
@@ -0,0 +1,619 @@
+//****************************************************************************
+// FILE:    CMpmcQueue.h
+//
+// DESC:    Bounded, multi-producer / multi-consumer queue class
+//          with configurable data type.
+//
+//          Each slot carries a sequence number (D. Vyukov's bounded
+//          MPMC queue), so producers and consumers only contend on
+//          a single atomic index each, and never on a global mutex.
+//          The mutex / condition variables are only used by the
+//          blocking functions, when the queue is full (or empty).
+//
+//          NOTE: T must be default constructible.  setMaxBufferSize()
+//          must only be called while no other thread uses the queue.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _MPMC_QUEUE_H_
+#define _MPMC_QUEUE_H_
+
+
+#include "../Logging/Logging.h"
+
+#include "RingBufferUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <cstdint>
+
+
+template <typename T> class CMpmcQueue
+{
+    struct SSlot
+    {
+        std::atomic<size_t>     sequence;
+        T                       data;
+    };
+
+    SSlot                   *m_pSlots;
+
+    size_t                  m_bufferSize;               // always a power of 2
+    size_t                  m_indexMask;
+
+    // Free running position counters (slot = pos & m_indexMask)
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t>    m_enqueuePos;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t>    m_dequeuePos;
+
+    // Only used by the blocking functions
+    alignas(CACHE_LINE_SIZE) std::atomic<int>       m_nPushWaiters;
+    std::atomic<int>                                m_nPopWaiters;
+    std::atomic<bool>                               m_bCancelWait;
+
+    std::mutex              m_waitMutex;
+    std::condition_variable m_dataReadyVar;             // signaled when entries are pushed
+    std::condition_variable m_spaceReadyVar;            // signaled when entries are popped
+
+  protected:
+
+    void free()
+    {
+        if (m_pSlots != nullptr)
+        {
+            delete[] m_pSlots;
+
+            m_pSlots = nullptr;
+        }
+
+        m_bufferSize = 0;
+        m_indexMask = 0;
+    }
+
+    // Allocate the slot array.  The number of slots is
+    // rounded up to a power of 2 (minimum 2).
+    bool allocateBuffer(const size_t numEntries)
+    {
+        free();
+
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+
+        if (numEntries < 1)
+            return false;
+
+        size_t numSlots = 2;
+
+        while (numSlots < numEntries)
+        {
+            numSlots <<= 1;
+        }
+
+        m_pSlots = new (std::nothrow) SSlot[numSlots];
+
+        if (m_pSlots == nullptr)
+        {
+            LogDebug("[CMpmcQueue:{}] Invalid data buffer pointer ", __func__);
+            return false;
+        }
+
+        for (size_t i = 0; i < numSlots; i++)
+        {
+            m_pSlots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        m_bufferSize = numSlots;
+        m_indexMask = (numSlots - 1);
+
+        return true;
+    }
+
+    // Claim the next slot and move / copy the item into it.
+    // Returns false if the queue is full.
+    template <typename U> bool enqueue(U &&item)
+    {
+        if (m_pSlots == nullptr)
+            return false;
+
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+
+        SSlot *pSlot;
+
+        for (;;)
+        {
+            pSlot = &m_pSlots[pos & m_indexMask];
+
+            size_t seq = pSlot->sequence.load(std::memory_order_acquire);
+
+            intptr_t diff = ((intptr_t) seq - (intptr_t) pos);
+
+            if (diff == 0)
+            {
+                // slot is free - try to claim it
+                if (m_enqueuePos.compare_exchange_weak(pos, (pos + 1), std::memory_order_relaxed) == true)
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // slot still holds the entry from the last lap (full)
+                return false;
+            }
+            else
+            {
+                // another producer claimed it
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        pSlot->data = std::forward<U>(item);
+
+        pSlot->sequence.store((pos + 1), std::memory_order_release);
+
+        return true;
+    }
+
+    // Claim the oldest slot and move the item out of it.
+    // Returns false if the queue is empty.
+    bool dequeue(T &item)
+    {
+        if (m_pSlots == nullptr)
+            return false;
+
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+
+        SSlot *pSlot;
+
+        for (;;)
+        {
+            pSlot = &m_pSlots[pos & m_indexMask];
+
+            size_t seq = pSlot->sequence.load(std::memory_order_acquire);
+
+            intptr_t diff = ((intptr_t) seq - (intptr_t) (pos + 1));
+
+            if (diff == 0)
+            {
+                // slot is filled - try to claim it
+                if (m_dequeuePos.compare_exchange_weak(pos, (pos + 1), std::memory_order_relaxed) == true)
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // slot not written yet (empty)
+                return false;
+            }
+            else
+            {
+                // another consumer claimed it
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        item = std::move(pSlot->data);
+
+        pSlot->sequence.store((pos + m_bufferSize), std::memory_order_release);
+
+        return true;
+    }
+
+    // Claim up to numEntries consecutive slots with a single CAS,
+    // then fill them in order.  A claimed slot may still be being
+    // read by a (slower) consumer, in which case we wait for it.
+    size_t enqueueBatch(const T *pItems, const size_t numEntries)
+    {
+        if (m_pSlots == nullptr || numEntries < 1)
+            return 0;
+
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t numToPush;
+
+        for (;;)
+        {
+            size_t dequeuePos = m_dequeuePos.load(std::memory_order_acquire);
+
+            if (dequeuePos > pos)
+            {
+                // stale position
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            size_t numFree = (m_bufferSize - (pos - dequeuePos));
+
+            numToPush = std::min(numEntries, numFree);
+
+            if (numToPush < 1)
+                return 0;
+
+            if (m_enqueuePos.compare_exchange_weak(pos, (pos + numToPush), std::memory_order_relaxed) == true)
+                break;
+        }
+
+        for (size_t i = 0; i < numToPush; i++)
+        {
+            SSlot *pSlot = &m_pSlots[(pos + i) & m_indexMask];
+
+            while (pSlot->sequence.load(std::memory_order_acquire) != (pos + i))
+            {
+                std::this_thread::yield();
+            }
+
+            pSlot->data = pItems[i];
+
+            pSlot->sequence.store((pos + i + 1), std::memory_order_release);
+        }
+
+        return numToPush;
+    }
+
+    // Claim up to numEntries consecutive (filled) slots with a
+    // single CAS, then empty them in order.  A claimed slot may still
+    // be being written by a (slower) producer, in which case we wait for it.
+    size_t dequeueBatch(T *pItems, const size_t numEntries)
+    {
+        if (m_pSlots == nullptr || numEntries < 1)
+            return 0;
+
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        size_t numToPop;
+
+        for (;;)
+        {
+            size_t enqueuePos = m_enqueuePos.load(std::memory_order_acquire);
+
+            if (pos > enqueuePos)
+            {
+                // stale position
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            numToPop = std::min(numEntries, (enqueuePos - pos));
+
+            if (numToPop < 1)
+                return 0;
+
+            if (m_dequeuePos.compare_exchange_weak(pos, (pos + numToPop), std::memory_order_relaxed) == true)
+                break;
+        }
+
+        for (size_t i = 0; i < numToPop; i++)
+        {
+            SSlot *pSlot = &m_pSlots[(pos + i) & m_indexMask];
+
+            while (pSlot->sequence.load(std::memory_order_acquire) != (pos + i + 1))
+            {
+                std::this_thread::yield();
+            }
+
+            pItems[i] = std::move(pSlot->data);
+
+            pSlot->sequence.store((pos + i + m_bufferSize), std::memory_order_release);
+        }
+
+        return numToPop;
+    }
+
+    // Wake thread(s) blocked in the pop (or push) functions.
+    // The waiter count is checked first, so the mutex is
+    // never touched unless someone is actually waiting.
+    void notifyWaiters(std::atomic<int> &nWaiters, std::condition_variable &waitVar, const bool bNotifyAll)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (nWaiters.load(std::memory_order_relaxed) < 1)
+            return;
+
+        std::lock_guard<std::mutex> lock{m_waitMutex};
+
+        if (bNotifyAll == true)
+            waitVar.notify_all();
+        else
+            waitVar.notify_one();
+    }
+
+    // Block (up to timeoutMs milliseconds) until fnAttempt() succeeds,
+    // retrying each time the other side signals waitVar.
+    template <typename F> bool waitFor
+        (
+            std::atomic<int> &nWaiters,
+            std::condition_variable &waitVar,
+            const unsigned int timeoutMs,
+            F fnAttempt
+        )
+    {
+        std::unique_lock<std::mutex> lock{m_waitMutex};
+
+        nWaiters.fetch_add(1);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool bDone = false;
+
+        waitVar.wait_for
+            (
+                lock,
+                std::chrono::milliseconds(timeoutMs),
+                [&]
+                {
+                    bDone = fnAttempt();
+
+                    return (bDone == true || m_bCancelWait.load() == true);
+                }
+            );
+
+        nWaiters.fetch_sub(1);
+
+        return bDone;
+    }
+
+  public:
+
+    CMpmcQueue(const size_t numEntries = 0) :
+        m_enqueuePos(0),
+        m_dequeuePos(0),
+        m_nPushWaiters(0),
+        m_nPopWaiters(0),
+        m_bCancelWait(false)
+    {
+        m_pSlots = nullptr;
+
+        m_bufferSize = 0;
+        m_indexMask = 0;
+
+        if (numEntries > 0)
+        {
+            allocateBuffer(numEntries);
+        }
+    }
+
+    ~CMpmcQueue()
+    {
+        free();
+    }
+
+    CMpmcQueue(const CMpmcQueue &) = delete;
+    CMpmcQueue &operator=(const CMpmcQueue &) = delete;
+
+    // Set the maximum number of entries that can be stored in the queue
+    // (rounded up to a power of 2).
+    // NOTE: Doing this will flush (delete) all entries.
+    bool setMaxBufferSize(const size_t numEntries)
+    {
+        return allocateBuffer(numEntries);
+    }
+
+    // Get the maximum number of entries that can be stored in the queue.
+    int getMaxBufferSize()
+    {
+        return (int) m_bufferSize;
+    }
+
+    // Get the current number of entries in the queue.
+    // NOTE: With other threads active, this is only a snapshot.
+    unsigned int getCurrentDataSize()
+    {
+        size_t dequeuePos = m_dequeuePos.load(std::memory_order_acquire);
+        size_t enqueuePos = m_enqueuePos.load(std::memory_order_acquire);
+
+        if (enqueuePos < dequeuePos)
+            return 0;
+
+        return (unsigned int) (enqueuePos - dequeuePos);
+    }
+
+    // Add an entry to the queue, without blocking.
+    // Returns false if the queue is full.
+    bool tryPush(const T &item)
+    {
+        if (enqueue(item) == false)
+            return false;
+
+        notifyWaiters(m_nPopWaiters, m_dataReadyVar, false);
+
+        return true;
+    }
+
+    bool tryPush(T &&item)
+    {
+        if (enqueue(std::move(item)) == false)
+            return false;
+
+        notifyWaiters(m_nPopWaiters, m_dataReadyVar, false);
+
+        return true;
+    }
+
+    // Remove the oldest entry from the queue, without blocking.
+    // Returns false if the queue is empty.
+    bool tryPop(T &item)
+    {
+        if (dequeue(item) == false)
+            return false;
+
+        notifyWaiters(m_nPushWaiters, m_spaceReadyVar, false);
+
+        return true;
+    }
+
+    // Add an entry to the queue, waiting (up to timeoutMs
+    // milliseconds) for a free slot if the queue is full.
+    // Returns false on timeout, or if the wait was cancelled.
+    bool push(const T &item, const unsigned int timeoutMs)
+    {
+        if (tryPush(item) == true)
+            return true;
+
+        bool status = waitFor(m_nPushWaiters, m_spaceReadyVar, timeoutMs, [&] { return enqueue(item); });
+
+        if (status == true)
+            notifyWaiters(m_nPopWaiters, m_dataReadyVar, false);
+
+        return status;
+    }
+
+    bool push(T &&item, const unsigned int timeoutMs)
+    {
+        if (tryPush(std::move(item)) == true)
+            return true;
+
+        // NOTE: item is only moved from by a successful enqueue()
+        bool status = waitFor(m_nPushWaiters, m_spaceReadyVar, timeoutMs, [&] { return enqueue(std::move(item)); });
+
+        if (status == true)
+            notifyWaiters(m_nPopWaiters, m_dataReadyVar, false);
+
+        return status;
+    }
+
+    // Remove the oldest entry from the queue, waiting (up to
+    // timeoutMs milliseconds) for one if the queue is empty.
+    // Returns false on timeout, or if the wait was cancelled.
+    bool pop(T &item, const unsigned int timeoutMs)
+    {
+        if (tryPop(item) == true)
+            return true;
+
+        bool status = waitFor(m_nPopWaiters, m_dataReadyVar, timeoutMs, [&] { return dequeue(item); });
+
+        if (status == true)
+            notifyWaiters(m_nPushWaiters, m_spaceReadyVar, false);
+
+        return status;
+    }
+
+    // Add (up to) numEntries entries to the queue, without blocking.
+    // Returns the number of entries added (0 = queue full), or < 0 on error.
+    int tryPushBatch(const T *pItems, const size_t numEntries)
+    {
+        if (pItems == nullptr)
+        {
+            LogDebug("[CMpmcQueue:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        size_t numPushed = enqueueBatch(pItems, numEntries);
+
+        if (numPushed > 0)
+            notifyWaiters(m_nPopWaiters, m_dataReadyVar, true);
+
+        return (int) numPushed;
+    }
+
+    // Remove (up to) numEntries entries from the queue, without blocking.
+    // Returns the number of entries removed (0 = queue empty), or < 0 on error.
+    int tryPopBatch(T *pItems, const size_t numEntries)
+    {
+        if (pItems == nullptr)
+        {
+            LogDebug("[CMpmcQueue:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        size_t numPopped = dequeueBatch(pItems, numEntries);
+
+        if (numPopped > 0)
+            notifyWaiters(m_nPushWaiters, m_spaceReadyVar, true);
+
+        return (int) numPopped;
+    }
+
+    // Add numEntries entries to the queue, waiting (up to timeoutMs
+    // milliseconds) for free slots while the queue is full.
+    // Returns the number of entries added (less than numEntries
+    // on timeout / cancel), or < 0 on error.
+    int pushBatch(const T *pItems, const size_t numEntries, const unsigned int timeoutMs)
+    {
+        int status = tryPushBatch(pItems, numEntries);
+
+        if (status < 0 || (size_t) status >= numEntries)
+            return status;
+
+        size_t numPushed = (size_t) status;
+
+        auto endTime = (std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs));
+
+        while (numPushed < numEntries && m_bCancelWait.load() == false)
+        {
+            auto now = std::chrono::steady_clock::now();
+
+            if (now >= endTime)
+                break;
+
+            auto remainingMs = (unsigned int) std::chrono::duration_cast<std::chrono::milliseconds>(endTime - now).count();
+
+            waitFor
+                (
+                    m_nPushWaiters,
+                    m_spaceReadyVar,
+                    remainingMs,
+                    [&]
+                    {
+                        size_t num = enqueueBatch((pItems + numPushed), (numEntries - numPushed));
+
+                        numPushed += num;
+
+                        return (num > 0);
+                    }
+                );
+
+            notifyWaiters(m_nPopWaiters, m_dataReadyVar, true);
+        }
+
+        return (int) numPushed;
+    }
+
+    // Remove (up to) numEntries entries from the queue, waiting (up to
+    // timeoutMs milliseconds) for at least one if the queue is empty.
+    // Returns the number of entries removed (0 = timeout / cancel), or < 0 on error.
+    int popBatch(T *pItems, const size_t numEntries, const unsigned int timeoutMs)
+    {
+        int status = tryPopBatch(pItems, numEntries);
+
+        if (status != 0 || numEntries < 1)
+            return status;
+
+        size_t numPopped = 0;
+
+        waitFor
+            (
+                m_nPopWaiters,
+                m_dataReadyVar,
+                timeoutMs,
+                [&]
+                {
+                    numPopped = dequeueBatch(pItems, numEntries);
+
+                    return (numPopped > 0);
+                }
+            );
+
+        if (numPopped > 0)
+            notifyWaiters(m_nPushWaiters, m_spaceReadyVar, true);
+
+        return (int) numPopped;
+    }
+
+    // Release all threads blocked in the push / pop functions (ie: on
+    // shutdown).  While cancelled, the blocking functions don't wait.
+    void cancelWait(const bool bCancel = true)
+    {
+        m_bCancelWait.store(bCancel);
+
+        if (bCancel == true)
+        {
+            std::lock_guard<std::mutex> lock{m_waitMutex};
+
+            m_dataReadyVar.notify_all();
+            m_spaceReadyVar.notify_all();
+        }
+    }
+};
+
+#endif // _MPMC_QUEUE_H_
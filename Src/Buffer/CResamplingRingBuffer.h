@@ -0,0 +1,583 @@
+//****************************************************************************
+// FILE:    CResamplingRingBuffer.h
+//
+// DESC:    A ring buffer between 2 audio devices (or streams) that run
+//          at different sample rates, ie: capture at 44.1 kHz and
+//          playback at 48 kHz.
+//
+//          writeBlock() takes (interleaved) frames at the input rate,
+//          readBlock() returns frames at the output rate.  The read side
+//          resamples with a windowed sinc (Blackman window) polyphase
+//          filter, with linear interpolation between the filter phases.
+//
+//          The two device clocks never run at exactly their nominal
+//          rates, so the resampling ratio is trimmed (by up to +/- 0.5%)
+//          by a PI controller that holds the buffer fill level at its
+//          target - the reader never runs dry, and the writer never
+//          overflows the buffer (once the loop has locked).
+//
+//          If the buffer does run dry (ie: the writer stops), readBlock()
+//          returns silence until the buffer has filled back up to the
+//          target level.  If it overflows, the oldest frames are dropped.
+//
+//          NOTE: 1 writer thread and 1 reader thread.  The rate / status
+//          functions are called on the reader thread.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _RESAMPLING_RING_BUFFER_H_
+#define _RESAMPLING_RING_BUFFER_H_
+
+
+#include "../Logging/Logging.h"
+
+#include "CRingBuffer.h"
+#include "SampleConvert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+
+#define RESAMPLER_HALF_TAPS         16          // filter taps on each side of the centre
+#define RESAMPLER_NUM_TAPS          (RESAMPLER_HALF_TAPS * 2)
+#define RESAMPLER_NUM_PHASES        256         // sub-sample positions in the filter table
+#define RESAMPLER_CUTOFF            0.95        // low pass cutoff (fraction of the lower Nyquist rate)
+
+// Drift control: the fill error is measured in seconds (of input), and
+// the ratio correction = (P * error) + (I * error integral).  These gains
+// give a well damped loop with a ~15 minute period, slow enough
+// that the pitch changes are inaudible.
+//
+// The fill level is averaged over (at least) a whole write period, so
+// the read side doesn't see the jump of each write.  When the reads and
+// writes are the same length the sampled fill level still steps by a
+// whole write block each time the read / write phase slips, so the P
+// gain is kept low, and the ratio change per second is slew limited.
+#define RESAMPLER_MAX_CORRECTION    0.005       // max. ratio correction (+/- 0.5%)
+#define RESAMPLER_DRIFT_P_GAIN      0.01        // 1/s
+#define RESAMPLER_DRIFT_I_GAIN      0.00005     // 1/s^2
+#define RESAMPLER_DRIFT_SMOOTHING   20.0        // fill level low pass filter time constant (seconds)
+#define RESAMPLER_DRIFT_SLEW        0.00002     // max. ratio change per second (20 ppm/s)
+
+
+template <typename T> class CResamplingRingBuffer
+{
+    static_assert(getSampleFormat<T>() != eSampleFormat_unknown, "CResamplingRingBuffer needs an int16_t, int32_t, float or double sample type");
+
+    CRingBuffer<float>      m_ring;             // input frames (interleaved, as float)
+
+    unsigned int            m_numChls;
+    double                  m_inRate;
+    double                  m_outRate;
+    size_t                  m_capacityFrames;
+    size_t                  m_targetFill;       // fill level (input frames) the drift control holds
+
+    std::vector<float>      m_coeffs;           // (RESAMPLER_NUM_PHASES + 1) x RESAMPLER_NUM_TAPS
+
+    // Read side state
+    std::vector<float>      m_history;          // input frames being resampled
+    size_t                  m_histFrames;
+    double                  m_pos;              // read position in m_history (in frames)
+    double                  m_nominalStep;      // input frames per output frame (inRate / outRate)
+    double                  m_step;             // ... with the drift correction
+    double                  m_fillSum;          // fill level * output frames, over the current write period
+    size_t                  m_fillFrames;       // output frames summed in m_fillSum
+    double                  m_errAvg;
+    double                  m_integral;
+    double                  m_correction;
+    bool                    m_bPrimed;          // false = filling up to the target level
+    std::vector<float>      m_readScratch;
+
+    // Write side state
+    std::vector<float>      m_writeScratch;
+    std::atomic<size_t>     m_writeFrames;      // frames in the last write
+
+    std::atomic<unsigned long>  m_nUnderruns;
+    std::atomic<unsigned long>  m_nOverruns;
+
+  protected:
+
+    // Build the polyphase windowed sinc filter table
+    void buildFilter()
+    {
+        const double pi = 3.14159265358979323846;
+        const double cutoff = std::min(1.0, (m_outRate / m_inRate)) * RESAMPLER_CUTOFF;
+
+        m_coeffs.assign(((RESAMPLER_NUM_PHASES + 1) * RESAMPLER_NUM_TAPS), 0.0f);
+
+        for (int phase = 0; phase <= RESAMPLER_NUM_PHASES; phase++)
+        {
+            double frac = ((double) phase / RESAMPLER_NUM_PHASES);
+            double sum = 0.0;
+
+            float *pCoeffs = &m_coeffs[phase * RESAMPLER_NUM_TAPS];
+
+            for (int tap = 0; tap < RESAMPLER_NUM_TAPS; tap++)
+            {
+                // distance (in input frames) from the output position
+                double x = ((tap - (RESAMPLER_HALF_TAPS - 1)) - frac);
+
+                double sinc = (x == 0.0) ? 1.0 : (sin(pi * cutoff * x) / (pi * cutoff * x));
+
+                double window = 0.0;
+
+                if (fabs(x) < RESAMPLER_HALF_TAPS)
+                    window = 0.42 + (0.5 * cos((pi * x) / RESAMPLER_HALF_TAPS)) + (0.08 * cos((2.0 * pi * x) / RESAMPLER_HALF_TAPS));
+
+                double value = (cutoff * sinc * window);
+
+                pCoeffs[tap] = (float) value;
+                sum += value;
+            }
+
+            // unity gain at DC, for every phase
+            for (int tap = 0; tap < RESAMPLER_NUM_TAPS; tap++)
+                pCoeffs[tap] = (float) (pCoeffs[tap] / sum);
+        }
+    }
+
+    // Restart the read side (the history starts with RESAMPLER_HALF_TAPS - 1
+    // frames of silence, so the 1st output frame is the 1st input frame)
+    void resetReader()
+    {
+        m_histFrames = (RESAMPLER_HALF_TAPS - 1);
+        m_history.assign((m_histFrames * m_numChls), 0.0f);
+
+        m_pos = (RESAMPLER_HALF_TAPS - 1);
+        m_bPrimed = false;
+
+        resetDrift();
+    }
+
+    // Restart the drift control from the nominal ratio
+    void resetDrift()
+    {
+        m_step = m_nominalStep;
+        m_fillSum = 0.0;
+        m_fillFrames = 0;
+        m_errAvg = 0.0;
+        m_integral = 0.0;
+        m_correction = 0.0;
+    }
+
+    size_t getRingFrames()
+    {
+        return (m_ring.getCurrentDataSize() / m_numChls);
+    }
+
+    // Trim the resampling ratio, to pull the fill level towards the
+    // target.  fillLevel = the fill level before this block is read,
+    // numFrames = the (output) frames in this block.
+    void updateDrift(const size_t fillLevel, const size_t numFrames)
+    {
+        // average the fill level over (at least) 1 write period, so the
+        // jump of each write is spread over the period it covers
+        m_fillSum += ((double) fillLevel * (double) numFrames);
+        m_fillFrames += numFrames;
+
+        double writePeriod = (((double) m_writeFrames.load() * m_outRate) / m_inRate);
+
+        if ((double) m_fillFrames < writePeriod)
+            return;
+
+        double dt = ((double) m_fillFrames / m_outRate);
+        double fill = (m_fillSum / (double) m_fillFrames);
+
+        m_fillSum = 0.0;
+        m_fillFrames = 0;
+
+        // smooth out the period to period jitter of the fill level
+        double err = ((fill - (double) m_targetFill) / m_inRate);
+
+        m_errAvg += (std::min(1.0, (dt / RESAMPLER_DRIFT_SMOOTHING)) * (err - m_errAvg));
+
+        m_integral += (RESAMPLER_DRIFT_I_GAIN * m_errAvg * dt);
+        m_integral = std::max(-RESAMPLER_MAX_CORRECTION, std::min(m_integral, RESAMPLER_MAX_CORRECTION));
+
+        double correction = ((RESAMPLER_DRIFT_P_GAIN * m_errAvg) + m_integral);
+
+        correction = std::max(-RESAMPLER_MAX_CORRECTION, std::min(correction, RESAMPLER_MAX_CORRECTION));
+
+        // limit the rate of the pitch change
+        double maxChange = (RESAMPLER_DRIFT_SLEW * dt);
+
+        m_correction += std::max(-maxChange, std::min((correction - m_correction), maxChange));
+
+        // fuller than the target = consume input faster
+        m_step = (m_nominalStep * (1.0 + m_correction));
+    }
+
+    // Drop the history frames the filter no longer needs
+    void compactHistory()
+    {
+        size_t drop = (size_t) m_pos;
+
+        if (drop <= (RESAMPLER_HALF_TAPS - 1))
+            return;
+
+        drop -= (RESAMPLER_HALF_TAPS - 1);
+
+        if (drop > m_histFrames)
+            drop = m_histFrames;
+
+        memmove(m_history.data(), (m_history.data() + (drop * m_numChls)), ((m_histFrames - drop) * m_numChls * sizeof(float)));
+
+        m_histFrames -= drop;
+        m_pos -= (double) drop;
+    }
+
+    // Move (up to) numFrames from the ring to the end of the history,
+    // in pieces no bigger than the ring (a bigger read would fail)
+    void pullFrames(const size_t numFrames)
+    {
+        if (numFrames < 1)
+            return;
+
+        if (m_history.size() < ((m_histFrames + numFrames) * m_numChls))
+            m_history.resize((m_histFrames + numFrames) * m_numChls);
+
+        size_t remaining = numFrames;
+
+        while (remaining > 0)
+        {
+            size_t count = std::min(remaining, m_capacityFrames);
+
+            int numRead = m_ring.readBlock((m_history.data() + (m_histFrames * m_numChls)), (count * m_numChls), true);
+
+            if (numRead <= 0)
+                break;
+
+            size_t framesRead = ((size_t) numRead / m_numChls);
+
+            m_histFrames += framesRead;
+            remaining -= framesRead;
+
+            // the ring is empty
+            if (framesRead < count)
+                break;
+        }
+    }
+
+    // Resample up to numFrames output frames from the history.
+    // Returns the number of frames produced.
+    size_t resample(float *pTarget, const size_t numFrames)
+    {
+        float coeffs[RESAMPLER_NUM_TAPS];
+
+        size_t frame = 0;
+
+        for (; frame < numFrames; frame++)
+        {
+            size_t idx = (size_t) m_pos;
+
+            if ((idx + RESAMPLER_HALF_TAPS) >= m_histFrames)
+                break;
+
+            double phasePos = ((m_pos - (double) idx) * RESAMPLER_NUM_PHASES);
+            int phase = (int) phasePos;
+            float blend = (float) (phasePos - phase);
+
+            const float *pCoeffs0 = &m_coeffs[phase * RESAMPLER_NUM_TAPS];
+            const float *pCoeffs1 = (pCoeffs0 + RESAMPLER_NUM_TAPS);
+
+            for (int tap = 0; tap < RESAMPLER_NUM_TAPS; tap++)
+                coeffs[tap] = pCoeffs0[tap] + (blend * (pCoeffs1[tap] - pCoeffs0[tap]));
+
+            const float *pInput = (m_history.data() + ((idx - (RESAMPLER_HALF_TAPS - 1)) * m_numChls));
+
+            for (unsigned int chl = 0; chl < m_numChls; chl++)
+            {
+                float sum = 0.0f;
+
+                for (int tap = 0; tap < RESAMPLER_NUM_TAPS; tap++)
+                    sum += (coeffs[tap] * pInput[(tap * m_numChls) + chl]);
+
+                pTarget[(frame * m_numChls) + chl] = sum;
+            }
+
+            m_pos += m_step;
+        }
+
+        return frame;
+    }
+
+  public:
+
+    CResamplingRingBuffer() :
+        m_writeFrames(0),
+        m_nUnderruns(0),
+        m_nOverruns(0)
+    {
+        m_numChls = 0;
+        m_inRate = 0.0;
+        m_outRate = 0.0;
+        m_capacityFrames = 0;
+        m_targetFill = 0;
+
+        m_histFrames = 0;
+        m_pos = 0.0;
+        m_nominalStep = 1.0;
+        m_step = 1.0;
+        m_fillSum = 0.0;
+        m_fillFrames = 0;
+        m_errAvg = 0.0;
+        m_integral = 0.0;
+        m_correction = 0.0;
+        m_bPrimed = false;
+    }
+
+    // Set up the buffer.  capacityFrames = max. number of (input)
+    // frames buffered, targetFill = the fill level (in input frames)
+    // the drift control holds (0 = half the capacity).
+    // Returns 0, or -1 = invalid param, -2 = out of memory
+    int init
+        (
+            const unsigned int numChls,
+            const double inRate,
+            const double outRate,
+            const size_t capacityFrames,
+            const size_t targetFill = 0
+        )
+    {
+        if (numChls < 1 || inRate <= 0.0 || outRate <= 0.0 || capacityFrames < (RESAMPLER_NUM_TAPS * 2))
+        {
+            LogDebug("[CResamplingRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (targetFill >= capacityFrames)
+        {
+            LogDebug("[CResamplingRingBuffer:{}] Invalid target fill level ", __func__);
+            return -1;
+        }
+
+        if (m_ring.setMaxBufferSize(numChls, capacityFrames) == false)
+        {
+            LogDebug("[CResamplingRingBuffer:{}] Failed to allocate the buffer ", __func__);
+            return -2;
+        }
+
+        m_numChls = numChls;
+        m_inRate = inRate;
+        m_outRate = outRate;
+        m_capacityFrames = capacityFrames;
+        m_targetFill = (targetFill > 0) ? targetFill : (capacityFrames / 2);
+
+        m_nominalStep = (inRate / outRate);
+
+        buildFilter();
+        resetReader();
+
+        m_writeFrames = 0;
+        m_nUnderruns = 0;
+        m_nOverruns = 0;
+
+        return 0;
+    }
+
+    // Change the nominal input / output rates (ie: a device was
+    // re-opened).  NOTE: Call this on the reader thread.
+    // Returns 0, or -1 = invalid param
+    int setRates(const double inRate, const double outRate)
+    {
+        if (m_numChls < 1 || inRate <= 0.0 || outRate <= 0.0)
+        {
+            LogDebug("[CResamplingRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        m_inRate = inRate;
+        m_outRate = outRate;
+        m_nominalStep = (inRate / outRate);
+
+        buildFilter();
+
+        // the drift control starts again from the new nominal ratio
+        resetDrift();
+
+        return 0;
+    }
+
+    // Write numFrames (interleaved) frames, at the input rate.
+    // If the buffer is full the oldest frames are dropped (an overrun).
+    // Returns the number of frames written, or -1 = invalid param
+    int writeBlock(const T *pSource, const size_t numFrames)
+    {
+        if (pSource == nullptr || m_numChls < 1)
+        {
+            LogDebug("[CResamplingRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        m_writeFrames = numFrames;
+
+        // write in pieces smaller than the ring
+        const size_t maxFrames = (m_capacityFrames / 2);
+
+        size_t written = 0;
+
+        while (written < numFrames)
+        {
+            size_t count = std::min((numFrames - written), maxFrames);
+            size_t numSamples = (count * m_numChls);
+
+            const T *pFrames = (pSource + (written * m_numChls));
+            const float *pData;
+
+            if constexpr (std::is_same<T, float>::value)
+            {
+                pData = pFrames;
+            }
+            else
+            {
+                if (m_writeScratch.size() < numSamples)
+                    m_writeScratch.resize(numSamples);
+
+                convertToFloat(m_writeScratch.data(), pFrames, getSampleFormat<T>(), numSamples);
+
+                pData = m_writeScratch.data();
+            }
+
+            if ((getRingFrames() + count) > m_capacityFrames)
+                m_nOverruns++;
+
+            if (m_ring.writeBlock(pData, numSamples, true) < 0)
+                break;
+
+            written += count;
+        }
+
+        return (int) written;
+    }
+
+    // Read numFrames (interleaved) frames, at the output rate.  Any
+    // frames that can't be produced (the buffer ran dry) are silence.
+    // Returns numFrames, or -1 = invalid param
+    int readBlock(T *pTarget, const size_t numFrames)
+    {
+        if (pTarget == nullptr || m_numChls < 1)
+        {
+            LogDebug("[CResamplingRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (numFrames < 1)
+            return 0;
+
+        size_t numSamples = (numFrames * m_numChls);
+
+        float *pOutput;
+
+        if constexpr (std::is_same<T, float>::value)
+        {
+            pOutput = pTarget;
+        }
+        else
+        {
+            if (m_readScratch.size() < numSamples)
+                m_readScratch.resize(numSamples);
+
+            pOutput = m_readScratch.data();
+        }
+
+        size_t produced = 0;
+
+        // (re-)fill up to the target level before starting
+        if (m_bPrimed == false && getFillLevel() >= m_targetFill)
+            m_bPrimed = true;
+
+        if (m_bPrimed == true)
+        {
+            compactHistory();
+
+            updateDrift(getFillLevel(), numFrames);
+
+            // input frames needed for this block
+            size_t lastIdx = (size_t) (m_pos + (m_step * (double) (numFrames - 1)));
+            size_t needed = (lastIdx + RESAMPLER_HALF_TAPS + 1);
+
+            if (needed > m_histFrames)
+                pullFrames(needed - m_histFrames);
+
+            produced = resample(pOutput, numFrames);
+
+            if (produced < numFrames)
+            {
+                m_nUnderruns++;
+
+                m_bPrimed = false;
+            }
+        }
+
+        if (produced < numFrames)
+            memset((pOutput + (produced * m_numChls)), 0, ((numFrames - produced) * m_numChls * sizeof(float)));
+
+        if constexpr (std::is_same<T, float>::value == false)
+            convertFromFloat(pTarget, getSampleFormat<T>(), pOutput, numSamples, SAMPLE_CONVERT_CLIP);
+
+        return (int) numFrames;
+    }
+
+    // Drop all the buffered frames, and restart the drift control
+    void reset()
+    {
+        m_ring.flush();
+
+        resetReader();
+    }
+
+    // Get the number of input frames buffered (not yet resampled)
+    size_t getFillLevel()
+    {
+        double ahead = ((double) m_histFrames - m_pos);
+
+        return (getRingFrames() + (size_t) std::max(0.0, ahead));
+    }
+
+    size_t getTargetFill()
+    {
+        return m_targetFill;
+    }
+
+    size_t getCapacity()
+    {
+        return m_capacityFrames;
+    }
+
+    unsigned int getNumChannels()
+    {
+        return m_numChls;
+    }
+
+    // Get the current resampling ratio (input frames per output frame)
+    double getRatio()
+    {
+        return m_step;
+    }
+
+    // Get the current drift correction, in parts per million
+    double getCorrectionPpm()
+    {
+        return (((m_step / m_nominalStep) - 1.0) * 1000000.0);
+    }
+
+    unsigned long getNumUnderruns()
+    {
+        return m_nUnderruns.load();
+    }
+
+    unsigned long getNumOverruns()
+    {
+        return m_nOverruns.load();
+    }
+};
+
+
+#endif // _RESAMPLING_RING_BUFFER_H_
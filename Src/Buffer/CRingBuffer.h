@@ -13,6 +13,8 @@
 
 #include "../Logging/Logging.h"
 
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <string>
 
@@ -20,6 +22,8 @@
 
 #include <cstring>
 
+#include "RingBufferUtils.h"
+
 
 //#define DIAPLAY_CONSOLE_LOG_MESSAGES
 
@@ -38,13 +42,26 @@ template <typename T> class CRingBuffer
     
     std::mutex              m_ioMutex;
 
+    std::condition_variable m_dataReadyVar;         // signaled when entries are written
+    std::condition_variable m_spaceReadyVar;        // signaled when entries are deleted
+
+    size_t                  m_lowWaterMark;         // see setWaterMarks()
+    size_t                  m_highWaterMark;
+
+    int                     m_nReadWaiters;         // number of threads in readBlockWait()
+    size_t                  m_nReadWakeLevel;       // data size they are waiting for
+    int                     m_nWriteWaiters;        // number of threads in writeBlockWait()
+    size_t                  m_nWriteWakeLevel;      // data size they are waiting for
+
+    bool                    m_bCancelWait;
+
   protected:
 
     void free()
     {
         if (m_pDataBuffer != nullptr)
         {
-            free(m_pDataBuffer);
+            ::free(m_pDataBuffer);
 
             m_pDataBuffer = nullptr;
         }
@@ -84,90 +101,159 @@ template <typename T> class CRingBuffer
             return false;
         }
 
-        if (numEntries == 1)
+        // If numEntries to delete is too large
+        // delete everything we have.
+        if (numEntries > (int) m_bufferSize)
+        {
+            LogError
+            (
+                "[CRingBuffer:{}] numEnties ({}) > maxBufSize ({})  - flushing buffer ", 
+                __func__,
+                numEntries,
+                m_bufferSize
+            );
+            m_readIdx = 0;
+            m_writeIdx = 0;
+            m_currentDataSize = 0;
+            return false;
+        }
+        
+        if (numEntries > m_currentDataSize)
+        {
+            LogDebug
+            (
+                "[CRingBuffer:{}] numEnties ({}) > currDataSiZe ({}) ", 
+                __func__,
+                numEntries,
+                m_currentDataSize
+            );
+            m_readIdx = 0;
+            m_writeIdx = 0;
+            m_currentDataSize = 0;
+        }
+        else
         {
-            if (m_readIdx == m_writeIdx)
+            if ((m_readIdx + numEntries) >= m_bufferSize) 
             {
-                LogDebug("[CRingBuffer:{}] Nothing to delete ", __func__);
-                m_readIdx = 0;
-                m_writeIdx = 0;
-                m_currentDataSize = 0;
-                return true;
-            }
-
-            m_readIdx++;
+                // the new read index would be > bufSize...
+                size_t wrapAmount = ((m_readIdx + numEntries) - m_bufferSize);
 
-            if (m_readIdx >= m_bufferSize)
-            {
-                m_readIdx = 0;
+                // so set read index to 0 + wrapAmount
+                m_readIdx = wrapAmount;
             }
-
-            if (m_currentDataSize > 0)
+            else
             {
-                m_currentDataSize--;
+                // update the read index
+                m_readIdx += numEntries;
             }
-        }
-        else
-        {
-            // If numEntries to delete is too large
-            // delete everything we have.
-            if (numEntries > (int) m_bufferSize)
+
+            // Update the number of current entries (depth)
+            if (m_currentDataSize > numEntries)
             {
-                LogError
-                (
-                    "[CRingBuffer:{}] numEnties ({}) > maxBufSize ({})  - flushing buffer ", 
-                    __func__,
-                    numEntries,
-                    m_bufferSize
-                );
-                m_readIdx = 0;
-                m_writeIdx = 0;
-                m_currentDataSize = 0;
-                return false;
+                m_currentDataSize -= numEntries;
             }
-            
-            if (numEntries > m_currentDataSize)
+            else
             {
-                LogDebug
-                (
-                    "[CRingBuffer:{}] numEnties ({}) > currDataSiZe ({}) ", 
-                    __func__,
-                    numEntries,
-                    m_currentDataSize
-                );
-                m_readIdx = 0;
-                m_writeIdx = 0;
                 m_currentDataSize = 0;
             }
-            else
+        }
+
+        return true;
+    }
+
+    // Copy up to numEntries (from the current read index) to
+    // the target buffer, then (optionally) delete them.
+    // The copy is done in (at most) 2 blocks, up to the end of
+    // the data buffer, then the wrapped remainder.
+    // NOTE: m_ioMutex must be held by the caller.
+    int read(T *pTargetBuff, const size_t numEntries, const bool deleteEntries)
+    {
+        size_t numEntriesToRead = numEntries;
+
+        if (numEntriesToRead > m_currentDataSize)
+            numEntriesToRead = m_currentDataSize;
+
+        if (numEntriesToRead < 1)
+            return 0;
+
+        copyFromRing(pTargetBuff, m_pDataBuffer, m_bufferSize, m_readIdx, numEntriesToRead);
+
+        // If true, delete the entries read
+        if (deleteEntries == true)
+        {
+            erase(numEntriesToRead);
+
+            notifySpaceReady();
+        }
+
+        return (int) numEntriesToRead;
+    }
+
+    // Copy numEntries from the source buffer to the data buffer
+    // (at the current write index), in (at most) 2 blocks.
+    // If there is not enough room, either fail (bOverwrite = false)
+    // or delete the oldest entries to make room.
+    // NOTE: m_ioMutex must be held by the caller.
+    int write(const T *pSourceBuff, const size_t numEntries, const bool bOverwrite)
+    {
+        size_t numEntriesFree = (m_bufferSize - m_currentDataSize);
+
+        if (numEntries > numEntriesFree)
+        {
+            if (bOverwrite == false)
             {
-                if ((m_readIdx + numEntries) >= m_bufferSize) 
-                {
-                    // the new read index would be > bufSize...
-                    size_t wrapAmount = ((m_readIdx + numEntries) - m_bufferSize);
-
-                    // so set read index to 0 + wrapAmount
-                    m_readIdx = wrapAmount;
-                }
-                else
-                {
-                    // update the read index
-                    m_readIdx += numEntries;
-                }
-
-                // Update the number of current entries (depth)
-                if (m_currentDataSize > numEntries)
-                {
-                    m_currentDataSize -= numEntries;
-                }
-                else
-                {
-                    m_currentDataSize = 0;
-                }
+                // overwrite flag = false, so exit
+                LogDebug("[CRingBuffer:{}] Buffer over-flow ", __func__);
+                return -5;
             }
+
+            LogTrace
+            (
+                "[CRingBuffer:{}] currSize: {}, maxBufSize: {} - buffer full ", 
+                __func__,
+                m_currentDataSize,
+                m_bufferSize
+            );
+
+            // overwrite flag = true, so drop the oldest entries
+            erase(numEntries - numEntriesFree);
         }
 
-        return true;
+        copyToRing(m_pDataBuffer, m_bufferSize, m_writeIdx, pSourceBuff, numEntries);
+
+        m_writeIdx += numEntries;
+        if (m_writeIdx >= m_bufferSize)
+        {
+            m_writeIdx -= m_bufferSize;
+        }
+
+        m_currentDataSize += numEntries;
+
+        notifyDataReady();
+
+        return (int) numEntries;
+    }
+
+    // Wake any reader(s) waiting in readBlockWait(), once the
+    // data size has reached the level they are waiting for.
+    // NOTE: m_ioMutex must be held by the caller.
+    void notifyDataReady()
+    {
+        if (m_nReadWaiters > 0 && m_currentDataSize >= m_nReadWakeLevel)
+        {
+            m_dataReadyVar.notify_all();
+        }
+    }
+
+    // Wake any writer(s) waiting in writeBlockWait(), once the
+    // data size has fallen to the level they are waiting for.
+    // NOTE: m_ioMutex must be held by the caller.
+    void notifySpaceReady()
+    {
+        if (m_nWriteWaiters > 0 && m_currentDataSize <= m_nWriteWakeLevel)
+        {
+            m_spaceReadyVar.notify_all();
+        }
     }
 
   public:
@@ -183,6 +269,16 @@ template <typename T> class CRingBuffer
         m_writeIdx = 0;
         m_readIdx = 0;
 
+        m_lowWaterMark = 0;
+        m_highWaterMark = 0;
+
+        m_nReadWaiters = 0;
+        m_nReadWakeLevel = 0;
+        m_nWriteWaiters = 0;
+        m_nWriteWakeLevel = 0;
+
+        m_bCancelWait = false;
+
         if (numEntries > 0)
         {
             if (allocateBuffer(numEntries) == true)
@@ -201,6 +297,16 @@ template <typename T> class CRingBuffer
         m_writeIdx = 0;
         m_readIdx = 0;
 
+        m_lowWaterMark = 0;
+        m_highWaterMark = 0;
+
+        m_nReadWaiters = 0;
+        m_nReadWakeLevel = 0;
+        m_nWriteWaiters = 0;
+        m_nWriteWakeLevel = 0;
+
+        m_bCancelWait = false;
+
         if (entriesPerBlock > 0 && numBlocks > 0)
         {
             auto numEntries = (entriesPerBlock * numBlocks);
@@ -283,6 +389,8 @@ template <typename T> class CRingBuffer
         m_writeIdx = 0;
         m_readIdx = 0;
 
+        notifySpaceReady();
+
         if (bZeroOutBuffer == false)
         {
             return true;
@@ -325,52 +433,10 @@ template <typename T> class CRingBuffer
         if (m_currentDataSize < 1)
             return 0;
 
-        size_t numEntriesToRead = blockSize;
-
-		unsigned int currentReadIdx = (unsigned int) m_readIdx;
-		unsigned int entriesRead = 0;
-
-        // copy the data from the data buffer to the target buffer
-        while (entriesRead < numEntriesToRead)
-		{
-			if (currentReadIdx >= m_bufferSize)
-            {
-				currentReadIdx = 0;
-            }
-
-			if (currentReadIdx == m_writeIdx)
-            {
-                // No data in buffer to read
-				break;
-            }
-
-            try
-            {
-                T valueRead = *(m_pDataBuffer + currentReadIdx);
-
-                *(pTargetBuff + entriesRead) = valueRead;
-            }
-            catch(...)
-            {
-                LogDebug("[CRingBuffer:{}] Unknown exception ", __func__);
-                break;
-            }
-
-			// If true, delete the current entry
-			if (deleteEntries == true)
-			{
-                erase(1);
-            }
-			
-            currentReadIdx++;
-
-			entriesRead++;
-		}
-
-        return (int) entriesRead;
+        return read(pTargetBuff, blockSize, deleteEntries);
     }
 
-    // Read "blockSize" entries from the data block (entry array).
+    // Read (entriesPerBlock * blockSize) entries from the data block (entry array).
     volatile int readBlock
         (
             T *pTargetBuff, 
@@ -399,49 +465,7 @@ template <typename T> class CRingBuffer
             return 0;
         }
 
-        size_t numEntriesToRead = (entriesPerBlock * blockSize);
-
-		unsigned int currentReadIdx = (unsigned int) m_readIdx;
-		unsigned int entriesRead = 0;
-
-        // copy the data from the data buffer to the target buffer
-        while (entriesRead < numEntriesToRead)
-		{
-			if (currentReadIdx >= m_bufferSize)
-            {
-				currentReadIdx = 0;
-            }
-
-			if (currentReadIdx == m_writeIdx)
-            {
-                // No data in buffer to read
-				break;
-            }
-			
-            try
-            {
-                T valueRead = *(m_pDataBuffer + currentReadIdx);
-
-                *(pTargetBuff + entriesRead) = valueRead;
-            }
-            catch(...)
-            {
-                LogDebug("[CRingBuffer:{}] Unknown exception ", __func__);
-                break;
-            }
-			
-			// If true, delete the current entry
-			if (deleteEntries == true)
-			{
-                erase(1);
-            }
-			
-            currentReadIdx++;
-
-			entriesRead++;
-		}
-
-        return (int) entriesRead;
+        return read(pTargetBuff, (entriesPerBlock * blockSize), deleteEntries);
     }
 
     // Write "blockSize" entries to the data block (entry array).
@@ -466,84 +490,10 @@ template <typename T> class CRingBuffer
             return -2;
         }
 
-		unsigned int entriesWritten = 0;
-
-        // copy the data from the input buffer to the data buffer
-        while (entriesWritten < blockSize)
-		{
-			if (m_writeIdx == m_readIdx && m_currentDataSize > 0)
-			{
-				if (bOverwrite == false)
-				{
-					// overwrite flag = false, so break
-                    LogDebug("[CRingBuffer:{}] Buffer over-flow ", __func__);
-    				return -5;
-				}
-				else
-				{
-					// overwrite flag = true, so update read index
-					m_readIdx++;
-					if (m_readIdx >= m_bufferSize)
-                    {
-						m_readIdx = 0;
-                    }
-				}
-			}
-
-            try
-            {
-                T valueToWrite = *(pBuff + entriesWritten);
-
-                *(m_pDataBuffer + m_writeIdx) = valueToWrite;
-            }
-            catch(...)
-            {
-                LogDebug("[CRingBuffer:{}] Unkown exception ", __func__);
-                return -6;
-            }
-			
-            if (m_currentDataSize < m_bufferSize)
-            {
-                m_currentDataSize++;
-            }
-            else
-            {
-				if (bOverwrite == false)
-				{
-                    LogDebug
-                    (
-                        "[CRingBuffer:{}] currSize: {} = maxBufSize: {}, overWrite = false ", 
-                        __func__,
-                        m_currentDataSize,
-                        m_bufferSize
-                    );
-                }
-                else
-                {
-                    LogTrace
-                    (
-                        "[CRingBuffer:{}] currSize: {} = maxBufSize: {} - buffer full ", 
-                        __func__,
-                        m_currentDataSize,
-                        m_bufferSize
-                    );
-                }
-            }
-
-            m_writeIdx++;
-			if (m_writeIdx >= m_bufferSize)
-            {
-				m_writeIdx = 0;
-            }
-
-			entriesWritten++;
-		}
-		
-
-        return entriesWritten;
+        return write(pBuff, blockSize, bOverwrite);
     }
 
-    // Write "blockSize" entries to the data block (entry array).
+    // Write (entriesPerBlock * blockSize) entries to the data block (entry array).
     volatile int writeBlock
         (
             const T *pBuff, 
@@ -574,82 +524,268 @@ template <typename T> class CRingBuffer
             return -3;
         }
 
-		unsigned int entriesWritten = 0;
-
-        // copy the data from the input buffer to the data buffer
-        while (entriesWritten < writeSize)
-		{
-			if (m_writeIdx == m_readIdx && m_currentDataSize > 0)
-			{
-				if (bOverwrite == false)
-				{
-					// overwrite flag = false, so break
-                    LogDebug("[CRingBuffer:{}] Buffer over-flow ", __func__);
-    				-5;
-				}
-				else
-				{
-					// overwrite flag = true, so update read index
-					m_readIdx++;
-					if (m_readIdx >= m_bufferSize)
-                    {
-						m_readIdx = 0;
-                    }
-				}
-			}
-			
-            try
-            {
-                T valueToWrite = *(pBuff + entriesWritten);
+        return write(pBuff, writeSize, bOverwrite);
+    }
 
-                *(m_pDataBuffer + m_writeIdx) = valueToWrite;
+    // Get (up to) "numEntries" free entries of the data buffer,
+    // to be filled in place (ie: by a decoder or a socket read),
+    // without first copying them to a scratch buffer.
+    // The returned region is only valid until commitWrite() is called.
+    // NOTE: Only one writer may hold a reservation at a time.
+    SRingBufferRegion<T> reserveWrite(const size_t numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_pDataBuffer == nullptr || m_bufferSize < 1)
+        {
+            LogDebug("[CRingBuffer:{}] Invalid buffer size ", __func__);
+            return SRingBufferRegion<T>();
+        }
+
+        size_t numEntriesFree = (m_bufferSize - m_currentDataSize);
+
+        return makeRingRegion(m_pDataBuffer, m_bufferSize, (size_t) m_writeIdx, std::min(numEntries, numEntriesFree));
+    }
+
+    // Publish "numEntries" entries written into the
+    // region returned by the last reserveWrite() call.
+    int commitWrite(const size_t numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (numEntries > (m_bufferSize - m_currentDataSize))
+        {
+            LogDebug("[CRingBuffer:{}] Buffer over-flow ", __func__);
+            return -5;
+        }
+
+        m_writeIdx += numEntries;
+        if (m_writeIdx >= m_bufferSize)
+        {
+            m_writeIdx -= m_bufferSize;
+        }
+
+        m_currentDataSize += numEntries;
+
+        notifyDataReady();
+
+        return (int) numEntries;
+    }
+
+    // Get (up to) "numEntries" entries, starting at the current read
+    // index, to be used in place (without copying them out).
+    // The returned region is only valid until consumeRead() is called.
+    // NOTE: Only one reader may hold a region at a time.
+    SRingBufferRegion<T> peekRead(const size_t numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_pDataBuffer == nullptr || m_bufferSize < 1)
+        {
+            LogDebug("[CRingBuffer:{}] Invalid buffer size ", __func__);
+            return SRingBufferRegion<T>();
+        }
+
+        return makeRingRegion(m_pDataBuffer, m_bufferSize, (size_t) m_readIdx, std::min(numEntries, (size_t) m_currentDataSize));
+    }
+
+    // Release "numEntries" entries (returned by the last peekRead() call).
+    int consumeRead(const size_t numEntries)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (numEntries > m_currentDataSize)
+        {
+            LogDebug("[CRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (numEntries > 0)
+        {
+            erase(numEntries);
+
+            notifySpaceReady();
+        }
+
+        return (int) numEntries;
+    }
+
+    // Set the fill level thresholds used by the "wait" functions, so the
+    // other side is woken once per batch rather than once per block.
+    // A reader blocked in readBlockWait() is woken when the data size
+    // reaches max(blockSize, highWaterMark).  A writer blocked in
+    // writeBlockWait() is woken when there is room for its block
+    // and the data size has fallen to lowWaterMark.
+    // (0 = no threshold)
+    bool setWaterMarks(const size_t lowWaterMark, const size_t highWaterMark)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (highWaterMark > 0 && lowWaterMark > highWaterMark)
+        {
+            LogDebug("[CRingBuffer:{}] Invalid param ", __func__);
+            return false;
+        }
+
+        m_lowWaterMark = lowWaterMark;
+        m_highWaterMark = highWaterMark;
+
+        return true;
+    }
+
+    // Release all threads blocked in readBlockWait() / writeBlockWait()
+    // (ie: on shutdown).  While cancelled, the "wait" functions don't block.
+    void cancelWait(const bool bCancel = true)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        m_bCancelWait = bCancel;
+
+        if (bCancel == true)
+        {
+            m_dataReadyVar.notify_all();
+            m_spaceReadyVar.notify_all();
+        }
+    }
+
+    // Read "blockSize" entries from the data block (entry array), waiting
+    // (up to timeoutMs milliseconds) for them to be written.
+    // Returns the number of entries read - less than blockSize only if
+    // the wait timed out or was cancelled (0 = buffer empty), or < 0 on error.
+    volatile int readBlockWait
+        (
+            T *pTargetBuff, 
+            const size_t blockSize, 
+            const unsigned int timeoutMs,
+            const bool deleteEntries = true
+        )
+    {
+        std::unique_lock<std::mutex> lock{m_ioMutex};
+
+        if (m_pDataBuffer == nullptr || pTargetBuff == nullptr)
+        {
+            LogDebug("[CRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (m_bufferSize < 1 || blockSize > m_bufferSize)
+        {
+            LogDebug("[CRingBuffer:{}] Invalid buffer size ", __func__);
+            return -1;
+        }
+
+        if (m_currentDataSize < blockSize && m_bCancelWait == false)
+        {
+            size_t wakeLevel = std::min(std::max(blockSize, m_highWaterMark), (size_t) m_bufferSize);
+
+            if (m_nReadWaiters < 1 || wakeLevel < m_nReadWakeLevel)
+            {
+                m_nReadWakeLevel = wakeLevel;
             }
-            catch(...)
+
+            m_nReadWaiters++;
+
+            // A blocked writer can't fill the buffer up to the high water mark,
+            // so let it (and this reader) go as soon as the block is available.
+            if (m_nWriteWaiters > 0)
             {
-                LogDebug("[CRingBuffer:{}] Unkown exception ", __func__);
-                return -6;
+                m_spaceReadyVar.notify_all();
             }
-			
-            if (m_currentDataSize < m_bufferSize)
+
+            m_dataReadyVar.wait_for
+                (
+                    lock, 
+                    std::chrono::milliseconds(timeoutMs), 
+                    [&]
+                    {
+                        return
+                            (
+                                m_currentDataSize >= wakeLevel || 
+                                (m_currentDataSize >= blockSize && m_nWriteWaiters > 0) ||
+                                m_bCancelWait == true
+                            );
+                    }
+                );
+
+            m_nReadWaiters--;
+        }
+
+        if (m_currentDataSize < 1)
+            return 0;
+
+        return read(pTargetBuff, blockSize, deleteEntries);
+    }
+
+    // Write "blockSize" entries to the data block (entry array), waiting
+    // (up to timeoutMs milliseconds) for room to write them.
+    // Returns the number of entries written, -5 if the wait timed out
+    // or was cancelled (nothing is written), or < 0 on error.
+    volatile int writeBlockWait
+        (
+            const T *pBuff, 
+            const size_t blockSize, 
+            const unsigned int timeoutMs
+        )
+    {
+        std::unique_lock<std::mutex> lock{m_ioMutex};
+
+        if (m_pDataBuffer == nullptr || pBuff == nullptr)
+        {
+            LogDebug("[CRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (m_bufferSize < 1 || blockSize >= m_bufferSize)
+        {
+            LogDebug("[CRingBuffer:{}] Invalid buffer size ", __func__);
+            return -2;
+        }
+
+        // Largest data size that leaves room for this block
+        size_t maxDataSize = (m_bufferSize - blockSize);
+
+        if (m_currentDataSize > maxDataSize && m_bCancelWait == false)
+        {
+            size_t wakeLevel = maxDataSize;
+
+            if (m_lowWaterMark > 0 && m_lowWaterMark < wakeLevel)
             {
-                m_currentDataSize++;
+                wakeLevel = m_lowWaterMark;
             }
-            else
+
+            if (m_nWriteWaiters < 1 || wakeLevel > m_nWriteWakeLevel)
             {
-				if (bOverwrite == false)
-				{
-                    LogDebug
-                    (
-                        "[CRingBuffer:{}] entriesPerBlock: {}, currSize: {} = maxBufSize: {}, overWrite = false ", 
-                        __func__,
-                        entriesPerBlock,
-                        m_currentDataSize,
-                        m_bufferSize
-                    );
-                }
-                else
-                {
-                    LogTrace
-                    (
-                        "[CRingBuffer:{}] entriesPerBlock: {}, currSize: {},  maxBufSize: {} ", 
-                        __func__,
-                        entriesPerBlock,
-                        m_currentDataSize,
-                        m_bufferSize
-                    );
-                }
+                m_nWriteWakeLevel = wakeLevel;
             }
 
-            m_writeIdx++;
-			if (m_writeIdx >= m_bufferSize)
+            m_nWriteWaiters++;
+
+            // A blocked reader can't drain the buffer down to the low water mark,
+            // so let it (and this writer) go as soon as there is room for the block.
+            if (m_nReadWaiters > 0)
             {
-				m_writeIdx = 0;
+                m_dataReadyVar.notify_all();
             }
 
-			entriesWritten++;
-		}
-		
-        return entriesWritten;
+            m_spaceReadyVar.wait_for
+                (
+                    lock, 
+                    std::chrono::milliseconds(timeoutMs), 
+                    [&]
+                    {
+                        return
+                            (
+                                m_currentDataSize <= wakeLevel || 
+                                (m_currentDataSize <= maxDataSize && m_nReadWaiters > 0) ||
+                                m_bCancelWait == true
+                            );
+                    }
+                );
+
+            m_nWriteWaiters--;
+        }
+
+        return write(pBuff, blockSize, false);
     }
 
     // Delete (remove) 1 entry.
@@ -657,7 +793,11 @@ template <typename T> class CRingBuffer
     {
         std::lock_guard<std::mutex> lock{m_ioMutex};
 
-        return erase(1);
+        auto status = erase(1);
+
+        notifySpaceReady();
+
+        return status;
     }
 
     // Delete (remove) entries, from  start to 1 less than end. 
@@ -666,7 +806,11 @@ template <typename T> class CRingBuffer
     {
         std::lock_guard<std::mutex> lock{m_ioMutex};
 
-        return erase(numEntries);
+        auto status = erase(numEntries);
+
+        notifySpaceReady();
+
+        return status;
     }
 };
 
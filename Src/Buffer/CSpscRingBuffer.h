@@ -0,0 +1,505 @@
+//****************************************************************************
+// FILE:    CSpscRingBuffer.h
+//
+// DESC:    Lock-free, single-producer / single-consumer ring buffer
+//          class with configurable data type.
+//
+//          NOTE: Exactly one thread may call the "write" functions
+//          and exactly one (other) thread may call the "read" /
+//          "delete" functions.  Neither side ever blocks the other.
+//          setMaxBufferSize() and flush(true) must only be called
+//          while no reads or writes are in progress.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _SPSC_RING_BUFFER_H_
+#define _SPSC_RING_BUFFER_H_
+
+
+#include "../Logging/Logging.h"
+
+#include "RingBufferUtils.h"
+
+#include <atomic>
+#include <string>
+
+#include <cstdlib>
+#include <cstring>
+
+
+template <typename T> class CSpscRingBuffer
+{
+    T                       *m_pDataBuffer;
+
+    size_t                  m_bufferSize;
+
+    size_t                  m_entriesPerBlock;
+
+    // The read/write "indices" are free running entry counters.
+    // The storage offset is (counter % m_bufferSize), and the
+    // current data size is (writeIdx - readIdx).
+
+    // Producer side (written only by the producer)
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t>    m_writeIdx;
+    size_t                                          m_cachedReadIdx;
+
+    // Consumer side (written only by the consumer)
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t>    m_readIdx;
+    size_t                                          m_cachedWriteIdx;
+
+    char                    m_padding[CACHE_LINE_SIZE - sizeof(size_t)];
+
+  protected:
+
+    void free()
+    {
+        if (m_pDataBuffer != nullptr)
+        {
+            ::free(m_pDataBuffer);
+
+            m_pDataBuffer = nullptr;
+        }
+
+        m_bufferSize = 0;
+    }
+
+    bool allocateBuffer(const size_t numEntries)
+    {
+        free();
+
+        m_writeIdx.store(0, std::memory_order_relaxed);
+        m_readIdx.store(0, std::memory_order_relaxed);
+
+        m_cachedReadIdx = 0;
+        m_cachedWriteIdx = 0;
+
+        if (numEntries > 0)
+        {
+            m_pDataBuffer = (T*) calloc(numEntries, sizeof(T));
+
+            if (m_pDataBuffer == nullptr)
+            {
+                LogDebug("[CSpscRingBuffer:{}] Invalid data buffer pointer ", __func__);
+                return false;
+            }
+
+            m_bufferSize = numEntries;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    // Number of entries available to the consumer.
+    // (Only call from the consumer thread)
+    size_t availableToRead()
+    {
+        size_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+
+        size_t numEntries = (m_cachedWriteIdx - readIdx);
+
+        if (numEntries < 1)
+        {
+            m_cachedWriteIdx = m_writeIdx.load(std::memory_order_acquire);
+
+            numEntries = (m_cachedWriteIdx - readIdx);
+        }
+
+        return numEntries;
+    }
+
+    // Number of free entries available to the producer.
+    // (Only call from the producer thread)
+    size_t availableToWrite(const size_t numWanted)
+    {
+        size_t writeIdx = m_writeIdx.load(std::memory_order_relaxed);
+
+        size_t numFree = (m_bufferSize - (writeIdx - m_cachedReadIdx));
+
+        if (numFree < numWanted)
+        {
+            m_cachedReadIdx = m_readIdx.load(std::memory_order_acquire);
+
+            numFree = (m_bufferSize - (writeIdx - m_cachedReadIdx));
+        }
+
+        return numFree;
+    }
+
+    // Copy up to numEntries to the target buffer, and
+    // (optionally) release them back to the producer.
+    int read(T *pTargetBuff, const size_t numEntries, const bool deleteEntries)
+    {
+        size_t numEntriesToRead = std::min(numEntries, availableToRead());
+
+        if (numEntriesToRead < 1)
+            return 0;
+
+        size_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+
+        copyFromRing(pTargetBuff, m_pDataBuffer, m_bufferSize, (readIdx % m_bufferSize), numEntriesToRead);
+
+        if (deleteEntries == true)
+        {
+            m_readIdx.store((readIdx + numEntriesToRead), std::memory_order_release);
+        }
+
+        return (int) numEntriesToRead;
+    }
+
+    // Copy numEntries from the source buffer, and publish them
+    // to the consumer.  Nothing is written if there is not enough room.
+    int write(const T *pSourceBuff, const size_t numEntries)
+    {
+        if (availableToWrite(numEntries) < numEntries)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Buffer over-flow ", __func__);
+            return -5;
+        }
+
+        size_t writeIdx = m_writeIdx.load(std::memory_order_relaxed);
+
+        copyToRing(m_pDataBuffer, m_bufferSize, (writeIdx % m_bufferSize), pSourceBuff, numEntries);
+
+        m_writeIdx.store((writeIdx + numEntries), std::memory_order_release);
+
+        return (int) numEntries;
+    }
+
+  public:
+
+    CSpscRingBuffer(const size_t numEntries = 0) :
+        m_writeIdx(0),
+        m_readIdx(0)
+    {
+        m_pDataBuffer = nullptr;
+
+        m_entriesPerBlock = 1;
+        m_bufferSize = 0;
+
+        m_cachedReadIdx = 0;
+        m_cachedWriteIdx = 0;
+
+        if (numEntries > 0)
+        {
+            allocateBuffer(numEntries);
+        }
+    }
+
+    CSpscRingBuffer(const size_t entriesPerBlock, const size_t numBlocks) :
+        m_writeIdx(0),
+        m_readIdx(0)
+    {
+        m_pDataBuffer = nullptr;
+
+        m_entriesPerBlock = entriesPerBlock;
+        m_bufferSize = 0;
+
+        m_cachedReadIdx = 0;
+        m_cachedWriteIdx = 0;
+
+        if (entriesPerBlock > 0 && numBlocks > 0)
+        {
+            allocateBuffer(entriesPerBlock * numBlocks);
+        }
+    }
+
+    ~CSpscRingBuffer()
+    {
+        free();
+
+        m_entriesPerBlock = 0;
+    }
+
+    CSpscRingBuffer(const CSpscRingBuffer &) = delete;
+    CSpscRingBuffer &operator=(const CSpscRingBuffer &) = delete;
+
+    // Set the maximum number of entries that can be stored in the entry array.
+    // NOTE: Doing this will flush (zero out) the data buffer.
+    bool setMaxBufferSize(const size_t numEntries)
+    {
+        return allocateBuffer(numEntries);
+    }
+
+    // Set the maximum number of entries that can be stored in the entry array.
+    // NOTE: Doing this will flush (zero out) the data buffer.
+    bool setMaxBufferSize(const size_t entriesPerBlock, const size_t numBlocks)
+    {
+        if (entriesPerBlock > 0 && numBlocks > 0)
+        {
+            auto status = allocateBuffer(entriesPerBlock * numBlocks);
+
+            if (status == true)
+            {
+                m_entriesPerBlock = entriesPerBlock;
+            }
+
+            return status;
+        }
+
+        LogDebug("[CSpscRingBuffer:{}] Invalid param ", __func__);
+
+        return false;
+    }
+
+    // Get the maximum number of entries that can be
+    // stored in the buffer (storage array).
+    int getMaxBufferSize()
+    {
+        return (int) m_bufferSize;
+    }
+
+    // Get the current (active) number of entries in
+    // the buffer (storage array).  Safe to call from either side.
+    unsigned int getCurrentDataSize()
+    {
+        size_t readIdx = m_readIdx.load(std::memory_order_acquire);
+        size_t writeIdx = m_writeIdx.load(std::memory_order_acquire);
+
+        return (unsigned int) (writeIdx - readIdx);
+    }
+
+    // Discard all entries currently in the buffer.
+    // (Consumer side - unless bZeroOutBuffer = true, which
+    // requires that no reads or writes are in progress)
+    bool flush(const bool bZeroOutBuffer = false)
+    {
+        m_cachedWriteIdx = m_writeIdx.load(std::memory_order_acquire);
+
+        m_readIdx.store(m_cachedWriteIdx, std::memory_order_release);
+
+        if (bZeroOutBuffer == false)
+        {
+            return true;
+        }
+
+        if (m_bufferSize > 0)
+        {
+            memset((void *) m_pDataBuffer, 0, (m_bufferSize * sizeof(T)));
+
+            return true;
+        }
+
+        LogDebug("[CSpscRingBuffer:{}] Invalid buffer size ", __func__);
+
+        return false;
+    }
+
+    // Read "blockSize" entries from the data block (entry array).
+    // (Consumer side)
+    int readBlock
+        (
+            T *pTargetBuff,
+            const size_t blockSize,
+            const bool deleteEntries = false
+        )
+    {
+        if (m_pDataBuffer == nullptr || pTargetBuff == nullptr)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (m_bufferSize < 1 || blockSize > m_bufferSize)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid buffer size ", __func__);
+            return -1;
+        }
+
+        return read(pTargetBuff, blockSize, deleteEntries);
+    }
+
+    // Read (entriesPerBlock * blockSize) entries from the data block (entry array).
+    // (Consumer side)
+    int readBlock
+        (
+            T *pTargetBuff,
+            const size_t entriesPerBlock,       // this is (more or less) numChannels
+            const size_t blockSize,             // this is (more or less) numFrames
+            const bool deleteEntries = false
+        )
+    {
+        if (m_pDataBuffer == nullptr || pTargetBuff == nullptr)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        size_t numEntriesToRead = (entriesPerBlock * blockSize);
+
+        if (m_bufferSize < 1 || numEntriesToRead > m_bufferSize)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid buffer size ", __func__);
+            return -1;
+        }
+
+        return read(pTargetBuff, numEntriesToRead, deleteEntries);
+    }
+
+    // Write "blockSize" entries to the data block (entry array).
+    // (Producer side)
+    // NOTE: bOverwrite is accepted for compatibility with CRingBuffer,
+    // but only the consumer may advance the read index, so a
+    // full buffer always returns -5 (over-flow).
+    int writeBlock
+        (
+            const T *pBuff,
+            const size_t blockSize,
+            bool bOverwrite = false
+        )
+    {
+        if (m_pDataBuffer == nullptr || pBuff == nullptr)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (m_bufferSize < 1 || blockSize >= m_bufferSize)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid buffer size ", __func__);
+            return -2;
+        }
+
+        (void) bOverwrite;
+
+        return write(pBuff, blockSize);
+    }
+
+    // Write (entriesPerBlock * blockSize) entries to the data block (entry array).
+    // (Producer side)
+    int writeBlock
+        (
+            const T *pBuff,
+            const size_t entriesPerBlock,           // this is (more or less) numChannels
+            const size_t blockSize,                 // this is (more or less) numFrames
+            bool bOverwrite = false
+        )
+    {
+        if (m_pDataBuffer == nullptr || pBuff == nullptr)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        size_t writeSize = (entriesPerBlock * blockSize);
+
+        if (writeSize < 1 || writeSize >= m_bufferSize)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid write size ", __func__);
+            return -3;
+        }
+
+        (void) bOverwrite;
+
+        return write(pBuff, writeSize);
+    }
+
+    // Get (up to) "numEntries" free entries of the data buffer,
+    // to be filled in place, without a scratch buffer copy.
+    // The returned region is only valid until commitWrite() is called.
+    // (Producer side)
+    SRingBufferRegion<T> reserveWrite(const size_t numEntries)
+    {
+        if (m_pDataBuffer == nullptr || m_bufferSize < 1)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid buffer size ", __func__);
+            return SRingBufferRegion<T>();
+        }
+
+        size_t numEntriesFree = availableToWrite(numEntries);
+
+        size_t writeIdx = m_writeIdx.load(std::memory_order_relaxed);
+
+        return makeRingRegion(m_pDataBuffer, m_bufferSize, (writeIdx % m_bufferSize), std::min(numEntries, numEntriesFree));
+    }
+
+    // Publish "numEntries" entries written into the
+    // region returned by the last reserveWrite() call.
+    // (Producer side)
+    int commitWrite(const size_t numEntries)
+    {
+        if (availableToWrite(numEntries) < numEntries)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Buffer over-flow ", __func__);
+            return -5;
+        }
+
+        size_t writeIdx = m_writeIdx.load(std::memory_order_relaxed);
+
+        m_writeIdx.store((writeIdx + numEntries), std::memory_order_release);
+
+        return (int) numEntries;
+    }
+
+    // Get (up to) "numEntries" entries, starting at the current read
+    // index, to be used in place (without copying them out).
+    // The returned region is only valid until consumeRead() is called.
+    // (Consumer side)
+    SRingBufferRegion<T> peekRead(const size_t numEntries)
+    {
+        if (m_pDataBuffer == nullptr || m_bufferSize < 1)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid buffer size ", __func__);
+            return SRingBufferRegion<T>();
+        }
+
+        size_t numAvailable = availableToRead();
+
+        size_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+
+        return makeRingRegion(m_pDataBuffer, m_bufferSize, (readIdx % m_bufferSize), std::min(numEntries, numAvailable));
+    }
+
+    // Release "numEntries" entries (returned by the last peekRead() call)
+    // back to the producer.
+    // (Consumer side)
+    int consumeRead(const size_t numEntries)
+    {
+        if (numEntries > availableToRead())
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        size_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+
+        m_readIdx.store((readIdx + numEntries), std::memory_order_release);
+
+        return (int) numEntries;
+    }
+
+    // Delete (remove) 1 entry.
+    // (Consumer side)
+    bool deleteEntry()
+    {
+        return deleteBlock(1);
+    }
+
+    // Delete (remove) numEntries from the front of the buffer.
+    // If numEntries > current data size, everything is deleted.
+    // (Consumer side)
+    bool deleteBlock(unsigned int numEntries)
+    {
+        if (m_pDataBuffer == nullptr || m_bufferSize < 1)
+        {
+            LogDebug("[CSpscRingBuffer:{}] Invalid param ", __func__);
+            return false;
+        }
+
+        size_t numToDelete = std::min((size_t) numEntries, availableToRead());
+
+        if (numToDelete < 1)
+            return false;
+
+        size_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+
+        m_readIdx.store((readIdx + numToDelete), std::memory_order_release);
+
+        return true;
+    }
+};
+
+#endif // _SPSC_RING_BUFFER_H_
@@ -0,0 +1,517 @@
+//****************************************************************************
+// FILE:    CTimedRingBuffer.h
+//
+// DESC:    A ring buffer of timestamped blocks, ie: audio / video blocks
+//          pulled from a GStreamer appsink, with their presentation time
+//          stamps (PTS), duration, sequence number and discontinuity flag.
+//
+//          The payload entries are stored as in CVRingBuffer, and the
+//          block info in a second (fixed size) ring, both under 1 lock,
+//          so the A/V alignment needs no side table:
+//
+//              videoRing.writeBlock(pFrame, frameSize, info);
+//              ...
+//              // play all the audio up to the current video frame
+//              audioRing.readUntil(videoPts, pAudio, maxEntries);
+//
+//              // skip the video frames that are already too late
+//              videoRing.dropBefore(audioClock);
+//
+//          Blocks are always read / dropped whole.  Time values are in
+//          nanoseconds (as GstClockTime), TIMED_BLOCK_NO_TIME = not set
+//          (same value as (int64_t) GST_CLOCK_TIME_NONE).
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _TIMED_RING_BUFFER_H_
+#define _TIMED_RING_BUFFER_H_
+
+
+#include "../Logging/Logging.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <cstdint>
+
+#include "RingBufferUtils.h"
+
+
+#define TIMED_BLOCK_NO_TIME         ((int64_t) -1)
+
+
+// The info stored with each block
+struct STimedBlockInfo
+{
+    int64_t     nPts            = TIMED_BLOCK_NO_TIME;  // presentation time stamp (ns)
+    int64_t     nDuration       = TIMED_BLOCK_NO_TIME;  // ns
+    uint64_t    nSeqNum         = 0;
+    bool        bDiscontinuity  = false;                // there is a gap before this block
+    size_t      numEntries      = 0;                    // payload size (set by the buffer)
+
+    bool hasPts() const
+    {
+        return (nPts != TIMED_BLOCK_NO_TIME);
+    }
+
+    // Get the time stamp of the end of the block (PTS + duration)
+    int64_t getEndTime() const
+    {
+        if (nDuration == TIMED_BLOCK_NO_TIME)
+            return nPts;
+
+        return (nPts + nDuration);
+    }
+};
+
+
+template <typename T> class CTimedRingBuffer
+{
+    std::vector<T>                  m_dataBuffer;
+
+    size_t                          m_bufferSize;
+    size_t                          m_currentDataSize;
+
+    size_t                          m_writeIdx;
+    size_t                          m_readIdx;
+
+    std::vector<STimedBlockInfo>    m_blockInfo;        // ring of block info
+
+    size_t                          m_numBlocks;
+    size_t                          m_firstBlock;       // index (in m_blockInfo) of the oldest block
+
+    uint64_t                        m_nDroppedBlocks;   // overwritten / dropBefore()
+
+    std::mutex                      m_ioMutex;
+
+    std::condition_variable         m_dataReadyVar;     // signaled when a block is written
+
+    bool                            m_bCancelWait;
+
+  protected:
+
+    // NOTE: m_ioMutex must be held by the caller.
+    STimedBlockInfo &frontInfo()
+    {
+        return m_blockInfo[m_firstBlock];
+    }
+
+    // Remove the oldest block.
+    // NOTE: m_ioMutex must be held by the caller.
+    void eraseFront()
+    {
+        size_t numEntries = frontInfo().numEntries;
+
+        m_readIdx += numEntries;
+        if (m_readIdx >= m_bufferSize)
+        {
+            m_readIdx -= m_bufferSize;
+        }
+
+        m_currentDataSize -= numEntries;
+
+        m_firstBlock++;
+        if (m_firstBlock >= m_blockInfo.size())
+        {
+            m_firstBlock = 0;
+        }
+
+        m_numBlocks--;
+
+        if (m_numBlocks < 1)
+        {
+            m_readIdx = 0;
+            m_writeIdx = 0;
+            m_currentDataSize = 0;
+        }
+    }
+
+    // Copy the oldest block to pTargetBuff, then remove it.
+    // NOTE: m_ioMutex must be held by the caller.
+    size_t readFront(T *pTargetBuff, STimedBlockInfo *pInfo)
+    {
+        STimedBlockInfo &info = frontInfo();
+
+        copyFromRing(pTargetBuff, m_dataBuffer.data(), m_bufferSize, m_readIdx, info.numEntries);
+
+        if (pInfo != nullptr)
+            *pInfo = info;
+
+        size_t numEntries = info.numEntries;
+
+        eraseFront();
+
+        return numEntries;
+    }
+
+    // Is the oldest block due before "pts"?
+    // (blocks without a time stamp are always due)
+    // NOTE: m_ioMutex must be held by the caller.
+    bool isFrontBefore(const int64_t pts)
+    {
+        STimedBlockInfo &info = frontInfo();
+
+        return (info.hasPts() == false || info.nPts < pts);
+    }
+
+    void reset()
+    {
+        m_currentDataSize = 0;
+        m_writeIdx = 0;
+        m_readIdx = 0;
+
+        m_numBlocks = 0;
+        m_firstBlock = 0;
+    }
+
+  public:
+
+    CTimedRingBuffer(const size_t numEntries = 0, const size_t maxBlocks = 0)
+    {
+        m_bufferSize = 0;
+
+        m_nDroppedBlocks = 0;
+
+        m_bCancelWait = false;
+
+        reset();
+
+        if (numEntries > 0)
+        {
+            setMaxBufferSize(numEntries, maxBlocks);
+        }
+    }
+
+    // Set the size of the buffer, in entries, and the max. number
+    // of blocks it can hold (0 = numEntries, ie: 1 entry per block).
+    // NOTE: Doing this will flush the buffer.
+    bool setMaxBufferSize(const size_t numEntries, const size_t maxBlocks = 0)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (numEntries < 1)
+        {
+            LogDebug("[CTimedRingBuffer:{}] Invalid param ", __func__);
+            return false;
+        }
+
+        try
+        {
+            m_dataBuffer.assign(numEntries, T());
+            m_blockInfo.assign(((maxBlocks > 0) ? maxBlocks : numEntries), STimedBlockInfo());
+        }
+        catch (...)
+        {
+            LogDebug("[CTimedRingBuffer:{}] Memory allocation failed ", __func__);
+
+            m_dataBuffer.clear();
+            m_blockInfo.clear();
+            m_bufferSize = 0;
+
+            reset();
+            return false;
+        }
+
+        m_bufferSize = numEntries;
+
+        reset();
+
+        return true;
+    }
+
+    // Get the max. number of entries that can be stored in the buffer
+    int getMaxBufferSize()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        return (int) m_bufferSize;
+    }
+
+    // Get the number of entries (in all the blocks) in the buffer
+    size_t getCurrentDataSize()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        return m_currentDataSize;
+    }
+
+    size_t getNumBlocks()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        return m_numBlocks;
+    }
+
+    // Get the number of blocks removed by writeBlock() (bOverwrite) and dropBefore()
+    uint64_t getNumDroppedBlocks()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        return m_nDroppedBlocks;
+    }
+
+    // Remove all the blocks
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        reset();
+    }
+
+    // Write a block of "numEntries" entries, with its info
+    // (info.numEntries is set by the buffer).
+    // If there is not enough room, either fail (bOverwrite = false) or
+    // drop the oldest blocks to make room, in which case the (new)
+    // oldest block is flagged as a discontinuity - or the block written,
+    // if every older block was dropped.
+    // Returns the number of entries written, or < 0 on error.
+    int writeBlock
+        (
+            const T *pSourceBuff,
+            const size_t numEntries,
+            const STimedBlockInfo &info,
+            const bool bOverwrite = false
+        )
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (pSourceBuff == nullptr || numEntries < 1)
+        {
+            LogDebug("[CTimedRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (numEntries > m_bufferSize)
+        {
+            LogDebug("[CTimedRingBuffer:{}] Invalid block size ", __func__);
+            return -2;
+        }
+
+        bool bDroppedAll = false;
+
+        if ((m_bufferSize - m_currentDataSize) < numEntries || m_numBlocks >= m_blockInfo.size())
+        {
+            if (bOverwrite == false)
+            {
+                LogDebug("[CTimedRingBuffer:{}] Buffer over-flow ", __func__);
+                return -5;
+            }
+
+            while ((m_bufferSize - m_currentDataSize) < numEntries || m_numBlocks >= m_blockInfo.size())
+            {
+                eraseFront();
+
+                m_nDroppedBlocks++;
+            }
+
+            if (m_numBlocks > 0)
+                frontInfo().bDiscontinuity = true;
+            else
+                bDroppedAll = true;
+        }
+
+        copyToRing(m_dataBuffer.data(), m_bufferSize, m_writeIdx, pSourceBuff, numEntries);
+
+        m_writeIdx += numEntries;
+        if (m_writeIdx >= m_bufferSize)
+        {
+            m_writeIdx -= m_bufferSize;
+        }
+
+        m_currentDataSize += numEntries;
+
+        size_t infoIdx = (m_firstBlock + m_numBlocks);
+        if (infoIdx >= m_blockInfo.size())
+        {
+            infoIdx -= m_blockInfo.size();
+        }
+
+        m_blockInfo[infoIdx] = info;
+        m_blockInfo[infoIdx].numEntries = numEntries;
+
+        // (the gap is before the block written)
+        if (bDroppedAll)
+            m_blockInfo[infoIdx].bDiscontinuity = true;
+
+        m_numBlocks++;
+
+        m_dataReadyVar.notify_all();
+
+        return (int) numEntries;
+    }
+
+    // Get the info of the oldest block (without removing it).
+    // Returns false if the buffer is empty.
+    bool peekBlockInfo(STimedBlockInfo &info)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_numBlocks < 1)
+            return false;
+
+        info = frontInfo();
+
+        return true;
+    }
+
+    // Get the PTS of the oldest block (TIMED_BLOCK_NO_TIME = empty / not set)
+    int64_t getFrontPts()
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (m_numBlocks < 1)
+            return TIMED_BLOCK_NO_TIME;
+
+        return frontInfo().nPts;
+    }
+
+    // Read (and remove) the oldest block.
+    // Returns the number of entries read (0 = buffer empty),
+    // -1 = invalid param, -2 = the block is larger than maxEntries
+    // (it is left in the buffer, see peekBlockInfo()).
+    int readBlock(T *pTargetBuff, const size_t maxEntries, STimedBlockInfo &info)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (pTargetBuff == nullptr)
+        {
+            LogDebug("[CTimedRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (m_numBlocks < 1)
+            return 0;
+
+        if (frontInfo().numEntries > maxEntries)
+        {
+            LogDebug("[CTimedRingBuffer:{}] Target buffer too small ", __func__);
+            return -2;
+        }
+
+        return (int) readFront(pTargetBuff, &info);
+    }
+
+    // As readBlock(), waiting (up to timeoutMs milliseconds) for a block.
+    int readBlockWait(T *pTargetBuff, const size_t maxEntries, STimedBlockInfo &info, const unsigned int timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock{m_ioMutex};
+
+        if (pTargetBuff == nullptr)
+        {
+            LogDebug("[CTimedRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (m_numBlocks < 1 && m_bCancelWait == false)
+        {
+            m_dataReadyVar.wait_for
+                (
+                    lock,
+                    std::chrono::milliseconds(timeoutMs),
+                    [&] { return (m_numBlocks > 0 || m_bCancelWait == true); }
+                );
+        }
+
+        if (m_numBlocks < 1)
+            return 0;
+
+        if (frontInfo().numEntries > maxEntries)
+        {
+            LogDebug("[CTimedRingBuffer:{}] Target buffer too small ", __func__);
+            return -2;
+        }
+
+        return (int) readFront(pTargetBuff, &info);
+    }
+
+    // Read (and remove) all the blocks with a PTS before "pts" (and any
+    // blocks without a PTS), as long as they fit in maxEntries.
+    // The info of each block read is added to pInfoList (if not null).
+    // Returns the number of entries read, or -1 = invalid param.
+    int readUntil
+        (
+            const int64_t pts,
+            T *pTargetBuff,
+            const size_t maxEntries,
+            std::vector<STimedBlockInfo> *pInfoList = nullptr
+        )
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (pTargetBuff == nullptr)
+        {
+            LogDebug("[CTimedRingBuffer:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        size_t numRead = 0;
+
+        while (m_numBlocks > 0 && isFrontBefore(pts))
+        {
+            if (frontInfo().numEntries > (maxEntries - numRead))
+                break;
+
+            STimedBlockInfo info;
+
+            numRead += readFront((pTargetBuff + numRead), &info);
+
+            if (pInfoList != nullptr)
+                pInfoList->push_back(info);
+        }
+
+        return (int) numRead;
+    }
+
+    // Remove all the blocks that end at (or before) "pts", ie: frames
+    // that are too late to be presented (blocks without a PTS are removed
+    // too, if they are the oldest).  Returns the number of blocks removed.
+    int dropBefore(const int64_t pts)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        int numDropped = 0;
+
+        while (m_numBlocks > 0)
+        {
+            STimedBlockInfo &info = frontInfo();
+
+            if (info.hasPts() == true)
+            {
+                // (a block with no duration is late once its PTS has passed)
+                bool bLate = ((info.nDuration == TIMED_BLOCK_NO_TIME) ? (info.nPts < pts) : (info.getEndTime() <= pts));
+
+                if (bLate == false)
+                    break;
+            }
+
+            eraseFront();
+
+            numDropped++;
+        }
+
+        m_nDroppedBlocks += numDropped;
+
+        return numDropped;
+    }
+
+    // Release any thread blocked in readBlockWait() (ie: on shutdown).
+    // While cancelled, readBlockWait() doesn't block.
+    void cancelWait(const bool bCancel = true)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        m_bCancelWait = bCancel;
+
+        if (bCancel == true)
+        {
+            m_dataReadyVar.notify_all();
+        }
+    }
+};
+
+
+#endif // _TIMED_RING_BUFFER_H_
@@ -4,6 +4,22 @@
 // DEESC:   Buffer class with configurable data type, 
 //          derrived from std::vector.
 //
+//          The buffer is used as a FIFO, so entries consumed from the
+//          front are not erased from the vector (which would shift every
+//          remaining entry).  Instead a head index is advanced, and the
+//          live entries are moved back to the start of the vector only
+//          once the consumed part is larger than the live part (or the
+//          vector would otherwise have to grow).  This makes consuming
+//          from the front O(1) (amortized), and a buffer that stays
+//          under its high water mark never reallocates.
+//
+//          In ring storage mode (eVectorBufferStorage_ring) the vector
+//          is used as a circular buffer instead, so the live entries are
+//          never moved on a consume, and growing the ring moves them
+//          once.  getBufferPtr() unwraps the ring (to give a contiguous
+//          pointer), so the vector mode suits buffers that are mostly
+//          accessed through the pointer.
+//
 // AUTHOR:  Russ Barker
 //
 
@@ -11,6 +27,8 @@
 #ifndef _VECTOR_BUFFER_h
 #define _VECTOR_BUFFER_h
 
+#include <algorithm>
+#include <iterator>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -18,32 +36,171 @@
 #include "../Error/CError.h"
 
 
+// Don't bother compacting until at least this many entries are consumed
+#define VECTOR_BUFFER_MIN_COMPACT_SIZE      64
+
+// Initial number of entries in a ring (it doubles as it fills up)
+#define VECTOR_BUFFER_MIN_RING_SIZE         64
+
+
+enum eVectorBufferStorage_def
+{
+    eVectorBufferStorage_vector = 0,    // contiguous, consumed entries are skipped (and compacted)
+    eVectorBufferStorage_ring           // circular
+};
+
+
 template <typename T> 
 class CVectorBuffer: 
     public CErrorHandler
 {
     std::vector<T> m_dataBuffer;
+    size_t         m_headIdx;           // index of the 1st (live) entry in m_dataBuffer
+    size_t         m_ringCount;         // number of live entries (ring storage only)
     size_t         m_maxSize;
+    eVectorBufferStorage_def m_storage;
     std::mutex     m_ioMutex;
 
   protected:
 
+    // Number of live entries (from m_headIdx to the end of the vector,
+    // or around the ring)
+    size_t size()
+    {
+        if (m_storage == eVectorBufferStorage_ring)
+            return m_ringCount;
+
+        return (m_dataBuffer.size() - m_headIdx);
+    }
+
+    // Index in m_dataBuffer of the live entry at "pos"
+    size_t index(const size_t pos)
+    {
+        size_t idx = (m_headIdx + pos);
+
+        if (m_storage == eVectorBufferStorage_ring && idx >= m_dataBuffer.size())
+            idx -= m_dataBuffer.size();
+
+        return idx;
+    }
+
+    // Move the live ring entries to the start of a vector of "ringSize"
+    // entries (ringSize >= the number of live entries)
+    void resizeRing(const size_t ringSize)
+    {
+        std::vector<T> newBuffer(ringSize);
+
+        size_t firstPart = std::min(m_ringCount, (m_dataBuffer.size() - m_headIdx));
+
+        std::move((m_dataBuffer.begin() + m_headIdx), (m_dataBuffer.begin() + m_headIdx + firstPart), newBuffer.begin());
+        std::move(m_dataBuffer.begin(), (m_dataBuffer.begin() + (m_ringCount - firstPart)), (newBuffer.begin() + firstPart));
+
+        m_dataBuffer.swap(newBuffer);
+        m_headIdx = 0;
+    }
+
+    // Make room in the ring for "numEntries" more entries
+    void growRing(const size_t numEntries)
+    {
+        size_t needed = (m_ringCount + numEntries);
+
+        if (needed <= m_dataBuffer.size())
+            return;
+
+        size_t ringSize = std::max(m_dataBuffer.size(), (size_t) VECTOR_BUFFER_MIN_RING_SIZE);
+
+        while (ringSize < needed)
+            ringSize *= 2;
+
+        ringSize = std::max(needed, std::min(ringSize, m_maxSize));
+
+        resizeRing(ringSize);
+    }
+
+    // Remove "numEntries" entries from the front
+    void consume(const size_t numEntries)
+    {
+        if (m_storage == eVectorBufferStorage_ring)
+        {
+            m_headIdx = index(numEntries);
+            m_ringCount -= numEntries;
+
+            if (m_ringCount == 0)
+                m_headIdx = 0;
+
+            return;
+        }
+
+        m_headIdx += numEntries;
+        compact();
+    }
+
+    // Remove the entries from start to 1 less than end (start > 0),
+    // by moving the entries after them down
+    void eraseMiddle(const size_t start, const size_t end)
+    {
+        if (m_storage == eVectorBufferStorage_ring)
+        {
+            size_t delSize = (end - start);
+
+            for (size_t pos = start; (pos + delSize) < m_ringCount; pos++)
+                m_dataBuffer[index(pos)] = std::move(m_dataBuffer[index(pos + delSize)]);
+
+            m_ringCount -= delSize;
+
+            return;
+        }
+
+        m_dataBuffer.erase((m_dataBuffer.begin() + m_headIdx + start), (m_dataBuffer.begin() + m_headIdx + end));
+    }
+
+    // Move the live entries back to the start of the vector.
+    // If bForce = false, this is only done once the consumed
+    // entries outnumber the live ones, so the cost is amortized
+    // over the entries consumed.
+    void compact(const bool bForce = false)
+    {
+        if (m_headIdx < 1)
+            return;
+
+        if (m_headIdx >= m_dataBuffer.size())
+        {
+            // nothing left - keep the capacity
+            m_dataBuffer.clear();
+            m_headIdx = 0;
+            return;
+        }
+
+        if (bForce == false && (m_headIdx < VECTOR_BUFFER_MIN_COMPACT_SIZE || m_headIdx < size()))
+            return;
+
+        std::move((m_dataBuffer.begin() + m_headIdx), m_dataBuffer.end(), m_dataBuffer.begin());
+
+        m_dataBuffer.resize(size());
+        m_headIdx = 0;
+    }
+
     // Delete (remove) 1 entry at pos
     // If no pos is given, delete entry at pos zero (0).
     bool erase(int pos = -1)
     {
-        auto bufSize = m_dataBuffer.size();
+        auto bufSize = size();
 
-        if (pos >= (int)bufSize)
+        if (bufSize < 1 || pos >= (int)bufSize)
             return false;
 
         if (pos == -1)
             pos = 0;
 
-        auto entry = (m_dataBuffer.begin() + pos);
-        m_dataBuffer.erase(entry);
+        if (pos == 0)
+        {
+            consume(1);
+            return true;
+        }
+
+        eraseMiddle(pos, (pos + 1));
 
-        auto newSize = m_dataBuffer.size();
+        auto newSize = size();
         if (newSize > (bufSize - 1))
             return false;
 
@@ -51,9 +208,9 @@ class CVectorBuffer:
     }
 
     // Delete (remove) array entries, from  start to 1 less than end. Range is NOT inclusive of end
-    bool erase(int start = -1, int end = -1)
+    bool erase(int start, int end)
     {
-        auto bufSize = m_dataBuffer.size();
+        auto bufSize = size();
 
         if (start >= (int)bufSize)
             return false;
@@ -65,17 +222,21 @@ class CVectorBuffer:
             start = 0;
 
         if (end == -1)
-            end = ((int)m_dataBuffer.size());
+            end = ((int)bufSize);
 
         if (start >= end)
             return false;
 
-        auto first = (m_dataBuffer.begin() + start);
-        auto last  = (m_dataBuffer.begin() + end);
-        m_dataBuffer.erase(first, last);
+        if (start == 0)
+        {
+            consume(end);
+            return true;
+        }
+
+        eraseMiddle(start, end);
 
         auto delSize = (end - start);
-        auto newSize = m_dataBuffer.size();
+        auto newSize = size();
         if (newSize > (bufSize - delSize))
             return false;
 
@@ -84,8 +245,12 @@ class CVectorBuffer:
 
   public:
 
-    CVectorBuffer(const size_t buffSize = 0)
+    CVectorBuffer(const size_t buffSize = 0, const eVectorBufferStorage_def storage = eVectorBufferStorage_vector)
     {
+        m_headIdx = 0;
+        m_ringCount = 0;
+        m_storage = storage;
+
         m_maxSize = 0;
         if (buffSize > 0)
             m_maxSize = buffSize;
@@ -100,7 +265,41 @@ class CVectorBuffer:
     {
         std::lock_guard<std::mutex> lock{m_ioMutex};
 
-        m_dataBuffer.clear();
+        m_headIdx = 0;
+        m_ringCount = 0;
+
+        // a ring keeps its size (the entries are unused)
+        if (m_storage == eVectorBufferStorage_vector)
+            m_dataBuffer.clear();
+    }
+
+    // Switch between vector and ring storage (the entries are kept)
+    void setStorageMode(const eVectorBufferStorage_def storage)
+    {
+        std::lock_guard<std::mutex> lock{m_ioMutex};
+
+        if (storage == m_storage)
+            return;
+
+        if (storage == eVectorBufferStorage_ring)
+        {
+            m_ringCount = size();
+            m_storage = storage;
+
+            // the consumed entries become free ring space
+            return;
+        }
+
+        // unwrap the ring, with the entries at the start of the vector
+        resizeRing(m_ringCount);
+
+        m_ringCount = 0;
+        m_storage = storage;
+    }
+
+    eVectorBufferStorage_def getStorageMode()
+    {
+        return m_storage;
     }
 
     // Set the maximum number of entries that can be stored in the entry array.
@@ -129,27 +328,27 @@ class CVectorBuffer:
     {
         std::lock_guard<std::mutex> lock{m_ioMutex};
 
-        return (int)m_dataBuffer.size();
+        return (int)size();
     }
 
     T get(const unsigned int pos)
     {
         std::lock_guard<std::mutex> lock{ m_ioMutex };
 
-        if (pos >= m_maxSize)
+        if (pos >= size())
             return (T) 0;;
 
-        return m_dataBuffer.at(x);
+        return m_dataBuffer.at(index(pos));
     }
 
     bool set(const unsigned int pos, T &val)
     {
         std::lock_guard<std::mutex> lock{ m_ioMutex };
 
-        if (pos >= m_maxSize)
+        if (pos >= size())
             return false;;
 
-        m_dataBuffer.at(pos) = val;
+        m_dataBuffer.at(index(pos)) = val;
 
         return true;
     }
@@ -165,7 +364,7 @@ class CVectorBuffer:
         if (blockSize > m_maxSize)
             return -1;
 
-        size_t numSamples = m_dataBuffer.size();
+        size_t numSamples = size();
 
         if (numSamples < 1)
             return 0;
@@ -176,14 +375,26 @@ class CVectorBuffer:
             readSize = numSamples;
 
         // copy the sample data from the output buffer to the target buffer
-        for (unsigned int x = 0; x < readSize; x++)
-            *(pTargetBuff + x) = m_dataBuffer.at(x);
+        auto first = (m_dataBuffer.begin() + m_headIdx);
+
+        if (m_storage == eVectorBufferStorage_ring)
+        {
+            // (in up to 2 parts, around the end of the ring)
+            size_t firstPart = std::min(readSize, (m_dataBuffer.size() - m_headIdx));
+
+            std::copy(first, (first + firstPart), pTargetBuff);
+            std::copy(m_dataBuffer.begin(), (m_dataBuffer.begin() + (readSize - firstPart)), (pTargetBuff + firstPart));
+        }
+        else
+        {
+            std::copy(first, (first + readSize), pTargetBuff);
+        }
 
         // If true, delete those sample entries from the output buffer
         if (deleteEntries == true)
         {
             erase(0, (int)readSize);
-            size_t newSize = m_dataBuffer.size();
+            size_t newSize = size();
             if (newSize != numSamples - readSize)
                 return -1;
         }
@@ -196,18 +407,38 @@ class CVectorBuffer:
     {
         std::lock_guard<std::mutex> lock{m_ioMutex};
 
-        auto                        bufSize = m_dataBuffer.size();
+        auto                        bufSize = size();
         if ((bufSize + blockSize) > m_maxSize)
         {
             return false;
         }
 
-        for (unsigned int x = 0; x < blockSize; x++)
+        if (m_storage == eVectorBufferStorage_ring)
         {
-            T sampleValue = *(pBuff + x);
-            m_dataBuffer.push_back(sampleValue);
+            growRing(blockSize);
+
+            // copy in up to 2 parts, around the end of the ring
+            size_t tailIdx = index(m_ringCount);
+            size_t firstPart = std::min(blockSize, (m_dataBuffer.size() - tailIdx));
+
+            std::copy(pBuff, (pBuff + firstPart), (m_dataBuffer.begin() + tailIdx));
+            std::copy((pBuff + firstPart), (pBuff + blockSize), m_dataBuffer.begin());
+
+            m_ringCount += blockSize;
+
+            return true;
+        }
+
+        // Re-use the space of the consumed entries, rather than letting
+        // the vector grow (reallocate) - as long as there are enough of
+        // them to make moving the live entries worthwhile.
+        if ((m_dataBuffer.size() + blockSize) > m_dataBuffer.capacity() && (m_headIdx * 2) >= size())
+        {
+            compact(true);
         }
 
+        m_dataBuffer.insert(m_dataBuffer.end(), pBuff, (pBuff + blockSize));
+
         return true;
     }
 
@@ -244,7 +475,14 @@ class CVectorBuffer:
     {
         m_ioMutex.lock();
 
-        return (T *)(m_dataBuffer.data());
+        // unwrap the ring, if the live entries run past the end of it
+        if (m_storage == eVectorBufferStorage_ring && (m_headIdx + m_ringCount) > m_dataBuffer.size())
+        {
+            std::rotate(m_dataBuffer.begin(), (m_dataBuffer.begin() + m_headIdx), m_dataBuffer.end());
+            m_headIdx = 0;
+        }
+
+        return (T *)(m_dataBuffer.data() + m_headIdx);
     }
 
     // "unlock" the data block "locked" by the "freeDataPtr" call.
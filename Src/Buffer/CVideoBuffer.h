@@ -3,6 +3,11 @@
 //
 // DESC:    An video buffer handler class.
 //
+//          Frames are stored in the plane layout of the video format
+//          (see VideoFrameLayout.h), with each row padded to the row
+//          alignment (default 64 bytes).  getFrame() / setFrame() copy
+//          packed frames, the pixel functions work on the 1st plane.
+//
 // AUTHOR:  Russ Barker
 //
 
@@ -17,6 +22,10 @@
 
 #include "../Error/CError.h"
 
+#include "CBufferPool.h"
+#include "CVideoFramePool.h"
+#include "VideoFrameLayout.h"
+
 
 typedef std::vector<uint8_t>    VideoPixelData_def;
 
@@ -45,6 +54,11 @@ class CSimpleVideoBuffer :
 
     unsigned long               m_nBufferLen;
 
+    CBufferAllocator            *m_pAllocator;  // where m_pBuffer comes from
+
+    unsigned int                m_nRowAlignment;    // rows are padded to a multiple of this
+    SVideoFrameLayout           m_layout;           // plane layout of 1 frame
+
     std::vector<unsigned long>  m_frameDataLen;   // Length of actual frame data (in byts)
 
     std::mutex                  m_ioLock;
@@ -59,11 +73,102 @@ protected:
         }
     }
 
+    // Get the byte offset of pixel 'xPos, yPos' of the 1st plane of a frame
+    size_t getPixelOffset(const unsigned long xPos, const unsigned long yPos, const unsigned long frame)
+    {
+        const SVideoPlane &plane = m_layout.planes[0];
+
+        return ((frame * m_layout.frameSize) + plane.offset + (yPos * plane.stride) + ((xPos * plane.nBitsPerPixel) / 8));
+    }
+
+    size_t getPixelOffset(const unsigned long index, const unsigned long frame)
+    {
+        return getPixelOffset((index % m_frameWidth), (index / m_frameWidth), frame);
+    }
+
+    unsigned int getPixelBytes()
+    {
+        return (((m_layout.planes[0].nBitsPerPixel + 8) - 1) / 8);       // divide by 8 and round up
+    }
+
+    // Call fnRow(pPixels, numBytes) for each (partial) row of 'count'
+    // pixels, starting at pixel 'index' of the 1st plane.
+    template <class TFn> void forEachPixelRow(const unsigned long index, const unsigned int count, const unsigned long frame, TFn fnRow)
+    {
+        const SVideoPlane &plane = m_layout.planes[0];
+
+        unsigned long pos = index;
+        unsigned int remaining = count;
+
+        while (remaining > 0)
+        {
+            unsigned long xPos = (pos % m_frameWidth);
+
+            unsigned int numPixels = (unsigned int) (m_frameWidth - xPos);
+
+            if (numPixels > remaining)
+                numPixels = remaining;
+
+            uint8_t *pPixels = (((uint8_t*) m_pBuffer) + getPixelOffset(xPos, (pos / m_frameWidth), frame));
+
+            size_t copySize = ((((size_t) plane.nBitsPerPixel * numPixels) + 8) - 1) / 8;       // divide by 8 and round up
+
+            fnRow(pPixels, copySize);
+
+            pos += numPixels;
+            remaining -= numPixels;
+        }
+    }
+
+    // Copy 'count' pixels from pSource into the buffer, starting at pixel 'index'
+    void copyPixelsIn(const uint8_t *pSource, const unsigned long index, const unsigned int count, const unsigned long frame)
+    {
+        forEachPixelRow(index, count, frame, [&](uint8_t *pPixels, const size_t numBytes)
+            {
+                memcpy(pPixels, pSource, numBytes);
+                pSource += numBytes;
+            });
+    }
+
+    // Copy 'count' pixels out of the buffer to pTarget, starting at pixel 'index'
+    void copyPixelsOut(uint8_t *pTarget, const unsigned long index, const unsigned int count, const unsigned long frame)
+    {
+        forEachPixelRow(index, count, frame, [&](const uint8_t *pPixels, const size_t numBytes)
+            {
+                memcpy(pTarget, pPixels, numBytes);
+                pTarget += numBytes;
+            });
+    }
+
+    // Whether a (pooled) video frame has the same plane sizes as a frame of this buffer
+    bool isSameLayout(CVideoFrame &frame)
+    {
+        if (frame.getFrameWidth() != m_frameWidth || frame.getFrameHeight() != m_frameHeight || frame.getNumPlanes() != m_layout.numPlanes)
+        {
+            return false;
+        }
+
+        for (unsigned int idx = 0; idx < m_layout.numPlanes; idx++)
+        {
+            auto pPlane = frame.getPlane(idx);
+
+            if (pPlane->rowBytes != m_layout.planes[idx].rowBytes || pPlane->height != m_layout.planes[idx].height)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
 public:
 
     CSimpleVideoBuffer() :
         m_bAllocated(false)
     {
+        m_frameWidth = 0;
+        m_frameHeight = 0;
+
         m_blockSize = 1;
         m_frameSize = 0;
 
@@ -78,6 +183,10 @@ public:
 
         m_nBufferLen = 0;
 
+        m_pAllocator = getDefaultBufferAllocator();
+
+        m_nRowAlignment = VIDEO_FRAME_ROW_ALIGNMENT;
+
         m_frameDataLen.clear();
         m_frameDataLen.resize(m_blockSize);
         resetFrameLen();
@@ -98,14 +207,55 @@ public:
 
     void setPixelSize(const unsigned int nBitsPerPixel)
     {
+        if (m_bAllocated)
+        {
+            return;
+        }
+
         m_nBitsPerPixel = nBitsPerPixel;
     }
 
+    unsigned int getPixelSize()
+    {
+        return m_nBitsPerPixel;
+    }
+
+    // Set the video format (see eVideoDataIoFormat_def), this
+    // sets the plane layout (and the pixel size if it is not set)
     void setVideoFormat(const unsigned int nFmt)
     {
+        if (m_bAllocated)
+        {
+            return;
+        }
+
         m_nVideoFormat = nFmt;
     }
 
+    unsigned long getVideoFormat()
+    {
+        return m_nVideoFormat;
+    }
+
+    // Rows (of every plane) are padded to a multiple of 'alignment'
+    // bytes (default 64, 0 or 1 = packed rows, no padding).
+    bool setRowAlignment(const unsigned int alignment)
+    {
+        if (m_bAllocated)
+        {
+            return false;
+        }
+
+        m_nRowAlignment = alignment;
+
+        return true;
+    }
+
+    unsigned int getRowAlignment()
+    {
+        return m_nRowAlignment;
+    }
+
     void setResolution(const unsigned int frameWidth, const unsigned int frameHeight)
     {
         if (m_bAllocated)
@@ -115,6 +265,8 @@ public:
 
         m_frameWidth = frameWidth;
         m_frameHeight = frameHeight;
+
+        m_frameSize = 0;
     }
 
     void setFrameWidth(const unsigned int frameWidth)
@@ -125,6 +277,8 @@ public:
         }
 
         m_frameWidth = frameWidth;
+
+        m_frameSize = 0;
     }
 
     void setFrameHeight(const unsigned int frameHeight)
@@ -135,6 +289,8 @@ public:
         }
 
         m_frameHeight = frameHeight;
+
+        m_frameSize = 0;
     }
 
     unsigned int getFrameWidth()
@@ -166,8 +322,27 @@ public:
         return m_blockSize;
     }
 
+    // Set the allocator the pixel data buffer comes from
+    // (default = the shared 64 byte aligned buffer pool).
+    bool setAllocator(CBufferAllocator *pAllocator)
+    {
+        if (m_bAllocated || pAllocator == nullptr)
+        {
+            return false;
+        }
+
+        m_pAllocator = pAllocator;
+
+        return true;
+    }
+
     bool alloc(const unsigned int blockSize = 0)
     {
+        if (m_bAllocated)
+        {
+            free();
+        }
+
         if (blockSize > 0)
             m_blockSize = blockSize;
 
@@ -178,13 +353,18 @@ public:
 
         if (m_frameWidth > 0 && m_frameHeight > 0)
         {
-            // frameSize = total numner of pixels in the buffer
+            // frameSize = total numner of pixels in a frame
             if (m_frameSize < 1)
             {
                 m_frameSize = (m_frameWidth * m_frameHeight);
             }
         }
 
+        if (m_nBitsPerPixel < 1)
+        {
+            m_nBitsPerPixel = getVideoFormatBitsPerPixel(m_nVideoFormat);
+        }
+
         if (m_nBitsPerPixel < 1 || m_frameSize < 1)
         {
             m_frameSize = 0;
@@ -192,11 +372,21 @@ public:
             return false;
         }
 
-        auto numPixelsPerBlock = (m_frameSize * m_blockSize);
+        if (getVideoFrameLayout(m_layout, m_frameWidth, m_frameHeight, m_nBitsPerPixel, m_nVideoFormat, m_nRowAlignment) < 0)
+        {
+            m_frameSize = 0;
+
+            return false;
+        }
+
+        auto bufferSizeInBytes = (m_layout.frameSize * m_blockSize);
 
-        auto bufferSizeInBytes = ((numPixelsPerBlock * m_nBitsPerPixel) / 8);
+        if (m_frameDataLen.size() != m_blockSize)
+        {
+            m_frameDataLen.resize(m_blockSize);
+        }
 
-        m_pBuffer = (void*) calloc(bufferSizeInBytes, sizeof(uint8_t));
+        m_pBuffer = m_pAllocator->allocate(bufferSizeInBytes);
 
         if (m_pBuffer == nullptr)
         {
@@ -205,6 +395,8 @@ public:
             return false;
         }
 
+        memset(m_pBuffer, 0, bufferSizeInBytes);
+
         m_nBufferLen = bufferSizeInBytes;
 
         resetFrameLen();
@@ -237,7 +429,7 @@ public:
         {
             try
             {
-                ::free(m_pBuffer);
+                m_pAllocator->deallocate(m_pBuffer, m_nBufferLen);
             }
             catch (...)
             {
@@ -322,13 +514,76 @@ public:
             return nullptr;
         }
 
-        unsigned int bytesPerFrame = ((m_nBitsPerPixel * m_frameSize) / 8);
-
-        unsigned int offset = (bytesPerFrame * frame);
+        size_t offset = (m_layout.frameSize * frame);
 
         return ((void*) (((uint8_t *) m_pBuffer) + offset));
     }
 
+    // Get the size of a frame in the buffer (including the row padding)
+    size_t getFrameBytes()
+    {
+        return m_layout.frameSize;
+    }
+
+    // Get the size of a packed frame (as copied by getFrame() / setFrame())
+    size_t getPackedFrameBytes()
+    {
+        return m_layout.packedSize;
+    }
+
+    const SVideoFrameLayout &getLayout()
+    {
+        return m_layout;
+    }
+
+    unsigned int getNumPlanes()
+    {
+        return m_layout.numPlanes;
+    }
+
+    // Get a plane descriptor (nullptr = invalid plane / not allocated)
+    const SVideoPlane *getPlane(const unsigned int plane)
+    {
+        if (!m_bAllocated || plane >= m_layout.numPlanes)
+        {
+            return nullptr;
+        }
+
+        return &m_layout.planes[plane];
+    }
+
+    // Get the number of bytes per row of a plane (including padding)
+    unsigned int getPlaneStride(const unsigned int plane = 0)
+    {
+        if (plane >= m_layout.numPlanes)
+        {
+            return 0;
+        }
+
+        return m_layout.planes[plane].stride;
+    }
+
+    // Get a pointer to the start of a row of a plane of a frame
+    // (nullptr = invalid row / plane / frame)
+    uint8_t* getRowPtr(const unsigned int row, const unsigned int plane = 0, const unsigned int frame = 0)
+    {
+        if (!m_bAllocated || frame >= m_blockSize || plane >= m_layout.numPlanes || row >= m_layout.planes[plane].height)
+        {
+            return nullptr;
+        }
+
+        const SVideoPlane &planeInfo = m_layout.planes[plane];
+
+        size_t offset = ((m_layout.frameSize * frame) + planeInfo.offset + ((size_t) row * planeInfo.stride));
+
+        return (((uint8_t *) m_pBuffer) + offset);
+    }
+
+    uint8_t* getPlanePtr(const unsigned int plane, const unsigned int frame = 0)
+    {
+        return getRowPtr(0, plane, frame);
+    }
+
     void lockBuffer()
     {
         m_ioLock.lock();
@@ -339,9 +594,10 @@ public:
         m_ioLock.unlock();
     }
 
+    // Copy a frame to a packed buffer (planes back to back, no row padding)
     bool getFrame(void* pTarget, const unsigned int frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
         {
             return false;
         }
@@ -353,13 +609,11 @@ public:
 
         std::lock_guard<std::mutex> lock(m_ioLock);
 
-        unsigned int bytesPerFrame = ((m_nBitsPerPixel * m_frameSize) / 8);
-
-        unsigned int offset = (bytesPerFrame * frame);
+        size_t offset = (m_layout.frameSize * frame);
 
         try
         {
-            memcpy(pTarget, (((uint8_t*) m_pBuffer) + offset), bytesPerFrame);
+            packVideoFrame(pTarget, (((uint8_t*) m_pBuffer) + offset), m_layout);
         }
         catch (...)
         {
@@ -369,9 +623,10 @@ public:
         return true;;
     }
 
+    // Copy a packed frame (planes back to back, no row padding) into a frame
     bool setFrame(const void* pSource, const unsigned int frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
         {
             return false;
         }
@@ -383,15 +638,13 @@ public:
 
         std::lock_guard<std::mutex> lock(m_ioLock);
 
-        unsigned int bytesPerFrame = ((m_nBitsPerPixel * m_frameSize) / 8);
-
-        unsigned int offset = (bytesPerFrame * frame);
+        size_t offset = (m_layout.frameSize * frame);
 
         try
         {
-            memcpy((((uint8_t*) m_pBuffer) + offset), pSource, bytesPerFrame);
+            unpackVideoFrame((((uint8_t*) m_pBuffer) + offset), pSource, m_layout);
 
-            m_frameDataLen[frame] = bytesPerFrame;
+            m_frameDataLen[frame] = m_layout.packedSize;
         }
         catch (...)
         {
@@ -401,6 +654,117 @@ public:
         return true;;
     }
 
+    // Copy one plane of a frame to pTarget, with 'trgtStride'
+    // bytes per row (0 = packed rows).
+    bool readPlane(void* pTarget, const unsigned int plane, const unsigned int frame = 0, const unsigned int trgtStride = 0)
+    {
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || plane >= m_layout.numPlanes)
+        {
+            return false;
+        }
+
+        const SVideoPlane &planeInfo = m_layout.planes[plane];
+
+        if (pTarget == nullptr || (trgtStride > 0 && trgtStride < planeInfo.rowBytes))
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_ioLock);
+
+        size_t offset = ((m_layout.frameSize * frame) + planeInfo.offset);
+
+        copyVideoPlane((uint8_t*) pTarget, ((trgtStride > 0) ? trgtStride : planeInfo.rowBytes), (((uint8_t*) m_pBuffer) + offset), planeInfo.stride, planeInfo.rowBytes, planeInfo.height);
+
+        return true;
+    }
+
+    // Copy one plane of a frame from pSource, with 'srcStride'
+    // bytes per row (0 = packed rows).
+    bool writePlane(const void* pSource, const unsigned int plane, const unsigned int frame = 0, const unsigned int srcStride = 0)
+    {
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || plane >= m_layout.numPlanes)
+        {
+            return false;
+        }
+
+        const SVideoPlane &planeInfo = m_layout.planes[plane];
+
+        if (pSource == nullptr || (srcStride > 0 && srcStride < planeInfo.rowBytes))
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_ioLock);
+
+        size_t offset = ((m_layout.frameSize * frame) + planeInfo.offset);
+
+        copyVideoPlane((((uint8_t*) m_pBuffer) + offset), planeInfo.stride, (const uint8_t*) pSource, ((srcStride > 0) ? srcStride : planeInfo.rowBytes), planeInfo.rowBytes, planeInfo.height);
+
+        return true;
+    }
+
+    // Copy a frame into a (pooled) video frame, which must
+    // have the same resolution and format as this buffer.
+    bool getFrame(CVideoFrame &target, const unsigned int frame = 0)
+    {
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
+        {
+            return false;
+        }
+
+        if (isSameLayout(target) == false)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_ioLock);
+
+        auto pFrame = (((uint8_t*) m_pBuffer) + (m_layout.frameSize * frame));
+
+        for (unsigned int idx = 0; idx < m_layout.numPlanes; idx++)
+        {
+            const SVideoPlane &plane = m_layout.planes[idx];
+
+            copyVideoPlane(target.getPlanePtr(idx), target.getPlane(idx)->stride, (pFrame + plane.offset), plane.stride, plane.rowBytes, plane.height);
+        }
+
+        target.setDataLen(m_layout.packedSize);
+        target.setVideoFormat(m_nVideoFormat);
+
+        return true;
+    }
+
+    // Copy a (pooled) video frame, with the same resolution
+    // and format as this buffer, into a frame.
+    bool setFrame(CVideoFrame &source, const unsigned int frame = 0)
+    {
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
+        {
+            return false;
+        }
+
+        if (isSameLayout(source) == false)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_ioLock);
+
+        auto pFrame = (((uint8_t*) m_pBuffer) + (m_layout.frameSize * frame));
+
+        for (unsigned int idx = 0; idx < m_layout.numPlanes; idx++)
+        {
+            const SVideoPlane &plane = m_layout.planes[idx];
+
+            copyVideoPlane((pFrame + plane.offset), plane.stride, source.getPlanePtr(idx), source.getPlane(idx)->stride, plane.rowBytes, plane.height);
+        }
+
+        m_frameDataLen[frame] = m_layout.packedSize;
+
+        return true;
+    }
+
     void resetReadIndex()
     {
         m_readIdx = 0;
@@ -411,11 +775,11 @@ public:
         m_writeIdx = 0;
     }
 
-    // read a single pixel at the current read offset 
-    // and then increment the offset.
+    // read a single pixel (of the 1st plane) at the current
+    // read offset and then increment the offset.
     int readPixel(void *pTrgtPixel, const unsigned int frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || m_nBitsPerPixel < 1)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || m_nBitsPerPixel < 1)
         {
             return -1;
         }
@@ -434,15 +798,11 @@ public:
             return -1;
         }
 
-        unsigned int bytesPerFrame = ((m_nBitsPerPixel * m_frameSize) / 8);
-
-        unsigned int offset = ((frame * bytesPerFrame) + ((m_readIdx * m_nBitsPerPixel) / 8));
-
-        unsigned int pixelSize = (((m_nBitsPerPixel + 8) - 1) / 8);       // divide by 8 and round up
+        size_t offset = getPixelOffset(m_readIdx, frame);
 
         try
         {
-            memcpy(pTrgtPixel, (((uint8_t*) m_pBuffer) + offset), pixelSize);
+            memcpy(pTrgtPixel, (((uint8_t*) m_pBuffer) + offset), getPixelBytes());
         }
         catch (...)
         {
@@ -454,10 +814,10 @@ public:
         return m_readIdx;
     }
 
-    // read a single pixel at 'index' offset.
+    // read a single pixel (of the 1st plane) at 'index' offset.
     bool readPixelAt(void* pTrgtPixel, const unsigned long index, const unsigned int frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || index > m_frameSize || m_nBitsPerPixel < 8)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || index >= m_frameSize || m_nBitsPerPixel < 8)
         {
             return false;
         }
@@ -470,20 +830,11 @@ public:
         // make sure multiple functions are not modifying the buffer at the same time
         std::lock_guard<std::mutex> lock(m_ioLock);
 
-        if (index >= (m_frameSize * m_blockSize))
-        {
-            return false;
-        }
-
-        unsigned int bytesPerFrame = ((m_frameSize * m_nBitsPerPixel) / 8);
-
-        unsigned int offset = ((frame * bytesPerFrame) + ((index * m_nBitsPerPixel) / 8));
-
-        unsigned int pixelSize = (((m_nBitsPerPixel + 8) - 1) / 8);       // divide by 8 and round up
+        size_t offset = getPixelOffset(index, frame);
 
         try
         {
-            memcpy(pTrgtPixel, (((uint8_t*) m_pBuffer) + offset), pixelSize);
+            memcpy(pTrgtPixel, (((uint8_t*) m_pBuffer) + offset), getPixelBytes());
         }
         catch (...)
         {
@@ -493,11 +844,11 @@ public:
         return true;
     }
 
-    // read a single pixel at 'index' offset.
+    // read a single pixel (of the 1st plane) at 'xPos, yPos'.
     // return: the pixel value at that offset
     bool readPixel(void* pTrgtPixel, const unsigned long xPos, const unsigned long yPos, const unsigned long frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || xPos > m_frameWidth || yPos > m_frameHeight || m_nBitsPerPixel < 8)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || xPos >= m_frameWidth || yPos >= m_frameHeight || m_nBitsPerPixel < 8)
         {
             return false;
         }
@@ -510,17 +861,11 @@ public:
         // make sure multiple functions are not modifying the buffer at the same time
         std::lock_guard<std::mutex> lock(m_ioLock);
 
-        unsigned int bytesPerFrame = ((m_frameSize * m_nBitsPerPixel) / 8);
-
-        unsigned int bytesPerScanLine = ((m_frameWidth * m_nBitsPerPixel) / 8);
-
-        unsigned int offset = ((frame * bytesPerFrame) + (yPos * bytesPerScanLine) + ((xPos * m_nBitsPerPixel) / 8));
-
-        unsigned int pixelSize = (((m_nBitsPerPixel + 8) - 1) / 8);       // divide by 8 and round up
+        size_t offset = getPixelOffset(xPos, yPos, frame);
 
         try
         {
-            memcpy(pTrgtPixel, (((uint8_t*)m_pBuffer) + offset), pixelSize);
+            memcpy(pTrgtPixel, (((uint8_t*)m_pBuffer) + offset), getPixelBytes());
         }
         catch (...)
         {
@@ -530,11 +875,12 @@ public:
         return true;
     }
 
-    // read a block of size 'count' (pixels) starting at the current read offset,
-    // and then update the current read offset. return the updated read offset
+    // read a block of size 'count' (pixels of the 1st plane) starting at
+    // the current read offset, and then update the current read offset.
+    // return the updated read offset
     int readPixels(void* pTrgtPixel, const unsigned int count, const unsigned long frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
         {
             return -1;
         }
@@ -547,24 +893,18 @@ public:
         // make sure multiple functions are not modifying the buffer at the same time
         std::lock_guard<std::mutex> lock(m_ioLock);
 
-        if ((m_readIdx + count) >= (m_frameSize * m_blockSize))
+        if ((m_readIdx + count) > m_frameSize)
         {
             return -1;
         }
 
-        unsigned int bytesPerFrame = ((m_frameSize * m_nBitsPerPixel) / 8);
-
-        unsigned int offset = ((frame * bytesPerFrame) + ((m_readIdx * m_nBitsPerPixel) / 8));
-
-        unsigned int copySize = ((((m_nBitsPerPixel * count) + 8) - 1) / 8);       // divide by 8 and round up
-
         try
         {
-            memcpy(pTrgtPixel, (((uint8_t*) m_pBuffer) + offset), copySize);
+            copyPixelsOut(static_cast<uint8_t*>(pTrgtPixel), m_readIdx, count, frame);
         }
         catch (...)
         {
-            return false;
+            return -1;
         }
 
         m_readIdx += count;
@@ -572,11 +912,11 @@ public:
         return m_readIdx;
     }
 
-    // write a single pixel at the current write offset, and
-    // then increment the offset, return the updated write offset.
+    // write a single pixel (of the 1st plane) at the current write offset,
+    // and then increment the offset, return the updated write offset.
     int writePixel(const void* pSrctPixel, const unsigned long frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
         {
             return -1;
         }
@@ -594,19 +934,15 @@ public:
             return -1;
         }
 
-        unsigned int bytesPerFrame = ((m_frameSize * m_nBitsPerPixel) / 8);
-
-        unsigned int offset = ((frame * bytesPerFrame) + ((m_writeIdx * m_nBitsPerPixel) / 8));
-
-        unsigned int pixelSize = (((m_nBitsPerPixel + 8) - 1) / 8);       // divide by 8 and round up
+        size_t offset = getPixelOffset(m_writeIdx, frame);
 
         try
         {
-            memcpy((((uint8_t*) m_pBuffer) + offset), pSrctPixel, pixelSize);
+            memcpy((((uint8_t*) m_pBuffer) + offset), pSrctPixel, getPixelBytes());
         }
         catch (...)
         {
-            return false;
+            return -1;
         }
 
         m_writeIdx++;
@@ -614,11 +950,11 @@ public:
         return m_writeIdx;
     }
 
-    // write a single pixel at 'index' write offset.
+    // write a single pixel (of the 1st plane) at 'index' write offset.
     // return: the write offset    
     bool writePixelAt(const void* pSrctPixel, const unsigned long index, const unsigned long frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || m_nBitsPerPixel < 8)
         {
             return false;
         }
@@ -635,15 +971,11 @@ public:
             return false;
         }
 
-        unsigned int bytesPerFrame = ((m_frameSize * m_nBitsPerPixel) / 8);
-
-        unsigned int offset = ((frame * bytesPerFrame) + ((index * m_nBitsPerPixel) / 8));
-
-        unsigned int pixelSize = (((m_nBitsPerPixel + 8) - 1) / 8);       // divide by 8 and round up
+        size_t offset = getPixelOffset(index, frame);
 
         try
         {
-            memcpy((((uint8_t*)m_pBuffer) + offset), pSrctPixel, pixelSize);
+            memcpy((((uint8_t*)m_pBuffer) + offset), pSrctPixel, getPixelBytes());
         }
         catch (...)
         {
@@ -653,11 +985,11 @@ public:
         return true;
     }
 
-    // write a single pixel at 'index' offset.
+    // write a single pixel (of the 1st plane) at 'xPos, yPos'.
     // return: the write offset    
     bool writePixel(const void* pSrctPixel, const unsigned long xPos, const unsigned long yPos, const unsigned long frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || xPos > m_frameWidth || yPos > m_frameHeight || m_nBitsPerPixel < 8)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || xPos >= m_frameWidth || yPos >= m_frameHeight || m_nBitsPerPixel < 8)
         {
             return false;
         }
@@ -670,17 +1002,11 @@ public:
         // make sure multiple functions are not modifying the buffer at the same time
         std::lock_guard<std::mutex> lock(m_ioLock);
 
-        unsigned int bytesPerFrame = ((m_frameSize * m_nBitsPerPixel) / 8);
-
-        unsigned int bytesPerScanLine = ((m_frameWidth * m_nBitsPerPixel) / 8);
-
-        unsigned int offset = ((frame * bytesPerFrame) + (yPos * bytesPerScanLine) + ((xPos * m_nBitsPerPixel) / 8));
-
-        unsigned int pixelSize = (((m_nBitsPerPixel + 8) - 1) / 8);       // divide by 8 and round up
+        size_t offset = getPixelOffset(xPos, yPos, frame);
 
         try
         {
-            memcpy((((uint8_t*) m_pBuffer) + offset), pSrctPixel, pixelSize);
+            memcpy((((uint8_t*) m_pBuffer) + offset), pSrctPixel, getPixelBytes());
         }
         catch (...)
         {
@@ -690,13 +1016,13 @@ public:
         return true;
     }
 
-    // write a block of size 'count' (pixels)
+    // write a block of size 'count' (pixels of the 1st plane)
     // starting at the current write offset,
     // and then update the current write offset.
     // return:  the updated write offset.
     int writePixels(const void* pSrctPixel, const unsigned int count, const unsigned long frame = 0)
     {
-        if (m_frameSize < 1 || m_blockSize < 1 || frame > m_blockSize || !m_bAllocated || count > m_frameSize || m_nBitsPerPixel < 8)
+        if (m_frameSize < 1 || m_blockSize < 1 || frame >= m_blockSize || !m_bAllocated || count > m_frameSize || m_nBitsPerPixel < 8)
         {
             return -1;
         }
@@ -713,19 +1039,13 @@ public:
             return -1;
         }
 
-        unsigned int bytesPerFrame = ((m_frameSize * m_nBitsPerPixel) / 8);
-
-        unsigned offset = ((frame * bytesPerFrame) + ((m_writeIdx * m_nBitsPerPixel) / 8));
-
-        unsigned int copySize = ((((m_nBitsPerPixel * count) + 8) - 1) / 8);       // divide by 8 and round up
-
         try
         {
-            memcpy((((uint8_t*)m_pBuffer) + offset), pSrctPixel, copySize);
+            copyPixelsIn(static_cast<const uint8_t*>(pSrctPixel), m_writeIdx, count, frame);
         }
         catch (...)
         {
-            return false;
+            return -1;
         }
 
         m_writeIdx += count;
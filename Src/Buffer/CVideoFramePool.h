@@ -0,0 +1,726 @@
+//****************************************************************************
+// FILE:    CVideoFramePool.h
+//
+// DESC:    A pool of reference counted (raw) video frames.
+//
+//          CVideoFramePool::acquire() hands out CVideoFrameRef handles.
+//          Copying a handle only adds a reference (no pixel data is
+//          copied), so a frame can be passed from a capture thread to
+//          encoders / file writers etc.  When the last handle is
+//          released the frame goes back to the pool, to be re-used.
+//
+//          Frames use the (planar / padded row) layout described in
+//          VideoFrameLayout.h, so every row of every plane starts on a
+//          64 byte boundary and SIMD code can use aligned loads.
+//
+//          NOTE: Frames may outlive the pool that created them, they
+//          are simply deleted (instead of recycled) when released.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _VIDEO_FRAME_POOL_H_
+#define _VIDEO_FRAME_POOL_H_
+
+
+#include "../Logging/Logging.h"
+
+#include "CBufferPool.h"
+#include "VideoFrameLayout.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+
+class CVideoFrame;
+
+
+// Shared state of a frame pool.  Every frame holds a reference to
+// it, so a frame that is released after the pool has been
+// destroyed can still tell it has nowhere to go.
+struct SVideoFramePoolState
+{
+    std::mutex                  lock;
+    std::condition_variable     frameReadyVar;      // signaled when a frame is recycled
+
+    std::vector<CVideoFrame *>  freeList;
+
+    CBufferAllocator            *pAllocator = nullptr;
+
+    unsigned long               generation  = 0;    // bumped when the frame format changes
+    unsigned int                numFrames   = 0;    // total frames created (in use + free)
+    unsigned int                maxFrames   = 0;    // 0 = no limit
+
+    bool                        bClosed     = false;
+    bool                        bCancelWait = false;
+
+    void recycle(CVideoFrame *pFrame);
+};
+
+
+class CVideoFrame
+{
+    friend class CVideoFramePool;
+    friend struct SVideoFramePoolState;
+
+    std::atomic<int>            m_nRefs;
+
+    std::shared_ptr<SVideoFramePoolState>   m_pPoolState;
+    unsigned long               m_generation;
+
+    CBufferAllocator            *m_pAllocator;
+
+    uint8_t                     *m_pData;
+    size_t                      m_nBufferLen;   // size of the allocated pixel buffer (in bytes)
+
+    unsigned int                m_frameWidth;   // video frame width (in pixels)
+    unsigned int                m_frameHeight;  // video frame height
+    unsigned int                m_nBitsPerPixel;
+    unsigned int                m_nStride;      // bytes per row of the 1st plane (including padding)
+
+    unsigned long               m_nVideoFormat; // 0 = uncopressed/raw video
+
+    SVideoFrameLayout           m_layout;
+
+    unsigned long               m_nDataLen;     // length of actual frame data (in bytes)
+    int64_t                     m_nTimeStamp;
+
+    CVideoFrame() :
+        m_nRefs(0)
+    {
+        m_generation = 0;
+
+        m_pAllocator = nullptr;
+
+        m_pData = nullptr;
+        m_nBufferLen = 0;
+
+        m_frameWidth = 0;
+        m_frameHeight = 0;
+        m_nBitsPerPixel = 0;
+        m_nStride = 0;
+
+        m_nVideoFormat = 0;
+
+        m_nDataLen = 0;
+        m_nTimeStamp = 0;
+    }
+
+    ~CVideoFrame()
+    {
+        if (m_pData != nullptr && m_pAllocator != nullptr)
+            m_pAllocator->deallocate(m_pData, m_nBufferLen);
+
+        m_pData = nullptr;
+    }
+
+  public:
+
+    CVideoFrame(const CVideoFrame &) = delete;
+    CVideoFrame &operator=(const CVideoFrame &) = delete;
+
+    void addRef()
+    {
+        m_nRefs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Drop a reference, the last one returns the frame to its pool
+    void release()
+    {
+        if (m_nRefs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        if (m_pPoolState != nullptr)
+        {
+            // NOTE: recycle() may delete this frame
+            auto pState = m_pPoolState;
+
+            pState->recycle(this);
+        }
+        else
+        {
+            delete this;
+        }
+    }
+
+    int getRefCount()
+    {
+        return m_nRefs.load(std::memory_order_relaxed);
+    }
+
+    uint8_t *getDataPtr()
+    {
+        return m_pData;
+    }
+
+    // Get a pointer to the start of a row of a plane (nullptr = invalid row)
+    uint8_t *getRowPtr(const unsigned int row, const unsigned int plane = 0)
+    {
+        if (m_pData == nullptr || plane >= m_layout.numPlanes || row >= m_layout.planes[plane].height)
+            return nullptr;
+
+        return (m_pData + m_layout.planes[plane].offset + ((size_t) row * m_layout.planes[plane].stride));
+    }
+
+    uint8_t *getPlanePtr(const unsigned int plane)
+    {
+        return getRowPtr(0, plane);
+    }
+
+    // Get a plane descriptor (nullptr = invalid plane)
+    const SVideoPlane *getPlane(const unsigned int plane)
+    {
+        if (plane >= m_layout.numPlanes)
+            return nullptr;
+
+        return &m_layout.planes[plane];
+    }
+
+    unsigned int getNumPlanes()
+    {
+        return m_layout.numPlanes;
+    }
+
+    const SVideoFrameLayout &getLayout()
+    {
+        return m_layout;
+    }
+
+    size_t getBufferLen()
+    {
+        return m_nBufferLen;
+    }
+
+    unsigned int getFrameWidth()
+    {
+        return m_frameWidth;
+    }
+
+    unsigned int getFrameHeight()
+    {
+        return m_frameHeight;
+    }
+
+    unsigned int getPixelSize()
+    {
+        return m_nBitsPerPixel;
+    }
+
+    unsigned int getStride()
+    {
+        return m_nStride;
+    }
+
+    unsigned long getVideoFormat()
+    {
+        return m_nVideoFormat;
+    }
+
+    void setVideoFormat(const unsigned long nFmt)
+    {
+        m_nVideoFormat = nFmt;
+    }
+
+    unsigned long getDataLen()
+    {
+        return m_nDataLen;
+    }
+
+    void setDataLen(const unsigned long nLen)
+    {
+        m_nDataLen = (nLen > m_nBufferLen) ? m_nBufferLen : nLen;
+    }
+
+    int64_t getTimeStamp()
+    {
+        return m_nTimeStamp;
+    }
+
+    void setTimeStamp(const int64_t nTimeStamp)
+    {
+        m_nTimeStamp = nTimeStamp;
+    }
+
+    // Copy a frame from a packed source buffer (planes back to back, or
+    // "srcStride" bytes per row for single plane formats) into this frame.
+    // Returns the number of bytes copied, or -1 = invalid param
+    int copyFrom(const void *pSource, const unsigned int srcStride = 0)
+    {
+        if (pSource == nullptr || m_pData == nullptr)
+        {
+            LogDebug("[CVideoFrame:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (srcStride == 0)
+        {
+            m_nDataLen = (unsigned long) unpackVideoFrame(m_pData, pSource, m_layout);
+
+            return (int) m_nDataLen;
+        }
+
+        const SVideoPlane &plane = m_layout.planes[0];
+
+        if (m_layout.numPlanes != 1 || srcStride < plane.rowBytes)
+        {
+            LogDebug("[CVideoFrame:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        copyVideoPlane(m_pData + plane.offset, plane.stride, (const uint8_t *) pSource, srcStride, plane.rowBytes, plane.height);
+
+        m_nDataLen = (unsigned long) m_layout.packedSize;
+
+        return (int) m_nDataLen;
+    }
+
+    // Copy this frame to a packed target buffer (planes back to back, or
+    // "trgtStride" bytes per row for single plane formats).
+    // Returns the number of bytes copied, or -1 = invalid param
+    int copyTo(void *pTarget, const unsigned int trgtStride = 0)
+    {
+        if (pTarget == nullptr || m_pData == nullptr)
+        {
+            LogDebug("[CVideoFrame:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        if (trgtStride == 0)
+            return (int) packVideoFrame(pTarget, m_pData, m_layout);
+
+        const SVideoPlane &plane = m_layout.planes[0];
+
+        if (m_layout.numPlanes != 1 || trgtStride < plane.rowBytes)
+        {
+            LogDebug("[CVideoFrame:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        copyVideoPlane((uint8_t *) pTarget, trgtStride, m_pData + plane.offset, plane.stride, plane.rowBytes, plane.height);
+
+        return (int) m_layout.packedSize;
+    }
+};
+
+
+// Reference counted handle to a CVideoFrame
+class CVideoFrameRef
+{
+    CVideoFrame     *m_pFrame;
+
+  public:
+
+    CVideoFrameRef() :
+        m_pFrame(nullptr)
+    {
+    }
+
+    // Take over a reference that has already been added
+    explicit CVideoFrameRef(CVideoFrame *pFrame) :
+        m_pFrame(pFrame)
+    {
+    }
+
+    CVideoFrameRef(const CVideoFrameRef &other) :
+        m_pFrame(other.m_pFrame)
+    {
+        if (m_pFrame != nullptr)
+            m_pFrame->addRef();
+    }
+
+    CVideoFrameRef(CVideoFrameRef &&other) noexcept :
+        m_pFrame(other.m_pFrame)
+    {
+        other.m_pFrame = nullptr;
+    }
+
+    ~CVideoFrameRef()
+    {
+        reset();
+    }
+
+    CVideoFrameRef &operator=(const CVideoFrameRef &other)
+    {
+        if (other.m_pFrame != nullptr)
+            other.m_pFrame->addRef();
+
+        reset();
+
+        m_pFrame = other.m_pFrame;
+
+        return *this;
+    }
+
+    CVideoFrameRef &operator=(CVideoFrameRef &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+
+            m_pFrame = other.m_pFrame;
+            other.m_pFrame = nullptr;
+        }
+
+        return *this;
+    }
+
+    // Drop this handle's reference
+    void reset()
+    {
+        if (m_pFrame != nullptr)
+        {
+            m_pFrame->release();
+
+            m_pFrame = nullptr;
+        }
+    }
+
+    CVideoFrame *get() const
+    {
+        return m_pFrame;
+    }
+
+    CVideoFrame *operator->() const
+    {
+        return m_pFrame;
+    }
+
+    CVideoFrame &operator*() const
+    {
+        return *m_pFrame;
+    }
+
+    explicit operator bool() const
+    {
+        return (m_pFrame != nullptr);
+    }
+};
+
+
+inline void SVideoFramePoolState::recycle(CVideoFrame *pFrame)
+{
+    {
+        std::lock_guard<std::mutex> guard{lock};
+
+        // frames of an old format (or a closed pool) are not re-used
+        if (bClosed == false && pFrame->m_generation == generation)
+        {
+            pFrame->m_nDataLen = 0;
+            pFrame->m_nTimeStamp = 0;
+
+            freeList.push_back(pFrame);
+
+            frameReadyVar.notify_one();
+
+            return;
+        }
+
+        if (numFrames > 0 && pFrame->m_generation == generation)
+            numFrames--;
+    }
+
+    // NOTE: The frame holds a reference to this state, so must
+    // not be deleted while the lock is still held.
+    delete pFrame;
+}
+
+
+class CVideoFramePool
+{
+    std::shared_ptr<SVideoFramePoolState>   m_pState;
+
+    unsigned int                m_frameWidth;   // video frame width (in pixels)
+    unsigned int                m_frameHeight;  // video frame height
+    unsigned int                m_nBitsPerPixel;
+    unsigned int                m_nStride;      // bytes per row of the 1st plane (including padding)
+
+    unsigned long               m_nVideoFormat; // 0 = uncopressed/raw video
+
+    SVideoFrameLayout           m_layout;
+
+  protected:
+
+    // Free the frames that are not in use (the state lock must be held)
+    void freeUnusedFrames()
+    {
+        for (auto pFrame : m_pState->freeList)
+        {
+            if (m_pState->numFrames > 0)
+                m_pState->numFrames--;
+
+            pFrame->m_pPoolState.reset();
+
+            delete pFrame;
+        }
+
+        m_pState->freeList.clear();
+    }
+
+    // Create a new frame (the state lock must be held)
+    CVideoFrame *createFrame()
+    {
+        if (m_layout.frameSize < 1)
+            return nullptr;
+
+        auto pFrame = new (std::nothrow) CVideoFrame();
+
+        if (pFrame == nullptr)
+            return nullptr;
+
+        size_t bufferLen = m_layout.frameSize;
+
+        pFrame->m_pAllocator = m_pState->pAllocator;
+        pFrame->m_pData = (uint8_t *) m_pState->pAllocator->allocate(bufferLen);
+
+        if (pFrame->m_pData == nullptr)
+        {
+            delete pFrame;
+
+            return nullptr;
+        }
+
+        pFrame->m_nBufferLen = bufferLen;
+
+        pFrame->m_frameWidth = m_frameWidth;
+        pFrame->m_frameHeight = m_frameHeight;
+        pFrame->m_nBitsPerPixel = m_nBitsPerPixel;
+        pFrame->m_nStride = m_nStride;
+        pFrame->m_nVideoFormat = m_nVideoFormat;
+        pFrame->m_layout = m_layout;
+
+        pFrame->m_pPoolState = m_pState;
+        pFrame->m_generation = m_pState->generation;
+
+        m_pState->numFrames++;
+
+        return pFrame;
+    }
+
+    // Take a free frame, or create one (the state lock must be held)
+    CVideoFrame *takeFrame()
+    {
+        CVideoFrame *pFrame = nullptr;
+
+        if (m_pState->freeList.empty() == false)
+        {
+            pFrame = m_pState->freeList.back();
+            m_pState->freeList.pop_back();
+        }
+        else if (m_pState->maxFrames == 0 || m_pState->numFrames < m_pState->maxFrames)
+        {
+            pFrame = createFrame();
+        }
+
+        if (pFrame != nullptr)
+            pFrame->m_nRefs.store(1, std::memory_order_relaxed);
+
+        return pFrame;
+    }
+
+  public:
+
+    // maxFrames = max number of frames (in use + free), 0 = no limit
+    CVideoFramePool(const unsigned int maxFrames = 0, CBufferAllocator *pAllocator = nullptr) :
+        m_pState(std::make_shared<SVideoFramePoolState>())
+    {
+        m_frameWidth = 0;
+        m_frameHeight = 0;
+        m_nBitsPerPixel = 0;
+        m_nStride = 0;
+
+        m_nVideoFormat = 0;
+
+        m_pState->maxFrames = maxFrames;
+        m_pState->pAllocator = (pAllocator != nullptr) ? pAllocator : getDefaultBufferAllocator();
+    }
+
+    ~CVideoFramePool()
+    {
+        std::lock_guard<std::mutex> lock{m_pState->lock};
+
+        m_pState->bClosed = true;
+        m_pState->bCancelWait = true;
+
+        freeUnusedFrames();
+
+        m_pState->frameReadyVar.notify_all();
+    }
+
+    CVideoFramePool(const CVideoFramePool &) = delete;
+    CVideoFramePool &operator=(const CVideoFramePool &) = delete;
+
+    // Set the format of the frames handed out by acquire().
+    // nBitsPerPixel may be 0 for the raw formats in eVideoDataIoFormat_def.
+    // Frames of the previous format that are still in use
+    // are deleted (not recycled) when they are released.
+    // Returns -1 = invalid param
+    int setFormat(const unsigned int frameWidth, const unsigned int frameHeight, const unsigned int nBitsPerPixel, const unsigned long nFmt = 0)
+    {
+        unsigned int nBits = (nBitsPerPixel > 0) ? nBitsPerPixel : getVideoFormatBitsPerPixel(nFmt);
+
+        SVideoFrameLayout layout;
+
+        if (nBits < 1 || getVideoFrameLayout(layout, frameWidth, frameHeight, nBits, nFmt) < 0)
+        {
+            LogDebug("[CVideoFramePool:{}] Invalid param ", __func__);
+            return -1;
+        }
+
+        std::lock_guard<std::mutex> lock{m_pState->lock};
+
+        m_frameWidth = frameWidth;
+        m_frameHeight = frameHeight;
+        m_nBitsPerPixel = nBits;
+        m_nStride = layout.planes[0].stride;
+        m_layout = layout;
+
+        m_nVideoFormat = nFmt;
+
+        freeUnusedFrames();
+
+        // frames still in use no longer count against maxFrames
+        m_pState->numFrames = 0;
+        m_pState->generation++;
+
+        return 0;
+    }
+
+    // Set the max number of frames (in use + free), 0 = no limit
+    void setMaxFrames(const unsigned int maxFrames)
+    {
+        std::lock_guard<std::mutex> lock{m_pState->lock};
+
+        m_pState->maxFrames = maxFrames;
+    }
+
+    // Create (up to) numFrames frames up front, so acquire()
+    // does not allocate.  Returns the number of free frames.
+    unsigned int preallocate(const unsigned int numFrames)
+    {
+        std::lock_guard<std::mutex> lock{m_pState->lock};
+
+        while (m_pState->freeList.size() < numFrames)
+        {
+            if (m_pState->maxFrames > 0 && m_pState->numFrames >= m_pState->maxFrames)
+                break;
+
+            auto pFrame = createFrame();
+
+            if (pFrame == nullptr)
+                break;
+
+            m_pState->freeList.push_back(pFrame);
+        }
+
+        return (unsigned int) m_pState->freeList.size();
+    }
+
+    // Get a frame without blocking.  The handle is empty if the
+    // format is not set, or maxFrames frames are already in use.
+    CVideoFrameRef tryAcquire()
+    {
+        std::lock_guard<std::mutex> lock{m_pState->lock};
+
+        return CVideoFrameRef(takeFrame());
+    }
+
+    // Get a frame, waiting (up to timeoutMs milliseconds) for one
+    // to be released if maxFrames frames are already in use.
+    CVideoFrameRef acquire(const unsigned int timeoutMs = 0)
+    {
+        std::unique_lock<std::mutex> lock{m_pState->lock};
+
+        CVideoFrame *pFrame = takeFrame();
+
+        if (pFrame == nullptr && timeoutMs > 0 && m_layout.frameSize > 0)
+        {
+            m_pState->frameReadyVar.wait_for
+                (
+                    lock,
+                    std::chrono::milliseconds(timeoutMs),
+                    [&]
+                    {
+                        pFrame = takeFrame();
+
+                        return (pFrame != nullptr || m_pState->bCancelWait == true);
+                    }
+                );
+        }
+
+        return CVideoFrameRef(pFrame);
+    }
+
+    // Cancel (or re-enable) waiting in acquire()
+    void cancelWait(const bool bCancel = true)
+    {
+        std::lock_guard<std::mutex> lock{m_pState->lock};
+
+        m_pState->bCancelWait = bCancel;
+
+        if (bCancel == true)
+            m_pState->frameReadyVar.notify_all();
+    }
+
+    // Free all the frames that are not in use
+    void trim()
+    {
+        std::lock_guard<std::mutex> lock{m_pState->lock};
+
+        freeUnusedFrames();
+    }
+
+    unsigned int getNumFrames()
+    {
+        std::lock_guard<std::mutex> lock{m_pState->lock};
+
+        return m_pState->numFrames;
+    }
+
+    unsigned int getNumFreeFrames()
+    {
+        std::lock_guard<std::mutex> lock{m_pState->lock};
+
+        return (unsigned int) m_pState->freeList.size();
+    }
+
+    unsigned int getFrameWidth()
+    {
+        return m_frameWidth;
+    }
+
+    unsigned int getFrameHeight()
+    {
+        return m_frameHeight;
+    }
+
+    unsigned int getPixelSize()
+    {
+        return m_nBitsPerPixel;
+    }
+
+    unsigned int getStride()
+    {
+        return m_nStride;
+    }
+
+    unsigned long getVideoFormat()
+    {
+        return m_nVideoFormat;
+    }
+
+    const SVideoFrameLayout &getLayout()
+    {
+        return m_layout;
+    }
+};
+
+
+#endif // _VIDEO_FRAME_POOL_H_
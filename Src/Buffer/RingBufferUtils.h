@@ -0,0 +1,141 @@
+//****************************************************************************
+// FILE:    RingBufferUtils.h
+//
+// DESC:    Helper functions shared by the ring buffer classes.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _RING_BUFFER_UTILS_H_
+#define _RING_BUFFER_UTILS_H_
+
+
+#include <algorithm>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstring>
+
+
+// Size (in bytes) used to keep producer and consumer
+// indices on separate cache lines.
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE         64
+#endif
+
+
+// Copy "numEntries" entries from pSource to pTarget.
+// Trivially copyable types are copied with a single memcpy.
+template <typename T> inline void copyBufferEntries
+    (
+        T *pTarget,
+        const T *pSource,
+        const size_t numEntries
+    )
+{
+    if (numEntries < 1)
+        return;
+
+    if constexpr (std::is_trivially_copyable<T>::value)
+    {
+        memcpy((void *) pTarget, (const void *) pSource, (numEntries * sizeof(T)));
+    }
+    else
+    {
+        std::copy(pSource, (pSource + numEntries), pTarget);
+    }
+}
+
+// Copy "numEntries" entries out of a ring (starting at readIdx)
+// into a linear target buffer.  At most two copies are done,
+// one up to the end of the ring and one for the wrapped remainder.
+template <typename T> inline void copyFromRing
+    (
+        T *pTarget,
+        const T *pRing,
+        const size_t ringSize,
+        const size_t readIdx,
+        const size_t numEntries
+    )
+{
+    size_t firstSpan = std::min(numEntries, (ringSize - readIdx));
+
+    copyBufferEntries(pTarget, (pRing + readIdx), firstSpan);
+
+    copyBufferEntries((pTarget + firstSpan), pRing, (numEntries - firstSpan));
+}
+
+// Copy "numEntries" entries from a linear source buffer
+// into a ring (starting at writeIdx).  At most two copies are done,
+// one up to the end of the ring and one for the wrapped remainder.
+template <typename T> inline void copyToRing
+    (
+        T *pRing,
+        const size_t ringSize,
+        const size_t writeIdx,
+        const T *pSource,
+        const size_t numEntries
+    )
+{
+    size_t firstSpan = std::min(numEntries, (ringSize - writeIdx));
+
+    copyBufferEntries((pRing + writeIdx), pSource, firstSpan);
+
+    copyBufferEntries(pRing, (pSource + firstSpan), (numEntries - firstSpan));
+}
+
+
+// Up to two contiguous regions of ring buffer storage,
+// as handed out by the "reserveWrite" / "peekRead" functions.
+// Region 1 runs up to the end of the storage, region 2 is
+// the wrapped remainder (at the start of the storage).
+template <typename T> struct SRingBufferRegion
+{
+    T           *pData1 = nullptr;
+    size_t      size1   = 0;
+
+    T           *pData2 = nullptr;
+    size_t      size2   = 0;
+
+    // Total number of entries in both regions
+    size_t size() const
+    {
+        return (size1 + size2);
+    }
+
+    bool empty() const
+    {
+        return (size() < 1);
+    }
+};
+
+// Build the region(s) describing "numEntries" entries
+// of a ring, starting at offset "idx".
+template <typename T> inline SRingBufferRegion<T> makeRingRegion
+    (
+        T *pRing,
+        const size_t ringSize,
+        const size_t idx,
+        const size_t numEntries
+    )
+{
+    SRingBufferRegion<T> region;
+
+    if (pRing == nullptr || numEntries < 1)
+        return region;
+
+    region.pData1 = (pRing + idx);
+    region.size1  = std::min(numEntries, (ringSize - idx));
+
+    if (region.size1 < numEntries)
+    {
+        region.pData2 = pRing;
+        region.size2  = (numEntries - region.size1);
+    }
+
+    return region;
+}
+
+
+#endif // _RING_BUFFER_UTILS_H_
@@ -0,0 +1,1057 @@
+//****************************************************************************
+// FILE:    SampleConvert.h
+//
+// DESC:    Audio sample format conversion (s16, packed s24, s32, f32, f64),
+//          a block of samples at a time.
+//
+//          Integer <-> float conversions use SSE2 / AVX2 (x86) or NEON
+//          (ARM) kernels, selected at run-time, with scalar loops for
+//          everything else (and for any left over samples).
+//
+//          Float -> integer conversions round to nearest, saturate out
+//          of range values to full scale (in the scalar and the SIMD
+//          code), and can optionally add TPDF dither
+//          (SAMPLE_CONVERT_DITHER).
+//
+//          Conversions that don't involve f32 don't go through a float
+//          (24 bit mantissa): integer <-> f64 is done in double precision,
+//          and integer <-> integer shifts the samples (s16 -> s32 = << 16),
+//          so widening is exact and narrowing rounds (and saturates).
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _SAMPLE_CONVERT_H_
+#define _SAMPLE_CONVERT_H_
+
+
+#include "SimdUtils.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+
+enum eSampleFormat_def
+{
+    eSampleFormat_unknown = 0,
+    eSampleFormat_s16,
+    eSampleFormat_s24,          // packed (3 bytes per sample, little endian)
+    eSampleFormat_s32,
+    eSampleFormat_f32,
+    eSampleFormat_f64
+};
+
+
+// Float -> integer conversion flags
+#define SAMPLE_CONVERT_CLIP         0x01        // clamp out of range values to full scale (always done, the flag is accepted for compatibility)
+#define SAMPLE_CONVERT_DITHER       0x02        // add TPDF dither (+/- 1 LSB)
+
+// Full scale values (the same scaling as ConvertInt16ToFloat)
+#define SAMPLE_SCALE_S16            32767.0f
+#define SAMPLE_SCALE_S24            8388607.0f
+#define SAMPLE_SCALE_S32            2147483647.0f
+
+// Largest float values that still fit in the integer formats
+#define SAMPLE_MAX_S16              32767.0f
+#define SAMPLE_MIN_S16              -32768.0f
+#define SAMPLE_MAX_S24              8388607.0f
+#define SAMPLE_MIN_S24              -8388608.0f
+#define SAMPLE_MAX_S32              2147483520.0f
+#define SAMPLE_MIN_S32              -2147483648.0f
+
+// (and in double precision)
+#define SAMPLE_MAX_S32_F64          2147483647.0
+
+
+// Get the number of bytes per sample for a sample format
+inline size_t getSampleSize(const eSampleFormat_def format)
+{
+    switch (format)
+    {
+        case eSampleFormat_s16: return 2;
+        case eSampleFormat_s24: return 3;
+        case eSampleFormat_s32: return 4;
+        case eSampleFormat_f32: return 4;
+        case eSampleFormat_f64: return 8;
+        default: break;
+    }
+
+    return 0;
+}
+
+// Get the sample format of a sample data type
+template <typename T> constexpr eSampleFormat_def getSampleFormat()
+{
+    if constexpr (std::is_same<T, int16_t>::value)
+        return eSampleFormat_s16;
+    else if constexpr (std::is_same<T, int32_t>::value)
+        return eSampleFormat_s32;
+    else if constexpr (std::is_same<T, float>::value)
+        return eSampleFormat_f32;
+    else if constexpr (std::is_same<T, double>::value)
+        return eSampleFormat_f64;
+    else
+        return eSampleFormat_unknown;
+}
+
+
+// Per thread dither noise generator state (one xorshift32 per SIMD lane)
+struct SDitherState
+{
+    uint32_t    lane[8] = { 0x9E3779B9, 0x7F4A7C15, 0x85EBCA6B, 0xC2B2AE35, 0x27D4EB2F, 0x165667B1, 0xD3A2646C, 0xFD7046C5 };
+};
+
+inline SDitherState &getDitherState()
+{
+    static thread_local SDitherState state;
+
+    return state;
+}
+
+// TPDF dither noise, (-1.0 to 1.0) LSB
+inline float getDitherNoise(uint32_t &state)
+{
+    float noise = 0;
+
+    for (unsigned int x = 0; x < 2; x++)
+    {
+        state ^= (state << 13);
+        state ^= (state >> 17);
+        state ^= (state << 5);
+
+        float value = ((float) (state >> 8) * (1.0f / 16777216.0f));
+
+        noise = (x == 0) ? value : (noise - value);
+    }
+
+    return noise;
+}
+
+// Scale, (dither), clip and round one float sample
+inline int32_t convertFloatToInt(const float value, const float scale, const float minValue, const float maxValue, const int flags, uint32_t &ditherState)
+{
+    float x = (value * scale);
+
+    if ((flags & SAMPLE_CONVERT_DITHER) != 0)
+        x += getDitherNoise(ditherState);
+
+    // (clip before narrowing, as the SIMD code does)
+    x = std::min(std::max(x, minValue), maxValue);
+
+    return (int32_t) std::lrintf(x);
+}
+
+// As convertFloatToInt(), for a double sample
+inline int32_t convertDoubleToInt(const double value, const double scale, const double minValue, const double maxValue, const int flags, uint32_t &ditherState)
+{
+    double x = (value * scale);
+
+    if ((flags & SAMPLE_CONVERT_DITHER) != 0)
+        x += getDitherNoise(ditherState);
+
+    x = std::min(std::max(x, minValue), maxValue);
+
+    return (int32_t) std::lrint(x);
+}
+
+
+#ifdef SIMD_X86
+
+// Each kernel returns the number of samples it converted - the
+// caller converts the rest with a scalar loop.
+
+SIMD_TARGET_SSE2 inline __m128 getDitherNoiseSse2(__m128i &state)
+{
+    __m128 noise[2];
+
+    for (unsigned int x = 0; x < 2; x++)
+    {
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+        state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+
+        noise[x] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(state, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+    }
+
+    return _mm_sub_ps(noise[0], noise[1]);
+}
+
+SIMD_TARGET_AVX2 inline __m256 getDitherNoiseAvx2(__m256i &state)
+{
+    __m256 noise[2];
+
+    for (unsigned int x = 0; x < 2; x++)
+    {
+        state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 13));
+        state = _mm256_xor_si256(state, _mm256_srli_epi32(state, 17));
+        state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 5));
+
+        noise[x] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(state, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+    }
+
+    return _mm256_sub_ps(noise[0], noise[1]);
+}
+
+// Scale, (dither) and clip 4 float samples, then round them to int32
+SIMD_TARGET_SSE2 inline __m128i convertFloatToIntSse2(__m128 value, const __m128 scale, const __m128 minValue, const __m128 maxValue, const int flags, __m128i &ditherState)
+{
+    __m128 x = _mm_mul_ps(value, scale);
+
+    if ((flags & SAMPLE_CONVERT_DITHER) != 0)
+        x = _mm_add_ps(x, getDitherNoiseSse2(ditherState));
+
+    // (cvtps2dq doesn't saturate, out of range values become INT32_MIN)
+    x = _mm_min_ps(_mm_max_ps(x, minValue), maxValue);
+
+    return _mm_cvtps_epi32(x);
+}
+
+SIMD_TARGET_AVX2 inline __m256i convertFloatToIntAvx2(__m256 value, const __m256 scale, const __m256 minValue, const __m256 maxValue, const int flags, __m256i &ditherState)
+{
+    __m256 x = _mm256_mul_ps(value, scale);
+
+    if ((flags & SAMPLE_CONVERT_DITHER) != 0)
+        x = _mm256_add_ps(x, getDitherNoiseAvx2(ditherState));
+
+    x = _mm256_min_ps(_mm256_max_ps(x, minValue), maxValue);
+
+    return _mm256_cvtps_epi32(x);
+}
+
+//
+// s16
+//
+
+SIMD_TARGET_SSE2 inline size_t convertS16ToFloatSse2(float *pTarget, const int16_t *pSource, const size_t numSamples)
+{
+    const __m128 scale = _mm_set1_ps(1.0f / SAMPLE_SCALE_S16);
+
+    size_t x = 0;
+
+    for (; (x + 8) <= numSamples; x += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (pSource + x));
+
+        // sign extend to 32 bits
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps((pTarget + x), _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps((pTarget + x + 4), _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+
+    return x;
+}
+
+SIMD_TARGET_AVX2 inline size_t convertS16ToFloatAvx2(float *pTarget, const int16_t *pSource, const size_t numSamples)
+{
+    const __m256 scale = _mm256_set1_ps(1.0f / SAMPLE_SCALE_S16);
+
+    size_t x = 0;
+
+    for (; (x + 16) <= numSamples; x += 16)
+    {
+        __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (pSource + x)));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (pSource + x + 8)));
+
+        _mm256_storeu_ps((pTarget + x), _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps((pTarget + x + 8), _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+
+    return x;
+}
+
+SIMD_TARGET_SSE2 inline size_t convertFloatToS16Sse2(int16_t *pTarget, const float *pSource, const size_t numSamples, const int flags)
+{
+    const __m128 scale    = _mm_set1_ps(SAMPLE_SCALE_S16);
+    const __m128 minValue = _mm_set1_ps(SAMPLE_MIN_S16);
+    const __m128 maxValue = _mm_set1_ps(SAMPLE_MAX_S16);
+
+    SDitherState &dither = getDitherState();
+    __m128i ditherState = _mm_loadu_si128((const __m128i *) dither.lane);
+
+    size_t x = 0;
+
+    for (; (x + 8) <= numSamples; x += 8)
+    {
+        __m128i lo = convertFloatToIntSse2(_mm_loadu_ps(pSource + x), scale, minValue, maxValue, flags, ditherState);
+        __m128i hi = convertFloatToIntSse2(_mm_loadu_ps(pSource + x + 4), scale, minValue, maxValue, flags, ditherState);
+
+        _mm_storeu_si128((__m128i *) (pTarget + x), _mm_packs_epi32(lo, hi));
+    }
+
+    _mm_storeu_si128((__m128i *) dither.lane, ditherState);
+
+    return x;
+}
+
+SIMD_TARGET_AVX2 inline size_t convertFloatToS16Avx2(int16_t *pTarget, const float *pSource, const size_t numSamples, const int flags)
+{
+    const __m256 scale    = _mm256_set1_ps(SAMPLE_SCALE_S16);
+    const __m256 minValue = _mm256_set1_ps(SAMPLE_MIN_S16);
+    const __m256 maxValue = _mm256_set1_ps(SAMPLE_MAX_S16);
+
+    SDitherState &dither = getDitherState();
+    __m256i ditherState = _mm256_loadu_si256((const __m256i *) dither.lane);
+
+    size_t x = 0;
+
+    for (; (x + 16) <= numSamples; x += 16)
+    {
+        __m256i lo = convertFloatToIntAvx2(_mm256_loadu_ps(pSource + x), scale, minValue, maxValue, flags, ditherState);
+        __m256i hi = convertFloatToIntAvx2(_mm256_loadu_ps(pSource + x + 8), scale, minValue, maxValue, flags, ditherState);
+
+        // packs works per 128 bit lane, so put the 64 bit blocks back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm256_storeu_si256((__m256i *) (pTarget + x), packed);
+    }
+
+    _mm256_storeu_si256((__m256i *) dither.lane, ditherState);
+
+    return x;
+}
+
+//
+// s32
+//
+
+SIMD_TARGET_SSE2 inline size_t convertS32ToFloatSse2(float *pTarget, const int32_t *pSource, const size_t numSamples)
+{
+    const __m128 scale = _mm_set1_ps(1.0f / SAMPLE_SCALE_S32);
+
+    size_t x = 0;
+
+    for (; (x + 4) <= numSamples; x += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *) (pSource + x));
+
+        _mm_storeu_ps((pTarget + x), _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+
+    return x;
+}
+
+SIMD_TARGET_AVX2 inline size_t convertS32ToFloatAvx2(float *pTarget, const int32_t *pSource, const size_t numSamples)
+{
+    const __m256 scale = _mm256_set1_ps(1.0f / SAMPLE_SCALE_S32);
+
+    size_t x = 0;
+
+    for (; (x + 8) <= numSamples; x += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (pSource + x));
+
+        _mm256_storeu_ps((pTarget + x), _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+
+    return x;
+}
+
+SIMD_TARGET_SSE2 inline size_t convertFloatToS32Sse2(int32_t *pTarget, const float *pSource, const size_t numSamples, const int flags)
+{
+    const __m128 scale    = _mm_set1_ps(SAMPLE_SCALE_S32);
+    const __m128 minValue = _mm_set1_ps(SAMPLE_MIN_S32);
+    const __m128 maxValue = _mm_set1_ps(SAMPLE_MAX_S32);
+
+    SDitherState &dither = getDitherState();
+    __m128i ditherState = _mm_loadu_si128((const __m128i *) dither.lane);
+
+    size_t x = 0;
+
+    for (; (x + 4) <= numSamples; x += 4)
+    {
+        __m128i v = convertFloatToIntSse2(_mm_loadu_ps(pSource + x), scale, minValue, maxValue, flags, ditherState);
+
+        _mm_storeu_si128((__m128i *) (pTarget + x), v);
+    }
+
+    _mm_storeu_si128((__m128i *) dither.lane, ditherState);
+
+    return x;
+}
+
+SIMD_TARGET_AVX2 inline size_t convertFloatToS32Avx2(int32_t *pTarget, const float *pSource, const size_t numSamples, const int flags)
+{
+    const __m256 scale    = _mm256_set1_ps(SAMPLE_SCALE_S32);
+    const __m256 minValue = _mm256_set1_ps(SAMPLE_MIN_S32);
+    const __m256 maxValue = _mm256_set1_ps(SAMPLE_MAX_S32);
+
+    SDitherState &dither = getDitherState();
+    __m256i ditherState = _mm256_loadu_si256((const __m256i *) dither.lane);
+
+    size_t x = 0;
+
+    for (; (x + 8) <= numSamples; x += 8)
+    {
+        __m256i v = convertFloatToIntAvx2(_mm256_loadu_ps(pSource + x), scale, minValue, maxValue, flags, ditherState);
+
+        _mm256_storeu_si256((__m256i *) (pTarget + x), v);
+    }
+
+    _mm256_storeu_si256((__m256i *) dither.lane, ditherState);
+
+    return x;
+}
+
+//
+// s24 (packed) - byte shuffles need AVX2 (pshufb)
+//
+
+SIMD_TARGET_AVX2 inline size_t convertS24ToFloatAvx2(float *pTarget, const uint8_t *pSource, const size_t numSamples)
+{
+    const __m256 scale = _mm256_set1_ps(1.0f / SAMPLE_SCALE_S24);
+
+    // move each 3 byte sample into the top 3 bytes of a 32 bit lane
+    const __m256i shuffle = _mm256_setr_epi8
+        (
+            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11
+        );
+
+    size_t x = 0;
+
+    // each iteration loads 28 bytes (4 more than the 8 samples it
+    // converts), so stop while there are still 2 samples left over
+    for (; (x + 10) <= numSamples; x += 8)
+    {
+        const uint8_t *pBytes = (pSource + (x * 3));
+
+        __m256i v = _mm256_inserti128_si256
+            (
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) pBytes)),
+                _mm_loadu_si128((const __m128i *) (pBytes + 12)),
+                1
+            );
+
+        // shift back down, sign extending
+        v = _mm256_srai_epi32(_mm256_shuffle_epi8(v, shuffle), 8);
+
+        _mm256_storeu_ps((pTarget + x), _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+
+    return x;
+}
+
+SIMD_TARGET_AVX2 inline size_t convertFloatToS24Avx2(uint8_t *pTarget, const float *pSource, const size_t numSamples, const int flags)
+{
+    const __m256 scale    = _mm256_set1_ps(SAMPLE_SCALE_S24);
+    const __m256 minValue = _mm256_set1_ps(SAMPLE_MIN_S24);
+    const __m256 maxValue = _mm256_set1_ps(SAMPLE_MAX_S24);
+
+    // pack the low 3 bytes of each 32 bit lane into 12 bytes
+    const __m256i shuffle = _mm256_setr_epi8
+        (
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+        );
+
+    SDitherState &dither = getDitherState();
+    __m256i ditherState = _mm256_loadu_si256((const __m256i *) dither.lane);
+
+    size_t x = 0;
+
+    // each iteration stores 28 bytes (4 more than the 8 samples it
+    // converts), so stop while there are still 2 samples left over
+    // (which overwrite the extra bytes)
+    for (; (x + 10) <= numSamples; x += 8)
+    {
+        __m256i v = convertFloatToIntAvx2(_mm256_loadu_ps(pSource + x), scale, minValue, maxValue, flags, ditherState);
+
+        v = _mm256_shuffle_epi8(v, shuffle);
+
+        uint8_t *pBytes = (pTarget + (x * 3));
+
+        _mm_storeu_si128((__m128i *) pBytes, _mm256_castsi256_si128(v));
+        _mm_storeu_si128((__m128i *) (pBytes + 12), _mm256_extracti128_si256(v, 1));
+    }
+
+    _mm256_storeu_si256((__m256i *) dither.lane, ditherState);
+
+    return x;
+}
+
+//
+// f64
+//
+
+SIMD_TARGET_SSE2 inline size_t convertDoubleToFloatSse2(float *pTarget, const double *pSource, const size_t numSamples)
+{
+    size_t x = 0;
+
+    for (; (x + 4) <= numSamples; x += 4)
+    {
+        __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(pSource + x));
+        __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(pSource + x + 2));
+
+        _mm_storeu_ps((pTarget + x), _mm_movelh_ps(lo, hi));
+    }
+
+    return x;
+}
+
+SIMD_TARGET_SSE2 inline size_t convertFloatToDoubleSse2(double *pTarget, const float *pSource, const size_t numSamples)
+{
+    size_t x = 0;
+
+    for (; (x + 4) <= numSamples; x += 4)
+    {
+        __m128 v = _mm_loadu_ps(pSource + x);
+
+        _mm_storeu_pd((pTarget + x), _mm_cvtps_pd(v));
+        _mm_storeu_pd((pTarget + x + 2), _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+
+    return x;
+}
+
+#endif // SIMD_X86
+
+
+#ifdef SIMD_NEON
+
+// NOTE: Dithered conversions use the scalar code on ARM.
+
+inline size_t convertS16ToFloatNeon(float *pTarget, const int16_t *pSource, const size_t numSamples)
+{
+    size_t x = 0;
+
+    for (; (x + 8) <= numSamples; x += 8)
+    {
+        int16x8_t v = vld1q_s16(pSource + x);
+
+        vst1q_f32((pTarget + x), vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), (1.0f / SAMPLE_SCALE_S16)));
+        vst1q_f32((pTarget + x + 4), vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), (1.0f / SAMPLE_SCALE_S16)));
+    }
+
+    return x;
+}
+
+inline size_t convertFloatToS16Neon(int16_t *pTarget, const float *pSource, const size_t numSamples, const int flags)
+{
+    if ((flags & SAMPLE_CONVERT_DITHER) != 0)
+        return 0;
+
+    size_t x = 0;
+
+    // (the narrowing saturates, so out of range values are always clipped)
+    for (; (x + 8) <= numSamples; x += 8)
+    {
+        int32x4_t lo = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(pSource + x), SAMPLE_SCALE_S16));
+        int32x4_t hi = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(pSource + x + 4), SAMPLE_SCALE_S16));
+
+        vst1q_s16((pTarget + x), vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+
+    return x;
+}
+
+inline size_t convertS32ToFloatNeon(float *pTarget, const int32_t *pSource, const size_t numSamples)
+{
+    size_t x = 0;
+
+    for (; (x + 4) <= numSamples; x += 4)
+    {
+        vst1q_f32((pTarget + x), vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(pSource + x)), (1.0f / SAMPLE_SCALE_S32)));
+    }
+
+    return x;
+}
+
+inline size_t convertFloatToS32Neon(int32_t *pTarget, const float *pSource, const size_t numSamples, const int flags)
+{
+    if ((flags & SAMPLE_CONVERT_DITHER) != 0)
+        return 0;
+
+    const float32x4_t minValue = vdupq_n_f32(SAMPLE_MIN_S32);
+    const float32x4_t maxValue = vdupq_n_f32(SAMPLE_MAX_S32);
+
+    size_t x = 0;
+
+    // (clamped to the same range as the scalar / x86 code - the conversion
+    // alone would saturate +1.0 to 2147483647, not SAMPLE_MAX_S32)
+    for (; (x + 4) <= numSamples; x += 4)
+    {
+        float32x4_t value = vmulq_n_f32(vld1q_f32(pSource + x), SAMPLE_SCALE_S32);
+
+        value = vminq_f32(vmaxq_f32(value, minValue), maxValue);
+
+        vst1q_s32((pTarget + x), vcvtnq_s32_f32(value));
+    }
+
+    return x;
+}
+
+#endif // SIMD_NEON
+
+
+// Convert 16 bit integer samples to float (-1.0 to 1.0)
+inline void convertS16ToFloat(float *pTarget, const int16_t *pSource, const size_t numSamples)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return;
+
+    size_t x = 0;
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+#if defined(SIMD_X86)
+    if (cpu.bAvx2)
+        x = convertS16ToFloatAvx2(pTarget, pSource, numSamples);
+    else if (cpu.bSse2)
+        x = convertS16ToFloatSse2(pTarget, pSource, numSamples);
+#elif defined(SIMD_NEON)
+    if (cpu.bNeon)
+        x = convertS16ToFloatNeon(pTarget, pSource, numSamples);
+#endif
+
+    for (; x < numSamples; x++)
+        pTarget[x] = ((float) pSource[x] * (1.0f / SAMPLE_SCALE_S16));
+
+    (void) cpu;
+}
+
+// Convert float samples (-1.0 to 1.0) to 16 bit integers
+inline void convertFloatToS16(int16_t *pTarget, const float *pSource, const size_t numSamples, const int flags = SAMPLE_CONVERT_CLIP)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return;
+
+    size_t x = 0;
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+#if defined(SIMD_X86)
+    if (cpu.bAvx2)
+        x = convertFloatToS16Avx2(pTarget, pSource, numSamples, flags);
+    else if (cpu.bSse2)
+        x = convertFloatToS16Sse2(pTarget, pSource, numSamples, flags);
+#elif defined(SIMD_NEON)
+    if (cpu.bNeon)
+        x = convertFloatToS16Neon(pTarget, pSource, numSamples, flags);
+#endif
+
+    uint32_t &ditherState = getDitherState().lane[0];
+
+    for (; x < numSamples; x++)
+        pTarget[x] = (int16_t) convertFloatToInt(pSource[x], SAMPLE_SCALE_S16, SAMPLE_MIN_S16, SAMPLE_MAX_S16, flags, ditherState);
+
+    (void) cpu;
+}
+
+// Convert packed 24 bit integer samples to float (-1.0 to 1.0)
+inline void convertS24ToFloat(float *pTarget, const uint8_t *pSource, const size_t numSamples)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return;
+
+    size_t x = 0;
+
+#if defined(SIMD_X86)
+    if (getCpuFeatures().bAvx2)
+        x = convertS24ToFloatAvx2(pTarget, pSource, numSamples);
+#endif
+
+    for (; x < numSamples; x++)
+    {
+        const uint8_t *pBytes = (pSource + (x * 3));
+
+        // build the value in the top 24 bits, then shift back down (sign extending)
+        int32_t value = (int32_t) (((uint32_t) pBytes[0] << 8) | ((uint32_t) pBytes[1] << 16) | ((uint32_t) pBytes[2] << 24));
+
+        pTarget[x] = ((float) (value >> 8) * (1.0f / SAMPLE_SCALE_S24));
+    }
+}
+
+// Convert float samples (-1.0 to 1.0) to packed 24 bit integers
+inline void convertFloatToS24(uint8_t *pTarget, const float *pSource, const size_t numSamples, const int flags = SAMPLE_CONVERT_CLIP)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return;
+
+    size_t x = 0;
+
+#if defined(SIMD_X86)
+    if (getCpuFeatures().bAvx2)
+        x = convertFloatToS24Avx2(pTarget, pSource, numSamples, flags);
+#endif
+
+    uint32_t &ditherState = getDitherState().lane[0];
+
+    for (; x < numSamples; x++)
+    {
+        int32_t value = convertFloatToInt(pSource[x], SAMPLE_SCALE_S24, SAMPLE_MIN_S24, SAMPLE_MAX_S24, flags, ditherState);
+
+        uint8_t *pBytes = (pTarget + (x * 3));
+
+        pBytes[0] = (uint8_t) (value & 0xFF);
+        pBytes[1] = (uint8_t) ((value >> 8) & 0xFF);
+        pBytes[2] = (uint8_t) ((value >> 16) & 0xFF);
+    }
+}
+
+// Convert 32 bit integer samples to float (-1.0 to 1.0)
+inline void convertS32ToFloat(float *pTarget, const int32_t *pSource, const size_t numSamples)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return;
+
+    size_t x = 0;
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+#if defined(SIMD_X86)
+    if (cpu.bAvx2)
+        x = convertS32ToFloatAvx2(pTarget, pSource, numSamples);
+    else if (cpu.bSse2)
+        x = convertS32ToFloatSse2(pTarget, pSource, numSamples);
+#elif defined(SIMD_NEON)
+    if (cpu.bNeon)
+        x = convertS32ToFloatNeon(pTarget, pSource, numSamples);
+#endif
+
+    for (; x < numSamples; x++)
+        pTarget[x] = ((float) pSource[x] * (1.0f / SAMPLE_SCALE_S32));
+
+    (void) cpu;
+}
+
+// Convert float samples (-1.0 to 1.0) to 32 bit integers
+// NOTE: A float only has 24 bits of precision.
+inline void convertFloatToS32(int32_t *pTarget, const float *pSource, const size_t numSamples, const int flags = SAMPLE_CONVERT_CLIP)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return;
+
+    size_t x = 0;
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+#if defined(SIMD_X86)
+    if (cpu.bAvx2)
+        x = convertFloatToS32Avx2(pTarget, pSource, numSamples, flags);
+    else if (cpu.bSse2)
+        x = convertFloatToS32Sse2(pTarget, pSource, numSamples, flags);
+#elif defined(SIMD_NEON)
+    if (cpu.bNeon)
+        x = convertFloatToS32Neon(pTarget, pSource, numSamples, flags);
+#endif
+
+    uint32_t &ditherState = getDitherState().lane[0];
+
+    for (; x < numSamples; x++)
+        pTarget[x] = convertFloatToInt(pSource[x], SAMPLE_SCALE_S32, SAMPLE_MIN_S32, SAMPLE_MAX_S32, flags, ditherState);
+
+    (void) cpu;
+}
+
+// Convert double samples to float
+inline void convertDoubleToFloat(float *pTarget, const double *pSource, const size_t numSamples)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return;
+
+    size_t x = 0;
+
+#if defined(SIMD_X86)
+    if (getCpuFeatures().bSse2)
+        x = convertDoubleToFloatSse2(pTarget, pSource, numSamples);
+#endif
+
+    for (; x < numSamples; x++)
+        pTarget[x] = (float) pSource[x];
+}
+
+// Convert float samples to double
+inline void convertFloatToDouble(double *pTarget, const float *pSource, const size_t numSamples)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return;
+
+    size_t x = 0;
+
+#if defined(SIMD_X86)
+    if (getCpuFeatures().bSse2)
+        x = convertFloatToDoubleSse2(pTarget, pSource, numSamples);
+#endif
+
+    for (; x < numSamples; x++)
+        pTarget[x] = (double) pSource[x];
+}
+
+// Convert samples of any integer / f64 format to double (-1.0 to 1.0)
+inline bool convertToDouble(double *pTarget, const void *pSource, const eSampleFormat_def sourceFormat, const size_t numSamples)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return false;
+
+    switch (sourceFormat)
+    {
+        case eSampleFormat_s16:
+            {
+                auto pSrc = (const int16_t *) pSource;
+
+                for (size_t x = 0; x < numSamples; x++)
+                    pTarget[x] = ((double) pSrc[x] * (1.0 / (double) SAMPLE_SCALE_S16));
+            }
+            return true;
+
+        case eSampleFormat_s24:
+            {
+                auto pSrc = (const uint8_t *) pSource;
+
+                for (size_t x = 0; x < numSamples; x++, pSrc += 3)
+                {
+                    int32_t value = (int32_t) (((uint32_t) pSrc[0] << 8) | ((uint32_t) pSrc[1] << 16) | ((uint32_t) pSrc[2] << 24));
+
+                    pTarget[x] = ((double) (value >> 8) * (1.0 / (double) SAMPLE_SCALE_S24));
+                }
+            }
+            return true;
+
+        case eSampleFormat_s32:
+            {
+                auto pSrc = (const int32_t *) pSource;
+
+                for (size_t x = 0; x < numSamples; x++)
+                    pTarget[x] = ((double) pSrc[x] * (1.0 / (double) SAMPLE_SCALE_S32));
+            }
+            return true;
+
+        case eSampleFormat_f64:
+            memcpy(pTarget, pSource, (numSamples * sizeof(double)));
+            return true;
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+// Convert double samples (-1.0 to 1.0) to any integer / f64 format
+inline bool convertFromDouble(void *pTarget, const eSampleFormat_def targetFormat, const double *pSource, const size_t numSamples, const int flags = SAMPLE_CONVERT_CLIP)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return false;
+
+    uint32_t &ditherState = getDitherState().lane[0];
+
+    switch (targetFormat)
+    {
+        case eSampleFormat_s16:
+            {
+                auto pTrgt = (int16_t *) pTarget;
+
+                for (size_t x = 0; x < numSamples; x++)
+                    pTrgt[x] = (int16_t) convertDoubleToInt(pSource[x], SAMPLE_SCALE_S16, SAMPLE_MIN_S16, SAMPLE_MAX_S16, flags, ditherState);
+            }
+            return true;
+
+        case eSampleFormat_s24:
+            {
+                auto pTrgt = (uint8_t *) pTarget;
+
+                for (size_t x = 0; x < numSamples; x++, pTrgt += 3)
+                {
+                    int32_t value = convertDoubleToInt(pSource[x], SAMPLE_SCALE_S24, SAMPLE_MIN_S24, SAMPLE_MAX_S24, flags, ditherState);
+
+                    pTrgt[0] = (uint8_t) (value & 0xFF);
+                    pTrgt[1] = (uint8_t) ((value >> 8) & 0xFF);
+                    pTrgt[2] = (uint8_t) ((value >> 16) & 0xFF);
+                }
+            }
+            return true;
+
+        case eSampleFormat_s32:
+            {
+                auto pTrgt = (int32_t *) pTarget;
+
+                for (size_t x = 0; x < numSamples; x++)
+                    pTrgt[x] = convertDoubleToInt(pSource[x], SAMPLE_SCALE_S32, SAMPLE_MIN_S32, SAMPLE_MAX_S32_F64, flags, ditherState);
+            }
+            return true;
+
+        case eSampleFormat_f64:
+            memcpy(pTarget, pSource, (numSamples * sizeof(double)));
+            return true;
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+// Convert integer samples to left aligned 32 bit integers (s16 << 16, s24 << 8)
+inline bool convertToInt32(int32_t *pTarget, const void *pSource, const eSampleFormat_def sourceFormat, const size_t numSamples)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return false;
+
+    switch (sourceFormat)
+    {
+        case eSampleFormat_s16:
+            {
+                auto pSrc = (const int16_t *) pSource;
+
+                for (size_t x = 0; x < numSamples; x++)
+                    pTarget[x] = (int32_t) ((uint32_t) pSrc[x] << 16);
+            }
+            return true;
+
+        case eSampleFormat_s24:
+            {
+                auto pSrc = (const uint8_t *) pSource;
+
+                for (size_t x = 0; x < numSamples; x++, pSrc += 3)
+                    pTarget[x] = (int32_t) (((uint32_t) pSrc[0] << 8) | ((uint32_t) pSrc[1] << 16) | ((uint32_t) pSrc[2] << 24));
+            }
+            return true;
+
+        case eSampleFormat_s32:
+            memcpy(pTarget, pSource, (numSamples * sizeof(int32_t)));
+            return true;
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+// Convert left aligned 32 bit integers to any integer format (rounded, (dithered) and saturated)
+inline bool convertFromInt32(void *pTarget, const eSampleFormat_def targetFormat, const int32_t *pSource, const size_t numSamples, const int flags = SAMPLE_CONVERT_CLIP)
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return false;
+
+    uint32_t &ditherState = getDitherState().lane[0];
+
+    switch (targetFormat)
+    {
+        case eSampleFormat_s16:
+            {
+                auto pTrgt = (int16_t *) pTarget;
+
+                for (size_t x = 0; x < numSamples; x++)
+                    pTrgt[x] = (int16_t) convertDoubleToInt((double) pSource[x], (1.0 / 65536.0), SAMPLE_MIN_S16, SAMPLE_MAX_S16, flags, ditherState);
+            }
+            return true;
+
+        case eSampleFormat_s24:
+            {
+                auto pTrgt = (uint8_t *) pTarget;
+
+                for (size_t x = 0; x < numSamples; x++, pTrgt += 3)
+                {
+                    int32_t value = convertDoubleToInt((double) pSource[x], (1.0 / 256.0), SAMPLE_MIN_S24, SAMPLE_MAX_S24, flags, ditherState);
+
+                    pTrgt[0] = (uint8_t) (value & 0xFF);
+                    pTrgt[1] = (uint8_t) ((value >> 8) & 0xFF);
+                    pTrgt[2] = (uint8_t) ((value >> 16) & 0xFF);
+                }
+            }
+            return true;
+
+        case eSampleFormat_s32:
+            memcpy(pTarget, pSource, (numSamples * sizeof(int32_t)));
+            return true;
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+// Convert float samples to any sample format
+inline bool convertFromFloat(void *pTarget, const eSampleFormat_def targetFormat, const float *pSource, const size_t numSamples, const int flags = SAMPLE_CONVERT_CLIP)
+{
+    switch (targetFormat)
+    {
+        case eSampleFormat_s16: convertFloatToS16((int16_t *) pTarget, pSource, numSamples, flags); return true;
+        case eSampleFormat_s24: convertFloatToS24((uint8_t *) pTarget, pSource, numSamples, flags); return true;
+        case eSampleFormat_s32: convertFloatToS32((int32_t *) pTarget, pSource, numSamples, flags); return true;
+        case eSampleFormat_f32: memcpy(pTarget, pSource, (numSamples * sizeof(float))); return true;
+        case eSampleFormat_f64: convertFloatToDouble((double *) pTarget, pSource, numSamples); return true;
+        default: break;
+    }
+
+    return false;
+}
+
+// Convert samples of any sample format to float
+inline bool convertToFloat(float *pTarget, const void *pSource, const eSampleFormat_def sourceFormat, const size_t numSamples)
+{
+    switch (sourceFormat)
+    {
+        case eSampleFormat_s16: convertS16ToFloat(pTarget, (const int16_t *) pSource, numSamples); return true;
+        case eSampleFormat_s24: convertS24ToFloat(pTarget, (const uint8_t *) pSource, numSamples); return true;
+        case eSampleFormat_s32: convertS32ToFloat(pTarget, (const int32_t *) pSource, numSamples); return true;
+        case eSampleFormat_f32: memcpy(pTarget, pSource, (numSamples * sizeof(float))); return true;
+        case eSampleFormat_f64: convertDoubleToFloat(pTarget, (const double *) pSource, numSamples); return true;
+        default: break;
+    }
+
+    return false;
+}
+
+// Convert samples between any two sample formats.
+// Integer <-> integer conversions go through a (small) left aligned int32
+// scratch buffer, integer <-> f64 conversions are done in double precision.
+// Returns false if either format is unknown.
+inline bool convertSamples
+    (
+        void *pTarget,
+        const eSampleFormat_def targetFormat,
+        const void *pSource,
+        const eSampleFormat_def sourceFormat,
+        const size_t numSamples,
+        const int flags = SAMPLE_CONVERT_CLIP
+    )
+{
+    if (pTarget == nullptr || pSource == nullptr)
+        return false;
+
+    if (getSampleSize(targetFormat) < 1 || getSampleSize(sourceFormat) < 1)
+        return false;
+
+    if (targetFormat == sourceFormat)
+    {
+        memcpy(pTarget, pSource, (numSamples * getSampleSize(sourceFormat)));
+        return true;
+    }
+
+    if (sourceFormat == eSampleFormat_f32)
+        return convertFromFloat(pTarget, targetFormat, (const float *) pSource, numSamples, flags);
+
+    if (targetFormat == eSampleFormat_f32)
+        return convertToFloat((float *) pTarget, pSource, sourceFormat, numSamples);
+
+    if (sourceFormat == eSampleFormat_f64)
+        return convertFromDouble(pTarget, targetFormat, (const double *) pSource, numSamples, flags);
+
+    if (targetFormat == eSampleFormat_f64)
+        return convertToDouble((double *) pTarget, pSource, sourceFormat, numSamples);
+
+    // integer <-> integer
+    const size_t chunkSize = 1024;
+
+    int32_t scratch[chunkSize];
+
+    for (size_t x = 0; x < numSamples; x += chunkSize)
+    {
+        size_t numToConvert = std::min(chunkSize, (numSamples - x));
+
+        convertToInt32(scratch, ((const uint8_t *) pSource + (x * getSampleSize(sourceFormat))), sourceFormat, numToConvert);
+
+        convertFromInt32(((uint8_t *) pTarget + (x * getSampleSize(targetFormat))), targetFormat, scratch, numToConvert, flags);
+    }
+
+    return true;
+}
+
+
+#endif // _SAMPLE_CONVERT_H_
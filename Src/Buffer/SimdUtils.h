@@ -0,0 +1,126 @@
+//****************************************************************************
+// FILE:    SimdUtils.h
+//
+// DESC:    Run-time CPU (SIMD) feature detection, and the macros
+//          used to build SIMD kernels without global compiler flags.
+//
+//          Kernels for instruction sets above the build baseline are
+//          compiled with SIMD_TARGET_xxx (a per-function target), and
+//          must only be called when getCpuFeatures() reports support.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _SIMD_UTILS_H_
+#define _SIMD_UTILS_H_
+
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON
+#endif
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+
+// Per-function instruction set targets
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET_SSE2        __attribute__((target("sse2")))
+#define SIMD_TARGET_SSE41       __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2        __attribute__((target("avx2")))
+#define SIMD_TARGET_AVX2_FMA    __attribute__((target("avx2,fma")))
+#else
+#define SIMD_TARGET_SSE2
+#define SIMD_TARGET_SSE41
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX2_FMA
+#endif
+
+
+// Supported SIMD instruction sets
+struct SCpuFeatures
+{
+    bool        bSse2   = false;
+    bool        bSse41  = false;
+    bool        bAvx2   = false;
+    bool        bFma    = false;
+    bool        bNeon   = false;
+};
+
+
+// Set this (ie: from a test or a config file) to force
+// the scalar code paths, regardless of the CPU.
+inline bool &simdDisabled()
+{
+    static bool bDisabled = false;
+
+    return bDisabled;
+}
+
+// Detect the SIMD instruction sets supported by this CPU (and OS).
+// The result is cached on the 1st call.
+inline const SCpuFeatures &getCpuFeatures()
+{
+    static const SCpuFeatures features = []
+    {
+        SCpuFeatures cpu;
+
+#if defined(SIMD_X86) && defined(_MSC_VER)
+        int info[4] = { 0 };
+
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        cpu.bSse2  = ((info[3] & (1 << 26)) != 0);
+        cpu.bSse41 = ((info[2] & (1 << 19)) != 0);
+
+        bool bOsAvx = false;
+        if ((info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0)
+        {
+            // OS saves the YMM registers
+            bOsAvx = ((_xgetbv(0) & 0x6) == 0x6);
+        }
+
+        cpu.bFma = (bOsAvx && (info[2] & (1 << 12)) != 0);
+
+        if (maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            cpu.bAvx2 = (bOsAvx && (info[1] & (1 << 5)) != 0);
+        }
+#elif defined(SIMD_X86)
+        __builtin_cpu_init();
+
+        cpu.bSse2  = (__builtin_cpu_supports("sse2") != 0);
+        cpu.bSse41 = (__builtin_cpu_supports("sse4.1") != 0);
+        cpu.bAvx2  = (__builtin_cpu_supports("avx2") != 0);
+        cpu.bFma   = (__builtin_cpu_supports("fma") != 0);
+#elif defined(SIMD_NEON)
+        cpu.bNeon  = true;
+#endif
+
+        return cpu;
+    }();
+
+    static const SCpuFeatures none;
+
+    if (simdDisabled() == true)
+        return none;
+
+    return features;
+}
+
+
+#endif // _SIMD_UTILS_H_
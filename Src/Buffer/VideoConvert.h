@@ -0,0 +1,1069 @@
+//****************************************************************************
+// FILE:    VideoConvert.h
+//
+// DESC:    Raw video pixel format (colour space / chroma sub-sampling)
+//          conversion, between the I420, YV12, NV12, YUY2, RGB and BGR
+//          formats of eVideoDataIoFormat_def.
+//
+//          YUV <-> RGB uses the BT.601 (limited range) matrix, in fixed
+//          point.  4:2:0 chroma is the average of each 2x2 block, and
+//          4:2:2 -> 4:2:0 averages the chroma of each pair of rows.
+//
+//          Every row kernel has a scalar (reference) version, and
+//          SSE2 / SSE4.1 / AVX2 versions that are selected at run-time
+//          and give bit exact results.  Large frames are converted in
+//          slices of rows, on the (shared) CSlicePool worker threads.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _VIDEO_CONVERT_H_
+#define _VIDEO_CONVERT_H_
+
+
+#include "../Logging/Logging.h"
+
+#include "SimdUtils.h"
+#include "VideoFrameLayout.h"
+#include "CVideoBuffer.h"
+#include "CVideoFramePool.h"
+
+#include "../Thread/CSlicePool.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+#define VIDEO_CONVERT_PARALLEL_MIN_PIXELS   (1280 * 720)    // smaller frames use 1 thread
+#define VIDEO_CONVERT_MAX_THREADS           8               // max. slices per frame (when numThreads = 0)
+
+
+inline bool isRgbVideoFormat(const unsigned long nFmt)
+{
+    return (nFmt == eVideoDataIoFormat_rgb || nFmt == eVideoDataIoFormat_bgr);
+}
+
+// Whether convertVideoFrame() supports a format
+inline bool isConvertibleVideoFormat(const unsigned long nFmt)
+{
+    return (isRgbVideoFormat(nFmt) || isPlanarVideoFormat(nFmt) || nFmt == eVideoDataIoFormat_yuy2);
+}
+
+
+//
+// Fixed point BT.601 (limited range) colour conversion
+//
+
+inline uint8_t clampPixel(const int value)
+{
+    return (uint8_t) ((value < 0) ? 0 : ((value > 255) ? 255 : value));
+}
+
+inline uint8_t rgbToY(const int r, const int g, const int b)
+{
+    return (uint8_t) ((((66 * r) + (129 * g) + (25 * b) + 128) >> 8) + 16);
+}
+
+inline uint8_t rgbToU(const int r, const int g, const int b)
+{
+    return (uint8_t) ((((112 * b) + 128 - (38 * r) - (74 * g)) >> 8) + 128);
+}
+
+inline uint8_t rgbToV(const int r, const int g, const int b)
+{
+    return (uint8_t) ((((112 * r) + 128 - (94 * g) - (18 * b)) >> 8) + 128);
+}
+
+inline void yuvToRgb(const int y, const int u, const int v, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    int c = (((y - 16) * 74) + 32);
+    int d = (u - 128);
+    int e = (v - 128);
+
+    r = clampPixel((c + (102 * e)) >> 6);
+    g = clampPixel((c - (25 * d) - (52 * e)) >> 6);
+    b = clampPixel((c + (129 * d)) >> 6);
+}
+
+
+//
+// Scalar row kernels (from pixel / sample "start" to the end of the row)
+//
+
+// YUV (4:2:x chroma, 1 U / V sample per 2 pixels) to RGB (or BGR)
+inline void yuvToRgbPixels(uint8_t *pRgb, const uint8_t *pY, const uint8_t *pU, const uint8_t *pV, const size_t start, const size_t width, const bool bBgr)
+{
+    const int ri = (bBgr ? 2 : 0);
+    const int bi = (bBgr ? 0 : 2);
+
+    for (size_t x = start; x < width; x++)
+    {
+        uint8_t *pPixel = (pRgb + (x * 3));
+
+        yuvToRgb(pY[x], pU[x / 2], pV[x / 2], pPixel[ri], pPixel[1], pPixel[bi]);
+    }
+}
+
+// 2 rows of RGB (or BGR) to 2 rows of Y, and 1 row of U and V
+// ("start" must be even).  For a single row use pRgb1 = pRgb0.
+inline void rgbToYuvPixels
+    (
+        uint8_t *pY0,
+        uint8_t *pY1,
+        uint8_t *pU,
+        uint8_t *pV,
+        const uint8_t *pRgb0,
+        const uint8_t *pRgb1,
+        const size_t start,
+        const size_t width,
+        const bool bBgr
+    )
+{
+    const int ri = (bBgr ? 2 : 0);
+    const int bi = (bBgr ? 0 : 2);
+
+    for (size_t x = start; x < width; x += 2)
+    {
+        size_t x1 = ((x + 1) < width) ? (x + 1) : x;
+
+        const uint8_t *p00 = (pRgb0 + (x * 3));
+        const uint8_t *p01 = (pRgb0 + (x1 * 3));
+        const uint8_t *p10 = (pRgb1 + (x * 3));
+        const uint8_t *p11 = (pRgb1 + (x1 * 3));
+
+        pY0[x] = rgbToY(p00[ri], p00[1], p00[bi]);
+        pY0[x1] = rgbToY(p01[ri], p01[1], p01[bi]);
+        pY1[x] = rgbToY(p10[ri], p10[1], p10[bi]);
+        pY1[x1] = rgbToY(p11[ri], p11[1], p11[bi]);
+
+        int r = ((p00[ri] + p01[ri] + p10[ri] + p11[ri] + 2) >> 2);
+        int g = ((p00[1] + p01[1] + p10[1] + p11[1] + 2) >> 2);
+        int b = ((p00[bi] + p01[bi] + p10[bi] + p11[bi] + 2) >> 2);
+
+        pU[x / 2] = rgbToU(r, g, b);
+        pV[x / 2] = rgbToV(r, g, b);
+    }
+}
+
+// Separate U and V rows to an (NV12) UV row
+inline void interleaveChromaPixels(uint8_t *pUV, const uint8_t *pU, const uint8_t *pV, const size_t start, const size_t numSamples)
+{
+    for (size_t idx = start; idx < numSamples; idx++)
+    {
+        pUV[(idx * 2)] = pU[idx];
+        pUV[(idx * 2) + 1] = pV[idx];
+    }
+}
+
+// An (NV12) UV row to separate U and V rows
+inline void deinterleaveChromaPixels(uint8_t *pU, uint8_t *pV, const uint8_t *pUV, const size_t start, const size_t numSamples)
+{
+    for (size_t idx = start; idx < numSamples; idx++)
+    {
+        pU[idx] = pUV[(idx * 2)];
+        pV[idx] = pUV[(idx * 2) + 1];
+    }
+}
+
+// A YUY2 row to Y, U and V rows ("start" must be even)
+inline void unpackYuy2Pixels(uint8_t *pY, uint8_t *pU, uint8_t *pV, const uint8_t *pYuy2, const size_t start, const size_t width)
+{
+    for (size_t x = start; (x + 1) < width; x += 2)
+    {
+        const uint8_t *pPair = (pYuy2 + (x * 2));
+
+        pY[x] = pPair[0];
+        pU[x / 2] = pPair[1];
+        pY[x + 1] = pPair[2];
+        pV[x / 2] = pPair[3];
+    }
+}
+
+// Y, U and V rows to a YUY2 row ("start" must be even)
+inline void packYuy2Pixels(uint8_t *pYuy2, const uint8_t *pY, const uint8_t *pU, const uint8_t *pV, const size_t start, const size_t width)
+{
+    for (size_t x = start; (x + 1) < width; x += 2)
+    {
+        uint8_t *pPair = (pYuy2 + (x * 2));
+
+        pPair[0] = pY[x];
+        pPair[1] = pU[x / 2];
+        pPair[2] = pY[x + 1];
+        pPair[3] = pV[x / 2];
+    }
+}
+
+// Rounded average of 2 rows
+inline void averagePixels(uint8_t *pTarget, const uint8_t *pRow0, const uint8_t *pRow1, const size_t start, const size_t numSamples)
+{
+    for (size_t idx = start; idx < numSamples; idx++)
+        pTarget[idx] = (uint8_t) ((pRow0[idx] + pRow1[idx] + 1) >> 1);
+}
+
+// RGB <-> BGR
+inline void swapRgbPixels(uint8_t *pTarget, const uint8_t *pSource, const size_t start, const size_t width)
+{
+    for (size_t x = start; x < width; x++)
+    {
+        uint8_t r = pSource[(x * 3)];
+        uint8_t g = pSource[(x * 3) + 1];
+        uint8_t b = pSource[(x * 3) + 2];
+
+        pTarget[(x * 3)] = b;
+        pTarget[(x * 3) + 1] = g;
+        pTarget[(x * 3) + 2] = r;
+    }
+}
+
+
+#ifdef SIMD_X86
+
+// Each kernel returns the number of pixels (samples) it converted
+// (a multiple of its vector width) - the caller converts the rest
+// with the scalar kernel.
+
+//
+// SSE2
+//
+
+SIMD_TARGET_SSE2 inline size_t interleaveChromaSse2(uint8_t *pUV, const uint8_t *pU, const uint8_t *pV, const size_t numSamples)
+{
+    size_t idx = 0;
+
+    for (; (idx + 16) <= numSamples; idx += 16)
+    {
+        __m128i u = _mm_loadu_si128((const __m128i *) (pU + idx));
+        __m128i v = _mm_loadu_si128((const __m128i *) (pV + idx));
+
+        _mm_storeu_si128((__m128i *) (pUV + (idx * 2)), _mm_unpacklo_epi8(u, v));
+        _mm_storeu_si128((__m128i *) (pUV + (idx * 2) + 16), _mm_unpackhi_epi8(u, v));
+    }
+
+    return idx;
+}
+
+SIMD_TARGET_SSE2 inline size_t deinterleaveChromaSse2(uint8_t *pU, uint8_t *pV, const uint8_t *pUV, const size_t numSamples)
+{
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+
+    size_t idx = 0;
+
+    for (; (idx + 16) <= numSamples; idx += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *) (pUV + (idx * 2)));
+        __m128i b = _mm_loadu_si128((const __m128i *) (pUV + (idx * 2) + 16));
+
+        _mm_storeu_si128((__m128i *) (pU + idx), _mm_packus_epi16(_mm_and_si128(a, lowBytes), _mm_and_si128(b, lowBytes)));
+        _mm_storeu_si128((__m128i *) (pV + idx), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+    }
+
+    return idx;
+}
+
+SIMD_TARGET_SSE2 inline size_t unpackYuy2Sse2(uint8_t *pY, uint8_t *pU, uint8_t *pV, const uint8_t *pYuy2, const size_t width)
+{
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t x = 0;
+
+    for (; (x + 16) <= width; x += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *) (pYuy2 + (x * 2)));
+        __m128i b = _mm_loadu_si128((const __m128i *) (pYuy2 + (x * 2) + 16));
+
+        __m128i y = _mm_packus_epi16(_mm_and_si128(a, lowBytes), _mm_and_si128(b, lowBytes));
+        __m128i uv = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));      // U0 V0 U1 V1 ...
+
+        _mm_storeu_si128((__m128i *) (pY + x), y);
+        _mm_storel_epi64((__m128i *) (pU + (x / 2)), _mm_packus_epi16(_mm_and_si128(uv, lowBytes), zero));
+        _mm_storel_epi64((__m128i *) (pV + (x / 2)), _mm_packus_epi16(_mm_srli_epi16(uv, 8), zero));
+    }
+
+    return x;
+}
+
+SIMD_TARGET_SSE2 inline size_t packYuy2Sse2(uint8_t *pYuy2, const uint8_t *pY, const uint8_t *pU, const uint8_t *pV, const size_t width)
+{
+    size_t x = 0;
+
+    for (; (x + 16) <= width; x += 16)
+    {
+        __m128i y = _mm_loadu_si128((const __m128i *) (pY + x));
+        __m128i u = _mm_loadl_epi64((const __m128i *) (pU + (x / 2)));
+        __m128i v = _mm_loadl_epi64((const __m128i *) (pV + (x / 2)));
+
+        __m128i uv = _mm_unpacklo_epi8(u, v);
+
+        _mm_storeu_si128((__m128i *) (pYuy2 + (x * 2)), _mm_unpacklo_epi8(y, uv));
+        _mm_storeu_si128((__m128i *) (pYuy2 + (x * 2) + 16), _mm_unpackhi_epi8(y, uv));
+    }
+
+    return x;
+}
+
+SIMD_TARGET_SSE2 inline size_t averageRowsSse2(uint8_t *pTarget, const uint8_t *pRow0, const uint8_t *pRow1, const size_t numSamples)
+{
+    size_t idx = 0;
+
+    for (; (idx + 16) <= numSamples; idx += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *) (pRow0 + idx));
+        __m128i b = _mm_loadu_si128((const __m128i *) (pRow1 + idx));
+
+        _mm_storeu_si128((__m128i *) (pTarget + idx), _mm_avg_epu8(a, b));
+    }
+
+    return idx;
+}
+
+//
+// SSE4.1 (packed 24 bit RGB needs the SSSE3 byte shuffle)
+//
+
+// 16 pixels of 3 channels (planar) to 48 bytes of packed pixels
+SIMD_TARGET_SSE41 inline void storePacked24Sse41(uint8_t *pTarget, const __m128i c0, const __m128i c1, const __m128i c2)
+{
+    const __m128i m00 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+    const __m128i m01 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+    const __m128i m02 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i m10 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+    const __m128i m11 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+    const __m128i m12 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+    const __m128i m20 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+    const __m128i m21 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+    const __m128i m22 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+    __m128i out0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m00), _mm_shuffle_epi8(c1, m01)), _mm_shuffle_epi8(c2, m02));
+    __m128i out1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m10), _mm_shuffle_epi8(c1, m11)), _mm_shuffle_epi8(c2, m12));
+    __m128i out2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m20), _mm_shuffle_epi8(c1, m21)), _mm_shuffle_epi8(c2, m22));
+
+    _mm_storeu_si128((__m128i *) pTarget, out0);
+    _mm_storeu_si128((__m128i *) (pTarget + 16), out1);
+    _mm_storeu_si128((__m128i *) (pTarget + 32), out2);
+}
+
+// 48 bytes of packed pixels to 16 pixels of 3 channels (planar)
+SIMD_TARGET_SSE41 inline void loadPacked24Sse41(const uint8_t *pSource, __m128i &c0, __m128i &c1, __m128i &c2)
+{
+    const __m128i m00 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m01 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i m02 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i m10 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m11 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i m12 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i m20 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m21 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i m22 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+    __m128i in0 = _mm_loadu_si128((const __m128i *) pSource);
+    __m128i in1 = _mm_loadu_si128((const __m128i *) (pSource + 16));
+    __m128i in2 = _mm_loadu_si128((const __m128i *) (pSource + 32));
+
+    c0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in0, m00), _mm_shuffle_epi8(in1, m01)), _mm_shuffle_epi8(in2, m02));
+    c1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in0, m10), _mm_shuffle_epi8(in1, m11)), _mm_shuffle_epi8(in2, m12));
+    c2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in0, m20), _mm_shuffle_epi8(in1, m21)), _mm_shuffle_epi8(in2, m22));
+}
+
+// 8 pixels of 16 bit Y, U and V to 16 bit R, G and B (not clamped)
+SIMD_TARGET_SSE41 inline void yuvToRgb8Sse41(const __m128i y, const __m128i u, const __m128i v, __m128i &r, __m128i &g, __m128i &b)
+{
+    const __m128i k16 = _mm_set1_epi16(16);
+    const __m128i k128 = _mm_set1_epi16(128);
+
+    __m128i c = _mm_adds_epi16(_mm_mullo_epi16(_mm_sub_epi16(y, k16), _mm_set1_epi16(74)), _mm_set1_epi16(32));
+    __m128i d = _mm_sub_epi16(u, k128);
+    __m128i e = _mm_sub_epi16(v, k128);
+
+    // NOTE: Only B can saturate, and then it is clamped to 255 anyway
+    r = _mm_srai_epi16(_mm_adds_epi16(c, _mm_mullo_epi16(e, _mm_set1_epi16(102))), 6);
+    g = _mm_srai_epi16(_mm_subs_epi16(_mm_subs_epi16(c, _mm_mullo_epi16(d, _mm_set1_epi16(25))), _mm_mullo_epi16(e, _mm_set1_epi16(52))), 6);
+    b = _mm_srai_epi16(_mm_adds_epi16(c, _mm_mullo_epi16(d, _mm_set1_epi16(129))), 6);
+}
+
+SIMD_TARGET_SSE41 inline size_t yuvToRgbSse41(uint8_t *pRgb, const uint8_t *pY, const uint8_t *pU, const uint8_t *pV, const size_t width, const bool bBgr)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t x = 0;
+
+    for (; (x + 16) <= width; x += 16)
+    {
+        __m128i y = _mm_loadu_si128((const __m128i *) (pY + x));
+        __m128i u = _mm_loadl_epi64((const __m128i *) (pU + (x / 2)));
+        __m128i v = _mm_loadl_epi64((const __m128i *) (pV + (x / 2)));
+
+        // 1 chroma sample per 2 pixels
+        u = _mm_unpacklo_epi8(u, u);
+        v = _mm_unpacklo_epi8(v, v);
+
+        __m128i rLo, gLo, bLo, rHi, gHi, bHi;
+
+        yuvToRgb8Sse41(_mm_unpacklo_epi8(y, zero), _mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(v, zero), rLo, gLo, bLo);
+        yuvToRgb8Sse41(_mm_unpackhi_epi8(y, zero), _mm_unpackhi_epi8(u, zero), _mm_unpackhi_epi8(v, zero), rHi, gHi, bHi);
+
+        __m128i r = _mm_packus_epi16(rLo, rHi);
+        __m128i g = _mm_packus_epi16(gLo, gHi);
+        __m128i b = _mm_packus_epi16(bLo, bHi);
+
+        if (bBgr)
+            storePacked24Sse41((pRgb + (x * 3)), b, g, r);
+        else
+            storePacked24Sse41((pRgb + (x * 3)), r, g, b);
+    }
+
+    return x;
+}
+
+// 8 pixels of 16 bit R, G and B to 16 bit Y
+SIMD_TARGET_SSE41 inline __m128i rgbToY8Sse41(const __m128i r, const __m128i g, const __m128i b)
+{
+    // max. sum = 56228, so unsigned 16 bit does not overflow
+    __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+                                _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), _mm_set1_epi16(128)));
+
+    return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+}
+
+SIMD_TARGET_SSE41 inline size_t rgbToYuvSse41
+    (
+        uint8_t *pY0,
+        uint8_t *pY1,
+        uint8_t *pU,
+        uint8_t *pV,
+        const uint8_t *pRgb0,
+        const uint8_t *pRgb1,
+        const size_t width,
+        const bool bBgr
+    )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i k2 = _mm_set1_epi16(2);
+    const __m128i k128 = _mm_set1_epi16(128);
+
+    size_t x = 0;
+
+    for (; (x + 16) <= width; x += 16)
+    {
+        __m128i r0, g0, b0, r1, g1, b1;
+
+        if (bBgr)
+        {
+            loadPacked24Sse41((pRgb0 + (x * 3)), b0, g0, r0);
+            loadPacked24Sse41((pRgb1 + (x * 3)), b1, g1, r1);
+        }
+        else
+        {
+            loadPacked24Sse41((pRgb0 + (x * 3)), r0, g0, b0);
+            loadPacked24Sse41((pRgb1 + (x * 3)), r1, g1, b1);
+        }
+
+        __m128i r0Lo = _mm_unpacklo_epi8(r0, zero), r0Hi = _mm_unpackhi_epi8(r0, zero);
+        __m128i g0Lo = _mm_unpacklo_epi8(g0, zero), g0Hi = _mm_unpackhi_epi8(g0, zero);
+        __m128i b0Lo = _mm_unpacklo_epi8(b0, zero), b0Hi = _mm_unpackhi_epi8(b0, zero);
+        __m128i r1Lo = _mm_unpacklo_epi8(r1, zero), r1Hi = _mm_unpackhi_epi8(r1, zero);
+        __m128i g1Lo = _mm_unpacklo_epi8(g1, zero), g1Hi = _mm_unpackhi_epi8(g1, zero);
+        __m128i b1Lo = _mm_unpacklo_epi8(b1, zero), b1Hi = _mm_unpackhi_epi8(b1, zero);
+
+        _mm_storeu_si128((__m128i *) (pY0 + x), _mm_packus_epi16(rgbToY8Sse41(r0Lo, g0Lo, b0Lo), rgbToY8Sse41(r0Hi, g0Hi, b0Hi)));
+        _mm_storeu_si128((__m128i *) (pY1 + x), _mm_packus_epi16(rgbToY8Sse41(r1Lo, g1Lo, b1Lo), rgbToY8Sse41(r1Hi, g1Hi, b1Hi)));
+
+        // average of each 2x2 block
+        __m128i r = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(_mm_add_epi16(r0Lo, r1Lo), _mm_add_epi16(r0Hi, r1Hi)), k2), 2);
+        __m128i g = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(_mm_add_epi16(g0Lo, g1Lo), _mm_add_epi16(g0Hi, g1Hi)), k2), 2);
+        __m128i b = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(_mm_add_epi16(b0Lo, b1Lo), _mm_add_epi16(b0Hi, b1Hi)), k2), 2);
+
+        __m128i u = _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(112)), k128);
+        u = _mm_sub_epi16(u, _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(38)), _mm_mullo_epi16(g, _mm_set1_epi16(74))));
+        u = _mm_add_epi16(_mm_srai_epi16(u, 8), k128);
+
+        __m128i v = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(112)), k128);
+        v = _mm_sub_epi16(v, _mm_add_epi16(_mm_mullo_epi16(g, _mm_set1_epi16(94)), _mm_mullo_epi16(b, _mm_set1_epi16(18))));
+        v = _mm_add_epi16(_mm_srai_epi16(v, 8), k128);
+
+        _mm_storel_epi64((__m128i *) (pU + (x / 2)), _mm_packus_epi16(u, zero));
+        _mm_storel_epi64((__m128i *) (pV + (x / 2)), _mm_packus_epi16(v, zero));
+    }
+
+    return x;
+}
+
+SIMD_TARGET_SSE41 inline size_t swapRgbSse41(uint8_t *pTarget, const uint8_t *pSource, const size_t width)
+{
+    // swap bytes 0 and 2 of the 5 whole pixels in each 16 byte load
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+
+    size_t x = 0;
+
+    // NOTE: Each step reads / writes 16 bytes, but only converts 5 pixels (15 bytes)
+    for (; (x + 6) <= width; x += 5)
+    {
+        __m128i rgb = _mm_loadu_si128((const __m128i *) (pSource + (x * 3)));
+
+        _mm_storeu_si128((__m128i *) (pTarget + (x * 3)), _mm_shuffle_epi8(rgb, mask));
+    }
+
+    return x;
+}
+
+//
+// AVX2
+//
+
+SIMD_TARGET_AVX2 inline void yuvToRgb16Avx2(const __m256i y, const __m256i u, const __m256i v, __m256i &r, __m256i &g, __m256i &b)
+{
+    const __m256i k16 = _mm256_set1_epi16(16);
+    const __m256i k128 = _mm256_set1_epi16(128);
+
+    __m256i c = _mm256_adds_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(y, k16), _mm256_set1_epi16(74)), _mm256_set1_epi16(32));
+    __m256i d = _mm256_sub_epi16(u, k128);
+    __m256i e = _mm256_sub_epi16(v, k128);
+
+    r = _mm256_srai_epi16(_mm256_adds_epi16(c, _mm256_mullo_epi16(e, _mm256_set1_epi16(102))), 6);
+    g = _mm256_srai_epi16(_mm256_subs_epi16(_mm256_subs_epi16(c, _mm256_mullo_epi16(d, _mm256_set1_epi16(25))), _mm256_mullo_epi16(e, _mm256_set1_epi16(52))), 6);
+    b = _mm256_srai_epi16(_mm256_adds_epi16(c, _mm256_mullo_epi16(d, _mm256_set1_epi16(129))), 6);
+}
+
+SIMD_TARGET_AVX2 inline size_t yuvToRgbAvx2(uint8_t *pRgb, const uint8_t *pY, const uint8_t *pU, const uint8_t *pV, const size_t width, const bool bBgr)
+{
+    size_t x = 0;
+
+    for (; (x + 32) <= width; x += 32)
+    {
+        __m256i y = _mm256_loadu_si256((const __m256i *) (pY + x));
+        __m128i u = _mm_loadu_si128((const __m128i *) (pU + (x / 2)));
+        __m128i v = _mm_loadu_si128((const __m128i *) (pV + (x / 2)));
+
+        __m256i r0, g0, b0, r1, g1, b1;
+
+        // pixels 0 - 15 and 16 - 31 (1 chroma sample per 2 pixels)
+        yuvToRgb16Avx2(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(y)), _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u, u)), _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v, v)), r0, g0, b0);
+        yuvToRgb16Avx2(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(y, 1)), _mm256_cvtepu8_epi16(_mm_unpackhi_epi8(u, u)), _mm256_cvtepu8_epi16(_mm_unpackhi_epi8(v, v)), r1, g1, b1);
+
+        // (packus works per 128 bit lane)
+        __m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi16(r0, r1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i g = _mm256_permute4x64_epi64(_mm256_packus_epi16(g0, g1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(b0, b1), _MM_SHUFFLE(3, 1, 2, 0));
+
+        if (bBgr)
+        {
+            storePacked24Sse41((pRgb + (x * 3)), _mm256_castsi256_si128(b), _mm256_castsi256_si128(g), _mm256_castsi256_si128(r));
+            storePacked24Sse41((pRgb + (x * 3) + 48), _mm256_extracti128_si256(b, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(r, 1));
+        }
+        else
+        {
+            storePacked24Sse41((pRgb + (x * 3)), _mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b));
+            storePacked24Sse41((pRgb + (x * 3) + 48), _mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1));
+        }
+    }
+
+    return x;
+}
+
+SIMD_TARGET_AVX2 inline size_t averageRowsAvx2(uint8_t *pTarget, const uint8_t *pRow0, const uint8_t *pRow1, const size_t numSamples)
+{
+    size_t idx = 0;
+
+    for (; (idx + 32) <= numSamples; idx += 32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (pRow0 + idx));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (pRow1 + idx));
+
+        _mm256_storeu_si256((__m256i *) (pTarget + idx), _mm256_avg_epu8(a, b));
+    }
+
+    return idx;
+}
+
+#endif // SIMD_X86
+
+
+//
+// Row functions (best kernel for this CPU + scalar for the rest)
+//
+
+inline void yuvToRgbRow(uint8_t *pRgb, const uint8_t *pY, const uint8_t *pU, const uint8_t *pV, const size_t width, const bool bBgr)
+{
+    size_t x = 0;
+
+#ifdef SIMD_X86
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+    if (cpu.bAvx2)
+        x = yuvToRgbAvx2(pRgb, pY, pU, pV, width, bBgr);
+    else if (cpu.bSse41)
+        x = yuvToRgbSse41(pRgb, pY, pU, pV, width, bBgr);
+#endif
+
+    yuvToRgbPixels(pRgb, pY, pU, pV, x, width, bBgr);
+}
+
+inline void rgbToYuvRows(uint8_t *pY0, uint8_t *pY1, uint8_t *pU, uint8_t *pV, const uint8_t *pRgb0, const uint8_t *pRgb1, const size_t width, const bool bBgr)
+{
+    size_t x = 0;
+
+#ifdef SIMD_X86
+    if (getCpuFeatures().bSse41)
+        x = rgbToYuvSse41(pY0, pY1, pU, pV, pRgb0, pRgb1, width, bBgr);
+#endif
+
+    rgbToYuvPixels(pY0, pY1, pU, pV, pRgb0, pRgb1, x, width, bBgr);
+}
+
+inline void interleaveChromaRow(uint8_t *pUV, const uint8_t *pU, const uint8_t *pV, const size_t numSamples)
+{
+    size_t idx = 0;
+
+#ifdef SIMD_X86
+    if (getCpuFeatures().bSse2)
+        idx = interleaveChromaSse2(pUV, pU, pV, numSamples);
+#endif
+
+    interleaveChromaPixels(pUV, pU, pV, idx, numSamples);
+}
+
+inline void deinterleaveChromaRow(uint8_t *pU, uint8_t *pV, const uint8_t *pUV, const size_t numSamples)
+{
+    size_t idx = 0;
+
+#ifdef SIMD_X86
+    if (getCpuFeatures().bSse2)
+        idx = deinterleaveChromaSse2(pU, pV, pUV, numSamples);
+#endif
+
+    deinterleaveChromaPixels(pU, pV, pUV, idx, numSamples);
+}
+
+inline void unpackYuy2Row(uint8_t *pY, uint8_t *pU, uint8_t *pV, const uint8_t *pYuy2, const size_t width)
+{
+    size_t x = 0;
+
+#ifdef SIMD_X86
+    if (getCpuFeatures().bSse2)
+        x = unpackYuy2Sse2(pY, pU, pV, pYuy2, width);
+#endif
+
+    unpackYuy2Pixels(pY, pU, pV, pYuy2, x, width);
+}
+
+inline void packYuy2Row(uint8_t *pYuy2, const uint8_t *pY, const uint8_t *pU, const uint8_t *pV, const size_t width)
+{
+    size_t x = 0;
+
+#ifdef SIMD_X86
+    if (getCpuFeatures().bSse2)
+        x = packYuy2Sse2(pYuy2, pY, pU, pV, width);
+#endif
+
+    packYuy2Pixels(pYuy2, pY, pU, pV, x, width);
+}
+
+inline void averageRows(uint8_t *pTarget, const uint8_t *pRow0, const uint8_t *pRow1, const size_t numSamples)
+{
+    size_t idx = 0;
+
+#ifdef SIMD_X86
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+    if (cpu.bAvx2)
+        idx = averageRowsAvx2(pTarget, pRow0, pRow1, numSamples);
+    else if (cpu.bSse2)
+        idx = averageRowsSse2(pTarget, pRow0, pRow1, numSamples);
+#endif
+
+    averagePixels(pTarget, pRow0, pRow1, idx, numSamples);
+}
+
+inline void swapRgbRow(uint8_t *pTarget, const uint8_t *pSource, const size_t width)
+{
+    size_t x = 0;
+
+#ifdef SIMD_X86
+    if (getCpuFeatures().bSse41)
+        x = swapRgbSse41(pTarget, pSource, width);
+#endif
+
+    swapRgbPixels(pTarget, pSource, x, width);
+}
+
+
+//
+// Frame conversion
+//
+
+// Plane pointers / strides of 1 frame to convert
+struct SVideoConvertFrame
+{
+    uint8_t         *pPlanes[VIDEO_MAX_PLANES] = { nullptr, nullptr, nullptr };
+    size_t          strides[VIDEO_MAX_PLANES] = { 0, 0, 0 };
+
+    unsigned long   nFmt = 0;
+
+    uint8_t *getRowPtr(const unsigned int plane, const unsigned int row) const
+    {
+        return (pPlanes[plane] + (row * strides[plane]));
+    }
+
+    // Get the U and V rows of a 4:2:0 format (NV12: pV = nullptr, pU = the UV row)
+    void getChromaRowPtrs(const unsigned int chromaRow, uint8_t *&pU, uint8_t *&pV) const
+    {
+        if (nFmt == eVideoDataIoFormat_nv12)
+        {
+            pU = getRowPtr(1, chromaRow);
+            pV = nullptr;
+        }
+        else if (nFmt == eVideoDataIoFormat_yv12)
+        {
+            pU = getRowPtr(2, chromaRow);
+            pV = getRowPtr(1, chromaRow);
+        }
+        else
+        {
+            pU = getRowPtr(1, chromaRow);
+            pV = getRowPtr(2, chromaRow);
+        }
+    }
+};
+
+// Set up a SVideoConvertFrame for a frame (of a layout from getVideoFrameLayout())
+// Returns 0, or -1 = invalid param / unsupported format
+inline int makeVideoConvertFrame(SVideoConvertFrame &frame, uint8_t *pFrame, const SVideoFrameLayout &layout, const unsigned long nFmt)
+{
+    unsigned int numPlanes = 1;
+
+    if (nFmt == eVideoDataIoFormat_nv12)
+        numPlanes = 2;
+    else if (isPlanarVideoFormat(nFmt))
+        numPlanes = 3;
+
+    if (pFrame == nullptr || isConvertibleVideoFormat(nFmt) == false || layout.numPlanes != numPlanes)
+        return -1;
+
+    if (numPlanes == 1 && layout.planes[0].nBitsPerPixel != getVideoFormatBitsPerPixel(nFmt))
+        return -1;
+
+    frame.nFmt = nFmt;
+
+    for (unsigned int idx = 0; idx < numPlanes; idx++)
+    {
+        frame.pPlanes[idx] = (pFrame + layout.planes[idx].offset);
+        frame.strides[idx] = layout.planes[idx].stride;
+    }
+
+    return 0;
+}
+
+
+// Scratch rows for converting a slice of a frame
+class CVideoConvertScratch
+{
+    std::vector<uint8_t>    m_buffer;
+
+    size_t                  m_rowSize;
+
+  public:
+
+    uint8_t     *pY[2];             // (up to) 2 rows of luma / 4:2:2 chroma
+    uint8_t     *pU[2];
+    uint8_t     *pV[2];
+    uint8_t     *pU420;             // 4:2:0 chroma row
+    uint8_t     *pV420;
+
+    CVideoConvertScratch(const unsigned int width)
+    {
+        // 64 byte multiple, so every row starts aligned (relative to the 1st)
+        m_rowSize = (((width + 1) + 63) & ~((size_t) 63));
+
+        m_buffer.resize(m_rowSize * 8);
+
+        uint8_t *pRows = m_buffer.data();
+
+        pY[0] = pRows;
+        pY[1] = pRows + m_rowSize;
+        pU[0] = pRows + (m_rowSize * 2);
+        pU[1] = pRows + (m_rowSize * 3);
+        pV[0] = pRows + (m_rowSize * 4);
+        pV[1] = pRows + (m_rowSize * 5);
+        pU420 = pRows + (m_rowSize * 6);
+        pV420 = pRows + (m_rowSize * 7);
+    }
+};
+
+
+// Convert rows firstRow to (lastRow - 1) of a frame.  firstRow must be even.
+inline void convertVideoRows
+    (
+        const SVideoConvertFrame &target,
+        const SVideoConvertFrame &source,
+        const unsigned int width,
+        const unsigned int height,
+        const unsigned int firstRow,
+        const unsigned int lastRow,
+        CVideoConvertScratch &scratch
+    )
+{
+    const unsigned int chromaWidth = ((width + 1) / 2);
+
+    const bool bSrcRgb = isRgbVideoFormat(source.nFmt);
+    const bool bTrgtRgb = isRgbVideoFormat(target.nFmt);
+    const bool bTrgtBgr = (target.nFmt == eVideoDataIoFormat_bgr);
+
+    for (unsigned int row = firstRow; row < lastRow && row < height; row += 2)
+    {
+        const unsigned int numRows = ((row + 1) < height) ? 2 : 1;
+
+        if (bSrcRgb)
+        {
+            const bool bSrcBgr = (source.nFmt == eVideoDataIoFormat_bgr);
+
+            const uint8_t *pRgb0 = source.getRowPtr(0, row);
+            const uint8_t *pRgb1 = source.getRowPtr(0, (row + numRows) - 1);
+
+            if (bTrgtRgb)
+            {
+                for (unsigned int idx = 0; idx < numRows; idx++)
+                {
+                    if (bSrcBgr == bTrgtBgr)
+                        memcpy(target.getRowPtr(0, row + idx), source.getRowPtr(0, row + idx), (size_t) width * 3);
+                    else
+                        swapRgbRow(target.getRowPtr(0, row + idx), source.getRowPtr(0, row + idx), width);
+                }
+            }
+            else if (target.nFmt == eVideoDataIoFormat_yuy2)
+            {
+                for (unsigned int idx = 0; idx < numRows; idx++)
+                {
+                    const uint8_t *pRgb = source.getRowPtr(0, row + idx);
+
+                    rgbToYuvRows(scratch.pY[0], scratch.pY[0], scratch.pU420, scratch.pV420, pRgb, pRgb, width, bSrcBgr);
+
+                    packYuy2Row(target.getRowPtr(0, row + idx), scratch.pY[0], scratch.pU420, scratch.pV420, width);
+                }
+            }
+            else
+            {
+                uint8_t *pY0 = target.getRowPtr(0, row);
+                uint8_t *pY1 = (numRows > 1) ? target.getRowPtr(0, row + 1) : scratch.pY[1];
+
+                uint8_t *pU, *pV;
+
+                target.getChromaRowPtrs((row / 2), pU, pV);
+
+                if (pV == nullptr)
+                {
+                    rgbToYuvRows(pY0, pY1, scratch.pU420, scratch.pV420, pRgb0, pRgb1, width, bSrcBgr);
+
+                    interleaveChromaRow(pU, scratch.pU420, scratch.pV420, chromaWidth);
+                }
+                else
+                {
+                    rgbToYuvRows(pY0, pY1, pU, pV, pRgb0, pRgb1, width, bSrcBgr);
+                }
+            }
+
+            continue;
+        }
+
+        // YUV source - get the Y, U and V of each row (4:2:x chroma)
+        const uint8_t *pY[2];
+        const uint8_t *pU[2];
+        const uint8_t *pV[2];
+
+        if (source.nFmt == eVideoDataIoFormat_yuy2)
+        {
+            for (unsigned int idx = 0; idx < numRows; idx++)
+            {
+                unpackYuy2Row(scratch.pY[idx], scratch.pU[idx], scratch.pV[idx], source.getRowPtr(0, row + idx), width);
+
+                pY[idx] = scratch.pY[idx];
+                pU[idx] = scratch.pU[idx];
+                pV[idx] = scratch.pV[idx];
+            }
+        }
+        else
+        {
+            uint8_t *pSrcU, *pSrcV;
+
+            source.getChromaRowPtrs((row / 2), pSrcU, pSrcV);
+
+            if (pSrcV == nullptr)
+            {
+                deinterleaveChromaRow(scratch.pU[0], scratch.pV[0], pSrcU, chromaWidth);
+
+                pSrcU = scratch.pU[0];
+                pSrcV = scratch.pV[0];
+            }
+
+            for (unsigned int idx = 0; idx < numRows; idx++)
+            {
+                pY[idx] = source.getRowPtr(0, row + idx);
+                pU[idx] = pSrcU;
+                pV[idx] = pSrcV;
+            }
+        }
+
+        if (bTrgtRgb)
+        {
+            for (unsigned int idx = 0; idx < numRows; idx++)
+                yuvToRgbRow(target.getRowPtr(0, row + idx), pY[idx], pU[idx], pV[idx], width, bTrgtBgr);
+        }
+        else if (target.nFmt == eVideoDataIoFormat_yuy2)
+        {
+            for (unsigned int idx = 0; idx < numRows; idx++)
+                packYuy2Row(target.getRowPtr(0, row + idx), pY[idx], pU[idx], pV[idx], width);
+        }
+        else
+        {
+            for (unsigned int idx = 0; idx < numRows; idx++)
+                memcpy(target.getRowPtr(0, row + idx), pY[idx], width);
+
+            const uint8_t *pChromaU = pU[0];
+            const uint8_t *pChromaV = pV[0];
+
+            // 4:2:2 -> 4:2:0
+            if (numRows > 1 && pU[1] != pU[0])
+            {
+                averageRows(scratch.pU420, pU[0], pU[1], chromaWidth);
+                averageRows(scratch.pV420, pV[0], pV[1], chromaWidth);
+
+                pChromaU = scratch.pU420;
+                pChromaV = scratch.pV420;
+            }
+
+            uint8_t *pTrgtU, *pTrgtV;
+
+            target.getChromaRowPtrs((row / 2), pTrgtU, pTrgtV);
+
+            if (pTrgtV == nullptr)
+            {
+                interleaveChromaRow(pTrgtU, pChromaU, pChromaV, chromaWidth);
+            }
+            else
+            {
+                memcpy(pTrgtU, pChromaU, chromaWidth);
+                memcpy(pTrgtV, pChromaV, chromaWidth);
+            }
+        }
+    }
+}
+
+
+// Convert a frame between 2 raw formats (both frames "width" x "height").
+// numThreads = max. number of threads (0 = auto, 1 = this thread only).
+// Returns 0, or -1 = invalid param / unsupported format
+inline int convertVideoFrame
+    (
+        const SVideoConvertFrame &target,
+        const SVideoConvertFrame &source,
+        const unsigned int width,
+        const unsigned int height,
+        unsigned int numThreads = 0
+    )
+{
+    if (width < 1 || height < 1 || isConvertibleVideoFormat(target.nFmt) == false || isConvertibleVideoFormat(source.nFmt) == false)
+    {
+        LogDebug("[VideoConvert:{}] Invalid param ", __func__);
+        return -1;
+    }
+
+    if ((width & 1) != 0 && (target.nFmt == eVideoDataIoFormat_yuy2 || source.nFmt == eVideoDataIoFormat_yuy2))
+    {
+        LogDebug("[VideoConvert:{}] YUY2 needs an even frame width ", __func__);
+        return -1;
+    }
+
+    if (numThreads == 0 && ((size_t) width * height) < VIDEO_CONVERT_PARALLEL_MIN_PIXELS)
+        numThreads = 1;
+
+    // slices of an even number of rows (for the 4:2:0 chroma rows)
+    parallelRows
+        (
+            height,
+            [&](unsigned int firstRow, unsigned int lastRow)
+            {
+                CVideoConvertScratch scratch(width);
+
+                convertVideoRows(target, source, width, height, firstRow, lastRow, scratch);
+            },
+            2,
+            ((numThreads == 0) ? VIDEO_CONVERT_MAX_THREADS : numThreads)
+        );
+
+    return 0;
+}
+
+// Convert a frame of a CSimpleVideoBuffer to a frame of another
+// CSimpleVideoBuffer (with the same resolution).
+// NOTE: The buffers are not locked while converting.
+// Returns 0, or -1 = invalid param / unsupported format, -2 = invalid frame size
+inline int convertVideoFrame
+    (
+        CSimpleVideoBuffer &target,
+        CSimpleVideoBuffer &source,
+        const unsigned int trgtFrame = 0,
+        const unsigned int srcFrame = 0,
+        const unsigned int numThreads = 0
+    )
+{
+    if (target.getFrameWidth() != source.getFrameWidth() || target.getFrameHeight() != source.getFrameHeight())
+    {
+        LogDebug("[VideoConvert:{}] Invalid frame size ", __func__);
+        return -2;
+    }
+
+    SVideoConvertFrame trgt, src;
+
+    if (makeVideoConvertFrame(trgt, (uint8_t *) target.getFramePtr(trgtFrame), target.getLayout(), target.getVideoFormat()) < 0 ||
+        makeVideoConvertFrame(src, (uint8_t *) source.getFramePtr(srcFrame), source.getLayout(), source.getVideoFormat()) < 0)
+    {
+        LogDebug("[VideoConvert:{}] Invalid param ", __func__);
+        return -1;
+    }
+
+    int status = convertVideoFrame(trgt, src, source.getFrameWidth(), source.getFrameHeight(), numThreads);
+
+    if (status == 0)
+        target.setFrameDataLen(target.getPackedFrameBytes(), trgtFrame);
+
+    return status;
+}
+
+// Convert a (pooled) video frame to another (with the same resolution).
+// The timestamp is copied to the target.
+// Returns 0, or -1 = invalid param / unsupported format, -2 = invalid frame size
+inline int convertVideoFrame(CVideoFrame &target, CVideoFrame &source, const unsigned int numThreads = 0)
+{
+    if (target.getFrameWidth() != source.getFrameWidth() || target.getFrameHeight() != source.getFrameHeight())
+    {
+        LogDebug("[VideoConvert:{}] Invalid frame size ", __func__);
+        return -2;
+    }
+
+    SVideoConvertFrame trgt, src;
+
+    if (makeVideoConvertFrame(trgt, target.getDataPtr(), target.getLayout(), target.getVideoFormat()) < 0 ||
+        makeVideoConvertFrame(src, source.getDataPtr(), source.getLayout(), source.getVideoFormat()) < 0)
+    {
+        LogDebug("[VideoConvert:{}] Invalid param ", __func__);
+        return -1;
+    }
+
+    int status = convertVideoFrame(trgt, src, source.getFrameWidth(), source.getFrameHeight(), numThreads);
+
+    if (status == 0)
+    {
+        target.setDataLen(target.getLayout().packedSize);
+        target.setTimeStamp(source.getTimeStamp());
+    }
+
+    return status;
+}
+
+
+#endif // _VIDEO_CONVERT_H_
@@ -0,0 +1,253 @@
+//****************************************************************************
+// FILE:    VideoFrameLayout.h
+//
+// DESC:    Plane / row layout of raw video frames.
+//
+//          A frame is made up of 1 (packed formats) to 3 (planar
+//          formats) planes.  Each plane has its own row stride, which
+//          is padded to a multiple of the row alignment (64 bytes by
+//          default), so every row starts on a SIMD aligned address.
+//
+//              format      planes (in memory order)
+//              ------      ------------------------
+//              I420        Y, U (w/2 x h/2), V (w/2 x h/2)
+//              YV12        Y, V (w/2 x h/2), U (w/2 x h/2)
+//              NV12        Y, UV (interleaved, w/2 pairs x h/2)
+//              others      1 packed plane (w * bitsPerPixel / 8 per row)
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _VIDEO_FRAME_LAYOUT_H_
+#define _VIDEO_FRAME_LAYOUT_H_
+
+
+#include "CBufferPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+// The video data formats (also used by FileIO/CVideoFileIO.h)
+#ifndef E_VIDEO_DATA_FOTMAT_DEF
+#define E_VIDEO_DATA_FOTMAT_DEF
+typedef enum
+{
+    eVideoDataIoFormat_unknown = 0,
+    // raw pixel formats
+    eVideoDataIoFormat_yuv,         // YUV 4:4:4
+    eVideoDataIoFormat_yuy2,        // YUV 4:2:2
+    eVideoDataIoFormat_yv12,        // YUV 4:2:0
+    eVideoDataIoFormat_nv12,        // YUV 4:2:0
+    eVideoDataIoFormat_rgb,
+    eVideoDataIoFormat_bgr,
+    // encoded video formats
+    eVideoDataIoFormat_mjpeg,
+    eVideoDataIoFormat_mpeg1,
+    eVideoDataIoFormat_mpeg2,
+    eVideoDataIoFormat_mpeg4,
+    eVideoDataIoFormat_h264,
+    eVideoDataIoFormat_h265,
+    eVideoDataIoFormat_divx,
+    eVideoDataIoFormat_webm,
+    eVideoDataIoFormat_vp7,
+    eVideoDataIoFormat_vp8,
+    eVideoDataIoFormat_vp9,
+    eVideoDataIoFormat_vc1,
+    eVideoDataIoFormat_i420,       // Intel I420
+
+} eVideoDataIoFormat_def;
+#endif
+
+
+#define VIDEO_FRAME_ROW_ALIGNMENT       DEFAULT_BUFFER_ALIGNMENT
+#define VIDEO_MAX_PLANES                3
+
+
+// One plane of a video frame
+struct SVideoPlane
+{
+    size_t          offset      = 0;    // from the start of the frame (in bytes)
+    unsigned int    rowBytes    = 0;    // bytes of pixel data per row
+    unsigned int    stride      = 0;    // bytes per row (including padding)
+    unsigned int    width       = 0;    // number of pixels (samples) per row
+    unsigned int    height      = 0;    // number of rows
+    unsigned int    nBitsPerPixel = 0;  // bits per pixel (sample) in this plane
+};
+
+struct SVideoFrameLayout
+{
+    unsigned int    numPlanes   = 0;
+    SVideoPlane     planes[VIDEO_MAX_PLANES];
+
+    size_t          frameSize   = 0;    // bytes per frame (including padding)
+    size_t          packedSize  = 0;    // bytes per frame without any padding
+};
+
+
+// Get the (padded) number of bytes per row, for a row of
+// "frameWidth" pixels of "nBitsPerPixel" bits each.
+inline unsigned int getVideoRowStride(const unsigned int frameWidth, const unsigned int nBitsPerPixel, const unsigned int alignment = VIDEO_FRAME_ROW_ALIGNMENT)
+{
+    unsigned int bytesPerRow = (((frameWidth * nBitsPerPixel) + 7) / 8);       // divide by 8 and round up
+
+    if (alignment < 2)
+        return bytesPerRow;
+
+    return (((bytesPerRow + alignment) - 1) / alignment) * alignment;
+}
+
+// Get the (average) number of bits per pixel of a raw
+// video format (0 = unknown, or not a raw format)
+inline unsigned int getVideoFormatBitsPerPixel(const unsigned long nFmt)
+{
+    switch (nFmt)
+    {
+        case eVideoDataIoFormat_yv12:
+        case eVideoDataIoFormat_nv12:
+        case eVideoDataIoFormat_i420:
+            return 12;
+
+        case eVideoDataIoFormat_yuy2:
+            return 16;
+
+        case eVideoDataIoFormat_yuv:
+        case eVideoDataIoFormat_rgb:
+        case eVideoDataIoFormat_bgr:
+            return 24;
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+inline bool isPlanarVideoFormat(const unsigned long nFmt)
+{
+    return (nFmt == eVideoDataIoFormat_yv12 || nFmt == eVideoDataIoFormat_nv12 || nFmt == eVideoDataIoFormat_i420);
+}
+
+// Work out the plane layout of a frame.  For packed (and unknown)
+// formats nBitsPerPixel sets the pixel size, for planar formats
+// it is ignored.  alignment < 2 = no row padding.
+// Returns 0, or -1 = invalid param
+inline int getVideoFrameLayout
+    (
+        SVideoFrameLayout &layout,
+        const unsigned int frameWidth,
+        const unsigned int frameHeight,
+        const unsigned int nBitsPerPixel,
+        const unsigned long nFmt,
+        const unsigned int alignment = VIDEO_FRAME_ROW_ALIGNMENT
+    )
+{
+    layout = SVideoFrameLayout();
+
+    if (frameWidth < 1 || frameHeight < 1)
+        return -1;
+
+    auto addPlane = [&](const unsigned int width, const unsigned int height, const unsigned int nBits)
+    {
+        SVideoPlane &plane = layout.planes[layout.numPlanes++];
+
+        plane.offset        = layout.frameSize;
+        plane.width         = width;
+        plane.height        = height;
+        plane.nBitsPerPixel = nBits;
+        plane.rowBytes      = getVideoRowStride(width, nBits, 1);
+        plane.stride        = getVideoRowStride(width, nBits, alignment);
+
+        layout.frameSize   += ((size_t) plane.stride * height);
+        layout.packedSize  += ((size_t) plane.rowBytes * height);
+    };
+
+    unsigned int chromaWidth = ((frameWidth + 1) / 2);
+    unsigned int chromaHeight = ((frameHeight + 1) / 2);
+
+    switch (nFmt)
+    {
+        case eVideoDataIoFormat_i420:
+        case eVideoDataIoFormat_yv12:
+            addPlane(frameWidth, frameHeight, 8);
+            addPlane(chromaWidth, chromaHeight, 8);
+            addPlane(chromaWidth, chromaHeight, 8);
+            break;
+
+        case eVideoDataIoFormat_nv12:
+            addPlane(frameWidth, frameHeight, 8);
+            addPlane(chromaWidth, chromaHeight, 16);
+            break;
+
+        default:
+            if (nBitsPerPixel < 1)
+                return -1;
+
+            addPlane(frameWidth, frameHeight, nBitsPerPixel);
+            break;
+    }
+
+    return 0;
+}
+
+// Copy "height" rows of "rowBytes" bytes between two (strided) planes
+inline void copyVideoPlane
+    (
+        uint8_t *pTarget,
+        const size_t trgtStride,
+        const uint8_t *pSource,
+        const size_t srcStride,
+        const size_t rowBytes,
+        const unsigned int height
+    )
+{
+    if (trgtStride == srcStride && rowBytes == srcStride)
+    {
+        memcpy(pTarget, pSource, rowBytes * height);
+        return;
+    }
+
+    for (unsigned int row = 0; row < height; row++)
+        memcpy(pTarget + (row * trgtStride), pSource + (row * srcStride), rowBytes);
+}
+
+// Copy a (padded) frame to a packed buffer (planes back to back, no
+// row padding).  Returns the number of bytes copied.
+inline size_t packVideoFrame(void *pTarget, const uint8_t *pFrame, const SVideoFrameLayout &layout)
+{
+    auto pTrgt = (uint8_t *) pTarget;
+
+    for (unsigned int idx = 0; idx < layout.numPlanes; idx++)
+    {
+        const SVideoPlane &plane = layout.planes[idx];
+
+        copyVideoPlane(pTrgt, plane.rowBytes, pFrame + plane.offset, plane.stride, plane.rowBytes, plane.height);
+
+        pTrgt += ((size_t) plane.rowBytes * plane.height);
+    }
+
+    return layout.packedSize;
+}
+
+// Copy a packed frame into a (padded) frame.
+// Returns the number of bytes copied.
+inline size_t unpackVideoFrame(uint8_t *pFrame, const void *pSource, const SVideoFrameLayout &layout)
+{
+    auto pSrc = (const uint8_t *) pSource;
+
+    for (unsigned int idx = 0; idx < layout.numPlanes; idx++)
+    {
+        const SVideoPlane &plane = layout.planes[idx];
+
+        copyVideoPlane(pFrame + plane.offset, plane.stride, pSrc, plane.rowBytes, plane.rowBytes, plane.height);
+
+        pSrc += ((size_t) plane.rowBytes * plane.height);
+    }
+
+    return layout.packedSize;
+}
+
+
+#endif // _VIDEO_FRAME_LAYOUT_H_
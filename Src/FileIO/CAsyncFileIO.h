@@ -0,0 +1,1103 @@
+//****************************************************************************
+// FILE:    CAsyncFileIO.h
+//
+// DESC:    Asynchronous (positional) file reads / writes, with up to N
+//          requests in flight, so a capture thread hands a block over
+//          and carries on, rather than stalling in fwrite() whenever
+//          the disk is slow (write-behind), and a reader can keep the
+//          next blocks on their way while it works on the current one
+//          (read-ahead).
+//
+//          Back ends:
+//              io_uring    - Linux, using the raw system calls (no
+//                            liburing needed), with 1 submission
+//                            and 1 completion thread.
+//              threads     - a small pool of worker threads doing
+//                            blocking pread() / pwrite() (portable,
+//                            and used if io_uring is not available,
+//                            ie: blocked by a container's seccomp).
+//
+//          Completion is reported with a callback (called on the
+//          completion / worker thread, after the request's slot is
+//          freed, so a callback can submit the next request) or a
+//          std::future:
+//
+//              CAsyncFileIO file;
+//
+//              file.openFile(eFileIoMode_output, sPath, 8);
+//
+//              file.append(pBlock, numBytes);      // data is copied
+//              ...
+//              file.closeFile();                   // waits for the writes
+//
+//              auto result = file.readAsync(pBuffer, numBytes, offset);
+//              ...
+//              long numRead = result.get();
+//
+//          NOTE: A callback must not call waitAll() or closeFile() (they
+//          wait for the callbacks to return).
+//
+//          Define ASYNC_FILE_IO_NO_IO_URING to build without io_uring.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _ASYNC_FILE_IO_H_
+#define _ASYNC_FILE_IO_H_
+
+
+#include "../Logging/Logging.h"
+#include "../Thread/ThreadBase.h"
+
+#include "CFileIO.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+
+#ifdef WINDOWS
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && !defined(ASYNC_FILE_IO_NO_IO_URING) && __has_include(<linux/io_uring.h>)
+#define ASYNC_FILE_IO_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+
+#define ASYNC_FILE_IO_DEFAULT_DEPTH     8       // default number of requests in flight
+#define ASYNC_FILE_IO_MAX_DEPTH         256
+#define ASYNC_FILE_IO_MAX_THREADS       4       // worker threads (threads back end)
+
+
+enum eAsyncIoBackend_def
+{
+    eAsyncIoBackend_auto = 0,           // io_uring if available, else threads
+    eAsyncIoBackend_ioUring,
+    eAsyncIoBackend_threads
+};
+
+
+// The result of 1 request (passed to its completion callback)
+struct SAsyncIoResult
+{
+    uint64_t    offset      = 0;        // file offset
+    size_t      numBytes    = 0;        // bytes requested
+    int64_t     result      = 0;        // bytes transferred (< numBytes = EOF), or -errno
+    bool        bWrite      = false;
+};
+
+typedef std::function<void(const SAsyncIoResult &)>    AsyncIoCallback_def;
+
+
+class CAsyncFileIO
+{
+    struct SRequest
+    {
+        SAsyncIoResult          info;
+        uint8_t                 *pData      = nullptr;  // read target / write source
+        size_t                  done        = 0;        // bytes transferred so far
+        std::vector<uint8_t>    copyBuffer;             // copy of the write data (kept for reuse)
+        AsyncIoCallback_def     callback;
+#ifdef ASYNC_FILE_IO_USE_IO_URING
+        struct iovec            iov;
+#endif
+    };
+
+    // Worker thread (threads back end) / completion thread (io_uring)
+    class CAsyncIoWorker : public CThreadBase
+    {
+        CAsyncFileIO    *m_pOwner;
+
+      public:
+
+        CAsyncIoWorker(CAsyncFileIO *pOwner, const std::string &sName) :
+            CThreadBase(sName),
+            m_pOwner(pOwner)
+        {
+        }
+
+        ~CAsyncIoWorker()
+        {
+            stopThread();
+        }
+
+        void threadProc(void) override
+        {
+            m_pOwner->workerProc();
+        }
+    };
+
+    int                         m_fd;
+    eFileIoMode_def             m_eMode;
+    eAsyncIoBackend_def         m_eBackend;
+
+    unsigned int                m_nMaxInFlight;
+    unsigned int                m_nInFlight;
+    unsigned int                m_nInCallbacks;     // completion callbacks running
+    uint64_t                    m_nAppendOffset;    // end of the data written by append()
+
+    std::vector<std::unique_ptr<SRequest>>  m_requests;
+    std::vector<SRequest *>     m_freeRequests;
+    std::deque<SRequest *>      m_queue;            // threads back end
+
+    std::vector<std::unique_ptr<CAsyncIoWorker>>    m_workers;
+    unsigned int                m_nStartedWorkers;
+    bool                        m_bExit;
+
+    std::mutex                  m_mutex;
+    std::condition_variable     m_slotFreeVar;      // signaled when a request completes
+    std::condition_variable     m_workReadyVar;     // signaled when a request is queued (or on exit)
+
+#ifdef WINDOWS
+    std::mutex                  m_fileMutex;        // (no pread() / pwrite())
+#endif
+
+    uint64_t                    m_nNumErrors;
+    int                         m_nLastErrorNum;
+    std::string                 m_sLastErrorStr;
+
+#ifdef ASYNC_FILE_IO_USE_IO_URING
+    int                         m_ringFd;
+    void                        *m_pSqRing;
+    void                        *m_pCqRing;
+    size_t                      m_sqRingSize;
+    size_t                      m_cqRingSize;
+    struct io_uring_sqe         *m_pSqes;
+    size_t                      m_sqesSize;
+    unsigned int                *m_pSqHead;
+    unsigned int                *m_pSqTail;
+    unsigned int                *m_pSqMask;
+    unsigned int                *m_pSqArray;
+    unsigned int                *m_pCqHead;
+    unsigned int                *m_pCqTail;
+    unsigned int                *m_pCqMask;
+    struct io_uring_cqe         *m_pCqes;
+
+    bool setupRing(const unsigned int numEntries)
+    {
+        struct io_uring_params params;
+
+        memset(&params, 0, sizeof(params));
+
+        m_ringFd = (int) syscall(__NR_io_uring_setup, numEntries, &params);
+
+        if (m_ringFd < 0)
+        {
+            LogDebug("[CAsyncFileIO:{}] io_uring not available (errno {}) ", __func__, errno);
+            m_ringFd = -1;
+            return false;
+        }
+
+        m_sqRingSize = (params.sq_off.array + (params.sq_entries * sizeof(unsigned int)));
+        m_cqRingSize = (params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe)));
+
+        bool bSingleMmap = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+
+        if (bSingleMmap == true)
+        {
+            m_sqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+            m_cqRingSize = m_sqRingSize;
+        }
+
+        m_pSqRing = mmap(nullptr, m_sqRingSize, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), m_ringFd, IORING_OFF_SQ_RING);
+
+        if (m_pSqRing == MAP_FAILED)
+        {
+            m_pSqRing = nullptr;
+            releaseRing();
+            return false;
+        }
+
+        if (bSingleMmap == true)
+        {
+            m_pCqRing = m_pSqRing;
+        }
+        else
+        {
+            m_pCqRing = mmap(nullptr, m_cqRingSize, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), m_ringFd, IORING_OFF_CQ_RING);
+
+            if (m_pCqRing == MAP_FAILED)
+            {
+                m_pCqRing = nullptr;
+                releaseRing();
+                return false;
+            }
+        }
+
+        m_sqesSize = (params.sq_entries * sizeof(struct io_uring_sqe));
+
+        m_pSqes = (struct io_uring_sqe *) mmap(nullptr, m_sqesSize, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), m_ringFd, IORING_OFF_SQES);
+
+        if (m_pSqes == MAP_FAILED)
+        {
+            m_pSqes = nullptr;
+            releaseRing();
+            return false;
+        }
+
+        auto pSq = (uint8_t *) m_pSqRing;
+        auto pCq = (uint8_t *) m_pCqRing;
+
+        m_pSqHead  = (unsigned int *) (pSq + params.sq_off.head);
+        m_pSqTail  = (unsigned int *) (pSq + params.sq_off.tail);
+        m_pSqMask  = (unsigned int *) (pSq + params.sq_off.ring_mask);
+        m_pSqArray = (unsigned int *) (pSq + params.sq_off.array);
+        m_pCqHead  = (unsigned int *) (pCq + params.cq_off.head);
+        m_pCqTail  = (unsigned int *) (pCq + params.cq_off.tail);
+        m_pCqMask  = (unsigned int *) (pCq + params.cq_off.ring_mask);
+        m_pCqes    = (struct io_uring_cqe *) (pCq + params.cq_off.cqes);
+
+        return true;
+    }
+
+    void releaseRing()
+    {
+        if (m_pSqes != nullptr)
+            munmap((void *) m_pSqes, m_sqesSize);
+
+        if (m_pCqRing != nullptr && m_pCqRing != m_pSqRing)
+            munmap(m_pCqRing, m_cqRingSize);
+
+        if (m_pSqRing != nullptr)
+            munmap(m_pSqRing, m_sqRingSize);
+
+        if (m_ringFd >= 0)
+            ::close(m_ringFd);
+
+        m_ringFd  = -1;
+        m_pSqRing = nullptr;
+        m_pCqRing = nullptr;
+        m_pSqes   = nullptr;
+    }
+
+    // Fill in the next SQ entry, for the rest of a request (nullptr = a
+    // NOP, to wake the completion thread).  There is always a free entry,
+    // as there are no more requests in flight than entries.
+    // NOTE: Only called by the submission thread.
+    void queueSqe(SRequest *pRequest)
+    {
+        unsigned int tail = *m_pSqTail;
+        unsigned int idx  = (tail & *m_pSqMask);
+
+        struct io_uring_sqe *pSqe = &m_pSqes[idx];
+
+        memset(pSqe, 0, sizeof(*pSqe));
+
+        if (pRequest == nullptr)
+        {
+            pSqe->opcode = IORING_OP_NOP;
+        }
+        else
+        {
+            pRequest->iov.iov_base = (pRequest->pData + pRequest->done);
+            pRequest->iov.iov_len  = (pRequest->info.numBytes - pRequest->done);
+
+            pSqe->opcode    = (pRequest->info.bWrite ? IORING_OP_WRITEV : IORING_OP_READV);
+            pSqe->fd        = m_fd;
+            pSqe->addr      = (uint64_t) (uintptr_t) &pRequest->iov;
+            pSqe->len       = 1;
+            pSqe->off       = (pRequest->info.offset + pRequest->done);
+            pSqe->user_data = (uint64_t) (uintptr_t) pRequest;
+        }
+
+        m_pSqArray[idx] = idx;
+
+        __atomic_store_n(m_pSqTail, (tail + 1), __ATOMIC_RELEASE);
+    }
+
+    // Hand the queued SQ entries to the kernel.  If that fails, the
+    // requests the kernel did not take are completed with the error.
+    void enterSqes(unsigned int numEntries)
+    {
+        while (numEntries > 0)
+        {
+            int ret = (int) syscall(__NR_io_uring_enter, m_ringFd, numEntries, 0, 0, nullptr, 0);
+
+            if (ret >= 0)
+            {
+                numEntries -= std::min((unsigned int) ret, numEntries);
+                continue;
+            }
+
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                int errorNum = errno;
+
+                LogError("[CAsyncFileIO:{}] io_uring_enter failed (errno {}) ", __func__, errorNum);
+
+                failSqes(-errorNum);
+                return;
+            }
+        }
+    }
+
+    // Take back the SQ entries the kernel has not consumed, and complete
+    // their requests with "result" (-errno).
+    // NOTE: Only called by the submission thread.
+    void failSqes(const int64_t result)
+    {
+        unsigned int head = __atomic_load_n(m_pSqHead, __ATOMIC_ACQUIRE);
+        unsigned int tail = *m_pSqTail;
+
+        std::vector<SRequest *> failed;
+
+        for (unsigned int pos = head; pos != tail; pos++)
+        {
+            struct io_uring_sqe *pSqe = &m_pSqes[m_pSqArray[(pos & *m_pSqMask)]];
+
+            auto pRequest = (SRequest *) (uintptr_t) pSqe->user_data;
+
+            if (pRequest != nullptr)
+                failed.push_back(pRequest);
+        }
+
+        __atomic_store_n(m_pSqTail, head, __ATOMIC_RELEASE);
+
+        for (auto pRequest : failed)
+            complete(pRequest, result);
+    }
+
+    // Submission thread (io_uring back end).
+    // All the requests are submitted from this 1 (long lived) thread, as
+    // the kernel cancels the requests a thread submitted when it exits,
+    // and the threads calling append() (ie: capture threads) may not
+    // live as long as the file.
+    void submitProc()
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+
+        while (true)
+        {
+            m_workReadyVar.wait(lock, [&] { return (m_bExit == true || m_queue.empty() == false); });
+
+            unsigned int numEntries = 0;
+
+            bool bExit = m_queue.empty();       // (m_bExit, and all the requests are done)
+
+            if (bExit == true)
+            {
+                queueSqe(nullptr);
+                numEntries++;
+            }
+
+            while (m_queue.empty() == false)
+            {
+                queueSqe(m_queue.front());
+                m_queue.pop_front();
+                numEntries++;
+            }
+
+            lock.unlock();
+
+            enterSqes(numEntries);
+
+            if (bExit == true)
+                break;
+
+            lock.lock();
+        }
+    }
+
+    // Completion thread (io_uring back end)
+    void reapProc()
+    {
+        bool bExit = false;
+
+        while (bExit == false)
+        {
+            int ret = (int) syscall(__NR_io_uring_enter, m_ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+            if (ret < 0 && errno != EINTR)
+            {
+                LogError("[CAsyncFileIO:{}] io_uring_enter failed (errno {}) ", __func__, errno);
+            }
+
+            unsigned int head = *m_pCqHead;
+            unsigned int tail = __atomic_load_n(m_pCqTail, __ATOMIC_ACQUIRE);
+
+            // The requests were set up (under m_mutex) before they were
+            // submitted - take the lock once per batch, so that ordering is
+            // also visible to the compiler / thread checkers, not just
+            // implied by the kernel.
+            if (head != tail)
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+            }
+
+            while (head != tail)
+            {
+                struct io_uring_cqe *pCqe = &m_pCqes[(head & *m_pCqMask)];
+
+                auto pRequest = (SRequest *) (uintptr_t) pCqe->user_data;
+                int64_t result = pCqe->res;
+
+                head++;
+
+                __atomic_store_n(m_pCqHead, head, __ATOMIC_RELEASE);
+
+                if (pRequest == nullptr)
+                {
+                    bExit = true;
+                    continue;
+                }
+
+                if (result > 0)
+                    pRequest->done += (size_t) result;
+
+                // a short read / write - queue the rest (as doBlockingIo(),
+                // a read stops when it gets 0 bytes, ie: at EOF)
+                if (result > 0 && pRequest->done < pRequest->info.numBytes)
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+
+                    m_queue.push_front(pRequest);
+
+                    m_workReadyVar.notify_one();
+                    continue;
+                }
+
+                complete(pRequest, ((result < 0) ? result : (int64_t) pRequest->done));
+            }
+        }
+    }
+#endif
+
+    // Do a request with blocking I/O (threads back end).
+    // Returns the number of bytes transferred, or -errno.
+    int64_t doBlockingIo(SRequest *pRequest)
+    {
+        while (pRequest->done < pRequest->info.numBytes)
+        {
+            uint8_t *pData  = (pRequest->pData + pRequest->done);
+            size_t count    = (pRequest->info.numBytes - pRequest->done);
+            uint64_t offset = (pRequest->info.offset + pRequest->done);
+
+#ifdef WINDOWS
+            int64_t result;
+
+            count = std::min(count, (size_t) 0x40000000);
+
+            {
+                std::lock_guard<std::mutex> lock{m_fileMutex};
+
+                if (_lseeki64(m_fd, (__int64) offset, SEEK_SET) < 0)
+                    return -errno;
+
+                if (pRequest->info.bWrite == true)
+                    result = _write(m_fd, pData, (unsigned int) count);
+                else
+                    result = _read(m_fd, pData, (unsigned int) count);
+            }
+#else
+            ssize_t result;
+
+            if (pRequest->info.bWrite == true)
+                result = ::pwrite(m_fd, pData, count, (off_t) offset);
+            else
+                result = ::pread(m_fd, pData, count, (off_t) offset);
+#endif
+
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                return -errno;
+            }
+
+            if (result == 0)
+                break;                      // EOF
+
+            pRequest->done += (size_t) result;
+        }
+
+        return (int64_t) pRequest->done;
+    }
+
+    void workerProc()
+    {
+#ifdef ASYNC_FILE_IO_USE_IO_URING
+        if (m_eBackend == eAsyncIoBackend_ioUring)
+        {
+            bool bSubmitter;
+
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+
+                // the 1st thread submits, the 2nd reaps the completions
+                bSubmitter = (m_nStartedWorkers == 0);
+
+                m_nStartedWorkers++;
+                m_slotFreeVar.notify_all();
+            }
+
+            if (bSubmitter == true)
+                submitProc();
+            else
+                reapProc();
+
+            return;
+        }
+#endif
+
+        std::unique_lock<std::mutex> lock{m_mutex};
+
+        m_nStartedWorkers++;
+        m_slotFreeVar.notify_all();
+
+        while (true)
+        {
+            m_workReadyVar.wait(lock, [&] { return (m_bExit == true || m_queue.empty() == false); });
+
+            if (m_queue.empty() == true)
+                break;                      // (m_bExit)
+
+            SRequest *pRequest = m_queue.front();
+
+            m_queue.pop_front();
+
+            lock.unlock();
+
+            complete(pRequest, doBlockingIo(pRequest));
+
+            lock.lock();
+        }
+    }
+
+    // Free the slot of a request, and then report its result.  The slot
+    // is freed first, so the callback can submit the next request (ie:
+    // read-ahead) even when all the slots were in use.
+    void complete(SRequest *pRequest, const int64_t result)
+    {
+        pRequest->info.result = result;
+
+        bool bFailed = (result < 0 || (pRequest->info.bWrite == true && (size_t) result < pRequest->info.numBytes));
+
+        if (bFailed)
+        {
+            LogError("[CAsyncFileIO:{}] {} at offset {} failed (result {}) ", __func__, (pRequest->info.bWrite ? "write" : "read"), pRequest->info.offset, result);
+        }
+
+        SAsyncIoResult info = pRequest->info;
+        AsyncIoCallback_def callback;
+
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+
+            // (counted before the callback, so it sees the error count)
+            if (bFailed)
+            {
+                m_nNumErrors++;
+                m_nLastErrorNum = ((result < 0) ? (int) -result : EIO);
+                m_sLastErrorStr = (pRequest->info.bWrite ? "File async write failed" : "File async read failed");
+            }
+
+            callback.swap(pRequest->callback);
+            pRequest->pData = nullptr;
+
+            m_freeRequests.push_back(pRequest);
+
+            m_nInFlight--;
+
+            if (callback)
+                m_nInCallbacks++;
+
+            m_slotFreeVar.notify_all();
+        }
+
+        if (!callback)
+            return;
+
+        try
+        {
+            callback(info);
+        }
+        catch (...)
+        {
+            LogError("[CAsyncFileIO:{}] Exception in completion callback ", __func__);
+        }
+
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        m_nInCallbacks--;
+
+        m_slotFreeVar.notify_all();
+    }
+
+    // Queue a request, waiting for a free slot if N are in flight.
+    // Returns 0 = OK, or -errno: -EINVAL = invalid param, -EBADF = not open,
+    // -ENOMEM = out of memory (the same codes as SAsyncIoResult::result).
+    int submit
+        (
+            const bool bWrite,
+            void *pData,
+            const size_t numBytes,
+            const uint64_t offset,
+            AsyncIoCallback_def &&callback,
+            const bool bCopyData
+        )
+    {
+        if (pData == nullptr || numBytes < 1)
+        {
+            LogDebug("[CAsyncFileIO:{}] Invalid param ", __func__);
+            return -EINVAL;
+        }
+
+        std::unique_lock<std::mutex> lock{m_mutex};
+
+        if (m_fd < 0 || m_bExit == true)
+        {
+            LogDebug("[CAsyncFileIO:{}] File not open ", __func__);
+            return -EBADF;
+        }
+
+        m_slotFreeVar.wait(lock, [&] { return (m_freeRequests.empty() == false); });
+
+        SRequest *pRequest = m_freeRequests.back();
+
+        pRequest->pData = (uint8_t *) pData;
+
+        if (bCopyData == true)
+        {
+            try
+            {
+                pRequest->copyBuffer.resize(numBytes);
+            }
+            catch (...)
+            {
+                LogDebug("[CAsyncFileIO:{}] Memory allocation failed ", __func__);
+                return -ENOMEM;
+            }
+
+            memcpy(pRequest->copyBuffer.data(), pData, numBytes);
+
+            pRequest->pData = pRequest->copyBuffer.data();
+        }
+
+        m_freeRequests.pop_back();
+
+        pRequest->info.offset   = offset;
+        pRequest->info.numBytes = numBytes;
+        pRequest->info.result   = 0;
+        pRequest->info.bWrite   = bWrite;
+        pRequest->done          = 0;
+        pRequest->callback      = std::move(callback);
+
+        m_nInFlight++;
+
+        // (to the worker threads / the io_uring submission thread)
+        m_queue.push_back(pRequest);
+
+        m_workReadyVar.notify_one();
+
+        return 0;
+    }
+
+    void releaseAll()
+    {
+        m_workers.clear();
+
+#ifdef ASYNC_FILE_IO_USE_IO_URING
+        releaseRing();
+#endif
+
+        if (m_fd >= 0)
+        {
+#ifdef WINDOWS
+            _close(m_fd);
+#else
+            ::close(m_fd);
+#endif
+        }
+
+        m_fd = -1;
+        m_eMode = eFileIoMode_unknown;
+
+        m_requests.clear();
+        m_freeRequests.clear();
+        m_queue.clear();
+    }
+
+  public:
+
+    CAsyncFileIO()
+    {
+        m_fd = -1;
+        m_eMode = eFileIoMode_unknown;
+        m_eBackend = eAsyncIoBackend_auto;
+
+        m_nMaxInFlight = 0;
+        m_nInFlight = 0;
+        m_nInCallbacks = 0;
+        m_nAppendOffset = 0;
+
+        m_nStartedWorkers = 0;
+        m_bExit = false;
+
+        m_nNumErrors = 0;
+        m_nLastErrorNum = 0;
+        m_sLastErrorStr = "";
+
+#ifdef ASYNC_FILE_IO_USE_IO_URING
+        m_ringFd  = -1;
+        m_pSqRing = nullptr;
+        m_pCqRing = nullptr;
+        m_pSqes   = nullptr;
+#endif
+    }
+
+    ~CAsyncFileIO()
+    {
+        closeFile();
+    }
+
+    CAsyncFileIO(const CAsyncFileIO &) = delete;
+    CAsyncFileIO &operator=(const CAsyncFileIO &) = delete;
+
+    // Open a file, with up to "maxInFlight" requests in flight.
+    // Modes: eFileIoMode_input, eFileIoMode_output (truncated),
+    // eFileIoMode_IO and eFileIoMode_append (append() writes at the end).
+    bool openFile
+        (
+            const eFileIoMode_def eMode,
+            const std::string &sFilePath,
+            unsigned int maxInFlight = ASYNC_FILE_IO_DEFAULT_DEPTH,
+            const eAsyncIoBackend_def eBackend = eAsyncIoBackend_auto
+        )
+    {
+        if (m_fd >= 0)
+        {
+            m_sLastErrorStr = "File open called but file is already open";
+            return false;
+        }
+
+        int nFlags;
+
+        switch (eMode)
+        {
+            case eFileIoMode_input:     nFlags = O_RDONLY;                          break;
+            case eFileIoMode_output:    nFlags = (O_WRONLY | O_CREAT | O_TRUNC);    break;
+            case eFileIoMode_IO:        nFlags = (O_RDWR | O_CREAT);                break;
+            case eFileIoMode_append:    nFlags = (O_WRONLY | O_CREAT);              break;      // (not O_APPEND, it breaks positional writes)
+
+            default:
+                m_sLastErrorStr = "File open called with an invalid mode";
+                return false;
+        }
+
+        if (sFilePath.empty())
+        {
+            m_sLastErrorStr = "File open called but file path not set";
+            return false;
+        }
+
+#ifdef WINDOWS
+        m_fd = _open(sFilePath.c_str(), (nFlags | _O_BINARY), (_S_IREAD | _S_IWRITE));
+#else
+        m_fd = ::open(sFilePath.c_str(), (nFlags | O_CLOEXEC), 0644);
+#endif
+
+        if (m_fd < 0)
+        {
+            m_sLastErrorStr = "File open operation faild";
+            m_nLastErrorNum = errno;
+            return false;
+        }
+
+        m_eMode = eMode;
+        m_nAppendOffset = 0;
+
+        if (eMode == eFileIoMode_append || eMode == eFileIoMode_IO)
+        {
+            int64_t fileSize = getFileSize();
+
+            m_nAppendOffset = ((fileSize > 0) ? (uint64_t) fileSize : 0);
+        }
+
+        maxInFlight = std::max(1u, std::min(maxInFlight, (unsigned int) ASYNC_FILE_IO_MAX_DEPTH));
+
+        m_nMaxInFlight = maxInFlight;
+        m_nInFlight = 0;
+        m_nInCallbacks = 0;
+        m_nStartedWorkers = 0;
+        m_bExit = false;
+
+        m_nNumErrors = 0;
+        m_nLastErrorNum = 0;
+        m_sLastErrorStr = "";
+
+        try
+        {
+            for (unsigned int idx = 0; idx < maxInFlight; idx++)
+            {
+                m_requests.push_back(std::make_unique<SRequest>());
+                m_freeRequests.push_back(m_requests.back().get());
+            }
+        }
+        catch (...)
+        {
+            m_sLastErrorStr = "Memory allocation failed";
+            releaseAll();
+            return false;
+        }
+
+        m_eBackend = eAsyncIoBackend_threads;
+
+        unsigned int numThreads = std::min(maxInFlight, (unsigned int) ASYNC_FILE_IO_MAX_THREADS);
+
+#ifdef ASYNC_FILE_IO_USE_IO_URING
+        if (eBackend != eAsyncIoBackend_threads && setupRing(maxInFlight) == true)
+        {
+            m_eBackend = eAsyncIoBackend_ioUring;
+            numThreads = 2;
+        }
+#endif
+
+        if (eBackend == eAsyncIoBackend_ioUring && m_eBackend != eAsyncIoBackend_ioUring)
+        {
+            m_sLastErrorStr = "io_uring not available";
+            releaseAll();
+            return false;
+        }
+
+        for (unsigned int idx = 0; idx < numThreads; idx++)
+        {
+            auto pWorker = std::make_unique<CAsyncIoWorker>(this, ("asyncIo" + std::to_string(idx)));
+
+            if (pWorker->createThread() == false)
+            {
+                LogError("[CAsyncFileIO:{}] Failed to create thread ", __func__);
+                break;
+            }
+
+            m_workers.push_back(std::move(pWorker));
+        }
+
+        // wait until the threads are running (see CThreadBase::stopThread())
+        std::unique_lock<std::mutex> lock{m_mutex};
+
+        m_slotFreeVar.wait(lock, [&] { return (m_nStartedWorkers >= m_workers.size()); });
+
+        if (m_workers.empty() == true)
+        {
+            lock.unlock();
+
+            m_sLastErrorStr = "Failed to create the I/O thread(s)";
+            releaseAll();
+            return false;
+        }
+
+        return true;
+    }
+
+    // Wait for all the requests, then close the file.
+    // Returns false if any request failed (see getNumErrors()).
+    bool closeFile()
+    {
+        if (m_fd < 0)
+            return false;
+
+        waitAll();
+
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+
+            m_bExit = true;
+
+            m_workReadyVar.notify_all();
+        }
+
+        releaseAll();
+
+        return (m_nNumErrors == 0);
+    }
+
+    bool isOpen()
+    {
+        return (m_fd >= 0);
+    }
+
+    eAsyncIoBackend_def getBackend()
+    {
+        return m_eBackend;
+    }
+
+    int64_t getFileSize()
+    {
+        if (m_fd < 0)
+            return -1;
+
+#ifdef WINDOWS
+        struct _stat64 fileStat;
+
+        if (_fstat64(m_fd, &fileStat) != 0)
+            return -1;
+#else
+        struct stat fileStat;
+
+        if (fstat(m_fd, &fileStat) != 0)
+            return -1;
+#endif
+
+        return (int64_t) fileStat.st_size;
+    }
+
+    // Read "numBytes" at "offset" into pData, which must stay valid
+    // until the callback has been called.  See submit() for return codes.
+    int submitRead(void *pData, const size_t numBytes, const uint64_t offset, AsyncIoCallback_def callback)
+    {
+        return submit(false, pData, numBytes, offset, std::move(callback), false);
+    }
+
+    // Write "numBytes" at "offset".  The data is copied (so pData can be
+    // reused straight away) unless bCopyData = false, in which case it
+    // must stay valid until the callback has been called.
+    int submitWrite
+        (
+            const void *pData,
+            const size_t numBytes,
+            const uint64_t offset,
+            AsyncIoCallback_def callback = nullptr,
+            const bool bCopyData = true
+        )
+    {
+        return submit(true, (void *) pData, numBytes, offset, std::move(callback), bCopyData);
+    }
+
+    // Write (a copy of) "numBytes" after the data written by the
+    // previous append() calls (write-behind, ie: for a recorder).
+    // This returns without waiting for the disk (unless all the writes
+    // are in flight), so a failed write only shows up later, in
+    // getNumErrors() - check that before appending more data, so the
+    // caller's position doesn't move past what is in the file.
+    int append(const void *pData, const size_t numBytes, AsyncIoCallback_def callback = nullptr)
+    {
+        uint64_t offset;
+
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+
+            offset = m_nAppendOffset;
+            m_nAppendOffset += numBytes;
+        }
+
+        int status = submitWrite(pData, numBytes, offset, std::move(callback), true);
+
+        if (status < 0)
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+
+            if (m_nAppendOffset == (offset + numBytes))
+                m_nAppendOffset = offset;
+        }
+
+        return status;
+    }
+
+    // As submitRead(), with a future for the result (bytes read, or -errno,
+    // including the submit() errors)
+    std::future<int64_t> readAsync(void *pData, const size_t numBytes, const uint64_t offset)
+    {
+        auto pPromise = std::make_shared<std::promise<int64_t>>();
+
+        auto result = pPromise->get_future();
+
+        int status = submitRead(pData, numBytes, offset, [pPromise](const SAsyncIoResult &info) { pPromise->set_value(info.result); });
+
+        if (status < 0)
+            pPromise->set_value(status);
+
+        return result;
+    }
+
+    // As submitWrite() (the data is copied), with a future for the result
+    // (bytes written, or -errno)
+    std::future<int64_t> writeAsync(const void *pData, const size_t numBytes, const uint64_t offset)
+    {
+        auto pPromise = std::make_shared<std::promise<int64_t>>();
+
+        auto result = pPromise->get_future();
+
+        int status = submitWrite(pData, numBytes, offset, [pPromise](const SAsyncIoResult &info) { pPromise->set_value(info.result); });
+
+        if (status < 0)
+            pPromise->set_value(status);
+
+        return result;
+    }
+
+    // Wait for all the requests in flight to complete (and their
+    // callbacks to return).  NOTE: Not from a completion callback.
+    void waitAll()
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+
+        m_slotFreeVar.wait(lock, [&] { return (m_nInFlight == 0 && m_nInCallbacks == 0); });
+    }
+
+    unsigned int getNumInFlight()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        return m_nInFlight;
+    }
+
+    unsigned int getMaxInFlight()
+    {
+        return m_nMaxInFlight;
+    }
+
+    // Get the file offset the next append() will write at
+    uint64_t getAppendOffset()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        return m_nAppendOffset;
+    }
+
+    // Get the number of requests that failed (or wrote short)
+    uint64_t getNumErrors()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        return m_nNumErrors;
+    }
+
+    std::string getLastErrorText()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        return m_sLastErrorStr;
+    }
+
+    int getLastErrorCode()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+
+        return m_nLastErrorNum;
+    }
+};
+
+
+#endif // _ASYNC_FILE_IO_H_
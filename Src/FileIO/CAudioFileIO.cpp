@@ -33,6 +33,9 @@
 
 #include "FileUtils.h"
 
+#include "../Buffer/AudioInterleave.h"
+#include "../Buffer/SampleConvert.h"
+
 
 #ifdef  USE_DR_WAV
 
@@ -452,6 +455,12 @@ CRawAudioFileIO::CRawAudioFileIO(const unsigned int numChannels) :
     m_lastChlRead         = -1;
     m_lastChlWritten      = -1;
     m_bCreateInfoTextFile = false;
+    m_nAsyncWriteDepth    = 0;
+    m_bReadAhead          = false;
+    m_pReadAheadBuffer    = nullptr;
+    m_lReadAheadPos       = 0;
+    m_nReadAheadFrames    = 0;
+    m_nBlockFrames        = 0;
 }
 
 
@@ -470,6 +479,12 @@ CRawAudioFileIO::CRawAudioFileIO(const unsigned int numChannels, const std::stri
     m_lastChlRead         = -1;
     m_lastChlWritten      = -1;
     m_bCreateInfoTextFile = false;
+    m_nAsyncWriteDepth    = 0;
+    m_bReadAhead          = false;
+    m_pReadAheadBuffer    = nullptr;
+    m_lReadAheadPos       = 0;
+    m_nReadAheadFrames    = 0;
+    m_nBlockFrames        = 0;
 }
 
 
@@ -488,6 +503,18 @@ void CRawAudioFileIO::createInfoTextFile(const bool value)
 }
 
 
+void CRawAudioFileIO::setAsyncWriteDepth(const unsigned int numRequests)
+{
+    m_nAsyncWriteDepth = std::min(numRequests, (unsigned int) ASYNC_FILE_IO_MAX_DEPTH);
+}
+
+
+void CRawAudioFileIO::setReadAhead(const bool value)
+{
+    m_bReadAhead = value;
+}
+
+
 bool CRawAudioFileIO::parseInfoTextFile(const std::string &sFile, SRawFileInfo &info)
 {
     std::fstream infoFile;
@@ -603,7 +630,22 @@ bool CRawAudioFileIO::openFile(const eFileIoMode_def mode, const std::string &sF
 
     m_eFileType = getAudioFileType(m_sFilePath);
 
-    if (m_nIoBlockSize < 1)
+    bool bReadAhead = (m_bReadAhead && mode == eFileIoMode_input);
+
+    /// Read-ahead needs a block of frames (and big sequential reads are faster),
+    /// kept apart from m_nIoBlockSize so a later openFile() gets the user's value
+    int nBufferFrames = m_nIoBlockSize;
+
+    m_nReadAheadFrames = 0;
+
+    if (bReadAhead)
+    {
+        m_nReadAheadFrames = ((m_nIoBlockSize > 0) ? (unsigned int) m_nIoBlockSize
+                                                   : std::max(1u, (unsigned int) (RAW_AUDIO_READ_AHEAD_BLOCK_BYTES / m_nFrameSize)));
+        nBufferFrames      = (int) m_nReadAheadFrames;
+    }
+
+    if (nBufferFrames < 1)
     {
         /// Allocate just 1 frame (size of 'm_numChls')
         if (m_nBitsPerSample == 32)
@@ -615,18 +657,27 @@ bool CRawAudioFileIO::openFile(const eFileIoMode_def mode, const std::string &sF
     }
     else
     {
-        /// Allocate 'm_nIoBlockSize' (number of) frames (* size of 'm_numChls')
+        /// Allocate 'nBufferFrames' (number of) frames (* size of 'm_numChls')
         if (m_nBitsPerSample == 32)
-            m_pFramebuffer = calloc(sizeof(int32_t), (m_numChls * m_nIoBlockSize));
+            m_pFramebuffer = calloc(sizeof(int32_t), (m_numChls * nBufferFrames));
         else if (m_nBitsPerSample == 8)
-            m_pFramebuffer = calloc(sizeof(int8_t), (m_numChls * m_nIoBlockSize));
+            m_pFramebuffer = calloc(sizeof(int8_t), (m_numChls * nBufferFrames));
         else
-            m_pFramebuffer = calloc(sizeof(int16_t), (m_numChls * m_nIoBlockSize));
+            m_pFramebuffer = calloc(sizeof(int16_t), (m_numChls * nBufferFrames));
     }
 
     if (m_pFramebuffer == nullptr)
         return false;
 
+    if (bReadAhead)
+    {
+        /// The 2nd block buffer, filled while m_pFramebuffer is used
+        m_pReadAheadBuffer = calloc(m_nFrameSize, m_nReadAheadFrames);
+
+        if (m_pReadAheadBuffer == nullptr)
+            return false;
+    }
+
     m_eMode = mode;
 
     m_fileIO.setBinaryMode(true);
@@ -635,13 +686,32 @@ bool CRawAudioFileIO::openFile(const eFileIoMode_def mode, const std::string &sF
     {
         case eFileIoMode_input:
             {
-                if (!m_fileIO.openFile(eFileIoMode_input, m_sFilePath))
-                    return false;
+                long len = -1;
+
+                if (bReadAhead)
+                {
+                    /// 1 read in flight, by 1 worker thread (for 1 sequential
+                    /// stream, this has fewer hand-offs than the io_uring back end)
+                    if (!m_asyncIO.openFile(eFileIoMode_input, m_sFilePath, 1, eAsyncIoBackend_threads))
+                        return false;
+
+                    len = (long) m_asyncIO.getFileSize();
+                }
+                else
+                {
+                    if (!m_fileIO.openFile(eFileIoMode_input, m_sFilePath))
+                        return false;
+
+                    len = m_fileIO.getFileSize();
+                }
 
-                auto len = m_fileIO.getFileSize();
                 if (len < 0)
                 {
-                    m_fileIO.closeFile();
+                    if (m_asyncIO.isOpen())
+                        m_asyncIO.closeFile();
+                    else
+                        m_fileIO.closeFile();
+
                     return false;
                 }
 
@@ -651,15 +721,20 @@ bool CRawAudioFileIO::openFile(const eFileIoMode_def mode, const std::string &sF
                 /// Set the read position to the beginning of the file.
                 m_lCurrentFilePos = 0;
                 m_lastChlRead     = -1;
-
-                nextFrame();
             }
             break;
 
         case eFileIoMode_output:
             {
-                if (!m_fileIO.openFile(eFileIoMode_output, m_sFilePath))
+                if (m_nAsyncWriteDepth > 0)
+                {
+                    if (!m_asyncIO.openFile(eFileIoMode_output, m_sFilePath, m_nAsyncWriteDepth))
+                        return false;
+                }
+                else if (!m_fileIO.openFile(eFileIoMode_output, m_sFilePath))
+                {
                     return false;
+                }
 
                 m_lFileSize       = 0;
 
@@ -736,6 +811,27 @@ bool CRawAudioFileIO::openFile(const eFileIoMode_def mode, const std::string &sF
     m_nCurrentFrame    = 0;
     m_bFileOpened      = true;
 
+    /// Read the first frame / block (once the file is "opened")
+    if (m_eMode == eFileIoMode_input)
+    {
+        if (bReadAhead)
+        {
+            /// .. and start reading the next block
+            m_lReadAheadPos = 0;
+
+            if (startReadAhead())
+                swapReadAheadBlock();
+        }
+        else if (m_nIoBlockSize < 1)
+        {
+            nextFrame();
+        }
+        else
+        {
+            readBlock(m_pFramebuffer, m_nIoBlockSize);
+        }
+    }
+
     return true;
 }
 
@@ -747,6 +843,9 @@ long CRawAudioFileIO::getNumFrames()
     if (!m_bFileOpened || m_eMode == eFileIoMode_unknown || m_eMode == eFileIoMode_output || m_numChls < 1)
         return -1;
 
+    if (m_asyncIO.isOpen())
+        return (long) (m_asyncIO.getFileSize() / m_nFrameSize);
+
     /// Get the file length (which sets file pointer to EOF)
     long fileSize  = m_fileIO.getFileSize();
     
@@ -767,10 +866,21 @@ bool CRawAudioFileIO::closeFile()
     if (!m_bFileOpened)
         LogDebug("file close called when files is not open");
 
+    bool status = true;
+
     /// close input file
-    if (m_fileIO.isOpen())
+    if (m_fileIO.isOpen() || m_asyncIO.isOpen())
     {
-        if (!m_fileIO.closeFile())
+        if (m_asyncIO.isOpen())
+        {
+            /// (waits for the writes still in flight)
+            if (!m_asyncIO.closeFile())
+            {
+                LogCritical("CRawAudioFileIO - Error: write failed:{} ", m_asyncIO.getLastErrorText());
+                status = false;
+            }
+        }
+        else if (!m_fileIO.closeFile())
         {
             LogCritical("CRawAudioFileIO - Error: unable to close file ");
             return false;
@@ -786,6 +896,17 @@ bool CRawAudioFileIO::closeFile()
                 m_pFramebuffer = nullptr;
                 free(pTmp);
             }
+
+            /// (the file is closed, so there is no read still in flight)
+            m_readAheadResult = std::future<int64_t>();
+
+            if (m_pReadAheadBuffer != nullptr)
+            {
+                auto pTmp          = m_pReadAheadBuffer;
+
+                m_pReadAheadBuffer = nullptr;
+                free(pTmp);
+            }
         }
         catch (...)
         {
@@ -795,15 +916,23 @@ bool CRawAudioFileIO::closeFile()
     m_nCurrentFrameIdx = 0;
     m_nIoCntr          = -1;
     m_nCurrentFrame    = -1;
+    m_nBlockFrames     = 0;
+    m_nReadAheadFrames = 0;
     m_eMode            = eFileIoMode_def::eFileIoMode_unknown;
     m_bFileOpened      = false;
 
-    return true;
+    return status;
 }
 
 
 bool CRawAudioFileIO::isEOF()
 {
+    if (m_pReadAheadBuffer != nullptr)
+    {
+        /// Read-ahead, at the end of the last block
+        return (m_nCurrentFrameIdx >= (int) m_nBlockFrames && m_readAheadResult.valid() == false);
+    }
+
     if (m_nCurrentFrameIdx >= m_nFramesInFile)
     {
         return true;
@@ -909,6 +1038,9 @@ bool CRawAudioFileIO::readBlock(void *pData, const unsigned int numFrames)
         return false;
     }
 
+    if (m_pReadAheadBuffer != nullptr)
+        return readAheadFrames(pData, numFrames);
+
     auto nFramesLeftInFile = ((m_lFileSize - m_lCurrentFilePos) / m_nFrameSize);
 
     unsigned int nReadSize = 0;
@@ -944,25 +1076,11 @@ bool CRawAudioFileIO::readBlock(void *pData, const unsigned int numFrames)
             }
 
             // zero out/pad the rest of the samples (from chosen read size)
+            // (m_nFrameSize is in bytes, for any sample size)
 
-            auto nPadSize = 0;
+            auto nPadSize = ((numFrames - nFramesLeftInFile) * m_nFrameSize);
 
-            void *pPadStart = nullptr;
-
-            if (m_nBitsPerSample == 16)
-            {
-                nPadSize = ((numFrames - nFramesLeftInFile) * m_nFrameSize * sizeof(int16_t));
-                pPadStart = (void *) (((int16_t *) pData) + (nFramesLeftInFile * m_nFrameSize));
-            }
-            else if (m_nBitsPerSample == 32)
-            {
-                nPadSize = ((numFrames - nFramesLeftInFile) * m_nFrameSize * sizeof(int32_t));
-                pPadStart = (void *) (((int32_t *) pData) + (nFramesLeftInFile * m_nFrameSize));
-            }
-            else
-            {
-                return false;
-            }
+            void *pPadStart = (void *) (((uint8_t *) pData) + (nFramesLeftInFile * m_nFrameSize));
 
             memset(pPadStart, 0, nPadSize);
 
@@ -1124,6 +1242,43 @@ bool CRawAudioFileIO::writeBlock(const void *pData, const unsigned int numFrames
         return false;
     }
 
+    bool status = writeFrames(pData, numFrames);
+
+    if (status)
+    {
+        m_nCurrentFrame += numFrames;
+        m_nFramesInFile += numFrames;
+    }
+
+    return status;
+}
+
+
+bool CRawAudioFileIO::writeFrames(const void *pData, const unsigned int numFrames)
+{
+    if (m_asyncIO.isOpen())
+    {
+        /// Write-behind (see CAsyncFileIO::append()) - an earlier
+        /// write failed, so don't queue any more
+        if (m_asyncIO.getNumErrors() > 0)
+        {
+            LogDebug("async write failed:{}", m_asyncIO.getLastErrorText());
+            return false;
+        }
+
+        int nStatus = m_asyncIO.append(pData, ((size_t) m_nFrameSize * numFrames));
+
+        if (nStatus < 0)
+        {
+            LogDebug("async write not queued:{}", nStatus);
+            return false;
+        }
+
+        m_lCurrentFilePos = (unsigned long) m_asyncIO.getAppendOffset();
+
+        return true;
+    }
+
     bool status = m_fileIO.writeBlock(pData, m_nFrameSize, numFrames);
 
 #ifdef UPDATE_FILE_POSITION
@@ -1134,13 +1289,119 @@ bool CRawAudioFileIO::writeBlock(const void *pData, const unsigned int numFrames
     if (pos > 0)
         m_lCurrentFilePos += pos;
 #endif
-    if (status)
+
+    return status;
+}
+
+
+/// Read-ahead: start reading the next I/O block into m_pReadAheadBuffer.
+/// Returns false at the end of the file (nothing more to read).
+bool CRawAudioFileIO::startReadAhead()
+{
+    unsigned long dataSize = ((unsigned long) m_nFramesInFile * m_nFrameSize);
+
+    if (m_lReadAheadPos >= dataSize)
     {
-        m_nCurrentFrame += numFrames;
-        m_nFramesInFile += numFrames;
+        if (!m_bUseLoopingRead || dataSize < 1)
+            return false;
+
+        m_lReadAheadPos = 0;
     }
 
-    return status;
+    size_t numBytes = std::min(((size_t) m_nFrameSize * m_nReadAheadFrames), (size_t) (dataSize - m_lReadAheadPos));
+
+    m_readAheadResult = m_asyncIO.readAsync(m_pReadAheadBuffer, numBytes, m_lReadAheadPos);
+
+    return true;
+}
+
+
+/// Read-ahead: wait for the next I/O block, make it the current block
+/// (a buffer swap, no copy) and start reading the one after it.
+/// Returns false at the end of the file, or if the read failed.
+bool CRawAudioFileIO::swapReadAheadBlock()
+{
+    if (m_readAheadResult.valid() == false)
+        return false;
+
+    size_t  blockSize = ((size_t) m_nFrameSize * m_nReadAheadFrames);
+    auto    pBlock    = (uint8_t *) m_pReadAheadBuffer;
+
+    int64_t numRead   = m_readAheadResult.get();
+
+    if (numRead < 0)
+    {
+        LogDebug("read-ahead failed:{}", m_asyncIO.getLastErrorText());
+        return false;
+    }
+
+    size_t filled = (size_t) numRead;
+
+    m_lReadAheadPos += filled;
+
+    /// If the block reached the end of the file, either
+    /// continue from the start ("UseLoopingRead") or pad it.
+    while (filled < blockSize && m_bUseLoopingRead && m_nFramesInFile > 0)
+    {
+        size_t numBytes = std::min((blockSize - filled), ((size_t) m_nFramesInFile * m_nFrameSize));
+
+        numRead = m_asyncIO.readAsync((pBlock + filled), numBytes, 0).get();
+
+        if (numRead <= 0)
+            break;
+
+        filled += (size_t) numRead;
+
+        m_lReadAheadPos = (unsigned long) numRead;
+    }
+
+    if (filled < blockSize)
+        memset((pBlock + filled), 0, (blockSize - filled));
+
+    std::swap(m_pFramebuffer, m_pReadAheadBuffer);
+
+    m_nBlockFrames     = (unsigned int) (filled / m_nFrameSize);
+    m_nCurrentFrameIdx = 0;
+    m_nCurrentFrame   += m_nBlockFrames;
+    m_lCurrentFilePos  = m_lReadAheadPos;
+    m_lastChlRead      = -1;
+
+    startReadAhead();
+
+    return (m_nBlockFrames > 0);
+}
+
+
+/// Read-ahead: copy frames out of the current block(s)
+bool CRawAudioFileIO::readAheadFrames(void *pData, const unsigned int numFrames)
+{
+    auto pTrgt = (uint8_t *) pData;
+
+    unsigned int copied = 0;
+
+    while (copied < numFrames)
+    {
+        unsigned int count = std::min((numFrames - copied), (m_nBlockFrames - m_nCurrentFrameIdx));
+
+        memcpy
+        (
+            (pTrgt + ((size_t) copied * m_nFrameSize)),
+            (((uint8_t *) m_pFramebuffer) + ((size_t) m_nCurrentFrameIdx * m_nFrameSize)),
+            ((size_t) count * m_nFrameSize)
+        );
+
+        copied             += count;
+        m_nCurrentFrameIdx += count;
+
+        if (m_nCurrentFrameIdx >= (int) m_nBlockFrames && !swapReadAheadBlock())
+            break;
+    }
+
+    /// zero out/pad the rest of the frames (past the end of the file)
+    if (copied < numFrames)
+        memset((pTrgt + ((size_t) copied * m_nFrameSize)), 0, ((size_t) (numFrames - copied) * m_nFrameSize));
+
+    return (copied > 0);
 }
 
 
@@ -1150,6 +1411,17 @@ bool CRawAudioFileIO::nextFrame()
     if (m_pFramebuffer == nullptr)
         return false;
 
+    if (m_pReadAheadBuffer != nullptr)
+    {
+        m_nCurrentFrameIdx++;
+
+        /// At the end of the block, swap in the next one (already read)
+        if (m_nCurrentFrameIdx >= (int) m_nBlockFrames)
+            return swapReadAheadBlock();
+
+        return true;
+    }
+
     if (m_nIoBlockSize < 1)
     {
         m_nCurrentFrameIdx = 0;
@@ -1240,6 +1512,22 @@ bool CRawAudioFileIO::setCurrentFrame(unsigned int frameNum)
     if (newFilePos >= m_lFileSize)
         return false;
 
+    if (m_pReadAheadBuffer != nullptr)
+    {
+        /// Let the read in flight finish (into the buffer), then
+        /// restart the read-ahead at the new position.
+        if (m_readAheadResult.valid())
+            m_readAheadResult.wait();
+
+        m_readAheadResult = std::future<int64_t>();
+        m_lReadAheadPos   = newFilePos;
+
+        if (!startReadAhead())
+            return false;
+
+        return swapReadAheadBlock();
+    }
+
     if (!m_fileIO.setFilePosition(newFilePos))
     {
         return false;
@@ -1274,6 +1562,9 @@ CWavFileIO::CWavFileIO(const unsigned int numChannels) :
 
 #ifndef USE_DR_WAV
     m_blockSize = 0;
+
+    m_nBufferedFrame  = 0;
+    m_nBufferedFrames = 0;
 #endif
 
     m_nCurrentFrameIdx       = 0;
@@ -1295,6 +1586,9 @@ CWavFileIO::CWavFileIO(const unsigned int numChannels, const std::string &sFileP
 
 #ifndef USE_DR_WAV
     m_blockSize              = 0;
+
+    m_nBufferedFrame         = 0;
+    m_nBufferedFrames        = 0;
 #endif
 
     m_nCurrentFrameIdx       = 0;
@@ -1343,37 +1637,50 @@ bool CWavFileIO::openFile(const eFileIoMode_def mode, const std::string &sFilePa
         case eFileIoMode_input:
             {
 #ifndef USE_DR_WAV
-                LogTrace("loading WAV file for input");
+                LogTrace("opening WAV file for input");
 
-                auto status = m_audioFile.load(m_sFilePath);
-                if (!status)
+                /// Only the header is read here, the frames are read from
+                /// the file (a block at a time) as they are needed, rather
+                /// than loading the whole file into 'm_audioFile'.
+                if (!m_wavReader.openFile(m_sFilePath))
                 {
-                    LogDebug("audiofile load failed");
+                    LogDebug("WAV input file open failed:{}, file:{}", m_wavReader.getLastErrorText(), m_sFilePath);
                     return false;
                 }
 
-                if (m_audioFile.getNumSamplesPerChannel() < 1)
+                const SWavFormat &format = m_wavReader.getFormat();
+
+                std::string sError;
+
+                if (m_wavReader.getNumFrames() < 1)
+                    sError = "audiofile does not contain AT LEAST 1 frame";
+                else if (m_numChls != format.numChannels)
+                    sError = "bad audiofile num Channels";
+                else if (m_sampleRate != 0 && m_sampleRate != format.sampleRate)
+                    sError = "bad audiofile sample rate";
+
+                if (sError.empty())
                 {
-                    LogDebug("audiofile does not contain AT LEAST 1 frame");
-                    return false;
+                    /// Frame buffer for readSample(), 1 frame or 'm_nIoBlockSize' frames
+                    size_t sampleSize = ((m_nBitsPerSample == 8) ? sizeof(int8_t) : ((m_nBitsPerSample == 16) ? sizeof(int16_t) : sizeof(int32_t)));
+
+                    m_pFramebuffer    = calloc((m_numChls * sampleSize), std::max(1, m_nIoBlockSize));
+
+                    if (m_pFramebuffer == nullptr)
+                        sError = "invalid frame buffer pointer";
                 }
 
-                if (m_numChls != (unsigned int)m_audioFile.getNumChannels())
+                if (!sError.empty())
                 {
-                    LogDebug("bad audiofile num Channels");
+                    LogDebug("{}", sError);
+                    m_wavReader.closeFile();
                     return false;
                 }
 
-                if (m_sampleRate != 0)
-                {
-                    if (m_sampleRate != (unsigned int)m_audioFile.getSampleRate())
-                    {
-                        LogDebug("bad audiofile sample rate");
-                        return false;
-                    }
-                }
+                m_nBufferedFrame  = 0;
+                m_nBufferedFrames = 0;
 
-                m_nFramesInFile = m_audioFile.getNumSamplesPerChannel();
+                m_nFramesInFile   = (long) m_wavReader.getNumFrames();
 #else
                 LogTrace("loading WAV file for input");
                 if (!drwav_init_file(&m_audioFile, m_sFilePath.c_str(), nullptr))
@@ -1432,10 +1739,35 @@ bool CWavFileIO::openFile(const eFileIoMode_def mode, const std::string &sFilePa
 #ifndef USE_DR_WAV
                 LogTrace("opening WAV file for output");
 
-                m_audioFile.setNumChannels(m_numChls);
-                if (m_sampleRate != 0)
-                    m_audioFile.setSampleRate(m_sampleRate);
+                /// Stream the frames to the file, rather than keeping the
+                /// whole recording in 'm_audioFile' and re-saving it.
+                SWavFormat format;
+
+                format.numChannels   = m_numChls;
+                format.sampleRate    = ((m_sampleRate != 0) ? m_sampleRate : (unsigned int) m_audioFile.getSampleRate());
+                format.bitsPerSample = (unsigned int) m_nBitsPerSample;
+
+                /// Update the header sizes about once a second
+                /// (or for each write, if "WriteFileForEachFrame").
+                m_wavWriter.setCheckpointInterval(m_bWriteFileForEachFrame ? 1 : format.sampleRate);
+
+                if (!m_wavWriter.openFile(m_sFilePath, format, ((m_eFileType == eFileType_wav) ? eWavContainer_wav : eWavContainer_aiff)))
+                {
+                    LogDebug("WAV output file open failed:{}, file:{}", m_wavWriter.getLastErrorText(), m_sFilePath);
+                    return false;
+                }
+
+                /// Frame buffer for writeSample(), 1 frame or 'm_nIoBlockSize' frames
+                m_pFramebuffer = calloc(format.getFrameSize(), std::max(1, m_nIoBlockSize));
 
+                if (m_pFramebuffer == nullptr)
+                {
+                    LogDebug("invalid frame buffer pointer");
+                    m_wavWriter.closeFile();
+                    return false;
+                }
+
+                m_nFramesInFile = 0;
 #else
                 LogTrace("opening WAV file for output");
 
@@ -1569,23 +1901,42 @@ bool CWavFileIO::openFile(const eFileIoMode_def mode, const std::string &sFilePa
 
 /**
 @note For "wav" and "aiff" files.
-The data is ONLY written to the disk file when the file is closed unless m_bWriteFileForEachFrame = true
+Output files are streamed to disk, closing the file writes any frames
+still in the frame buffer and updates the header sizes.
 */
 bool CWavFileIO::closeFile()
 {
     LogTrace("file being closed");
 
+    bool status = true;
+
     if (m_bFileOpened)
     {
 #ifndef USE_DR_WAV
-        if (m_eMode == eFileIoMode_output || m_eMode == eFileIoMode_IO)
+        if (m_wavReader.isOpen())
+        {
+            m_wavReader.closeFile();
+        }
+        else if (m_wavWriter.isOpen())
+        {
+            /// Write the rest of a (partly filled) block
+            if (m_nIoBlockSize > 0 && m_nCurrentFrameIdx > 0)
+                status = m_wavWriter.writeFrames(m_pFramebuffer, (unsigned int) m_nCurrentFrameIdx);
+
+            if (!m_wavWriter.closeFile())
+                status = false;
+
+            if (!status)
+                LogDebug("WAV output file close failed:{}", m_wavWriter.getLastErrorText());
+        }
+        else if (m_eMode == eFileIoMode_IO)
         {
             if (m_eFileType == eFileType_wav)
                 m_audioFile.save(m_sFilePath, AudioFileFormat::Wave);
             else
                 m_audioFile.save(m_sFilePath, AudioFileFormat::Aiff);
         }
-#else
+#endif
         try
         {
             if (m_pFramebuffer != nullptr)
@@ -1600,15 +1951,15 @@ bool CWavFileIO::closeFile()
         {
             ;
         }
-#endif
     }
 
-    m_nIoCntr       = -1;
-    m_nCurrentFrame = -1;
-    m_eMode         = eFileIoMode_def::eFileIoMode_unknown;
-    m_bFileOpened   = false;
+    m_nIoCntr          = -1;
+    m_nCurrentFrame    = -1;
+    m_nCurrentFrameIdx = 0;
+    m_eMode            = eFileIoMode_def::eFileIoMode_unknown;
+    m_bFileOpened      = false;
 
-    return true;
+    return status;
 }
 
 
@@ -1641,7 +1992,10 @@ void CWavFileIO::setBlockSize(const unsigned int blockSize)
 int CWavFileIO::getSampleRate()
 {
 #ifndef USE_DR_WAV
-    m_sampleRate = (unsigned int)m_audioFile.getSampleRate();
+    if (m_wavReader.isOpen())
+        m_sampleRate = m_wavReader.getFormat().sampleRate;
+    else
+        m_sampleRate = (unsigned int)m_audioFile.getSampleRate();
 #else
     m_sampleRate  = (unsigned int)m_audioFile.sampleRate;
 #endif
@@ -1653,7 +2007,10 @@ int CWavFileIO::getSampleRate()
 int CWavFileIO::getNumChannels()
 {
 #ifndef USE_DR_WAV
-    m_numChls = (unsigned int)m_audioFile.getNumChannels();
+    if (m_wavReader.isOpen())
+        m_numChls = m_wavReader.getFormat().numChannels;
+    else
+        m_numChls = (unsigned int)m_audioFile.getNumChannels();
 #else
     m_numChls = (unsigned int)m_audioFile.channels;
 #endif
@@ -1665,6 +2022,12 @@ int CWavFileIO::getNumChannels()
 int CWavFileIO::getNumFrames() const
 {
 #ifndef USE_DR_WAV
+    if (m_eMode == eFileIoMode_output)
+        return (int)m_wavWriter.getNumFrames();
+
+    if (m_eMode == eFileIoMode_input)
+        return (int)m_wavReader.getNumFrames();
+
     return (int)m_audioFile.getNumSamplesPerChannel();
 #else
     return (int)m_audioFile.totalPCMFrameCount;
@@ -1693,7 +2056,7 @@ bool CWavFileIO::readSample(int16_t &data, const unsigned int chl)
         return false;
 
 #ifndef USE_DR_WAV
-    auto totalNumFrames = m_audioFile.getNumSamplesPerChannel();
+    auto totalNumFrames = (m_wavReader.isOpen() ? (long) m_wavReader.getNumFrames() : (long) m_audioFile.getNumSamplesPerChannel());
 #else
     auto totalNumFrames = m_audioFile.totalPCMFrameCount;
 #endif
@@ -1710,9 +2073,19 @@ bool CWavFileIO::readSample(int16_t &data, const unsigned int chl)
     }
 
 #ifndef USE_DR_WAV
-    float   fTmp = m_audioFile.samples[chl][m_nCurrentFrame];
+    if (m_wavReader.isOpen())
+    {
+        if (!bufferFrame())
+            return false;
 
-    int16_t iTmp = ConvertFloatToInt16(fTmp);
+        data = *(((int16_t *) m_pFramebuffer) + ((m_nCurrentFrame - m_nBufferedFrame) * m_numChls) + chl);
+    }
+    else
+    {
+        float fTmp = m_audioFile.samples[chl][m_nCurrentFrame];
+
+        data = ConvertFloatToInt16(fTmp);
+    }
 
     if ((int)chl != m_lastChlRead)
     {
@@ -1764,7 +2137,7 @@ bool CWavFileIO::readSample(int32_t &data, const unsigned int chl)
         return false;
 
 #ifndef USE_DR_WAV
-    auto totalNumFrames = m_audioFile.getNumSamplesPerChannel();
+    auto totalNumFrames = (m_wavReader.isOpen() ? (long) m_wavReader.getNumFrames() : (long) m_audioFile.getNumSamplesPerChannel());
 #else
     auto totalNumFrames = m_audioFile.totalPCMFrameCount;
 #endif
@@ -1781,9 +2154,19 @@ bool CWavFileIO::readSample(int32_t &data, const unsigned int chl)
     }
 
 #ifndef USE_DR_WAV
-    float   fTmp = m_audioFile.samples[chl][m_nCurrentFrame];
+    if (m_wavReader.isOpen())
+    {
+        if (!bufferFrame())
+            return false;
 
-    int16_t iTmp = ConvertFloatToInt16(fTmp);
+        data = *(((int32_t *) m_pFramebuffer) + ((m_nCurrentFrame - m_nBufferedFrame) * m_numChls) + chl);
+    }
+    else
+    {
+        float fTmp = m_audioFile.samples[chl][m_nCurrentFrame];
+
+        data = (int32_t) ((double) fTmp * 0x7FFFFFFF);
+    }
 
     if ((int)chl != m_lastChlRead)
     {
@@ -1831,18 +2214,34 @@ bool CWavFileIO::getSamples(void *pData, unsigned int numFrames)
 {
 #ifndef USE_DR_WAV
 
-    unsigned int readOffset = 0;
-    for (unsigned int i = 0; i < numFrames; i++)
+    if (m_wavReader.isOpen())
     {
-        for (unsigned int chl = 0; chl < m_numChls; chl++)
-        {
-            int16_t iTmp  = 
-                ConvertFloatToInt16(m_audioFile.samples[chl][m_nCurrentFrame + i]);
-            
-            *((int16_t *) pData + readOffset++) = iTmp;
-        }
+        /// Read (and convert) the frames straight from the file
+        if (!m_wavReader.setCurrentFrame((uint64_t) m_nCurrentFrame))
+            return false;
+
+        return (m_wavReader.readFrames(pData, numFrames, (unsigned int) m_nBitsPerSample) == numFrames);
     }
 
+    if (m_eMode != eFileIoMode_IO)
+        return false;
+
+    /// Convert each (float) channel to int16 a block at a time,
+    /// then interleave the channels into the output frames.
+    m_convertBuffer.resize(numFrames * m_numChls);
+
+    for (unsigned int chl = 0; chl < m_numChls; chl++)
+    {
+        convertFloatToS16
+            (
+                (m_convertBuffer.data() + (chl * numFrames)), 
+                (m_audioFile.samples[chl].data() + m_nCurrentFrame), 
+                numFrames
+            );
+    }
+
+    interleaveSamples((int16_t *) pData, m_convertBuffer.data(), numFrames, m_numChls, numFrames);
+
 #else
 
     drwav_uint64 framesRead = 0;
@@ -1920,24 +2319,11 @@ bool CWavFileIO::readBlock(void *pData, const unsigned int numFrames)
                 return false;
             }
 
-            auto nPadSize = 0;
+            // (m_nFrameSize is in bytes, for any sample size)
 
-            void *pPadStart = nullptr;
+            auto nPadSize = ((numFrames - nFramesLeftInFile) * m_nFrameSize);
 
-            if (m_nBitsPerSample == 16)
-            {
-                nPadSize = ((numFrames - nFramesLeftInFile) * m_nFrameSize * sizeof(int16_t));
-                pPadStart = (void *) (((int16_t *) pData) + (nFramesLeftInFile * m_nFrameSize));
-            }
-            else if (m_nBitsPerSample == 32)
-            {
-                nPadSize = ((numFrames - nFramesLeftInFile) * m_nFrameSize * sizeof(int32_t));
-                pPadStart = (void *) (((int32_t *) pData) + (nFramesLeftInFile * m_nFrameSize));
-            }
-            else
-            {
-                return false;
-            }
+            void *pPadStart = (void *) (((uint8_t *) pData) + (nFramesLeftInFile * m_nFrameSize));
 
             memset(pPadStart, 0, nPadSize);
 
@@ -1957,7 +2343,8 @@ bool CWavFileIO::readBlock(void *pData, const unsigned int numFrames)
 
         nReadSize = (numFrames - nFramesLeftInFile);
 
-        status = getSamples(pData, nReadSize);
+        /// (after the frames read from the end of the file)
+        status = getSamples((void *) (((uint8_t *) pData) + (std::max(0L, nFramesLeftInFile) * m_nFrameSize)), nReadSize);
     }
     else
     {
@@ -1993,15 +2380,24 @@ bool CWavFileIO::writeSample(const int16_t data, const unsigned int chl)
     }
 
 #ifndef USE_DR_WAV
-    float fTmp = ConvertInt16ToFloat(data);
+    if (m_wavWriter.isOpen())
+    {
+        /// (written to the file by nextFrame())
+        if (!putFrameSample(&data, chl))
+            return false;
+    }
+    else
+    {
+        float fTmp = ConvertInt16ToFloat(data);
 
-    if ((int)m_audioFile.samples.size() <= (int)chl)
-        m_audioFile.samples.resize(chl + 1);
+        if ((int)m_audioFile.samples.size() <= (int)chl)
+            m_audioFile.samples.resize(chl + 1);
 
-    if ((int)m_audioFile.samples[chl].size() <= (int)m_nCurrentFrame)
-        m_audioFile.samples[chl].resize(m_nCurrentFrame + 1);
+        if ((int)m_audioFile.samples[chl].size() <= (int)m_nCurrentFrame)
+            m_audioFile.samples[chl].resize(m_nCurrentFrame + 1);
 
-    m_audioFile.samples[chl][m_nCurrentFrame] = fTmp;
+        m_audioFile.samples[chl][m_nCurrentFrame] = fTmp;
+    }
 #else
     if (m_pFramebuffer == nullptr)
         return false;
@@ -2050,15 +2446,24 @@ bool CWavFileIO::writeSample(const int32_t data, const unsigned int chl)
     }
 
 #ifndef USE_DR_WAV
-    float fTmp = ConvertInt16ToFloat(data);
+    if (m_wavWriter.isOpen())
+    {
+        /// (written to the file by nextFrame())
+        if (!putFrameSample(&data, chl))
+            return false;
+    }
+    else
+    {
+        float fTmp = ConvertInt16ToFloat(data);
 
-    if ((int)m_audioFile.samples.size() <= (int)chl)
-        m_audioFile.samples.resize(chl + 1);
+        if ((int)m_audioFile.samples.size() <= (int)chl)
+            m_audioFile.samples.resize(chl + 1);
 
-    if ((int)m_audioFile.samples[chl].size() <= (int)m_nCurrentFrame)
-        m_audioFile.samples[chl].resize(m_nCurrentFrame + 1);
+        if ((int)m_audioFile.samples[chl].size() <= (int)m_nCurrentFrame)
+            m_audioFile.samples[chl].resize(m_nCurrentFrame + 1);
 
-    m_audioFile.samples[chl][m_nCurrentFrame] = fTmp;
+        m_audioFile.samples[chl][m_nCurrentFrame] = fTmp;
+    }
 #else
     if (m_pFramebuffer == nullptr)
         return false;
@@ -2116,37 +2521,50 @@ bool CWavFileIO::writeBlock(const void *pData, const unsigned int numFrames)
         return false;
 
 #ifndef USE_DR_WAV
-    unsigned int writeOffset = 0;
-    for (unsigned int i = 0; i < numFrames; i++)
+    if (m_wavWriter.isOpen())
     {
-        for (unsigned int chl = 0; chl < m_numChls; chl++)
+        /// Append the frames to the file (the header
+        /// is updated at checkpoints and on close).
+        if (!m_wavWriter.writeFrames(pData, numFrames))
         {
-            if (((int16_t *) pData + writeOffset) == nullptr)
-            {
-                LogTrace("write with invalid data input pointer value (pData + {})", writeOffset);
-                m_audioFile.samples[chl][m_nCurrentFrame + i] = 0;
-            }
-            else
-            {
-                int16_t iTmp = *((int16_t*) pData + writeOffset++);
-
-                m_audioFile.samples[chl][m_nCurrentFrame + i] = ConvertInt16ToFloat(iTmp);
-            }
+            LogDebug("WAV write failed:{}", m_wavWriter.getLastErrorText());
+            return false;
         }
     }
-
-    m_nFramesInFile += numFrames;
-    if (m_bWriteFileForEachFrame || m_nCurrentFrameIdx >= m_nIoBlockSize)
+    else
     {
-        if (m_eMode == eFileIoMode_output || m_eMode == eFileIoMode_IO)
+        /// De-interleave the input frames, then convert each
+        /// channel to float a block at a time.
+        m_convertBuffer.resize(numFrames * m_numChls);
+
+        deinterleaveSamples(m_convertBuffer.data(), numFrames, (const int16_t *) pData, m_numChls, numFrames);
+
+        for (unsigned int chl = 0; chl < m_numChls; chl++)
         {
-            if (m_eFileType == eFileType_wav)
-                m_audioFile.save(m_sFilePath, AudioFileFormat::Wave);
-            else
-                m_audioFile.save(m_sFilePath, AudioFileFormat::Aiff);
+            if (m_audioFile.samples[chl].size() < (size_t) (m_nCurrentFrame + numFrames))
+                m_audioFile.samples[chl].resize(m_nCurrentFrame + numFrames);
+
+            convertS16ToFloat
+                (
+                    (m_audioFile.samples[chl].data() + m_nCurrentFrame), 
+                    (m_convertBuffer.data() + (chl * numFrames)), 
+                    numFrames
+                );
         }
 
-        m_nFramesInFile = 0;
+        m_nFramesInFile += numFrames;
+        if (m_bWriteFileForEachFrame || m_nCurrentFrameIdx >= m_nIoBlockSize)
+        {
+            if (m_eMode == eFileIoMode_output || m_eMode == eFileIoMode_IO)
+            {
+                if (m_eFileType == eFileType_wav)
+                    m_audioFile.save(m_sFilePath, AudioFileFormat::Wave);
+                else
+                    m_audioFile.save(m_sFilePath, AudioFileFormat::Aiff);
+            }
+
+            m_nFramesInFile = 0;
+        }
     }
 #else
     drwav_uint64 framesWritten = 0;
@@ -2163,6 +2581,49 @@ bool CWavFileIO::writeBlock(const void *pData, const unsigned int numFrames)
 }
 
 
+#ifndef USE_DR_WAV
+/// Store a sample in the frame buffer (written to the file by nextFrame())
+bool CWavFileIO::putFrameSample(const void *pSample, const unsigned int chl)
+{
+    if (m_pFramebuffer == nullptr)
+        return false;
+
+    int frameIdx = ((m_nIoBlockSize < 1) ? 0 : m_nCurrentFrameIdx);
+
+    if (m_nIoBlockSize > 0 && frameIdx >= m_nIoBlockSize)
+        return false;
+
+    size_t sampleSize = (size_t) (m_nBitsPerSample / 8);
+
+    memcpy((((uint8_t *) m_pFramebuffer) + ((((size_t) frameIdx * m_numChls) + chl) * sampleSize)), pSample, sampleSize);
+
+    return true;
+}
+
+
+/// Make sure the current (input) frame is in the frame buffer,
+/// reading the next 1 frame or 'm_nIoBlockSize' frames if not.
+bool CWavFileIO::bufferFrame()
+{
+    if (m_pFramebuffer == nullptr)
+        return false;
+
+    if (m_nCurrentFrame >= m_nBufferedFrame && m_nCurrentFrame < (m_nBufferedFrame + (long) m_nBufferedFrames))
+        return true;
+
+    m_nBufferedFrames = 0;
+    m_nBufferedFrame  = m_nCurrentFrame;
+
+    if (!m_wavReader.setCurrentFrame((uint64_t) m_nCurrentFrame))
+        return false;
+
+    m_nBufferedFrames = m_wavReader.readFrames(m_pFramebuffer, (unsigned int) std::max(1, m_nIoBlockSize), (unsigned int) m_nBitsPerSample);
+
+    return (m_nBufferedFrames > 0);
+}
+#endif
+
+
 /// Move to next input/output frame
 bool CWavFileIO::nextFrame()
 {
@@ -2182,12 +2643,11 @@ bool CWavFileIO::nextFrame()
 
         case eFileIoMode_output:
             {
+                /// Append the frame (or the block, once it is full)
                 if (m_nIoBlockSize < 1)
                 {
-                    if (m_eFileType == eFileType_wav)
-                        m_audioFile.save(m_sFilePath, AudioFileFormat::Wave);
-                    else
-                        m_audioFile.save(m_sFilePath, AudioFileFormat::Aiff);
+                    if (!m_wavWriter.writeFrames(m_pFramebuffer, 1))
+                        return false;
                 }
                 else
                 {
@@ -2195,10 +2655,8 @@ bool CWavFileIO::nextFrame()
 
                     if (m_nCurrentFrameIdx >= m_nIoBlockSize)
                     {
-                        if (m_eFileType == eFileType_wav)
-                            m_audioFile.save(m_sFilePath, AudioFileFormat::Wave);
-                        else
-                            m_audioFile.save(m_sFilePath, AudioFileFormat::Aiff);
+                        if (!m_wavWriter.writeFrames(m_pFramebuffer, m_nIoBlockSize))
+                            return false;
 
                         m_nCurrentFrameIdx = 0;
                     }
@@ -2212,7 +2670,11 @@ bool CWavFileIO::nextFrame()
     }
 
     m_nCurrentFrame++;
-    m_nFramesInFile++;
+
+    if (m_eMode == eFileIoMode_output)
+        m_nFramesInFile++;
+    else if (isEOF() == true && m_bUseLoopingRead == false)
+        return false;
 #else
     if (m_pFramebuffer == nullptr)
         return false;
@@ -2293,7 +2755,7 @@ bool CWavFileIO::setCurrentFrame(unsigned int frameNum)
         return false;
 
 #ifndef USE_DR_WAV
-    auto totalNumFrames = m_audioFile.getNumSamplesPerChannel();
+    auto totalNumFrames = (m_wavReader.isOpen() ? (long) m_wavReader.getNumFrames() : (long) m_audioFile.getNumSamplesPerChannel());
 #else
     auto totalNumFrames = m_audioFile.totalPCMFrameCount;
 #endif
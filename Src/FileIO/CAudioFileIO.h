@@ -31,11 +31,16 @@ COMPILE_ERROR("ERRORL: C++17 not supported")
 
 
 #include "CFileIO.h"
+#include "CAsyncFileIO.h"
+#include "CWavStreamReader.h"
+#include "CWavStreamWriter.h"
 
 #include <string>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <vector>
 
 
 enum eAudioFileType_def
@@ -97,6 +102,9 @@ eAudioFileType_def getAudioFileType(const std::string &filepath);
 
 #define ConvertFloatToInt16(fSample)  ((int16_t)(fSample * 0x7FFF))
 
+/// Default I/O block size for read-ahead (if no block size is set)
+#define RAW_AUDIO_READ_AHEAD_BLOCK_BYTES    (256 * 1024)
+
 
 class CAudioFileIO
 {
@@ -232,6 +240,14 @@ class CRawAudioFileIO :
   private:
 
     CFileIO         m_fileIO;
+    CAsyncFileIO    m_asyncIO;              ///< the file, when write-behind / read-ahead is on
+    unsigned int    m_nAsyncWriteDepth;     ///< max. writes in flight (0 = write-behind off)
+    bool            m_bReadAhead;           ///< read the next I/O block while this one is used
+    void            *m_pReadAheadBuffer;    ///< (read-ahead) the next I/O block
+    std::future<int64_t> m_readAheadResult; ///< (read-ahead) the read into m_pReadAheadBuffer
+    unsigned long   m_lReadAheadPos;        ///< (read-ahead) file offset of that read
+    unsigned int    m_nReadAheadFrames;     ///< (read-ahead) frames in each I/O block
+    unsigned int    m_nBlockFrames;         ///< (read-ahead) frames of file data in m_pFramebuffer
     void            *m_pFramebuffer;
     unsigned long   m_lFileSize;
     unsigned long   m_lCurrentFilePos;
@@ -243,6 +259,14 @@ class CRawAudioFileIO :
 
     int getNumericStringAt(const std::string &sText, const unsigned int pos);
 
+    bool writeFrames(const void *pData, unsigned int numFrames);
+
+    bool startReadAhead();
+
+    bool swapReadAheadBlock();
+
+    bool readAheadFrames(void *pData, unsigned int numFrames);
+
   public:
 
     CRawAudioFileIO(unsigned int numChannels);
@@ -253,6 +277,17 @@ class CRawAudioFileIO :
 
     void createInfoTextFile(bool value);
 
+    /// Write-behind: let up to "numRequests" block writes be in flight,
+    /// so writeBlock() does not wait for the disk (0 = off, the default).
+    /// Set before openFile().
+    void setAsyncWriteDepth(unsigned int numRequests);
+
+    /// Read-ahead: read the next I/O block (in the background) while
+    /// the current one is used, so nextFrame() only swaps buffers at
+    /// a block boundary.  If no I/O block size is set, it uses
+    /// RAW_AUDIO_READ_AHEAD_BLOCK_BYTES.  Set before openFile().
+    void setReadAhead(bool value);
+
     bool parseInfoTextFile(const std::string &sFile, SRawFileInfo &info);
 
     bool openFile(eFileIoMode_def mode, const std::string &sFilePath) override;
@@ -290,7 +325,15 @@ class CWavFileIO :
 #ifndef USE_DR_WAV
     AudioFile<float> m_audioFile;
 
+    CWavStreamReader m_wavReader;           /// Input files are read from disk a block at a time (constant memory)
+    CWavStreamWriter m_wavWriter;           /// Output files are streamed to disk (constant memory)
+
+    long         m_nBufferedFrame;          /// First (input) frame in the frame buffer
+    unsigned int m_nBufferedFrames;         /// Number of (input) frames in the frame buffer
+
     unsigned int m_blockSize;
+
+    std::vector<int16_t> m_convertBuffer;   /// Non-interleaved int16 samples, for block I/O
 #else
     drwav       m_audioFile{};
 #endif
@@ -306,6 +349,12 @@ class CWavFileIO :
 
     bool getSamples(void *pData, unsigned int numFrames);
 
+#ifndef USE_DR_WAV
+    bool putFrameSample(const void *pSample, unsigned int chl);
+
+    bool bufferFrame();
+#endif
+
   public:
 
     CWavFileIO(unsigned int numChannels);
@@ -317,8 +366,11 @@ class CWavFileIO :
     bool openFile(eFileIoMode_def mode, const std::string &sFilePath) override;
 
    ///  @note For "wav" and "aiff" files.
-   ///  The data is ONLY written to the disk file when the 
-   ///  file is closed unless m_bWriteFileForEachFrame = true.
+   ///  Input files are not loaded, the frames are read (and converted
+   ///  to m_nBitsPerSample samples) as they are needed.
+   ///  Output files are written as the frames arrive, the header
+   ///  sizes are updated about once a second (or for each write if
+   ///  m_bWriteFileForEachFrame = true) and when the file is closed.
 
     bool closeFile() override;
 
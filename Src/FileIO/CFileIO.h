@@ -3,6 +3,19 @@
 //
 // DESC:    C++ file input/output class 
 //
+//          eFileIoMode_mappedInput opens the file read only and maps it
+//          into memory, so reads are served from the mapping (no read /
+//          tell syscalls), and the data can be used in place:
+//
+//              file.openFile(eFileIoMode_mappedInput, sPath);
+//              file.adviseAccess(eFileAccess_sequential);
+//
+//              auto pFrame = file.view(offset, frameSize);     // no copy
+//
+//              std::string_view sLine;
+//              while (file.nextLine(sLine))                   // no copy
+//                  ...
+//
 // AUTHOR:  Russ Barker
 //
 
@@ -13,13 +26,32 @@
 #ifndef _CFILEIO_H
 #define _CFILEIO_H
 
+#include <algorithm>
 #include <locale>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX                // (keep std::min / std::max usable)
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 #define MAX_LINE_IO_SIZE        1024
 
@@ -36,7 +68,19 @@ enum eFileIoMode_def
     eFileIoMode_input,
     eFileIoMode_output,
     eFileIoMode_IO,
-    eFileIoMode_append
+    eFileIoMode_append,
+    eFileIoMode_mappedInput         // read only, memory mapped
+};
+
+
+// Access pattern hints for a mapped file (see adviseAccess())
+enum eFileAccessHint_def
+{
+    eFileAccess_normal = 0,
+    eFileAccess_sequential,         // read ahead aggressively, drop pages once read
+    eFileAccess_random,             // no read ahead
+    eFileAccess_willNeed,           // start reading the range in now
+    eFileAccess_dontNeed            // the range can be dropped from memory
 };
 
 
@@ -57,6 +101,122 @@ class CFileIO
     bool            m_bBinary;
     long            m_lCurrFilePos;
 
+    std::vector<char>   m_lineBuffer;       // readLine() input buffer
+
+    // eFileIoMode_mappedInput
+    bool                m_bMapped;
+    const unsigned char *m_pMappedData;     // nullptr for an empty file
+    size_t              m_nMappedSize;
+    size_t              m_nMappedPos;       // read position
+#ifdef WINDOWS
+    HANDLE              m_hFileMapping;
+#endif
+
+    // Map the (open) file into memory
+    bool mapFile()
+    {
+        m_pMappedData = nullptr;
+        m_nMappedSize = 0;
+        m_nMappedPos  = 0;
+
+#ifdef WINDOWS
+        HANDLE hFile = (HANDLE) _get_osfhandle(_fileno(m_pFileHandle));
+
+        LARGE_INTEGER fileSize;
+
+        if (GetFileSizeEx(hFile, &fileSize) == FALSE)
+        {
+            m_sLastErrorStr = "File 'size' operation failed";
+            m_nLastErrorNum = (int) GetLastError();
+
+            return false;
+        }
+
+        m_nMappedSize = (size_t) fileSize.QuadPart;
+
+        if (m_nMappedSize > 0)
+        {
+            m_hFileMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+            if (m_hFileMapping == nullptr)
+            {
+                m_sLastErrorStr = "File 'map' operation failed";
+                m_nLastErrorNum = (int) GetLastError();
+
+                return false;
+            }
+
+            m_pMappedData = (const unsigned char *) MapViewOfFile(m_hFileMapping, FILE_MAP_READ, 0, 0, 0);
+
+            if (m_pMappedData == nullptr)
+            {
+                m_sLastErrorStr = "File 'map' operation failed";
+                m_nLastErrorNum = (int) GetLastError();
+
+                CloseHandle(m_hFileMapping);
+                m_hFileMapping = nullptr;
+
+                return false;
+            }
+        }
+#else
+        int fd = fileno(m_pFileHandle);
+
+        struct stat fileStat;
+
+        if (fstat(fd, &fileStat) != 0)
+        {
+            m_sLastErrorStr = "File 'stat' operation failed";
+            m_nLastErrorNum = errno;
+
+            return false;
+        }
+
+        m_nMappedSize = (size_t) fileStat.st_size;
+
+        if (m_nMappedSize > 0)
+        {
+            void *pMap = mmap(nullptr, m_nMappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (pMap == MAP_FAILED)
+            {
+                m_sLastErrorStr = "File 'mmap' operation failed";
+                m_nLastErrorNum = errno;
+
+                m_nMappedSize = 0;
+
+                return false;
+            }
+
+            m_pMappedData = (const unsigned char *) pMap;
+        }
+#endif
+
+        m_bMapped = true;
+
+        return true;
+    }
+
+    void unmapFile()
+    {
+        if (m_pMappedData != nullptr)
+        {
+#ifdef WINDOWS
+            UnmapViewOfFile((LPCVOID) m_pMappedData);
+
+            CloseHandle(m_hFileMapping);
+            m_hFileMapping = nullptr;
+#else
+            munmap((void *) m_pMappedData, m_nMappedSize);
+#endif
+        }
+
+        m_bMapped     = false;
+        m_pMappedData = nullptr;
+        m_nMappedSize = 0;
+        m_nMappedPos  = 0;
+    }
+
   public:
 
     explicit CFileIO(const std::string &sFilePath = "") :
@@ -72,6 +232,14 @@ class CFileIO
         m_nLastErrorNum = 0;
         m_bBinary       = false;
         m_lCurrFilePos  = 0;
+
+        m_bMapped       = false;
+        m_pMappedData   = nullptr;
+        m_nMappedSize   = 0;
+        m_nMappedPos    = 0;
+#ifdef WINDOWS
+        m_hFileMapping  = nullptr;
+#endif
     }
 
     ~CFileIO()
@@ -240,6 +408,12 @@ class CFileIO
                 }
                 break;
 
+            case eFileIoMode_def::eFileIoMode_mappedInput:
+                {
+                    sFileMode = "r";
+                }
+                break;
+
             default:
                 return false;
         }
@@ -254,7 +428,7 @@ class CFileIO
             return false;
         }
 
-        if (m_bBinary)
+        if (m_bBinary || m_eMode == eFileIoMode_def::eFileIoMode_mappedInput)
             sFileMode.append("b");
 
         bool status;
@@ -287,6 +461,14 @@ class CFileIO
             }
 
             m_lCurrFilePos = pos;
+
+            if (m_eMode == eFileIoMode_def::eFileIoMode_mappedInput && mapFile() == false)
+            {
+                fclose(m_pFileHandle);
+                m_pFileHandle = nullptr;
+
+                return false;
+            }
         }
         catch (...)
         {
@@ -311,6 +493,9 @@ class CFileIO
             return false;
         }
 
+        if (m_bMapped == true)
+            unmapFile();
+
         try
         {
             if (fclose(m_pFileHandle) != 0)
@@ -345,6 +530,9 @@ class CFileIO
             return false;
         }
 
+        if (m_bMapped == true)
+            return (long) m_nMappedSize;
+
         long length;
 
         try
@@ -377,9 +565,10 @@ class CFileIO
                 return -1;
             }
 
-            if (fgetpos(m_pFileHandle, &fPos) != 0)
+            // restore the file position
+            if (fsetpos(m_pFileHandle, &fPos) != 0)
             {
-                m_sLastErrorStr = "File 'getpos' call failed";
+                m_sLastErrorStr = "File 'setpos' call failed";
                 m_nLastErrorNum = ferror(m_pFileHandle);
 
                 return -1;
@@ -408,6 +597,9 @@ class CFileIO
             return -1;
         }
 
+        if (m_bMapped == true)
+            return (long) m_nMappedPos;
+
         long pos;
 
         try
@@ -445,6 +637,23 @@ class CFileIO
             return false;
         }
 
+        if (m_bMapped == true)
+        {
+            if (position > m_nMappedSize)
+            {
+                m_sLastErrorStr = "File 'seek' (to position) past the end of the mapped file";
+
+                return false;
+            }
+
+            m_nMappedPos    = (size_t) position;
+            m_lCurrFilePos  = (long) position;
+            m_sLastErrorStr = "";
+            m_nLastErrorNum = 0;
+
+            return true;
+        }
+
         try
         {
             if (fseek(m_pFileHandle, position, SEEK_SET) != 0)
@@ -478,6 +687,9 @@ class CFileIO
             return -1;
         }
 
+        if (m_bMapped == true)
+            return ((m_nMappedPos >= m_nMappedSize) ? 1 : 0);
+
         int retCode = 0;
 
         try
@@ -508,6 +720,29 @@ class CFileIO
             return false;
         }
 
+        if (m_bMapped == true)
+        {
+            std::string_view sLine;
+
+            if (nextLine(sLine, true) == false)
+            {
+                nNumBytesRead = 0;
+
+                m_sLastErrorStr = "File 'fread' operation encountered EOF";
+
+                return false;
+            }
+
+            sInput.assign(sLine.data(), sLine.size());
+
+            nNumBytesRead = m_nLastIoSize;
+
+            m_sLastErrorStr = "";
+            m_nLastErrorNum = 0;
+
+            return true;
+        }
+
         if (m_bBinary == true)
         {
             m_sLastErrorStr = "File readLine called but file is opened in binary mode";
@@ -536,12 +771,11 @@ class CFileIO
 #endif
             int nReadSize = MAX_LINE_IO_SIZE;
 
-            char *pInputBuffer = (char *) calloc(sizeof(char), nReadSize);
+            // (allocated once, not per line)
+            if (m_lineBuffer.size() < (size_t) nReadSize)
+                m_lineBuffer.resize(nReadSize);
 
-            if (pInputBuffer == nullptr)
-            {
-                return false;
-            }
+            char *pInputBuffer = m_lineBuffer.data();
 
             auto status = ::fgets(pInputBuffer, nReadSize, m_pFileHandle);
 
@@ -573,8 +807,6 @@ class CFileIO
                 {
                     m_sLastErrorStr = "File 'fread' operation encountered EOF";
 
-                    free(pInputBuffer);
-
                     return false;
                 }
                 else
@@ -586,8 +818,6 @@ class CFileIO
             else
             {
                 sInput.assign(pInputBuffer);
-
-                free(pInputBuffer);
             }
         }
         catch (...)
@@ -615,6 +845,34 @@ class CFileIO
             return false;
         }
 
+        if (m_bMapped == true)
+        {
+            // copy whole blocks from the mapping (as fread())
+            size_t blocksRead = ((blockSize > 0) ? std::min((size_t) numBlocks, ((m_nMappedSize - m_nMappedPos) / blockSize)) : 0);
+
+            if (blocksRead > 0)
+            {
+                memcpy(pData, (m_pMappedData + m_nMappedPos), (blocksRead * blockSize));
+
+                m_nMappedPos += (blocksRead * blockSize);
+            }
+
+            m_nLastIoSize  = (unsigned int) blocksRead;
+            m_lCurrFilePos = (long) m_nMappedPos;
+
+            if (blocksRead != (size_t) numBlocks)
+            {
+                m_sLastErrorStr = "File 'fread' operation encountered EOF";
+
+                return false;
+            }
+
+            m_sLastErrorStr = "";
+            m_nLastErrorNum = 0;
+
+            return true;
+        }
+
         try
         {
 #ifdef SET_FILE_POSITION_BEFORE_READ
@@ -684,6 +942,137 @@ class CFileIO
         return true;
     }
 
+    // Is the file open in eFileIoMode_mappedInput mode
+    bool isMapped()
+    {
+        return m_bMapped;
+    }
+
+    // Get a (zero copy) view of "len" bytes of a mapped file, starting
+    // at "offset".  The data is valid until the file is closed.
+    // Returns nullptr if the file is not mapped, or the range
+    // is past the end of the file.
+    const unsigned char *view(const size_t offset, const size_t len)
+    {
+        if (m_bMapped == false || m_pMappedData == nullptr || offset > m_nMappedSize || len > (m_nMappedSize - offset))
+        {
+            m_sLastErrorStr = "File view called but the range is not mapped";
+
+            return nullptr;
+        }
+
+        return (m_pMappedData + offset);
+    }
+
+    // As view(), at the current read position, which is then moved
+    // on by "len" bytes (ie: a zero copy readBlock()).
+    const unsigned char *viewNext(const size_t len)
+    {
+        auto pData = view(m_nMappedPos, len);
+
+        if (pData != nullptr)
+        {
+            m_nMappedPos  += len;
+            m_lCurrFilePos = (long) m_nMappedPos;
+            m_nLastIoSize  = (unsigned int) len;
+        }
+
+        return pData;
+    }
+
+    // Tell the OS how (a range of) a mapped file will be read
+    // (len = 0 means to the end of the file).
+    bool adviseAccess(const eFileAccessHint_def eHint, const size_t offset = 0, const size_t len = 0)
+    {
+        if (m_bMapped == false)
+        {
+            m_sLastErrorStr = "File adviseAccess called but file not mapped";
+
+            return false;
+        }
+
+        if (m_pMappedData == nullptr || offset >= m_nMappedSize)
+            return true;
+
+#ifdef WINDOWS
+        // (no equivalent hints for a mapped view)
+        (void) eHint;
+        (void) len;
+#else
+        int nAdvice;
+
+        switch (eHint)
+        {
+            case eFileAccessHint_def::eFileAccess_sequential:   nAdvice = MADV_SEQUENTIAL;  break;
+            case eFileAccessHint_def::eFileAccess_random:       nAdvice = MADV_RANDOM;      break;
+            case eFileAccessHint_def::eFileAccess_willNeed:     nAdvice = MADV_WILLNEED;    break;
+            case eFileAccessHint_def::eFileAccess_dontNeed:     nAdvice = MADV_DONTNEED;    break;
+            default:                                            nAdvice = MADV_NORMAL;      break;
+        }
+
+        // the start of the range must be page aligned
+        size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+        size_t start    = (offset - (offset % pageSize));
+        size_t count    = (((len > 0) ? std::min(len, (m_nMappedSize - offset)) : (m_nMappedSize - offset)) + (offset - start));
+
+        if (madvise((void *) (m_pMappedData + start), count, nAdvice) != 0)
+        {
+            m_sLastErrorStr = "File 'madvise' operation failed";
+            m_nLastErrorNum = errno;
+
+            return false;
+        }
+#endif
+
+        return true;
+    }
+
+    // Get the next line of a mapped file, as a view of the mapping
+    // (no copy, and no line length limit), without the line end
+    // ("\n" or "\r\n") unless bKeepLineEnd.  Returns false at EOF.
+    bool nextLine(std::string_view &sLine, const bool bKeepLineEnd = false)
+    {
+        if (m_bMapped == false)
+        {
+            m_sLastErrorStr = "File nextLine called but file not mapped";
+
+            return false;
+        }
+
+        if (m_nMappedPos >= m_nMappedSize)
+        {
+            sLine = std::string_view();
+
+            m_nLastIoSize = 0;
+
+            return false;
+        }
+
+        auto pStart      = (const char *) (m_pMappedData + m_nMappedPos);
+        size_t remaining = (m_nMappedSize - m_nMappedPos);
+
+        auto pEnd = (const char *) memchr(pStart, '\n', remaining);
+
+        size_t lineLen = ((pEnd != nullptr) ? ((size_t) (pEnd - pStart) + 1) : remaining);
+
+        m_nMappedPos  += lineLen;
+        m_lCurrFilePos = (long) m_nMappedPos;
+        m_nLastIoSize  = (unsigned int) lineLen;
+
+        if (bKeepLineEnd == false)
+        {
+            if (lineLen > 0 && pStart[(lineLen - 1)] == '\n')
+                lineLen--;
+
+            if (lineLen > 0 && pStart[(lineLen - 1)] == '\r')
+                lineLen--;
+        }
+
+        sLine = std::string_view(pStart, lineLen);
+
+        return true;
+    }
+
     bool writeLine(const std::string &sOutput)
     {
         if (m_pFileHandle == nullptr)
@@ -740,6 +1129,26 @@ class CFileIO
         return true;
     }
 
+    // Write any buffered data to the OS
+    bool flush()
+    {
+        if (m_pFileHandle == nullptr)
+        {
+            m_sLastErrorStr = "File flush called but file not open";
+            return false;
+        }
+
+        if (fflush(m_pFileHandle) != 0)
+        {
+            m_sLastErrorStr = "File 'fflush' operation failed";
+            m_nLastErrorNum = ferror(m_pFileHandle);
+
+            return false;
+        }
+
+        return true;
+    }
+
     bool writeBlock(const void *pData, const unsigned int bloclSize, const unsigned int numBlocks)
     {
         if (m_pFileHandle == nullptr)
@@ -590,6 +590,7 @@ CRawVideoFileIO::CRawVideoFileIO() :
     m_lFileSize = 0;
     m_lCurrentFilePos = 0;
     m_bCreateInfoTextFile = false;
+    m_nAsyncWriteDepth = 0;
 }
 
 
@@ -613,6 +614,7 @@ CRawVideoFileIO::CRawVideoFileIO(const unsigned int width, const unsigned int he
     m_lFileSize           	= 0;
     m_lCurrentFilePos     	= 0;
     m_bCreateInfoTextFile 	= false;
+    m_nAsyncWriteDepth    	= 0;
 
     m_fileInfo.width        = m_width;
     m_fileInfo.height       = m_height;
@@ -637,6 +639,7 @@ CRawVideoFileIO::CRawVideoFileIO(const std::string &sFilePath) :
     m_lFileSize           	= 0;
     m_lCurrentFilePos     	= 0;
     m_bCreateInfoTextFile 	= false;
+    m_nAsyncWriteDepth    	= 0;
 }
 
 
@@ -952,8 +955,15 @@ bool CRawVideoFileIO::openFile(const eFileIoMode_def mode, const std::string &sF
 
         case eFileIoMode_output:
             {
-                if (!m_fileIO.openFile(eFileIoMode_output, m_sFilePath))
+                if (m_nAsyncWriteDepth > 0)
+                {
+                    if (!m_asyncIO.openFile(eFileIoMode_output, m_sFilePath, m_nAsyncWriteDepth))
+                        return false;
+                }
+                else if (!m_fileIO.openFile(eFileIoMode_output, m_sFilePath))
+                {
                     return false;
+                }
 
                 m_lFileSize       = 0;
 
@@ -1026,10 +1036,21 @@ bool CRawVideoFileIO::closeFile()
     if (!m_bFileOpened)
         LogDebug("file close called when files is not open");
 
+    bool status = true;
+
     /// close input file
-    if (m_fileIO.isOpen())
+    if (m_fileIO.isOpen() || m_asyncIO.isOpen())
     {
-        if (!m_fileIO.closeFile())
+        if (m_asyncIO.isOpen())
+        {
+            /// (waits for the writes still in flight)
+            if (!m_asyncIO.closeFile())
+            {
+                LogCritical("CRawVideoFileIO - Error: write failed:{} ", m_asyncIO.getLastErrorText());
+                status = false;
+            }
+        }
+        else if (!m_fileIO.closeFile())
         {
             LogCritical("CRawVideoFileIO - Error: unable to close file ");
             return false;
@@ -1057,7 +1078,7 @@ bool CRawVideoFileIO::closeFile()
     m_eMode            = eFileIoMode_def::eFileIoMode_unknown;
     m_bFileOpened      = false;
 
-    return true;
+    return status;
 }
 
 
@@ -1264,7 +1285,7 @@ bool CRawVideoFileIO::writeVideoFrame(const void *pData)
     /// This "write" logic writes 1 "frame" 
     /// at a time to the output file.
 
-    bool status = m_fileIO.writeBlock(pData, m_nFrameSize, 1);
+    bool status = writeData(pData, m_nFrameSize, 1);
 
     if (status == false)
     {
@@ -1312,7 +1333,7 @@ bool CRawVideoFileIO::writeVideoFrame(const void* pData, const unsigned int fram
     /// This "write" logic writes 1 "frame" 
     /// at a time to the output file.
 
-    bool status = m_fileIO.writeBlock(pData, frameLen, 1);
+    bool status = writeData(pData, frameLen, 1);
 
     if (status == false)
     {
@@ -1336,7 +1357,44 @@ bool CRawVideoFileIO::writeVideoBlock(const void *pData, const unsigned int numF
         return false;
     }
 
-    bool status = m_fileIO.writeBlock(pData, m_nFrameSize, numFrames);
+    bool status = writeData(pData, m_nFrameSize, numFrames);
+
+    if (status)
+    {
+        m_nCurrentFrame += numFrames;
+        m_nFramesInFile += numFrames;
+    }
+
+    return status;
+}
+
+
+bool CRawVideoFileIO::writeData(const void *pData, const unsigned int size, const unsigned int count)
+{
+    if (m_asyncIO.isOpen())
+    {
+        /// Write-behind (see CAsyncFileIO::append()) - an earlier
+        /// write failed, so don't queue any more
+        if (m_asyncIO.getNumErrors() > 0)
+        {
+            LogDebug("async write failed:{}", m_asyncIO.getLastErrorText());
+            return false;
+        }
+
+        int nStatus = m_asyncIO.append(pData, ((size_t) size * count));
+
+        if (nStatus < 0)
+        {
+            LogDebug("async write not queued:{}", nStatus);
+            return false;
+        }
+
+        m_lCurrentFilePos = (unsigned long) m_asyncIO.getAppendOffset();
+
+        return true;
+    }
+
+    bool status = m_fileIO.writeBlock(pData, size, count);
 
 #ifdef UPDATE_FILE_POSITION
     m_lCurrentFilePos = m_fileIO.getFilePosition();
@@ -1346,11 +1404,6 @@ bool CRawVideoFileIO::writeVideoBlock(const void *pData, const unsigned int numF
     if (pos > 0)
         m_lCurrentFilePos += pos;
 #endif
-    if (status)
-    {
-        m_nCurrentFrame += numFrames;
-        m_nFramesInFile += numFrames;
-    }
 
     return status;
 }
@@ -31,6 +31,9 @@ COMPILE_ERROR("ERRORL: C++17 not supported")
 
 
 #include "CFileIO.h"
+#include "CAsyncFileIO.h"
+
+#include "../Buffer/VideoFrameLayout.h"         // eVideoDataIoFormat_def
 
 #include <string>
 #include <filesystem>
@@ -54,37 +57,6 @@ extern "C"
 #include "opencv2/videoio.hpp"
 
 
-#ifndef E_VIDEO_DATA_FOTMAT_DEF
-#define E_VIDEO_DATA_FOTMAT_DEF
-typedef enum
-{
-    eVideoDataIoFormat_unknown = 0,
-    // raw pixel formats
-    eVideoDataIoFormat_yuv,         // YUV 4:4:4
-    eVideoDataIoFormat_yuy2,        // YUV 4:2:2
-    eVideoDataIoFormat_yv12,        // YUV 4:2:0
-    eVideoDataIoFormat_nv12,        // YUV 4:2:0
-    eVideoDataIoFormat_rgb,
-    eVideoDataIoFormat_bgr,
-    // encoded video formats
-    eVideoDataIoFormat_mjpeg,
-    eVideoDataIoFormat_mpeg1,
-    eVideoDataIoFormat_mpeg2,
-    eVideoDataIoFormat_mpeg4,
-    eVideoDataIoFormat_h264,
-    eVideoDataIoFormat_h265,
-    eVideoDataIoFormat_divx,
-    eVideoDataIoFormat_webm,
-    eVideoDataIoFormat_vp7,
-    eVideoDataIoFormat_vp8,
-    eVideoDataIoFormat_vp9,
-    eVideoDataIoFormat_vc1,
-    eVideoDataIoFormat_i420,       // Intel I420 
-
-} eVideoDataIoFormat_def;
-#endif
-
-
 enum eVideoFileType_def
 {
     eFileType_unknown = 0,
@@ -303,6 +275,8 @@ class CRawVideoFileIO :
   private:
 
     CFileIO             m_fileIO;
+    CAsyncFileIO        m_asyncIO;              ///< output file, when write-behind is on
+    unsigned int        m_nAsyncWriteDepth;     ///< max. writes in flight (0 = write-behind off)
 
     void                *m_pFramebuffer;
     
@@ -322,6 +296,8 @@ class CRawVideoFileIO :
 
     bool writeInfoTextFile(const std::string& sFile, SVideoFormatInfo& info);
 
+    bool writeData(const void *pData, unsigned int size, unsigned int count);
+
 public:
 
     CRawVideoFileIO();
@@ -344,6 +320,14 @@ public:
         m_bCreateInfoTextFile = value;
     }
 
+    /// Write-behind: let up to "numRequests" frame writes be in flight,
+    /// so writeVideoFrame() does not wait for the disk (0 = off, the
+    /// default).  Set before openFile().
+    void setAsyncWriteDepth(unsigned int numRequests)
+    {
+        m_nAsyncWriteDepth = std::min(numRequests, (unsigned int) ASYNC_FILE_IO_MAX_DEPTH);
+    }
+
     virtual bool openFile(eFileIoMode_def mode, const std::string &sFilePath) override;
 
     virtual bool closeFile() override;
@@ -0,0 +1,566 @@
+//****************************************************************************
+// FILE:    CWavStreamReader.h
+//
+// DESC:    Reads a WAV (RIFF / RF64) or AIFF file as a stream: the header
+//          is parsed once when the file is opened, then the PCM frames are
+//          read (and decoded) a block at a time, straight from the file.
+//          Memory use, and the time to open the file / read the first
+//          block, do not depend on the length of the file.
+//
+//              CWavStreamReader wav;
+//
+//              wav.openFile(sPath);
+//              wav.setCurrentFrame(48000 * 60);                    // seek to 1 minute
+//
+//              wav.readFrames(pBlock, numFrames, 16);              // interleaved int16_t
+//              ...
+//              wav.closeFile();
+//
+//          The samples are returned interleaved, in the caller's sample
+//          size (as CWavStreamWriter): int8_t (8 bit), int16_t (16 bit),
+//          int32_t (24 bit, in the low 24 bits) or int32_t (32 bit).  If
+//          the file's sample size is different the samples are scaled
+//          (full scale to full scale).
+//
+//          Integer PCM (8 / 16 / 24 / 32 bit, including
+//          WAVE_FORMAT_EXTENSIBLE) and 32 / 64 bit float WAV files, and
+//          uncompressed AIFF / AIFF-C ("NONE" / "sowt") files are read.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _WAV_STREAM_READER_H_
+#define _WAV_STREAM_READER_H_
+
+
+#include "../Logging/Logging.h"
+
+#include "CFileIO.h"
+#include "WavFormat.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+
+class CWavStreamReader
+{
+    CFileIO                 m_fileIO;
+
+    SWavFormat              m_format;                   // bitsPerSample = the sample container size
+    eWavContainer_def       m_eContainer;
+
+    bool                    m_bBigEndian;
+    bool                    m_bFloat;
+
+    uint64_t                m_nDataOffset;              // file position of the first frame
+    uint64_t                m_nNumFrames;
+    uint64_t                m_nCurrentFrame;
+    bool                    m_bFilePositionValid;       // the file is at m_nCurrentFrame
+
+    std::vector<uint8_t>    m_readBuffer;
+
+    std::string             m_sLastErrorStr;
+
+  protected:
+
+    bool readHeaderBytes(uint8_t *pData, const uint64_t position, const unsigned int numBytes)
+    {
+        if (!m_fileIO.setFilePosition((unsigned long) position) || !m_fileIO.readBlock(pData, numBytes, 1))
+        {
+            m_sLastErrorStr = "header read failed: " + m_fileIO.getLastErrorText();
+            return false;
+        }
+
+        return true;
+    }
+
+    // Walk the chunks of a RIFF / RF64 file, to the "fmt " and "data" chunks
+    bool parseWav(const uint64_t fileSize, const bool bRf64)
+    {
+        uint8_t  chunk[40];
+        uint64_t position  = 12;
+        uint64_t dataSize  = 0;
+        uint64_t ds64Data  = 0;
+        bool     bFmt      = false;
+        bool     bData     = false;
+
+        while ((position + 8) <= fileSize && (bFmt == false || bData == false))
+        {
+            if (!readHeaderBytes(chunk, position, 8))
+                return false;
+
+            uint64_t chunkSize = getLE32(chunk + 4);
+
+            if (memcmp(chunk, "ds64", 4) == 0)
+            {
+                if (chunkSize < 24 || !readHeaderBytes(chunk, (position + 8), 24))
+                {
+                    m_sLastErrorStr = "bad ds64 chunk";
+                    return false;
+                }
+
+                ds64Data = getLE64(chunk + 8);
+            }
+            else if (memcmp(chunk, "fmt ", 4) == 0)
+            {
+                unsigned int fmtSize = (unsigned int) std::min(chunkSize, (uint64_t) sizeof(chunk));
+
+                if (fmtSize < 16 || !readHeaderBytes(chunk, (position + 8), fmtSize))
+                {
+                    m_sLastErrorStr = "bad fmt chunk";
+                    return false;
+                }
+
+                unsigned int formatTag  = getLE16(chunk);
+                unsigned int blockAlign = getLE16(chunk + 12);
+
+                // WAVE_FORMAT_EXTENSIBLE: the format is the first 2 bytes of the sub format GUID
+                if (formatTag == WAV_FORMAT_EXTENSIBLE && fmtSize >= 26)
+                    formatTag = getLE16(chunk + 24);
+
+                m_format.numChannels   = getLE16(chunk + 2);
+                m_format.sampleRate    = getLE32(chunk + 4);
+                m_format.bitsPerSample = ((m_format.numChannels > 0) ? ((blockAlign / m_format.numChannels) * 8) : 0);
+
+                if (formatTag == WAV_FORMAT_IEEE_FLOAT)
+                    m_bFloat = true;
+                else if (formatTag != WAV_FORMAT_PCM)
+                {
+                    m_sLastErrorStr = "unsupported WAV format (not PCM / float)";
+                    return false;
+                }
+
+                bFmt = true;
+            }
+            else if (memcmp(chunk, "data", 4) == 0)
+            {
+                if (bRf64 && chunkSize == 0xFFFFFFFF)
+                    chunkSize = ds64Data;
+
+                m_nDataOffset = (position + 8);
+                dataSize      = chunkSize;
+                bData         = true;
+            }
+
+            // chunks are padded to an even size
+            position += (8 + chunkSize + (chunkSize & 1));
+        }
+
+        if (bFmt == false || bData == false)
+        {
+            m_sLastErrorStr = "missing fmt / data chunk";
+            return false;
+        }
+
+        return setDataSize(dataSize, fileSize);
+    }
+
+    // Walk the chunks of an AIFF / AIFF-C file, to the "COMM" and "SSND" chunks
+    bool parseAiff(const uint64_t fileSize, const bool bAifc)
+    {
+        uint8_t  chunk[24];
+        uint64_t position  = 12;
+        uint64_t dataSize  = 0;
+        bool     bComm     = false;
+        bool     bData     = false;
+
+        while ((position + 8) <= fileSize && (bComm == false || bData == false))
+        {
+            if (!readHeaderBytes(chunk, position, 8))
+                return false;
+
+            uint64_t chunkSize = getBE32(chunk + 4);
+
+            if (memcmp(chunk, "COMM", 4) == 0)
+            {
+                unsigned int commSize = (unsigned int) std::min(chunkSize, (uint64_t) 22);
+
+                if (commSize < 18 || !readHeaderBytes(chunk, (position + 8), commSize))
+                {
+                    m_sLastErrorStr = "bad COMM chunk";
+                    return false;
+                }
+
+                m_format.numChannels   = getBE16(chunk);
+                m_format.bitsPerSample = (((getBE16(chunk + 6) + 7) / 8) * 8);
+                m_format.sampleRate    = (unsigned int) (getBEExtended80(chunk + 8) + 0.5);
+
+                if (bAifc)
+                {
+                    if (commSize < 22)
+                    {
+                        m_sLastErrorStr = "bad AIFF-C COMM chunk";
+                        return false;
+                    }
+
+                    if (memcmp((chunk + 18), "sowt", 4) == 0)
+                        m_bBigEndian = false;
+                    else if (memcmp((chunk + 18), "NONE", 4) != 0)
+                    {
+                        m_sLastErrorStr = "unsupported AIFF-C compression type";
+                        return false;
+                    }
+                }
+
+                bComm = true;
+            }
+            else if (memcmp(chunk, "SSND", 4) == 0)
+            {
+                if (chunkSize < 8 || !readHeaderBytes(chunk, (position + 8), 8))
+                {
+                    m_sLastErrorStr = "bad SSND chunk";
+                    return false;
+                }
+
+                uint32_t offset = getBE32(chunk);
+
+                m_nDataOffset = (position + 16 + offset);
+                dataSize      = (chunkSize - 8 - std::min((uint64_t) offset, (chunkSize - 8)));
+                bData         = true;
+            }
+
+            position += (8 + chunkSize + (chunkSize & 1));
+        }
+
+        if (bComm == false || bData == false)
+        {
+            m_sLastErrorStr = "missing COMM / SSND chunk";
+            return false;
+        }
+
+        return setDataSize(dataSize, fileSize);
+    }
+
+    bool setDataSize(uint64_t dataSize, const uint64_t fileSize)
+    {
+        bool bValid = (m_bFloat ? (m_format.bitsPerSample == 32 || m_format.bitsPerSample == 64) : m_format.isValid());
+
+        if (bValid == false || m_format.numChannels < 1 || m_format.sampleRate < 1)
+        {
+            m_sLastErrorStr = "unsupported sample format";
+            return false;
+        }
+
+        // (a recording that was cut short can have a data size past the end of the file)
+        if (m_nDataOffset > fileSize)
+            dataSize = 0;
+        else
+            dataSize = std::min(dataSize, (fileSize - m_nDataOffset));
+
+        m_nNumFrames = (dataSize / m_format.getFrameSize());
+
+        return true;
+    }
+
+    // Decode a run of file samples to the caller's sample size
+    void decodeSamples(void *pTrgt, const uint8_t *pSrc, const size_t numSamples, const unsigned int bitsPerSample) const
+    {
+        unsigned int bytesPerSample = m_format.getBytesPerSample();
+
+        for (size_t idx = 0; idx < numSamples; idx++, pSrc += bytesPerSample)
+        {
+            // the file sample, as a full scale int32
+            int32_t value;
+
+            if (m_bFloat)
+            {
+                double fValue;
+
+                if (bytesPerSample == 4)
+                {
+                    uint32_t bits = getLE32(pSrc);
+                    float    f32;
+
+                    memcpy(&f32, &bits, sizeof(f32));
+                    fValue = f32;
+                }
+                else
+                {
+                    uint64_t bits = getLE64(pSrc);
+
+                    memcpy(&fValue, &bits, sizeof(fValue));
+                }
+
+                fValue = std::max(-2147483648.0, std::min(2147483647.0, (fValue * 2147483648.0)));
+                value  = (int32_t) fValue;
+            }
+            else
+            {
+                switch (bytesPerSample)
+                {
+                    case 1:
+                        // WAV 8 bit samples are unsigned, AIFF are signed
+                        value = (int32_t) ((uint32_t) (m_eContainer == eWavContainer_aiff ? pSrc[0] : (uint8_t) (pSrc[0] - 128)) << 24);
+                        break;
+
+                    case 2:
+                        value = (int32_t) ((uint32_t) (m_bBigEndian ? getBE16(pSrc) : getLE16(pSrc)) << 16);
+                        break;
+
+                    case 3:
+                        if (m_bBigEndian)
+                            value = (int32_t) (((uint32_t) pSrc[0] << 24) | ((uint32_t) pSrc[1] << 16) | ((uint32_t) pSrc[2] << 8));
+                        else
+                            value = (int32_t) (((uint32_t) pSrc[2] << 24) | ((uint32_t) pSrc[1] << 16) | ((uint32_t) pSrc[0] << 8));
+                        break;
+
+                    default:
+                        value = (int32_t) (m_bBigEndian ? getBE32(pSrc) : getLE32(pSrc));
+                        break;
+                }
+            }
+
+            switch (bitsPerSample)
+            {
+                case 8:     ((int8_t *) pTrgt)[idx]  = (int8_t) (value >> 24);     break;
+                case 16:    ((int16_t *) pTrgt)[idx] = (int16_t) (value >> 16);    break;
+                case 24:    ((int32_t *) pTrgt)[idx] = (value >> 8);               break;
+                default:    ((int32_t *) pTrgt)[idx] = value;                      break;
+            }
+        }
+    }
+
+  public:
+
+    CWavStreamReader() :
+        m_eContainer(eWavContainer_wav),
+        m_bBigEndian(false),
+        m_bFloat(false),
+        m_nDataOffset(0),
+        m_nNumFrames(0),
+        m_nCurrentFrame(0),
+        m_bFilePositionValid(false)
+    {
+    }
+
+    ~CWavStreamReader()
+    {
+        if (isOpen())
+            closeFile();
+    }
+
+    // Open the file and read the header (positioned at the first frame)
+    bool openFile(const std::string &sFilePath)
+    {
+        if (isOpen())
+        {
+            m_sLastErrorStr = "file already open";
+            return false;
+        }
+
+        m_format        = SWavFormat();
+        m_bFloat        = false;
+        m_nDataOffset   = 0;
+        m_nNumFrames    = 0;
+        m_nCurrentFrame = 0;
+
+        m_fileIO.setBinaryMode(true);
+
+        if (!m_fileIO.openFile(eFileIoMode_input, sFilePath))
+        {
+            m_sLastErrorStr = "file open failed: " + m_fileIO.getLastErrorText();
+            LogDebug("[CWavStreamReader:{}] {} ", __func__, m_sLastErrorStr);
+            return false;
+        }
+
+        uint8_t header[12];
+
+        auto    fileSize = m_fileIO.getFileSize();
+        bool    status   = false;
+
+        if (fileSize < 12 || !readHeaderBytes(header, 0, 12))
+        {
+            m_sLastErrorStr = "file too short";
+        }
+        else if ((memcmp(header, "RIFF", 4) == 0 || memcmp(header, "RF64", 4) == 0) && memcmp((header + 8), "WAVE", 4) == 0)
+        {
+            m_eContainer = eWavContainer_wav;
+            m_bBigEndian = false;
+
+            status = parseWav((uint64_t) fileSize, (memcmp(header, "RF64", 4) == 0));
+        }
+        else if (memcmp(header, "FORM", 4) == 0 && (memcmp((header + 8), "AIFF", 4) == 0 || memcmp((header + 8), "AIFC", 4) == 0))
+        {
+            m_eContainer = eWavContainer_aiff;
+            m_bBigEndian = true;
+
+            status = parseAiff((uint64_t) fileSize, (memcmp((header + 8), "AIFC", 4) == 0));
+        }
+        else
+        {
+            m_sLastErrorStr = "not a WAV / AIFF file";
+        }
+
+        if (status)
+        {
+            m_bFilePositionValid = false;
+            status = setCurrentFrame(0);
+        }
+
+        if (status == false)
+        {
+            LogDebug("[CWavStreamReader:{}] {} ", __func__, m_sLastErrorStr);
+            m_fileIO.closeFile();
+            return false;
+        }
+
+        m_readBuffer.resize((size_t) WAV_STREAM_CONVERT_FRAMES * m_format.getFrameSize());
+
+        return true;
+    }
+
+    bool closeFile()
+    {
+        if (!isOpen())
+            return false;
+
+        m_nNumFrames    = 0;
+        m_nCurrentFrame = 0;
+
+        return m_fileIO.closeFile();
+    }
+
+    bool isOpen()
+    {
+        return m_fileIO.isOpen();
+    }
+
+    // Move the read position to "frameNum" (0 .. getNumFrames())
+    bool setCurrentFrame(const uint64_t frameNum)
+    {
+        if (!isOpen() || frameNum > m_nNumFrames)
+        {
+            m_sLastErrorStr = "file not open / frame out of range";
+            return false;
+        }
+
+        // (a seek would throw away the read buffer)
+        if (m_bFilePositionValid && frameNum == m_nCurrentFrame)
+            return true;
+
+        m_bFilePositionValid = m_fileIO.setFilePosition((unsigned long) (m_nDataOffset + (frameNum * m_format.getFrameSize())));
+
+        if (m_bFilePositionValid == false)
+        {
+            m_sLastErrorStr = "seek failed: " + m_fileIO.getLastErrorText();
+            return false;
+        }
+
+        m_nCurrentFrame = frameNum;
+
+        return true;
+    }
+
+    // Read up to "numFrames" interleaved frames, as "bitsPerSample"
+    // (8, 16, 24 or 32) samples.  Returns the number of frames read
+    // (less than numFrames at the end of the file).
+    unsigned int readFrames(void *pData, unsigned int numFrames, const unsigned int bitsPerSample)
+    {
+        if (!isOpen() || pData == nullptr)
+        {
+            m_sLastErrorStr = "file not open / invalid data";
+            return 0;
+        }
+
+        numFrames = (unsigned int) std::min((uint64_t) numFrames, (m_nNumFrames - m_nCurrentFrame));
+
+        if (numFrames < 1)
+            return 0;
+
+        if (!setCurrentFrame(m_nCurrentFrame))
+            return 0;
+
+        unsigned int framesRead = 0;
+
+        // 16 / 32 bit WAV samples can be read as they are (on a little endian host)
+        if (m_bFloat == false && m_bBigEndian == false && isLittleEndianHost() &&
+            bitsPerSample == m_format.bitsPerSample && (bitsPerSample == 16 || bitsPerSample == 32))
+        {
+            m_fileIO.readBlock(pData, m_format.getFrameSize(), numFrames);
+
+            framesRead = m_fileIO.getLastIoSize();
+        }
+        else
+        {
+            // the caller's sample size (24 bit samples are passed as int32_t)
+            size_t trgtSize = ((bitsPerSample == 8) ? 1 : ((bitsPerSample == 16) ? 2 : 4));
+
+            auto   pTrgt    = (uint8_t *) pData;
+
+            while (framesRead < numFrames)
+            {
+                unsigned int count = std::min((numFrames - framesRead), (unsigned int) WAV_STREAM_CONVERT_FRAMES);
+
+                m_fileIO.readBlock(m_readBuffer.data(), m_format.getFrameSize(), count);
+
+                unsigned int countRead = m_fileIO.getLastIoSize();
+                size_t       numSamples = ((size_t) countRead * m_format.numChannels);
+
+                decodeSamples(pTrgt, m_readBuffer.data(), numSamples, bitsPerSample);
+
+                framesRead += countRead;
+                pTrgt      += (numSamples * trgtSize);
+
+                if (countRead != count)
+                    break;
+            }
+        }
+
+        m_nCurrentFrame += framesRead;
+
+        if (framesRead != numFrames)
+        {
+            // (the file is shorter than the header says)
+            m_sLastErrorStr      = "read failed: " + m_fileIO.getLastErrorText();
+            m_bFilePositionValid = false;
+
+            LogDebug("[CWavStreamReader:{}] {} ", __func__, m_sLastErrorStr);
+        }
+
+        return framesRead;
+    }
+
+    uint64_t getNumFrames() const
+    {
+        return m_nNumFrames;
+    }
+
+    uint64_t getCurrentFrame() const
+    {
+        return m_nCurrentFrame;
+    }
+
+    bool isEOF() const
+    {
+        return (m_nCurrentFrame >= m_nNumFrames);
+    }
+
+    // The file's sample format (bitsPerSample = the size of the samples in the file)
+    const SWavFormat &getFormat() const
+    {
+        return m_format;
+    }
+
+    eWavContainer_def getContainer() const
+    {
+        return m_eContainer;
+    }
+
+    bool isFloat() const
+    {
+        return m_bFloat;
+    }
+
+    std::string getLastErrorText()
+    {
+        return m_sLastErrorStr;
+    }
+};
+
+
+#endif // _WAV_STREAM_READER_H_
@@ -0,0 +1,434 @@
+//****************************************************************************
+// FILE:    CWavStreamWriter.h
+//
+// DESC:    Writes a WAV (or AIFF) file as a stream: the PCM samples are
+//          appended to the file as they arrive, and the header sizes are
+//          patched at checkpoints and on close.  Memory use does not
+//          depend on the length of the recording, and a checkpoint
+//          leaves a valid file on disk (ie: if the process dies).
+//
+//              CWavStreamWriter wav;
+//              SWavFormat       format;
+//
+//              format.numChannels   = 8;
+//              format.sampleRate    = 48000;
+//              format.bitsPerSample = 16;
+//
+//              wav.openFile(sPath, format);
+//              wav.setCheckpointInterval(48000);       // once a second
+//
+//              wav.writeFrames(pBlock, numFrames);     // interleaved int16_t
+//              ...
+//              wav.closeFile();
+//
+//          The samples are passed interleaved, in the file's sample size:
+//          int8_t (8 bit), int16_t (16 bit), int32_t (24 bit, in the low
+//          24 bits) or int32_t (32 bit).
+//
+//          A WAV file that grows past 4 GB is written as an RF64 file.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _WAV_STREAM_WRITER_H_
+#define _WAV_STREAM_WRITER_H_
+
+
+#include "../Logging/Logging.h"
+
+#include "CFileIO.h"
+#include "WavFormat.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+
+class CWavStreamWriter
+{
+    CFileIO                 m_fileIO;
+
+    SWavFormat              m_format;
+    eWavContainer_def       m_eContainer;
+
+    uint64_t                m_nFramesWritten;
+    uint64_t                m_nCheckpointFrames;        // frames between header updates (0 = on close only)
+    uint64_t                m_nFramesSinceCheckpoint;
+    uint64_t                m_nMaxDataBytes;
+
+    bool                    m_bDirectWrite;             // samples are already in the file's byte order
+    std::vector<uint8_t>    m_convertBuffer;
+
+    std::string             m_sLastErrorStr;
+
+  protected:
+
+    uint64_t getDataBytes() const
+    {
+        return (m_nFramesWritten * m_format.getFrameSize());
+    }
+
+    // Build the header, for the samples written so far
+    unsigned int buildHeader(uint8_t *pHeader) const
+    {
+        uint64_t dataBytes = getDataBytes();
+        uint64_t padBytes  = (dataBytes & 1);
+
+        if (m_eContainer == eWavContainer_aiff)
+        {
+            memset(pHeader, 0, AIFF_HEADER_SIZE);
+
+            memcpy(pHeader, "FORM", 4);
+            putBE32((pHeader + 4), (uint32_t) (46 + dataBytes + padBytes));
+            memcpy((pHeader + 8), "AIFF", 4);
+
+            memcpy((pHeader + 12), "COMM", 4);
+            putBE32((pHeader + 16), 18);
+            putBE16((pHeader + 20), (uint16_t) m_format.numChannels);
+            putBE32((pHeader + 22), (uint32_t) m_nFramesWritten);
+            putBE16((pHeader + 26), (uint16_t) m_format.bitsPerSample);
+            putBEExtended80((pHeader + 28), (double) m_format.sampleRate);
+
+            memcpy((pHeader + 38), "SSND", 4);
+            putBE32((pHeader + 42), (uint32_t) (8 + dataBytes));
+            // (offset and block size = 0)
+
+            return AIFF_HEADER_SIZE;
+        }
+
+        memset(pHeader, 0, WAV_HEADER_SIZE);
+
+        uint64_t riffSize = ((WAV_HEADER_SIZE - 8) + dataBytes + padBytes);
+        bool     bRf64    = (riffSize > WAV_MAX_RIFF_SIZE);
+
+        memcpy(pHeader, (bRf64 ? "RF64" : "RIFF"), 4);
+        putLE32((pHeader + 4), (bRf64 ? 0xFFFFFFFF : (uint32_t) riffSize));
+        memcpy((pHeader + 8), "WAVE", 4);
+
+        if (bRf64)
+        {
+            memcpy((pHeader + 12), "ds64", 4);
+            putLE32((pHeader + 16), WAV_DS64_SIZE);
+            putLE64((pHeader + 20), riffSize);
+            putLE64((pHeader + 28), dataBytes);
+            putLE64((pHeader + 36), m_nFramesWritten);
+            // (table length = 0)
+        }
+        else
+        {
+            memcpy((pHeader + 12), "JUNK", 4);
+            putLE32((pHeader + 16), WAV_DS64_SIZE);
+        }
+
+        memcpy((pHeader + 48), "fmt ", 4);
+        putLE32((pHeader + 52), 16);
+        putLE16((pHeader + 56), WAV_FORMAT_PCM);
+        putLE16((pHeader + 58), (uint16_t) m_format.numChannels);
+        putLE32((pHeader + 60), m_format.sampleRate);
+        putLE32((pHeader + 64), (m_format.sampleRate * m_format.getFrameSize()));
+        putLE16((pHeader + 68), (uint16_t) m_format.getFrameSize());
+        putLE16((pHeader + 70), (uint16_t) m_format.bitsPerSample);
+
+        memcpy((pHeader + 72), "data", 4);
+        putLE32((pHeader + 76), (bRf64 ? 0xFFFFFFFF : (uint32_t) dataBytes));
+
+        return WAV_HEADER_SIZE;
+    }
+
+    // (Re)write the header, then return to the end of the data
+    bool writeHeader()
+    {
+        uint8_t header[WAV_HEADER_SIZE];
+
+        unsigned int headerSize = buildHeader(header);
+
+        if (!m_fileIO.setFilePosition(0) || !m_fileIO.writeBlock(header, headerSize, 1))
+        {
+            m_sLastErrorStr = "header write failed: " + m_fileIO.getLastErrorText();
+            return false;
+        }
+
+        return m_fileIO.setFilePosition((unsigned long) (headerSize + getDataBytes()));
+    }
+
+    // Convert a run of samples to the file's byte order / packing
+    void convertSamples(uint8_t *pTrgt, const void *pSource, const size_t numSamples) const
+    {
+        bool bBigEndian = (m_eContainer == eWavContainer_aiff);
+
+        switch (m_format.bitsPerSample)
+        {
+            case 8:
+                {
+                    // WAV 8 bit samples are unsigned, AIFF are signed
+                    auto pSrc = (const int8_t *) pSource;
+
+                    for (size_t idx = 0; idx < numSamples; idx++)
+                        pTrgt[idx] = (bBigEndian ? (uint8_t) pSrc[idx] : (uint8_t) (pSrc[idx] + 128));
+                }
+                break;
+
+            case 16:
+                {
+                    auto pSrc = (const int16_t *) pSource;
+
+                    for (size_t idx = 0; idx < numSamples; idx++, pTrgt += 2)
+                    {
+                        if (bBigEndian)
+                            putBE16(pTrgt, (uint16_t) pSrc[idx]);
+                        else
+                            putLE16(pTrgt, (uint16_t) pSrc[idx]);
+                    }
+                }
+                break;
+
+            case 24:
+                {
+                    auto pSrc = (const int32_t *) pSource;
+
+                    for (size_t idx = 0; idx < numSamples; idx++, pTrgt += 3)
+                    {
+                        auto value = (uint32_t) pSrc[idx];
+
+                        if (bBigEndian)
+                        {
+                            pTrgt[0] = (uint8_t) (value >> 16);
+                            pTrgt[1] = (uint8_t) (value >> 8);
+                            pTrgt[2] = (uint8_t) value;
+                        }
+                        else
+                        {
+                            pTrgt[0] = (uint8_t) value;
+                            pTrgt[1] = (uint8_t) (value >> 8);
+                            pTrgt[2] = (uint8_t) (value >> 16);
+                        }
+                    }
+                }
+                break;
+
+            default:
+                {
+                    auto pSrc = (const int32_t *) pSource;
+
+                    for (size_t idx = 0; idx < numSamples; idx++, pTrgt += 4)
+                    {
+                        if (bBigEndian)
+                            putBE32(pTrgt, (uint32_t) pSrc[idx]);
+                        else
+                            putLE32(pTrgt, (uint32_t) pSrc[idx]);
+                    }
+                }
+                break;
+        }
+    }
+
+  public:
+
+    CWavStreamWriter() :
+        m_eContainer(eWavContainer_wav),
+        m_nFramesWritten(0),
+        m_nCheckpointFrames(0),
+        m_nFramesSinceCheckpoint(0),
+        m_nMaxDataBytes(0),
+        m_bDirectWrite(false)
+    {
+    }
+
+    ~CWavStreamWriter()
+    {
+        if (isOpen())
+            closeFile();
+    }
+
+    // Create the file, and write the header (for 0 frames)
+    bool openFile(const std::string &sFilePath, const SWavFormat &format, const eWavContainer_def eContainer = eWavContainer_wav)
+    {
+        if (isOpen())
+        {
+            m_sLastErrorStr = "file already open";
+            return false;
+        }
+
+        if (format.isValid() == false)
+        {
+            m_sLastErrorStr = "invalid sample format";
+            return false;
+        }
+
+        m_format                 = format;
+        m_eContainer             = eContainer;
+        m_nFramesWritten         = 0;
+        m_nFramesSinceCheckpoint = 0;
+
+        if (m_eContainer == eWavContainer_aiff)
+            m_nMaxDataBytes = (AIFF_MAX_FORM_SIZE - (AIFF_HEADER_SIZE - 8) - 1);
+        else
+            m_nMaxDataBytes = UINT64_MAX;
+
+        // 16 / 32 bit WAV samples can be written as they are (on a little endian host)
+        m_bDirectWrite = (m_eContainer == eWavContainer_wav && isLittleEndianHost() &&
+                          (m_format.bitsPerSample == 16 || m_format.bitsPerSample == 32));
+
+        if (m_bDirectWrite == false)
+            m_convertBuffer.resize((size_t) WAV_STREAM_CONVERT_FRAMES * m_format.getFrameSize());
+
+        m_fileIO.setBinaryMode(true);
+
+        if (!m_fileIO.openFile(eFileIoMode_output, sFilePath))
+        {
+            m_sLastErrorStr = "file open failed: " + m_fileIO.getLastErrorText();
+            return false;
+        }
+
+        if (!writeHeader())
+        {
+            m_fileIO.closeFile();
+            return false;
+        }
+
+        return true;
+    }
+
+    // Patch the header sizes and close the file
+    bool closeFile()
+    {
+        if (!isOpen())
+            return false;
+
+        bool status = true;
+
+        // chunks are padded to an even size
+        if (getDataBytes() & 1)
+        {
+            uint8_t pad = 0;
+
+            status = m_fileIO.writeBlock(&pad, 1, 1);
+        }
+
+        if (!writeHeader())
+            status = false;
+
+        if (!m_fileIO.closeFile())
+            status = false;
+
+        if (!status)
+            LogDebug("[CWavStreamWriter:{}] {} ", __func__, m_sLastErrorStr);
+
+        return status;
+    }
+
+    bool isOpen()
+    {
+        return m_fileIO.isOpen();
+    }
+
+    // Update the header (with the frames written so far) every
+    // "numFrames" frames (0 = only when the file is closed).
+    void setCheckpointInterval(const uint64_t numFrames)
+    {
+        m_nCheckpointFrames = numFrames;
+    }
+
+    // Append interleaved frames
+    bool writeFrames(const void *pData, const unsigned int numFrames)
+    {
+        if (!isOpen() || pData == nullptr)
+        {
+            m_sLastErrorStr = "file not open / invalid data";
+            return false;
+        }
+
+        if (numFrames < 1)
+            return true;
+
+        if ((getDataBytes() + ((uint64_t) numFrames * m_format.getFrameSize())) > m_nMaxDataBytes)
+        {
+            m_sLastErrorStr = "file size limit reached";
+            return false;
+        }
+
+        if (m_bDirectWrite)
+        {
+            if (!m_fileIO.writeBlock(pData, m_format.getFrameSize(), numFrames))
+            {
+                m_sLastErrorStr = "write failed: " + m_fileIO.getLastErrorText();
+                return false;
+            }
+
+            m_nFramesWritten += numFrames;
+        }
+        else
+        {
+            // the caller's sample size (24 bit samples are passed as int32_t)
+            size_t sourceSize = ((m_format.bitsPerSample == 24) ? sizeof(int32_t) : m_format.getBytesPerSample());
+
+            auto   pSrc       = (const uint8_t *) pData;
+
+            unsigned int framesLeft = numFrames;
+
+            while (framesLeft > 0)
+            {
+                unsigned int count = std::min(framesLeft, (unsigned int) WAV_STREAM_CONVERT_FRAMES);
+
+                size_t numSamples  = ((size_t) count * m_format.numChannels);
+
+                convertSamples(m_convertBuffer.data(), pSrc, numSamples);
+
+                if (!m_fileIO.writeBlock(m_convertBuffer.data(), m_format.getFrameSize(), count))
+                {
+                    m_sLastErrorStr = "write failed: " + m_fileIO.getLastErrorText();
+                    return false;
+                }
+
+                m_nFramesWritten += count;
+
+                pSrc       += (numSamples * sourceSize);
+                framesLeft -= count;
+            }
+        }
+
+        m_nFramesSinceCheckpoint += numFrames;
+
+        if (m_nCheckpointFrames > 0 && m_nFramesSinceCheckpoint >= m_nCheckpointFrames)
+            return checkpoint();
+
+        return true;
+    }
+
+    // Update the header sizes and flush the file, so the file on
+    // disk is valid (up to here) while the recording continues.
+    bool checkpoint()
+    {
+        if (!isOpen())
+            return false;
+
+        m_nFramesSinceCheckpoint = 0;
+
+        if (!writeHeader())
+            return false;
+
+        return m_fileIO.flush();
+    }
+
+    uint64_t getNumFrames() const
+    {
+        return m_nFramesWritten;
+    }
+
+    const SWavFormat &getFormat() const
+    {
+        return m_format;
+    }
+
+    std::string getLastErrorText()
+    {
+        return m_sLastErrorStr;
+    }
+};
+
+
+#endif // _WAV_STREAM_WRITER_H_
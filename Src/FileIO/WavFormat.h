@@ -0,0 +1,169 @@
+//****************************************************************************
+// FILE:    WavFormat.h
+//
+// DESC:    WAV (RIFF / RF64) and AIFF file format definitions, shared by
+//          the streaming WAV writer and reader.
+//
+//          WAV files are written with a 28 byte "JUNK" chunk after the
+//          RIFF header (EBU Tech 3306), so a file that grows past 4 GB
+//          can be turned into an RF64 file (JUNK -> "ds64") in place.
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef _WAV_FORMAT_H_
+#define _WAV_FORMAT_H_
+
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+
+#define WAV_FORMAT_PCM              0x0001
+#define WAV_FORMAT_IEEE_FLOAT       0x0003
+#define WAV_FORMAT_EXTENSIBLE       0xFFFE
+
+#define WAV_DS64_SIZE               28      // ds64 chunk (without the table), same size as the JUNK chunk
+#define WAV_HEADER_SIZE             80      // RIFF + JUNK/ds64 + fmt + data chunk headers
+#define AIFF_HEADER_SIZE            54      // FORM + COMM + SSND chunk headers
+
+#define WAV_MAX_RIFF_SIZE           0xFFFFFFFFULL
+#define AIFF_MAX_FORM_SIZE          0x7FFFFFFFULL   // (AIFF chunk sizes are signed)
+
+#define WAV_STREAM_CONVERT_FRAMES   1024    // frames converted (byte order / packing) per pass
+
+
+enum eWavContainer_def
+{
+    eWavContainer_wav = 0,          // RIFF WAVE (RF64 once it passes 4 GB)
+    eWavContainer_aiff,             // AIFF (big endian)
+};
+
+
+// The sample format of a (integer PCM) WAV / AIFF file
+struct SWavFormat
+{
+    unsigned int    numChannels     = 0;
+    unsigned int    sampleRate      = 0;
+    unsigned int    bitsPerSample   = 16;   // 8, 16, 24 or 32
+
+    unsigned int getBytesPerSample() const
+    {
+        return ((bitsPerSample + 7) / 8);
+    }
+
+    unsigned int getFrameSize() const
+    {
+        return (numChannels * getBytesPerSample());
+    }
+
+    bool isValid() const
+    {
+        if (numChannels < 1 || numChannels > 0xFFFF || sampleRate < 1)
+            return false;
+
+        return (bitsPerSample == 8 || bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32);
+    }
+};
+
+
+inline bool isLittleEndianHost()
+{
+    const uint16_t value = 1;
+
+    return (*((const uint8_t *) &value) == 1);
+}
+
+
+// Store little / big endian header fields
+
+inline void putLE16(uint8_t *p, const uint16_t value)
+{
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+}
+
+inline void putLE32(uint8_t *p, const uint32_t value)
+{
+    putLE16(p, (uint16_t) value);
+    putLE16((p + 2), (uint16_t) (value >> 16));
+}
+
+inline void putLE64(uint8_t *p, const uint64_t value)
+{
+    putLE32(p, (uint32_t) value);
+    putLE32((p + 4), (uint32_t) (value >> 32));
+}
+
+inline void putBE16(uint8_t *p, const uint16_t value)
+{
+    p[0] = (uint8_t) (value >> 8);
+    p[1] = (uint8_t) value;
+}
+
+inline void putBE32(uint8_t *p, const uint32_t value)
+{
+    putBE16(p, (uint16_t) (value >> 16));
+    putBE16((p + 2), (uint16_t) value);
+}
+
+// Load little / big endian header fields
+
+inline uint16_t getLE16(const uint8_t *p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+inline uint32_t getLE32(const uint8_t *p)
+{
+    return (getLE16(p) | ((uint32_t) getLE16(p + 2) << 16));
+}
+
+inline uint64_t getLE64(const uint8_t *p)
+{
+    return (getLE32(p) | ((uint64_t) getLE32(p + 4) << 32));
+}
+
+inline uint16_t getBE16(const uint8_t *p)
+{
+    return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+inline uint32_t getBE32(const uint8_t *p)
+{
+    return (((uint32_t) getBE16(p) << 16) | getBE16(p + 2));
+}
+
+// AIFF sample rate: an 80 bit IEEE 754 extended value (big endian)
+inline void putBEExtended80(uint8_t *p, const double value)
+{
+    memset(p, 0, 10);
+
+    if (value <= 0)
+        return;
+
+    int     exponent = 0;
+    double  mantissa = frexp(value, &exponent);     // value = mantissa * 2^exponent, 0.5 <= mantissa < 1
+
+    uint64_t bits    = (uint64_t) ldexp(mantissa, 64);
+
+    putBE16(p, (uint16_t) (16383 + exponent - 1));
+    putBE32((p + 2), (uint32_t) (bits >> 32));
+    putBE32((p + 6), (uint32_t) bits);
+}
+
+inline double getBEExtended80(const uint8_t *p)
+{
+    int      exponent = ((getBE16(p) & 0x7FFF) - 16383);
+    uint64_t bits     = (((uint64_t) getBE32(p + 2) << 32) | getBE32(p + 6));
+
+    if (bits == 0)
+        return 0;
+
+    return ldexp((double) bits, (exponent - 63));
+}
+
+
+#endif // _WAV_FORMAT_H_
@@ -1051,6 +1051,8 @@ bool CGstWrapper::PullSampleFromAppSink
 {
     mediaInfo.m_nCurDataLen = 0;
 
+    mediaInfo.clearTiming();
+
     if (m_controlData.m_pAppsink == nullptr)
     {
         m_controlData.m_sLastError = "Invalid appSink ptr";
@@ -1108,6 +1110,11 @@ bool CGstWrapper::PullSampleFromAppSink
             return false;
         }
 
+        mediaInfo.m_nPts = (int64_t) GST_BUFFER_PTS(pBuffer);
+        mediaInfo.m_nDuration = (int64_t) GST_BUFFER_DURATION(pBuffer);
+        mediaInfo.m_nOffset = GST_BUFFER_OFFSET(pBuffer);
+        mediaInfo.m_bDiscontinuity = GST_BUFFER_FLAG_IS_SET(pBuffer, GST_BUFFER_FLAG_DISCONT);
+
         GstMapInfo map_info;
 
         // Map the buffer to access its m_controlData
@@ -93,6 +93,13 @@ public:
         
         unsigned int    m_nCurDataLen;
 
+        // Timing of the last sample (ns, -1 = not set), for
+        // keeping audio / video aligned (see CTimedRingBuffer)
+        int64_t         m_nPts;
+        int64_t         m_nDuration;
+        uint64_t        m_nOffset;              // sequence number (ie: frame / sample count)
+        bool            m_bDiscontinuity;
+
         SMediaInfo()
         {
             m_eMediaType = eMediaType_unknown;
@@ -100,6 +107,16 @@ public:
             m_sFourCC = "";
 
             m_nCurDataLen = 0;
+
+            clearTiming();
+        }
+
+        void clearTiming()
+        {
+            m_nPts = (int64_t) GST_CLOCK_TIME_NONE;
+            m_nDuration = (int64_t) GST_CLOCK_TIME_NONE;
+            m_nOffset = GST_BUFFER_OFFSET_NONE;
+            m_bDiscontinuity = false;
         }
     };
 
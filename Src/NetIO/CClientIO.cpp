@@ -1446,4 +1446,62 @@ int CTcpClient::write(const void *pSource, const unsigned int nLen)
     return nWriteSize;
 }
 
+int CTcpClient::write(const CChainBuffer &chain)
+{
+    if (chain.empty())
+        return -1;
+
+    if (chain.size() > 0x7FFFFFFF)
+        return -2;
+
+    // (the peer's buffers are the same size as ours, as for write())
+    if (chain.size() > m_nBufferSize)
+        return -3;
+
+    int nWriteSize = 0;
+
+    try
+    {
+        NetworkDataHeaderInfo_def header;
+
+        // the header (if used) is sent as the 1st segment, the
+        // chain's own segments are shared, not copied
+        CChainBuffer msg(chain);
+
+        if (m_nHeaderSize == sizeof(NetworkDataHeaderInfo_def))
+        {
+            memset(&header, 0, sizeof(header));
+
+            header.initialize(m_sStreamType.c_str(), (unsigned int) chain.size());
+
+            msg.prependRef(&header, sizeof(header));
+        }
+
+        asio::error_code error;
+
+        error.clear();
+
+        nWriteSize = (int) asio::write(m_netSocket, makeBufferSequence(msg), error);
+
+        if (error)
+        {
+            m_sLastError = error.message();
+
+            return -20;
+        }
+
+        m_sLastError.clear();
+    }
+    catch (...)
+    {
+        m_netSocket.close();
+
+        m_bConnected = false;
+
+        return -5;
+    }
+
+    return nWriteSize;
+}
+
 
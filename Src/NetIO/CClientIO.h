@@ -25,6 +25,7 @@
 #endif
 
 #include "CNetworkIO.h"
+#include "NetBufferSeq.h"
 
 
 namespace CNetworkIO
@@ -238,6 +239,11 @@ public:
     int read(void *pTarget = nullptr, const unsigned int nLen = 0);
 
     int write(const void *pSource = nullptr, const unsigned int nLen = 0);
+
+    // Send a chained buffer with 1 gathering write (the segments
+    // are not copied into the data buffer).  As write(), a chain
+    // larger than the buffer size is rejected (-3).
+    int write(const CChainBuffer &chain);
 };
 
 
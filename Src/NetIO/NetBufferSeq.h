@@ -0,0 +1,106 @@
+//****************************************************************************
+// FILE:    NetBufferSeq.h
+//
+// DESC:    Adapts a CChainBuffer to the asio ConstBufferSequence concept,
+//          so a chain of segments can be sent with 1 gathering write
+//          (asio::write() / async_write() -> writev()), without copying
+//          the segments into one buffer first.
+//
+//              CChainBuffer msg;
+//
+//              msg.appendOwned(std::move(payload));
+//              msg.prependCopy(&header, sizeof(header));
+//
+//              asio::write(socket, makeBufferSequence(msg));
+//
+// AUTHOR:  Russ Barker
+//
+
+
+#ifndef NET_BUFFER_SEQ_H
+#define NET_BUFFER_SEQ_H
+
+
+#include <asio.hpp>
+
+#include <iterator>
+
+#include "../Buffer/CChainBuffer.h"
+
+
+namespace CNetworkIO
+{
+
+
+// A (non owning) view of a CChainBuffer as asio const buffers.
+// NOTE: The chain must not change while the sequence is in use.
+class CChainBufferSequence
+{
+    const CChainBuffer      *m_pChain;
+
+  public:
+
+    class const_iterator
+    {
+        CChainBuffer::const_iterator    m_it;
+
+      public:
+
+        typedef std::bidirectional_iterator_tag     iterator_category;
+        typedef asio::const_buffer                  value_type;
+        typedef std::ptrdiff_t                      difference_type;
+        typedef const asio::const_buffer            *pointer;
+        typedef asio::const_buffer                  reference;
+
+        const_iterator()
+        {
+        }
+
+        explicit const_iterator(CChainBuffer::const_iterator it) :
+            m_it(it)
+        {
+        }
+
+        asio::const_buffer operator*() const
+        {
+            return asio::const_buffer(m_it->pData, m_it->len);
+        }
+
+        const_iterator &operator++()        { ++m_it; return *this; }
+        const_iterator operator++(int)      { const_iterator tmp = *this; ++m_it; return tmp; }
+        const_iterator &operator--()        { --m_it; return *this; }
+        const_iterator operator--(int)      { const_iterator tmp = *this; --m_it; return tmp; }
+
+        bool operator==(const const_iterator &other) const { return (m_it == other.m_it); }
+        bool operator!=(const const_iterator &other) const { return (m_it != other.m_it); }
+    };
+
+    typedef asio::const_buffer      value_type;
+
+    explicit CChainBufferSequence(const CChainBuffer &chain) :
+        m_pChain(&chain)
+    {
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(m_pChain->begin());
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(m_pChain->end());
+    }
+};
+
+
+inline CChainBufferSequence makeBufferSequence(const CChainBuffer &chain)
+{
+    return CChainBufferSequence(chain);
+}
+
+
+};  //  namespace CNetworkIO
+
+
+#endif  //  NET_BUFFER_SEQ_H
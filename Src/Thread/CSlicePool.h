@@ -0,0 +1,401 @@
+//**********************************************************************************
+//* FILE:    CSlicePool.h
+//*
+//* DESC:    A persistent pool of CThreadBase worker threads, for data
+//*          parallel (fork / join) processing of buffers.
+//*
+//*          CSlicePool::run(numSlices, fn) calls fn(slice) for every
+//*          slice, on the pool's workers and the calling thread, and
+//*          returns when all the slices are done.  The workers are
+//*          created once and then wait for work, so a job costs a
+//*          wake-up, not a thread start.
+//*
+//*          parallelRows(), parallelVideoRows(), parallelChannels() and
+//*          parallelAudioFrames() split a range of rows / a video frame /
+//*          an audio buffer into (contiguous) slices, for scale, crop,
+//*          gain, mix, format conversion etc.
+//*
+//*          NOTE: Jobs are not nested - run() from inside a slice (on
+//*          the same pool) runs the inner job on the calling thread.
+//*
+//* AUTHOR:  Russ Barker
+//*
+
+
+#ifndef _SLICE_POOL_H_
+#define _SLICE_POOL_H_
+
+
+#include "ThreadBase.h"
+
+#include "../Buffer/CAudioBuffer.h"
+#include "../Buffer/CVideoBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+#define SLICE_POOL_MAX_THREADS      64
+
+
+class CSlicePool
+{
+    // Pool worker thread
+    class CSliceWorker : public CThreadBase
+    {
+        CSlicePool      *m_pPool;
+
+      public:
+
+        CSliceWorker(CSlicePool *pPool, const std::string &sName) :
+            CThreadBase(sName),
+            m_pPool(pPool)
+        {
+        }
+
+        ~CSliceWorker()
+        {
+            // join here, while threadProc() can still be called
+            stopThread();
+        }
+
+        void threadProc(void) override
+        {
+            m_pPool->workerProc();
+        }
+    };
+
+    std::vector<std::unique_ptr<CSliceWorker>>  m_workers;
+
+    std::mutex                  m_runMutex;         // 1 job at a time
+
+    std::mutex                  m_jobMutex;
+    std::condition_variable     m_jobReadyVar;      // signaled when a job is posted (or on exit)
+    std::condition_variable     m_jobDoneVar;       // signaled when the last slice is done
+
+    // The current job
+    const std::function<void(unsigned int)>     *m_pFn;
+    unsigned int                m_numSlices;
+    std::atomic<unsigned int>   m_nextSlice;
+    std::atomic<unsigned int>   m_nSlicesDone;
+    std::exception_ptr          m_pException;       // 1st exception thrown by a slice
+
+    unsigned long               m_jobId;            // bumped for every job
+    unsigned int                m_nActiveWorkers;   // workers running slices of the current job
+    unsigned int                m_nStartedWorkers;
+    bool                        m_bExit;
+
+    static bool &inSlice()
+    {
+        static thread_local bool bInSlice = false;
+
+        return bInSlice;
+    }
+
+  protected:
+
+    // Claim and run slices of the current job, until there are none left.
+    // fn / numSlices are the caller's copy of the job (taken under
+    // m_jobMutex), m_pFn / m_numSlices may already belong to the next job.
+    void runSlices(const std::function<void(unsigned int)> &fn, const unsigned int numSlices)
+    {
+        bool bWasInSlice = inSlice();
+
+        inSlice() = true;
+
+        while (true)
+        {
+            unsigned int slice = m_nextSlice.fetch_add(1);
+
+            if (slice >= numSlices)
+                break;
+
+            try
+            {
+                fn(slice);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{m_jobMutex};
+
+                if (m_pException == nullptr)
+                    m_pException = std::current_exception();
+            }
+
+            if ((m_nSlicesDone.fetch_add(1) + 1) == numSlices)
+            {
+                std::lock_guard<std::mutex> lock{m_jobMutex};
+
+                m_jobDoneVar.notify_all();
+            }
+        }
+
+        inSlice() = bWasInSlice;
+    }
+
+    void workerProc()
+    {
+        std::unique_lock<std::mutex> lock{m_jobMutex};
+
+        m_nStartedWorkers++;
+        m_jobDoneVar.notify_all();
+
+        unsigned long lastJobId = m_jobId;
+
+        while (true)
+        {
+            m_jobReadyVar.wait(lock, [&] { return (m_bExit == true || m_jobId != lastJobId); });
+
+            if (m_bExit == true)
+                break;
+
+            lastJobId = m_jobId;
+
+            // the job already finished (this worker woke up late)
+            if (m_pFn == nullptr)
+                continue;
+
+            // take a copy of the job - run() doesn't post the next job
+            // until this worker is no longer active
+            const std::function<void(unsigned int)> *pFn = m_pFn;
+            unsigned int numSlices = m_numSlices;
+
+            m_nActiveWorkers++;
+
+            lock.unlock();
+
+            runSlices(*pFn, numSlices);
+
+            lock.lock();
+
+            m_nActiveWorkers--;
+
+            if (m_nActiveWorkers == 0)
+                m_jobDoneVar.notify_all();
+        }
+    }
+
+  public:
+
+    // numThreads = total number of threads that run slices, including
+    // the thread that calls run() (0 = 1 per CPU core)
+    CSlicePool(unsigned int numThreads = 0, const std::string &sName = "slice") :
+        m_pFn(nullptr),
+        m_numSlices(0),
+        m_nextSlice(0),
+        m_nSlicesDone(0)
+    {
+        m_jobId = 0;
+        m_nActiveWorkers = 0;
+        m_nStartedWorkers = 0;
+        m_bExit = false;
+
+        if (numThreads == 0)
+            numThreads = std::thread::hardware_concurrency();
+
+        numThreads = std::max(1u, std::min(numThreads, (unsigned int) SLICE_POOL_MAX_THREADS));
+
+        for (unsigned int idx = 1; idx < numThreads; idx++)
+        {
+            auto pWorker = std::make_unique<CSliceWorker>(this, (sName + std::to_string(idx)));
+
+            if (pWorker->createThread() == false)
+            {
+                LogDebug("[CSlicePool:{}] Failed to start worker thread ", __func__);
+                break;
+            }
+
+            m_workers.push_back(std::move(pWorker));
+        }
+
+        // wait for the workers to start (so stopThread() can join them)
+        std::unique_lock<std::mutex> lock{m_jobMutex};
+
+        m_jobDoneVar.wait(lock, [&] { return (m_nStartedWorkers >= m_workers.size()); });
+    }
+
+    ~CSlicePool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{m_jobMutex};
+
+            m_bExit = true;
+
+            m_jobReadyVar.notify_all();
+        }
+
+        m_workers.clear();
+    }
+
+    CSlicePool(const CSlicePool &) = delete;
+    CSlicePool &operator=(const CSlicePool &) = delete;
+
+    // Get the number of threads that run slices (workers + the caller)
+    unsigned int getNumThreads()
+    {
+        return (unsigned int) (m_workers.size() + 1);
+    }
+
+    // Call fn(slice) for slice = 0 to (numSlices - 1), and wait
+    // for them all to finish.  If a slice throws an exception the
+    // other slices still run, and then the (1st) exception is
+    // re-thrown here.
+    void run(const unsigned int numSlices, const std::function<void(unsigned int)> &fn)
+    {
+        if (numSlices < 1)
+            return;
+
+        // run serially if there are no workers (or for a nested job)
+        if (m_workers.empty() == true || numSlices == 1 || inSlice() == true)
+        {
+            for (unsigned int slice = 0; slice < numSlices; slice++)
+                fn(slice);
+
+            return;
+        }
+
+        std::lock_guard<std::mutex> runLock{m_runMutex};
+
+        {
+            std::lock_guard<std::mutex> lock{m_jobMutex};
+
+            m_pFn = &fn;
+            m_numSlices = numSlices;
+            m_nextSlice.store(0);
+            m_nSlicesDone.store(0);
+            m_pException = nullptr;
+
+            m_jobId++;
+
+            m_jobReadyVar.notify_all();
+        }
+
+        runSlices(fn, numSlices);
+
+        std::exception_ptr pException;
+
+        {
+            std::unique_lock<std::mutex> lock{m_jobMutex};
+
+            // all slices done, and no worker still looking at this job
+            m_jobDoneVar.wait(lock, [&] { return (m_nSlicesDone.load() >= m_numSlices && m_nActiveWorkers == 0); });
+
+            m_pFn = nullptr;
+
+            pException = m_pException;
+            m_pException = nullptr;
+        }
+
+        if (pException != nullptr)
+            std::rethrow_exception(pException);
+    }
+};
+
+
+// The pool used by the parallelXxx() functions (unless they are given one).
+// Created on first use, with 1 thread per CPU core.
+inline CSlicePool &defaultSlicePool()
+{
+    // never deleted, so it can be used during static destruction
+    static CSlicePool *pPool = new CSlicePool();
+
+    return *pPool;
+}
+
+
+// Run fnRows(firstRow, lastRow) on contiguous slices of numRows rows.
+// Every slice (except the last) is a multiple of rowAlign rows.
+// maxSlices = max. number of slices (0 = 1 per pool thread, 1 = run on this thread)
+inline void parallelRows
+    (
+        const unsigned int numRows,
+        const std::function<void(unsigned int, unsigned int)> &fnRows,
+        const unsigned int rowAlign = 1,
+        const unsigned int maxSlices = 0,
+        CSlicePool *pPool = nullptr
+    )
+{
+    if (numRows < 1)
+        return;
+
+    const unsigned int align = std::max(1u, rowAlign);
+    const unsigned int numUnits = ((numRows + align) - 1) / align;
+
+    if (maxSlices == 1 || numUnits < 2)
+    {
+        fnRows(0, numRows);
+        return;
+    }
+
+    CSlicePool &pool = (pPool != nullptr) ? *pPool : defaultSlicePool();
+
+    unsigned int numSlices = pool.getNumThreads();
+
+    if (maxSlices > 0)
+        numSlices = std::min(numSlices, maxSlices);
+
+    numSlices = std::min(numSlices, numUnits);
+
+    pool.run
+        (
+            numSlices,
+            [&](unsigned int slice)
+            {
+                unsigned int firstRow = (((numUnits * slice) / numSlices) * align);
+                unsigned int lastRow = (((numUnits * (slice + 1)) / numSlices) * align);
+
+                fnRows(firstRow, std::min(lastRow, numRows));
+            }
+        );
+}
+
+// Run fnRows(firstRow, lastRow) on slices of the rows of a video frame.
+// rowAlign = 2 keeps pairs of rows (4:2:0 chroma) in the same slice.
+inline void parallelVideoRows
+    (
+        CSimpleVideoBuffer &buffer,
+        const std::function<void(unsigned int, unsigned int)> &fnRows,
+        const unsigned int rowAlign = 2,
+        CSlicePool *pPool = nullptr
+    )
+{
+    parallelRows(buffer.getFrameHeight(), fnRows, rowAlign, 0, pPool);
+}
+
+// Run fnChannel(chl) for every channel of an audio buffer
+template <class T> inline void parallelChannels
+    (
+        CSimpleAudioBuffer<T> &buffer,
+        const std::function<void(unsigned int)> &fnChannel,
+        CSlicePool *pPool = nullptr
+    )
+{
+    CSlicePool &pool = (pPool != nullptr) ? *pPool : defaultSlicePool();
+
+    pool.run(buffer.getNumChannels(), fnChannel);
+}
+
+// Run fnFrames(firstFrame, lastFrame) on slices of the (sample)
+// frames of an audio buffer.  frameAlign = slice size multiple
+// (ie: to keep SIMD kernels on whole vectors).
+template <class T> inline void parallelAudioFrames
+    (
+        CSimpleAudioBuffer<T> &buffer,
+        const std::function<void(unsigned int, unsigned int)> &fnFrames,
+        const unsigned int frameAlign = 16,
+        CSlicePool *pPool = nullptr
+    )
+{
+    parallelRows(buffer.getSamplesPerBlock(), fnFrames, frameAlign, 0, pPool);
+}
+
+
+#endif // _SLICE_POOL_H_
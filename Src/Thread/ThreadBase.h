@@ -33,8 +33,10 @@
 #include <pthread.h>
 #include <sched.h>
 #include <sys/neutrino.h>
+#include <signal.h>
 #else
 #include <pthread.h>
+#include <signal.h>
 #endif
 
 #include "../Logging/Logging.h"
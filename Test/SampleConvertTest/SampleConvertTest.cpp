@@ -0,0 +1,240 @@
+﻿//******************************************************************
+// SampleConvertTest.cpp : Checks the SIMD sample conversions against
+//                         the scalar code, and the precision of the
+//                         integer <-> integer / f64 conversions.
+//
+
+#include "SampleConvertTest.h"
+
+
+static int  g_nFailures = 0;
+
+static void check(const bool bPassed, const char *pName, const size_t numBad)
+{
+    printf("%-48s %s", pName, (bPassed ? "passed" : "FAILED"));
+
+    if (!bPassed)
+    {
+        printf(" (%zu bad)", numBad);
+        g_nFailures++;
+    }
+
+    printf("\n");
+}
+
+
+// The scalar result for each sample (flags = 0, so no dither)
+template <typename T>
+static std::vector<int32_t> scalarConvert(const std::vector<float> &source, const float scale, const float minValue, const float maxValue)
+{
+    std::vector<int32_t> result(source.size());
+
+    uint32_t ditherState = 0;
+
+    for (size_t x = 0; x < source.size(); x++)
+        result[x] = (T) convertFloatToInt(source[x], scale, minValue, maxValue, 0, ditherState);
+
+    return result;
+}
+
+// Float -> integer with flags = 0: every SIMD kernel must give the
+// same (saturated) values as the scalar code, for out of range input too.
+static void testFloatToIntParity()
+{
+    // (an odd size, so the scalar tail runs as well)
+    std::vector<float> source(1037);
+
+    std::mt19937                            rng(1234);
+    std::uniform_real_distribution<float>   dist(-2.0f, 2.0f);
+
+    for (auto &value : source)
+        value = dist(rng);
+
+    source[0] = 1.0f;
+    source[1] = -1.0f;
+    source[2] = 2.0f;
+    source[3] = -2.0f;
+
+    auto expectS16 = scalarConvert<int16_t>(source, SAMPLE_SCALE_S16, SAMPLE_MIN_S16, SAMPLE_MAX_S16);
+    auto expectS24 = scalarConvert<int32_t>(source, SAMPLE_SCALE_S24, SAMPLE_MIN_S24, SAMPLE_MAX_S24);
+    auto expectS32 = scalarConvert<int32_t>(source, SAMPLE_SCALE_S32, SAMPLE_MIN_S32, SAMPLE_MAX_S32);
+
+    std::vector<int16_t> s16(source.size());
+    std::vector<uint8_t> s24(source.size() * 3);
+    std::vector<int32_t> s32(source.size());
+
+    auto countS16 = [&]() { size_t bad = 0; for (size_t x = 0; x < s16.size(); x++) bad += (s16[x] != expectS16[x]); return bad; };
+    auto countS32 = [&]() { size_t bad = 0; for (size_t x = 0; x < s32.size(); x++) bad += (s32[x] != expectS32[x]); return bad; };
+    auto countS24 = [&]()
+        {
+            size_t bad = 0;
+
+            for (size_t x = 0; x < source.size(); x++)
+            {
+                int32_t value = (int32_t) (((uint32_t) s24[x * 3] << 8) | ((uint32_t) s24[x * 3 + 1] << 16) | ((uint32_t) s24[x * 3 + 2] << 24));
+
+                bad += ((value >> 8) != expectS24[x]);
+            }
+
+            return bad;
+        };
+
+    size_t bad;
+
+    // (whichever kernel the dispatcher picks)
+    convertFloatToS16(s16.data(), source.data(), source.size(), 0);
+    bad = countS16();
+    check(bad == 0, "f32 -> s16, flags 0, dispatched", bad);
+
+    convertFloatToS24(s24.data(), source.data(), source.size(), 0);
+    bad = countS24();
+    check(bad == 0, "f32 -> s24, flags 0, dispatched", bad);
+
+    convertFloatToS32(s32.data(), source.data(), source.size(), 0);
+    bad = countS32();
+    check(bad == 0, "f32 -> s32, flags 0, dispatched", bad);
+
+#if defined(SIMD_X86) || defined(SIMD_NEON)
+    const SCpuFeatures &cpu = getCpuFeatures();
+
+    // each kernel, with the scalar code for the samples it leaves over
+    auto finishS16 = [&](size_t x) { for (; x < source.size(); x++) s16[x] = (int16_t) expectS16[x]; };
+    auto finishS32 = [&](size_t x) { for (; x < source.size(); x++) s32[x] = expectS32[x]; };
+#endif
+
+#if defined(SIMD_X86)
+    if (cpu.bSse2)
+    {
+        finishS16(convertFloatToS16Sse2(s16.data(), source.data(), source.size(), 0));
+        bad = countS16();
+        check(bad == 0, "f32 -> s16, flags 0, SSE2", bad);
+
+        finishS32(convertFloatToS32Sse2(s32.data(), source.data(), source.size(), 0));
+        bad = countS32();
+        check(bad == 0, "f32 -> s32, flags 0, SSE2", bad);
+    }
+
+    if (cpu.bAvx2)
+    {
+        finishS16(convertFloatToS16Avx2(s16.data(), source.data(), source.size(), 0));
+        bad = countS16();
+        check(bad == 0, "f32 -> s16, flags 0, AVX2", bad);
+
+        finishS32(convertFloatToS32Avx2(s32.data(), source.data(), source.size(), 0));
+        bad = countS32();
+        check(bad == 0, "f32 -> s32, flags 0, AVX2", bad);
+
+        size_t x = convertFloatToS24Avx2(s24.data(), source.data(), source.size(), 0);
+
+        for (; x < source.size(); x++)
+        {
+            s24[x * 3]     = (uint8_t) (expectS24[x] & 0xFF);
+            s24[x * 3 + 1] = (uint8_t) ((expectS24[x] >> 8) & 0xFF);
+            s24[x * 3 + 2] = (uint8_t) ((expectS24[x] >> 16) & 0xFF);
+        }
+
+        bad = countS24();
+        check(bad == 0, "f32 -> s24, flags 0, AVX2", bad);
+    }
+#elif defined(SIMD_NEON)
+    if (cpu.bNeon)
+    {
+        finishS16(convertFloatToS16Neon(s16.data(), source.data(), source.size(), 0));
+        bad = countS16();
+        check(bad == 0, "f32 -> s16, flags 0, NEON", bad);
+
+        finishS32(convertFloatToS32Neon(s32.data(), source.data(), source.size(), 0));
+        bad = countS32();
+        check(bad == 0, "f32 -> s32, flags 0, NEON", bad);
+    }
+#endif
+}
+
+// Integer <-> f64 and integer <-> integer round trips must be exact
+static void testPrecision()
+{
+    const size_t numSamples = 1000;
+
+    std::mt19937 rng(5678);
+
+    std::vector<int32_t> s32(numSamples);
+    std::vector<int32_t> s32Out(numSamples);
+    std::vector<int16_t> s16(numSamples);
+    std::vector<int16_t> s16Out(numSamples);
+    std::vector<uint8_t> s24(numSamples * 3);
+    std::vector<uint8_t> s24Out(numSamples * 3);
+    std::vector<double>  f64(numSamples);
+
+    for (size_t x = 0; x < numSamples; x++)
+    {
+        s32[x] = (int32_t) rng();
+        s16[x] = (int16_t) rng();
+    }
+
+    s32[0] = 123456789;
+    s32[1] = INT32_MAX;
+    s32[2] = INT32_MIN;
+    s16[0] = INT16_MAX;
+    s16[1] = INT16_MIN;
+
+    size_t bad;
+
+    // s32 -> f64 -> s32
+    convertSamples(f64.data(), eSampleFormat_f64, s32.data(), eSampleFormat_s32, numSamples);
+    convertSamples(s32Out.data(), eSampleFormat_s32, f64.data(), eSampleFormat_f64, numSamples);
+    bad = 0;
+    for (size_t x = 0; x < numSamples; x++)
+        bad += (s32[x] != s32Out[x]);
+    check(bad == 0, "s32 -> f64 -> s32", bad);
+
+    // s32 -> s24 -> s32 (the low 8 bits are lost, so compare s24 -> s32 -> s24)
+    convertSamples(s24.data(), eSampleFormat_s24, s32.data(), eSampleFormat_s32, numSamples);
+    convertSamples(s32Out.data(), eSampleFormat_s32, s24.data(), eSampleFormat_s24, numSamples);
+    convertSamples(s24Out.data(), eSampleFormat_s24, s32Out.data(), eSampleFormat_s32, numSamples);
+    bad = 0;
+    for (size_t x = 0; x < s24.size(); x++)
+        bad += (s24[x] != s24Out[x]);
+    check(bad == 0, "s24 -> s32 -> s24", bad);
+
+    // s24 -> f64 -> s24
+    convertSamples(f64.data(), eSampleFormat_f64, s24.data(), eSampleFormat_s24, numSamples);
+    convertSamples(s24Out.data(), eSampleFormat_s24, f64.data(), eSampleFormat_f64, numSamples);
+    bad = 0;
+    for (size_t x = 0; x < s24.size(); x++)
+        bad += (s24[x] != s24Out[x]);
+    check(bad == 0, "s24 -> f64 -> s24", bad);
+
+    // s16 -> s32 -> s16 and s16 -> s24 -> s16
+    convertSamples(s32Out.data(), eSampleFormat_s32, s16.data(), eSampleFormat_s16, numSamples);
+    convertSamples(s16Out.data(), eSampleFormat_s16, s32Out.data(), eSampleFormat_s32, numSamples);
+    bad = 0;
+    for (size_t x = 0; x < numSamples; x++)
+        bad += (s16[x] != s16Out[x]);
+    check(bad == 0, "s16 -> s32 -> s16", bad);
+
+    convertSamples(s24Out.data(), eSampleFormat_s24, s16.data(), eSampleFormat_s16, numSamples);
+    convertSamples(s16Out.data(), eSampleFormat_s16, s24Out.data(), eSampleFormat_s24, numSamples);
+    bad = 0;
+    for (size_t x = 0; x < numSamples; x++)
+        bad += (s16[x] != s16Out[x]);
+    check(bad == 0, "s16 -> s24 -> s16", bad);
+
+    // narrowing rounds to nearest, and saturates
+    int32_t  wide[4]     = { 0x7FFFFFFF, (int32_t) 0x80000000, 0x00018000, -0x00018001 };
+    int16_t  narrow[4];
+
+    convertSamples(narrow, eSampleFormat_s16, wide, eSampleFormat_s32, 4);
+    check((narrow[0] == INT16_MAX && narrow[1] == INT16_MIN && narrow[2] == 2 && narrow[3] == -2), "s32 -> s16 rounding / saturation", 0);
+}
+
+
+int main()
+{
+    testFloatToIntParity();
+
+    testPrecision();
+
+    printf("%d failure(s)\n", g_nFailures);
+
+    return ((g_nFailures == 0) ? 0 : 1);
+}
@@ -0,0 +1,11 @@
+﻿//******************************************************************
+// SampleConvertTest.h 
+//
+
+#pragma once
+
+#include "../../Src/Buffer/SampleConvert.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
@@ -0,0 +1,202 @@
+﻿//******************************************************************
+// VectorBufferBench.cpp : Times consuming from the front of a
+//                         CVectorBuffer (FIFO use), from 1K to 10M
+//                         entries deep, in vector and ring storage
+//                         modes.  The per-op cost should be flat.
+//
+
+#include "VectorBufferBench.h"
+
+
+#define BENCH_NUM_OPS       1000000     // timed write / consume pairs at each depth
+
+static int  g_nFailures = 0;
+
+static const char *storageName(const eVectorBufferStorage_def storage)
+{
+    return (storage == eVectorBufferStorage_ring) ? "ring" : "vector";
+}
+
+
+// Random writes, reads and deletes, checked against a std::deque
+static void checkStorage(const eVectorBufferStorage_def storage)
+{
+    CVectorBuffer<int32_t>  buffer(4096, storage);
+    std::deque<int32_t>     model;
+
+    std::mt19937            rng(1234);
+    std::vector<int32_t>    block(256);
+
+    int32_t                 nextValue = 0;
+    size_t                  numBad = 0;
+
+    for (int op = 0; op < 200000; op++)
+    {
+        switch (rng() % 6)
+        {
+            case 0:
+            case 1:
+            {
+                size_t count = (rng() % block.size());
+
+                for (size_t x = 0; x < count; x++)
+                    block[x] = nextValue++;
+
+                bool bWritten = buffer.writeBlock(block.data(), count);
+
+                if (bWritten != ((model.size() + count) <= 4096))
+                    numBad++;
+
+                if (bWritten)
+                    model.insert(model.end(), block.begin(), (block.begin() + count));
+
+                break;
+            }
+
+            case 2:
+            {
+                size_t count = (rng() % block.size());
+
+                int numRead = buffer.readBlock(block.data(), count, true);
+
+                if (numRead != (int) std::min(count, model.size()))
+                {
+                    numBad++;
+                    break;
+                }
+
+                for (int x = 0; x < numRead; x++)
+                {
+                    if (block[x] != model.front())
+                        numBad++;
+
+                    model.pop_front();
+                }
+
+                break;
+            }
+
+            case 3:
+            {
+                if (model.empty())
+                    break;
+
+                // from the middle
+                int pos = (int) (rng() % model.size());
+
+                buffer.deleteEntry(pos);
+                model.erase(model.begin() + pos);
+
+                break;
+            }
+
+            case 4:
+            {
+                if (model.empty())
+                    break;
+
+                int pos = (int) (rng() % model.size());
+
+                if (buffer.get(pos) != model[pos])
+                    numBad++;
+
+                break;
+            }
+
+            case 5:
+            {
+                if ((rng() % 50) != 0)
+                    break;
+
+                // contiguous access (unwraps a ring)
+                int32_t *pData = buffer.getBufferPtr();
+
+                for (size_t x = 0; x < model.size(); x++)
+                {
+                    if (pData[x] != model[x])
+                        numBad++;
+                }
+
+                buffer.freeBufferPtr();
+
+                // switch the storage mode and back (the entries are kept)
+                buffer.setStorageMode((storage == eVectorBufferStorage_ring) ? eVectorBufferStorage_vector : eVectorBufferStorage_ring);
+                buffer.setStorageMode(storage);
+
+                break;
+            }
+        }
+
+        if (buffer.getCurrentDataSize() != (int) model.size())
+            numBad++;
+    }
+
+    printf("%-48s %s", storageName(storage), ((numBad == 0) ? "passed" : "FAILED"));
+
+    if (numBad > 0)
+    {
+        printf(" (%zu bad)", numBad);
+        g_nFailures++;
+    }
+
+    printf("\n");
+}
+
+// Fill to "depth" entries, then time write 1 / read-and-delete 1 pairs
+// (the FIFO stays at "depth" entries).  Returns nanoseconds per pair.
+static double timeFrontConsume(const eVectorBufferStorage_def storage, const size_t depth)
+{
+    CVectorBuffer<int32_t>  buffer((depth + 1), storage);
+
+    std::vector<int32_t>    fill(depth);
+
+    for (size_t x = 0; x < depth; x++)
+        fill[x] = (int32_t) x;
+
+    buffer.writeBlock(fill.data(), depth);
+
+    int32_t     value = 0;
+    int64_t     sum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int op = 0; op < BENCH_NUM_OPS; op++)
+    {
+        buffer.writeBlock(&value, 1);
+        buffer.readBlock(&value, 1, true);
+
+        sum += value;
+    }
+
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+
+    // (keep the loop from being optimized away)
+    if (sum == -1)
+        printf("\n");
+
+    return (elapsed.count() / BENCH_NUM_OPS);
+}
+
+
+int main()
+{
+    printf("Checking CVectorBuffer storage modes\n");
+
+    checkStorage(eVectorBufferStorage_vector);
+    checkStorage(eVectorBufferStorage_ring);
+
+    printf("\nFront consume (write 1 + read-and-delete 1), ns per op\n");
+    printf("%10s %10s %10s\n", "depth", "vector", "ring");
+
+    for (size_t depth = 1000; depth <= 10000000; depth *= 10)
+    {
+        double vectorNs = timeFrontConsume(eVectorBufferStorage_vector, depth);
+        double ringNs = timeFrontConsume(eVectorBufferStorage_ring, depth);
+
+        printf("%10zu %10.1f %10.1f\n", depth, vectorNs, ringNs);
+    }
+
+    printf("\n%s\n", ((g_nFailures == 0) ? "All checks passed" : "Some checks FAILED"));
+
+    return (g_nFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+﻿//******************************************************************
+// VectorBufferBench.h 
+//
+
+#pragma once
+
+#include "../../Src/Buffer/CVectorBuffer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>